@@ -0,0 +1,105 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+#include "AudioBackend.hpp"
+#include "shared.hpp"
+
+AudioBackend::~AudioBackend(VOID)
+{
+}
+
+BOOL WINAPI AudioBackend::loadDeviceList(HWND p_listbox)
+{
+	listbox_clear(p_listbox);
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend::chooseDevice(SIZE_T index)
+{
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend::chooseDefaultDevice(VOID)
+{
+	return TRUE;
+}
+
+VOID WINAPI AudioBackend::release(VOID)
+{
+	this->close();
+	return;
+}
+
+BOOL WINAPI AudioBackend::canAcquireFrames(VOID)
+{
+	return FALSE;
+}
+
+BOOL WINAPI AudioBackend::acquireFrames(SIZE_T n_frames, VOID **pp_frames)
+{
+	this->err_msg = TEXT("AudioBackend::acquireFrames: Error: output spans are not supported by this backend.");
+	return FALSE;
+}
+
+BOOL WINAPI AudioBackend::commitFrames(SIZE_T n_frames)
+{
+	this->err_msg = TEXT("AudioBackend::commitFrames: Error: output spans are not supported by this backend.");
+	return FALSE;
+}
+
+BOOL WINAPI AudioBackend::flush(VOID)
+{
+	return TRUE;
+}
+
+SIZE_T WINAPI AudioBackend::getBufferSizeFrames(VOID)
+{
+	return this->AUDIOBUFFER_SIZE_FRAMES;
+}
+
+SIZE_T WINAPI AudioBackend::getPeriodSizeFrames(VOID)
+{
+	return 0u;
+}
+
+__string WINAPI AudioBackend::getLastErrorMessage(VOID)
+{
+	return this->err_msg;
+}
+
+BOOL WINAPI AudioBackend::format_set(const audiobackend_format_t *p_format)
+{
+	if(p_format == NULL)
+	{
+		this->err_msg = TEXT("AudioBackend::format_set: Error: given format object pointer is null.");
+		return FALSE;
+	}
+
+	if(!p_format->sample_rate || !p_format->n_channels)
+	{
+		this->err_msg = TEXT("AudioBackend::format_set: Error: invalid audio format.");
+		return FALSE;
+	}
+
+	if((p_format->bits_per_sample != 16u) && (p_format->bits_per_sample != 32u))
+	{
+		this->err_msg = TEXT("AudioBackend::format_set: Error: unsupported sample size.");
+		return FALSE;
+	}
+
+	if(p_format->valid_bits_per_sample > p_format->bits_per_sample)
+	{
+		this->err_msg = TEXT("AudioBackend::format_set: Error: invalid audio format.");
+		return FALSE;
+	}
+
+	CopyMemory(&(this->format), p_format, sizeof(audiobackend_format_t));
+
+	this->FRAME_SIZE_BYTES = ((SIZE_T) this->format.n_channels)*((SIZE_T) (this->format.bits_per_sample/8u));
+	return TRUE;
+}
@@ -0,0 +1,161 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+/*
+	Audio Backend:
+
+	The output side of the audio engine. The engine only talks to the audio output through this interface,
+	so the same load/DSP/play pipeline can render to an audio device (AudioBackend_WASAPI), a WAV file (AudioBackend_WAVFile),
+	or nowhere at all (AudioBackend_Null, AudioBackend_SimClock).
+
+	Usage:
+
+	open() with the stream format. The backend sets its buffer size (getBufferSizeFrames()).
+	start() the stream.
+	Repeat: waitFramesFree(), then writeFrames() (or acquireFrames(), fill in the frames, then commitFrames()).
+	flush() once every frame has been written, to check that they all reached the output.
+	close() when done (stops the stream).
+
+	Pacing: before writing new frames, the play thread must wait until the output has room for them (waitFramesFree()).
+	How that wait happens (polling, device events, real time clock, simulated clock...) is up to each backend implementation.
+
+	Device selection (loadDeviceList(), chooseDevice(), chooseDefaultDevice()) only applies to device backends.
+	Other backends have no devices: the list is left empty and choosing a device always succeeds.
+*/
+
+#ifndef AUDIOBACKEND_HPP
+#define AUDIOBACKEND_HPP
+
+#include "globldef.h"
+#include "strdef.hpp"
+
+/*
+	Audio Stream Format:
+
+	sample_rate: frames per second.
+	n_channels: samples per frame.
+	bits_per_sample: sample container size (16 or 32).
+	valid_bits_per_sample: significant bits within the container, MSB aligned (16 or 24).
+*/
+
+struct _audiobackend_format {
+	UINT32 sample_rate;
+	UINT16 n_channels;
+	UINT16 bits_per_sample;
+	UINT16 valid_bits_per_sample;
+};
+
+typedef struct _audiobackend_format audiobackend_format_t;
+
+class AudioBackend {
+	public:
+		virtual ~AudioBackend(VOID);
+
+		virtual BOOL WINAPI loadDeviceList(HWND p_listbox);
+		virtual BOOL WINAPI chooseDevice(SIZE_T index);
+		virtual BOOL WINAPI chooseDefaultDevice(VOID);
+
+		/*
+			open(): open the output stream with the given format.
+			returns true if successful, false otherwise.
+		*/
+
+		virtual BOOL WINAPI open(const audiobackend_format_t *p_format) = 0;
+
+		/*
+			close(): stop and close the output stream (if open). Device backends also release the chosen device.
+			Frames still held by the backend (see flush()) are discarded.
+		*/
+
+		virtual VOID WINAPI close(VOID) = 0;
+
+		/*
+			release(): close() and release every other resource held by the backend (device list).
+		*/
+
+		virtual VOID WINAPI release(VOID);
+
+		virtual BOOL WINAPI start(VOID) = 0;
+
+		/*
+			getFramesFree(): retrieve the number of frames that can be written to the output right now.
+			returns true if successful, false otherwise.
+		*/
+
+		virtual BOOL WINAPI getFramesFree(SIZE_T *p_n_frames) = 0;
+
+		/*
+			waitFramesFree(): pause the calling thread until at least n_frames frames can be written to the output.
+			returns true if successful, false otherwise.
+		*/
+
+		virtual BOOL WINAPI waitFramesFree(SIZE_T n_frames) = 0;
+
+		/*
+			writeFrames(): write n_frames frames to the output. n_frames must not exceed the number of free frames.
+			If p_frames is NULL, n_frames frames of silence are written.
+			returns true if successful, false otherwise.
+		*/
+
+		virtual BOOL WINAPI writeFrames(const VOID *p_frames, SIZE_T n_frames) = 0;
+
+		/*
+			Output spans (zero-copy output, optional):
+
+			canAcquireFrames(): returns true if the backend supports acquireFrames() and commitFrames(). Default: not supported.
+
+			acquireFrames(): retrieve a pointer to room for n_frames frames straight within the output (device buffer, file write page...),
+			so the caller can produce the frames in place instead of having writeFrames() copy them from a buffer of its own.
+			n_frames must not exceed the number of free frames.
+
+			commitFrames(): hand the first n_frames frames of the last acquired span over to the output. n_frames must not exceed the acquired size.
+
+			Each acquireFrames() must be followed by exactly one commitFrames(), with no other write in between.
+			returns true if successful, false otherwise (always false if the backend doesn't support output spans).
+		*/
+
+		virtual BOOL WINAPI canAcquireFrames(VOID);
+		virtual BOOL WINAPI acquireFrames(SIZE_T n_frames, VOID **pp_frames);
+		virtual BOOL WINAPI commitFrames(SIZE_T n_frames);
+
+		/*
+			flush(): hand every written frame the backend is still holding (file write page...) over to the output.
+			Default: nothing held, always succeeds.
+			returns true if successful, false otherwise.
+		*/
+
+		virtual BOOL WINAPI flush(VOID);
+
+		SIZE_T WINAPI getBufferSizeFrames(VOID);
+
+		/*
+			getPeriodSizeFrames(): retrieve the device period (frames), the granularity at which the output frees room for new frames. Any frame count.
+			returns 0 if the output has no fixed period (default).
+		*/
+
+		virtual SIZE_T WINAPI getPeriodSizeFrames(VOID);
+
+		__string WINAPI getLastErrorMessage(VOID);
+
+	protected:
+		audiobackend_format_t format = {
+			.sample_rate = 0u,
+			.n_channels = 0u,
+			.bits_per_sample = 0u,
+			.valid_bits_per_sample = 0u
+		};
+
+		SIZE_T FRAME_SIZE_BYTES = 0u;
+		SIZE_T AUDIOBUFFER_SIZE_FRAMES = 0u;
+
+		__string err_msg = TEXT("");
+
+		BOOL WINAPI format_set(const audiobackend_format_t *p_format);
+};
+
+#endif /*AUDIOBACKEND_HPP*/
@@ -0,0 +1,152 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+#include "AudioBackend_Null.hpp"
+
+AudioBackend_Null::AudioBackend_Null(SIZE_T audiobuffer_size_frames, BOOL realtime)
+{
+	this->BUFFER_SIZE_FRAMES = audiobuffer_size_frames;
+	this->realtime = realtime;
+}
+
+BOOL WINAPI AudioBackend_Null::open(const audiobackend_format_t *p_format)
+{
+	LARGE_INTEGER qpc_freq;
+
+	if(!this->BUFFER_SIZE_FRAMES)
+	{
+		this->err_msg = TEXT("AudioBackend_Null::open: Error: buffer size is zero.");
+		return FALSE;
+	}
+
+	if(!this->format_set(p_format)) return FALSE;
+
+	if(this->realtime)
+	{
+		QueryPerformanceFrequency(&qpc_freq);
+		this->qpc_freq = (ULONG64) qpc_freq.QuadPart;
+	}
+
+	this->AUDIOBUFFER_SIZE_FRAMES = this->BUFFER_SIZE_FRAMES;
+	this->n_frames_written = 0u;
+	this->started = FALSE;
+
+	return TRUE;
+}
+
+VOID WINAPI AudioBackend_Null::close(VOID)
+{
+	this->started = FALSE;
+	this->AUDIOBUFFER_SIZE_FRAMES = 0u;
+	return;
+}
+
+BOOL WINAPI AudioBackend_Null::start(VOID)
+{
+	LARGE_INTEGER qpc_now;
+
+	if(!this->AUDIOBUFFER_SIZE_FRAMES)
+	{
+		this->err_msg = TEXT("AudioBackend_Null::start: Error: output is not open.");
+		return FALSE;
+	}
+
+	if(this->realtime)
+	{
+		QueryPerformanceCounter(&qpc_now);
+		this->qpc_start = (ULONG64) qpc_now.QuadPart;
+	}
+
+	this->started = TRUE;
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_Null::getFramesFree(SIZE_T *p_n_frames)
+{
+	ULONG64 n_frames_pending = 0u;
+
+	if(p_n_frames == NULL) return FALSE;
+
+	n_frames_pending = this->n_frames_written - this->get_frames_consumed();
+
+	*p_n_frames = this->AUDIOBUFFER_SIZE_FRAMES - ((SIZE_T) n_frames_pending);
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_Null::waitFramesFree(SIZE_T n_frames)
+{
+	SIZE_T n_frames_free = 0u;
+
+	if(n_frames > this->AUDIOBUFFER_SIZE_FRAMES)
+	{
+		this->err_msg = TEXT("AudioBackend_Null::waitFramesFree: Error: requested frames exceed the audio buffer size.");
+		return FALSE;
+	}
+
+	while(TRUE)
+	{
+		this->getFramesFree(&n_frames_free);
+		if(n_frames_free >= n_frames) break;
+
+		Sleep(1u);
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_Null::writeFrames(const VOID *p_frames, SIZE_T n_frames)
+{
+	SIZE_T n_frames_free = 0u;
+
+	this->getFramesFree(&n_frames_free);
+
+	if(n_frames > n_frames_free)
+	{
+		this->err_msg = TEXT("AudioBackend_Null::writeFrames: Error: audio buffer overflow.");
+		return FALSE;
+	}
+
+	this->n_frames_written += (ULONG64) n_frames;
+	return TRUE;
+}
+
+ULONG64 WINAPI AudioBackend_Null::getFramesWritten(VOID)
+{
+	return this->n_frames_written;
+}
+
+/*
+	get_frames_consumed(): number of frames the output has consumed so far.
+	Never more than the number of frames written: on an underrun the clock start is moved forward,
+	so frames written after the underrun are consumed in real time, like a device resuming from silence.
+*/
+
+ULONG64 WINAPI AudioBackend_Null::get_frames_consumed(VOID)
+{
+	LARGE_INTEGER qpc_now;
+	ULONG64 qpc_elapsed = 0u;
+	ULONG64 n_frames = 0u;
+
+	if(!this->realtime) return this->n_frames_written;
+	if(!this->started) return 0u;
+
+	QueryPerformanceCounter(&qpc_now);
+	qpc_elapsed = ((ULONG64) qpc_now.QuadPart) - this->qpc_start;
+
+	/*Split seconds and remainder so that (elapsed*sample_rate) doesn't overflow*/
+	n_frames = (qpc_elapsed/(this->qpc_freq))*((ULONG64) this->format.sample_rate);
+	n_frames += ((qpc_elapsed%(this->qpc_freq))*((ULONG64) this->format.sample_rate))/(this->qpc_freq);
+
+	if(n_frames > this->n_frames_written)
+	{
+		this->qpc_start += ((n_frames - this->n_frames_written)*(this->qpc_freq))/((ULONG64) this->format.sample_rate);
+		n_frames = this->n_frames_written;
+	}
+
+	return n_frames;
+}
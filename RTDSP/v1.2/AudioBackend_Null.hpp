@@ -0,0 +1,52 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+/*
+	Null Audio Backend:
+
+	Discards every frame written to it. Needs no audio device and no Windows audio APIs.
+
+	realtime == FALSE: frames are consumed as soon as they're written. The output never blocks, the engine runs as fast as the CPU allows.
+	realtime == TRUE: frames are consumed at sample_rate, measured with the performance counter,
+	so the engine is paced exactly like it would be by a real audio device with a buffer of AUDIOBUFFER_SIZE_FRAMES frames.
+*/
+
+#ifndef AUDIOBACKEND_NULL_HPP
+#define AUDIOBACKEND_NULL_HPP
+
+#include "AudioBackend.hpp"
+
+class AudioBackend_Null : public AudioBackend {
+	public:
+		AudioBackend_Null(SIZE_T audiobuffer_size_frames, BOOL realtime);
+
+		BOOL WINAPI open(const audiobackend_format_t *p_format) override;
+		VOID WINAPI close(VOID) override;
+		BOOL WINAPI start(VOID) override;
+
+		BOOL WINAPI getFramesFree(SIZE_T *p_n_frames) override;
+		BOOL WINAPI waitFramesFree(SIZE_T n_frames) override;
+		BOOL WINAPI writeFrames(const VOID *p_frames, SIZE_T n_frames) override;
+
+		ULONG64 WINAPI getFramesWritten(VOID);
+
+	protected:
+		SIZE_T BUFFER_SIZE_FRAMES = 0u;
+
+		BOOL realtime = FALSE;
+		BOOL started = FALSE;
+
+		ULONG64 qpc_freq = 0u;
+		ULONG64 qpc_start = 0u;
+
+		ULONG64 n_frames_written = 0u;
+
+		ULONG64 WINAPI get_frames_consumed(VOID);
+};
+
+#endif /*AUDIOBACKEND_NULL_HPP*/
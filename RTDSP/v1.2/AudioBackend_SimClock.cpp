@@ -0,0 +1,191 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+#include "AudioBackend_SimClock.hpp"
+
+AudioBackend_SimClock::AudioBackend_SimClock(SIZE_T audiobuffer_size_frames, SIZE_T period_size_frames, BOOL realtime)
+{
+	this->AUDIOBUFFER_SIZE_FRAMES = audiobuffer_size_frames;
+	this->realtime = realtime;
+
+	if(period_size_frames) this->PERIOD_SIZE_FRAMES = period_size_frames;
+	else this->PERIOD_SIZE_FRAMES = 1u;
+}
+
+BOOL WINAPI AudioBackend_SimClock::open(const audiobackend_format_t *p_format)
+{
+	LARGE_INTEGER qpc_freq;
+
+	if(!this->format_set(p_format)) return FALSE;
+
+	if(this->realtime)
+	{
+		QueryPerformanceFrequency(&qpc_freq);
+		this->qpc_freq = (ULONG64) qpc_freq.QuadPart;
+	}
+
+	this->started = FALSE;
+	this->n_frames_pending = 0u;
+	this->clock_nframe = 0u;
+	this->n_wakeups = 0u;
+	this->n_underrun_frames = 0u;
+
+	return TRUE;
+}
+
+SIZE_T WINAPI AudioBackend_SimClock::getPeriodSizeFrames(VOID)
+{
+	return this->PERIOD_SIZE_FRAMES;
+}
+
+VOID WINAPI AudioBackend_SimClock::close(VOID)
+{
+	this->started = FALSE;
+	this->n_frames_pending = 0u;
+	return;
+}
+
+BOOL WINAPI AudioBackend_SimClock::start(VOID)
+{
+	LARGE_INTEGER qpc_now;
+
+	if(this->realtime)
+	{
+		QueryPerformanceCounter(&qpc_now);
+		this->qpc_start = (ULONG64) qpc_now.QuadPart;
+	}
+
+	this->started = TRUE;
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_SimClock::getFramesFree(SIZE_T *p_n_frames)
+{
+	if(p_n_frames == NULL) return FALSE;
+
+	this->clock_sync();
+
+	*p_n_frames = this->AUDIOBUFFER_SIZE_FRAMES - this->n_frames_pending;
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_SimClock::waitFramesFree(SIZE_T n_frames)
+{
+	SIZE_T n_frames_free = 0u;
+	SIZE_T n_frames_wait = 0u;
+
+	if(n_frames > this->AUDIOBUFFER_SIZE_FRAMES)
+	{
+		this->err_msg = TEXT("AudioBackend_SimClock::waitFramesFree: Error: requested frames exceed the audio buffer size.");
+		return FALSE;
+	}
+
+	if(this->realtime)
+	{
+		while(TRUE)
+		{
+			this->clock_sync();
+
+			n_frames_free = this->AUDIOBUFFER_SIZE_FRAMES - this->n_frames_pending;
+			if(n_frames_free >= n_frames) break;
+
+			/*Sleep until the device period that frees the missing frames*/
+
+			n_frames_wait = n_frames - n_frames_free;
+			n_frames_wait = ((n_frames_wait + this->PERIOD_SIZE_FRAMES - 1u)/(this->PERIOD_SIZE_FRAMES))*(this->PERIOD_SIZE_FRAMES);
+
+			Sleep((DWORD) ((((ULONG64) n_frames_wait)*1000u + ((ULONG64) this->format.sample_rate) - 1u)/((ULONG64) this->format.sample_rate)));
+			this->n_wakeups++;
+		}
+
+		return TRUE;
+	}
+
+	while((this->AUDIOBUFFER_SIZE_FRAMES - this->n_frames_pending) < n_frames)
+	{
+		this->advanceClock(this->PERIOD_SIZE_FRAMES);
+		this->n_wakeups++;
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_SimClock::writeFrames(const VOID *p_frames, SIZE_T n_frames)
+{
+	return this->commitFrames(n_frames);
+}
+
+BOOL WINAPI AudioBackend_SimClock::commitFrames(SIZE_T n_frames)
+{
+	this->clock_sync();
+
+	if(n_frames > (this->AUDIOBUFFER_SIZE_FRAMES - this->n_frames_pending))
+	{
+		this->err_msg = TEXT("AudioBackend_SimClock::commitFrames: Error: audio buffer overflow.");
+		return FALSE;
+	}
+
+	this->n_frames_pending += n_frames;
+	return TRUE;
+}
+
+VOID WINAPI AudioBackend_SimClock::advanceClock(SIZE_T n_frames)
+{
+	this->clock_nframe += (ULONG64) n_frames;
+
+	if(n_frames > this->n_frames_pending)
+	{
+		this->n_underrun_frames += (ULONG64) (n_frames - this->n_frames_pending);
+		this->n_frames_pending = 0u;
+	}
+	else this->n_frames_pending -= n_frames;
+
+	return;
+}
+
+/*
+	clock_sync(): realtime mode only. Advances the clock to the last device period elapsed since start().
+*/
+
+VOID WINAPI AudioBackend_SimClock::clock_sync(VOID)
+{
+	LARGE_INTEGER qpc_now;
+	ULONG64 n_ticks = 0u;
+	ULONG64 n_frames = 0u;
+
+	if(!this->realtime) return;
+	if(!this->started) return;
+
+	QueryPerformanceCounter(&qpc_now);
+
+	/*Whole seconds and the rest apart, so the frame count doesn't overflow on long runs*/
+
+	n_ticks = ((ULONG64) qpc_now.QuadPart) - this->qpc_start;
+	n_frames = (n_ticks/(this->qpc_freq))*((ULONG64) this->format.sample_rate);
+	n_frames += ((n_ticks%(this->qpc_freq))*((ULONG64) this->format.sample_rate))/(this->qpc_freq);
+
+	n_frames -= n_frames%((ULONG64) this->PERIOD_SIZE_FRAMES);
+
+	if(n_frames > this->clock_nframe) this->advanceClock((SIZE_T) (n_frames - this->clock_nframe));
+	return;
+}
+
+ULONG64 WINAPI AudioBackend_SimClock::getClockFrames(VOID)
+{
+	return this->clock_nframe;
+}
+
+ULONG64 WINAPI AudioBackend_SimClock::getWakeupCount(VOID)
+{
+	return this->n_wakeups;
+}
+
+ULONG64 WINAPI AudioBackend_SimClock::getUnderrunFrames(VOID)
+{
+	return this->n_underrun_frames;
+}
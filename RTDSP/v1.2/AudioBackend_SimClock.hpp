@@ -0,0 +1,80 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+/*
+	Simulated Clock Audio Backend:
+
+	Models an output device buffer of AUDIOBUFFER_SIZE_FRAMES frames, drained at a constant rate by a simulated clock.
+	The clock counts frames.
+
+	writeFrames(), commitFrames(): add frames to the device buffer (the frames themselves are discarded).
+	Has no output spans to acquire (canAcquireFrames() is false): commitFrames() is used on its own, to fill the device buffer without any frame data.
+	advanceClock(): lets the simulated device consume frames.
+
+	The device consumes frames in whole device periods (PERIOD_SIZE_FRAMES), waitFramesFree() wakes the play thread once per period
+	until enough frames are free, the way an event driven device would. A period of 1 frame means ideal (exact) wakeups.
+
+	realtime == FALSE: waitFramesFree() is the only thing that advances the clock, it skips ahead instead of waiting.
+	No real time is involved, so pacing behaviour is deterministic and runs as fast as the CPU allows,
+	but the device can never run dry, however late the frames are produced.
+
+	realtime == TRUE: the clock follows real time from start() (performance counter), and waitFramesFree() sleeps until the device frees enough frames.
+	The device plays on whatever the engine does, so an engine that can't keep up with sample_rate shows up as underruns.
+	A run takes real time (sample_rate frames per second).
+
+	Statistics:
+
+	clock_nframe: simulated time (number of frames elapsed).
+	n_wakeups: number of device periods the play thread was woken up for.
+	n_underrun_frames: number of frames the device had to play while its buffer was empty.
+*/
+
+#ifndef AUDIOBACKEND_SIMCLOCK_HPP
+#define AUDIOBACKEND_SIMCLOCK_HPP
+
+#include "AudioBackend.hpp"
+
+class AudioBackend_SimClock : public AudioBackend {
+	public:
+		AudioBackend_SimClock(SIZE_T audiobuffer_size_frames, SIZE_T period_size_frames, BOOL realtime);
+
+		BOOL WINAPI open(const audiobackend_format_t *p_format) override;
+		VOID WINAPI close(VOID) override;
+		BOOL WINAPI start(VOID) override;
+
+		BOOL WINAPI getFramesFree(SIZE_T *p_n_frames) override;
+		BOOL WINAPI waitFramesFree(SIZE_T n_frames) override;
+		BOOL WINAPI writeFrames(const VOID *p_frames, SIZE_T n_frames) override;
+
+		BOOL WINAPI commitFrames(SIZE_T n_frames) override;
+
+		SIZE_T WINAPI getPeriodSizeFrames(VOID) override;
+		VOID WINAPI advanceClock(SIZE_T n_frames);
+
+		ULONG64 WINAPI getClockFrames(VOID);
+		ULONG64 WINAPI getWakeupCount(VOID);
+		ULONG64 WINAPI getUnderrunFrames(VOID);
+
+	protected:
+		SIZE_T PERIOD_SIZE_FRAMES = 1u;
+		BOOL realtime = FALSE;
+		BOOL started = FALSE;
+
+		SIZE_T n_frames_pending = 0u;
+
+		ULONG64 clock_nframe = 0u;
+		ULONG64 n_wakeups = 0u;
+		ULONG64 n_underrun_frames = 0u;
+
+		ULONG64 qpc_freq = 0u;
+		ULONG64 qpc_start = 0u;
+
+		VOID WINAPI clock_sync(VOID);
+};
+
+#endif /*AUDIOBACKEND_SIMCLOCK_HPP*/
@@ -0,0 +1,539 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+#include "AudioBackend_WASAPI.hpp"
+#include "cstrdef.h"
+#include "thread.h"
+#include "shared.hpp"
+#include <combaseapi.h>
+
+AudioBackend_WASAPI::AudioBackend_WASAPI(VOID)
+{
+}
+
+AudioBackend_WASAPI::~AudioBackend_WASAPI(VOID)
+{
+	this->release();
+}
+
+BOOL WINAPI AudioBackend_WASAPI::setPacingMode(INT pacing_mode)
+{
+	if(this->p_audiomgr != NULL) return FALSE;
+
+	if((pacing_mode != this->PACING_POLL) && (pacing_mode != this->PACING_EVENT))
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::setPacingMode: Error: invalid pacing mode.");
+		return FALSE;
+	}
+
+	this->pacing_mode = pacing_mode;
+	return TRUE;
+}
+
+INT WINAPI AudioBackend_WASAPI::getPacingMode(VOID)
+{
+	return this->pacing_mode;
+}
+
+BOOL WINAPI AudioBackend_WASAPI::loadDeviceList(HWND p_listbox)
+{
+	const PROPERTYKEY* const P_PKEY = (const PROPERTYKEY*) P_PKEY_Device_FriendlyName;
+	IMMDevice *p_dev = NULL;
+	IPropertyStore *p_devprop = NULL;
+	HRESULT n_ret = 0;
+	UINT devcoll_count = 0u;
+	UINT n_dev = 0u;
+	PROPVARIANT propvar;
+
+	/*Local text buffer (not the global textbuf), so device lists can be loaded from any thread*/
+	TCHAR devname[DEVNAME_SIZE_CHARS];
+
+	/*If p_listbox is NULL, all functions to listbox will fail, but the audio device initialization shall continue normally.*/
+
+	listbox_clear(p_listbox);
+
+	this->release();
+
+	n_ret = CoCreateInstance(__uuidof(MMDeviceEnumerator), NULL, CLSCTX_ALL, __uuidof(IMMDeviceEnumerator), (VOID**) &(this->p_audiodevenum));
+	if(n_ret != S_OK)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::loadDeviceList: Error: CoCreateInstance (IMMDeviceEnumerator) failed.");
+		return FALSE;
+	}
+
+	n_ret = this->p_audiodevenum->EnumAudioEndpoints(eRender, DEVICE_STATE_ACTIVE, &(this->p_audiodevcoll));
+	if(n_ret != S_OK)
+	{
+		this->release();
+		this->err_msg = TEXT("AudioBackend_WASAPI::loadDeviceList: Error: IMMDeviceEnumerator::EnumAudioEndpoints failed.");
+		return FALSE;
+	}
+
+	n_ret = this->p_audiodevcoll->GetCount(&devcoll_count);
+	if(n_ret != S_OK)
+	{
+		this->release();
+		this->err_msg = TEXT("AudioBackend_WASAPI::loadDeviceList: Error: IMMDeviceCollection::GetCount failed.");
+		return FALSE;
+	}
+
+	for(n_dev = 0u; n_dev < devcoll_count; n_dev++)
+	{
+		n_ret = this->p_audiodevcoll->Item(n_dev, &p_dev);
+		if(n_ret != S_OK)
+		{
+			this->release();
+			this->err_msg = TEXT("AudioBackend_WASAPI::loadDeviceList: Error: IMMDeviceCollection::Item failed.");
+			return FALSE;
+		}
+
+		n_ret = p_dev->OpenPropertyStore(STGM_READ, &p_devprop);
+		if(n_ret != S_OK)
+		{
+			p_dev->Release();
+			this->release();
+			this->err_msg = TEXT("AudioBackend_WASAPI::loadDeviceList: Error: IMMDevice::OpenPropertyStore failed.");
+			return FALSE;
+		}
+
+		PropVariantInit(&propvar);
+
+		n_ret = p_devprop->GetValue(*P_PKEY, &propvar);
+		if(n_ret != S_OK)
+		{
+			p_devprop->Release();
+			p_dev->Release();
+			this->release();
+			this->err_msg = TEXT("AudioBackend_WASAPI::loadDeviceList: Error: IPropertyStore::GetValue failed.");
+			return FALSE;
+		}
+
+		if(propvar.vt == VT_EMPTY) __SPRINTF(devname, DEVNAME_SIZE_CHARS, TEXT("Unknown Audio Device"));
+		else cstr_wchar_to_tchar(propvar.pwszVal, devname, DEVNAME_SIZE_CHARS);
+
+		listbox_add_item(p_listbox, devname);
+
+		PropVariantClear(&propvar);
+
+		p_devprop->Release();
+		p_devprop = NULL;
+
+		p_dev->Release();
+		p_dev = NULL;
+	}
+
+	PropVariantClear(&propvar);
+
+	if(p_devprop != NULL) p_devprop->Release();
+	if(p_dev != NULL) p_dev->Release();
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WASAPI::chooseDevice(SIZE_T index)
+{
+	HRESULT n_ret = 0;
+
+	if(this->p_audiodevcoll == NULL)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::chooseDevice: Error: p_audiodevcoll is NULL.");
+		return FALSE;
+	}
+
+	this->close();
+
+	n_ret = this->p_audiodevcoll->Item((UINT) index, &(this->p_audiodev));
+	if(n_ret != S_OK)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::chooseDevice: Error: IMMDeviceCollection::Item failed.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WASAPI::chooseDefaultDevice(VOID)
+{
+	HRESULT n_ret = 0;
+
+	if(this->p_audiodevenum == NULL)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::chooseDefaultDevice: Error: p_audiodevnum is NULL.");
+		return FALSE;
+	}
+
+	this->close();
+
+	n_ret = this->p_audiodevenum->GetDefaultAudioEndpoint(eRender, eMultimedia, &(this->p_audiodev));
+	if(n_ret != S_OK)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::chooseDefaultDevice: Error: IMMDeviceEnumerator::GetDefaultAudioEndpoint failed.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WASAPI::open(const audiobackend_format_t *p_format)
+{
+	SIZE_T n_channel = 0u;
+	DWORD channel_mask = 0u;
+
+	HRESULT n_ret;
+	UINT32 u32;
+	WAVEFORMATEXTENSIBLE wavfmt;
+
+	if(this->p_audiodev == NULL)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::open: Error: p_audiodev is NULL.");
+		return FALSE;
+	}
+
+	if(!this->format_set(p_format)) return FALSE;
+
+	n_ret = this->p_audiodev->Activate(__uuidof(IAudioClient), CLSCTX_ALL, NULL, (VOID**) &(this->p_audiomgr));
+	if(n_ret != S_OK)
+	{
+		this->close();
+		this->err_msg = TEXT("AudioBackend_WASAPI::open: Error: IMMDevice::Activate failed.");
+		return FALSE;
+	}
+
+	channel_mask = 0u;
+	for(n_channel = 0u; n_channel < this->format.n_channels; n_channel++) channel_mask |= (1 << n_channel);
+
+	ZeroMemory(&wavfmt, sizeof(WAVEFORMATEXTENSIBLE));
+
+	wavfmt.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+	wavfmt.Format.nChannels = (WORD) this->format.n_channels;
+	wavfmt.Format.wBitsPerSample = (WORD) this->format.bits_per_sample;
+	wavfmt.Format.nBlockAlign = (WORD) this->FRAME_SIZE_BYTES;
+	wavfmt.Format.nSamplesPerSec = (DWORD) this->format.sample_rate;
+	wavfmt.Format.nAvgBytesPerSec = ((DWORD) this->format.sample_rate)*((DWORD) wavfmt.Format.nBlockAlign);
+	wavfmt.Format.cbSize = sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX);
+	wavfmt.Samples.wValidBitsPerSample = (WORD) this->format.valid_bits_per_sample;
+	wavfmt.dwChannelMask = channel_mask;
+	wavfmt.SubFormat = KSDATAFORMAT_SUBTYPE_PCM;
+
+	n_ret = this->p_audiomgr->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE, (WAVEFORMATEX*) &wavfmt, NULL);
+	if(n_ret != S_OK)
+	{
+		this->close();
+		this->err_msg = TEXT("AudioBackend_WASAPI::open: Error: audio format is not supported.");
+		return FALSE;
+	}
+
+	if(!this->client_init((WAVEFORMATEX*) &wavfmt))
+	{
+		this->close();
+		this->err_msg = TEXT("AudioBackend_WASAPI::open: Error: IAudioClient::Initialize failed.");
+		return FALSE;
+	}
+
+	n_ret = this->p_audiomgr->GetBufferSize(&u32);
+	if(n_ret != S_OK)
+	{
+		this->close();
+		this->err_msg = TEXT("AudioBackend_WASAPI::open: Error: IAudioClient::GetBufferSize failed.");
+		return FALSE;
+	}
+
+	n_ret = this->p_audiomgr->GetService(__uuidof(IAudioRenderClient), (VOID**) &(this->p_audioout));
+	if(n_ret != S_OK)
+	{
+		this->close();
+		this->err_msg = TEXT("AudioBackend_WASAPI::open: Error: IAudioClient::GetService failed.");
+		return FALSE;
+	}
+
+	this->AUDIOBUFFER_SIZE_FRAMES = (SIZE_T) u32;
+	return TRUE;
+}
+
+VOID WINAPI AudioBackend_WASAPI::close(VOID)
+{
+	if(this->p_audiomgr != NULL) this->p_audiomgr->Stop();
+
+	if(this->p_audioout != NULL)
+	{
+		this->p_audioout->Release();
+		this->p_audioout = NULL;
+	}
+
+	if(this->p_audiomgr != NULL)
+	{
+		this->p_audiomgr->Release();
+		this->p_audiomgr = NULL;
+	}
+
+	if(this->p_audiodev != NULL)
+	{
+		this->p_audiodev->Release();
+		this->p_audiodev = NULL;
+	}
+
+	if(this->p_event != NULL) event_destroy(&(this->p_event));
+
+	this->AUDIOBUFFER_SIZE_FRAMES = 0u;
+	return;
+}
+
+VOID WINAPI AudioBackend_WASAPI::release(VOID)
+{
+	this->close();
+
+	if(this->p_audiodevcoll != NULL)
+	{
+		this->p_audiodevcoll->Release();
+		this->p_audiodevcoll = NULL;
+	}
+
+	if(this->p_audiodevenum != NULL)
+	{
+		this->p_audiodevenum->Release();
+		this->p_audiodevenum = NULL;
+	}
+
+	return;
+}
+
+BOOL WINAPI AudioBackend_WASAPI::start(VOID)
+{
+	HRESULT n_ret = 0;
+
+	if(this->p_audiomgr == NULL)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::start: Error: p_audiomgr is NULL.");
+		return FALSE;
+	}
+
+	n_ret = this->p_audiomgr->Start();
+	if(n_ret != S_OK)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::start: Error: IAudioClient::Start failed.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WASAPI::getFramesFree(SIZE_T *p_n_frames)
+{
+	HRESULT n_ret = 0;
+	UINT32 u32 = 0u;
+
+	if(p_n_frames == NULL) return FALSE;
+
+	if(this->p_audiomgr == NULL)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::getFramesFree: Error: p_audiomgr is NULL.");
+		return FALSE;
+	}
+
+	n_ret = this->p_audiomgr->GetCurrentPadding(&u32);
+	if(n_ret != S_OK)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::getFramesFree: Error: IAudioClient::GetCurrentPadding failed.");
+		return FALSE;
+	}
+
+	*p_n_frames = this->AUDIOBUFFER_SIZE_FRAMES - ((SIZE_T) u32);
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WASAPI::waitFramesFree(SIZE_T n_frames)
+{
+	SIZE_T n_frames_free = 0u;
+
+	while(TRUE)
+	{
+		if(!this->getFramesFree(&n_frames_free)) return FALSE;
+		if(n_frames_free >= n_frames) break;
+
+		if(this->p_event == NULL)
+		{
+			Sleep(1u);
+			continue;
+		}
+
+		if(!event_wait(this->p_event, this->EVENT_TIMEOUT_MS))
+		{
+			this->err_msg = TEXT("AudioBackend_WASAPI::waitFramesFree: Error: audio device event timed out.");
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WASAPI::writeFrames(const VOID *p_frames, SIZE_T n_frames)
+{
+	HRESULT n_ret = 0;
+	BYTE *p_audiobuffer = NULL;
+
+	if(this->p_audioout == NULL)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::writeFrames: Error: p_audioout is NULL.");
+		return FALSE;
+	}
+
+	n_ret = this->p_audioout->GetBuffer((UINT32) n_frames, &p_audiobuffer);
+	if(n_ret != S_OK)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::writeFrames: Error: IAudioRenderClient::GetBuffer failed.");
+		return FALSE;
+	}
+
+	if(p_frames == NULL) ZeroMemory(p_audiobuffer, n_frames*(this->FRAME_SIZE_BYTES));
+	else CopyMemory(p_audiobuffer, p_frames, n_frames*(this->FRAME_SIZE_BYTES));
+
+	n_ret = this->p_audioout->ReleaseBuffer((UINT32) n_frames, 0u);
+	if(n_ret != S_OK)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::writeFrames: Error: IAudioRenderClient::ReleaseBuffer failed.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WASAPI::canAcquireFrames(VOID)
+{
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WASAPI::acquireFrames(SIZE_T n_frames, VOID **pp_frames)
+{
+	HRESULT n_ret = 0;
+	BYTE *p_audiobuffer = NULL;
+
+	if(pp_frames == NULL)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::acquireFrames: Error: given frame pointer is null.");
+		return FALSE;
+	}
+
+	if(this->p_audioout == NULL)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::acquireFrames: Error: p_audioout is NULL.");
+		return FALSE;
+	}
+
+	n_ret = this->p_audioout->GetBuffer((UINT32) n_frames, &p_audiobuffer);
+	if(n_ret != S_OK)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::acquireFrames: Error: IAudioRenderClient::GetBuffer failed.");
+		return FALSE;
+	}
+
+	*pp_frames = (VOID*) p_audiobuffer;
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WASAPI::commitFrames(SIZE_T n_frames)
+{
+	HRESULT n_ret = 0;
+
+	if(this->p_audioout == NULL)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::commitFrames: Error: p_audioout is NULL.");
+		return FALSE;
+	}
+
+	n_ret = this->p_audioout->ReleaseBuffer((UINT32) n_frames, 0u);
+	if(n_ret != S_OK)
+	{
+		this->err_msg = TEXT("AudioBackend_WASAPI::commitFrames: Error: IAudioRenderClient::ReleaseBuffer failed.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*
+	client_init(): Initialize p_audiomgr (already activated) in exclusive mode with the given format, according to pacing_mode.
+	In PACING_EVENT mode, falls back to PACING_POLL if event driven initialization fails.
+	returns true if successful, false otherwise.
+*/
+
+BOOL WINAPI AudioBackend_WASAPI::client_init(const WAVEFORMATEX *p_wavfmt)
+{
+	HRESULT n_ret = 0;
+
+	if(this->pacing_mode == this->PACING_EVENT)
+	{
+		if(this->client_init_event(p_wavfmt)) return TRUE;
+
+		/*IAudioClient can't be initialized twice, get a new one before falling back*/
+		if(!this->client_reactivate()) return FALSE;
+
+		this->pacing_mode = this->PACING_POLL;
+	}
+
+	n_ret = this->p_audiomgr->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE, 0, 10000000, 0, p_wavfmt, NULL);
+	return (n_ret == S_OK);
+}
+
+BOOL WINAPI AudioBackend_WASAPI::client_init_event(const WAVEFORMATEX *p_wavfmt)
+{
+	HRESULT n_ret = 0;
+	REFERENCE_TIME period_default = 0;
+	REFERENCE_TIME period_min = 0;
+	UINT32 u32 = 0u;
+
+	n_ret = this->p_audiomgr->GetDevicePeriod(&period_default, &period_min);
+	if(n_ret != S_OK) return FALSE;
+
+	/*Event driven exclusive mode requires buffer duration == periodicity*/
+
+	n_ret = this->p_audiomgr->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE, AUDCLNT_STREAMFLAGS_EVENTCALLBACK, period_default, period_default, p_wavfmt, NULL);
+
+	if(n_ret == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED)
+	{
+		/*GetBufferSize returns the next aligned buffer size, retry with the matching duration*/
+
+		n_ret = this->p_audiomgr->GetBufferSize(&u32);
+		if(n_ret != S_OK) return FALSE;
+
+		period_default = (REFERENCE_TIME) ((10000000.0*((DOUBLE) u32))/((DOUBLE) this->format.sample_rate) + 0.5);
+
+		if(!this->client_reactivate()) return FALSE;
+
+		n_ret = this->p_audiomgr->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE, AUDCLNT_STREAMFLAGS_EVENTCALLBACK, period_default, period_default, p_wavfmt, NULL);
+	}
+
+	if(n_ret != S_OK) return FALSE;
+
+	if(this->p_event == NULL) this->p_event = event_create(FALSE);
+	if(this->p_event == NULL) return FALSE;
+
+	n_ret = this->p_audiomgr->SetEventHandle(this->p_event);
+	if(n_ret != S_OK)
+	{
+		event_destroy(&(this->p_event));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WASAPI::client_reactivate(VOID)
+{
+	HRESULT n_ret = 0;
+
+	if(this->p_audiomgr != NULL)
+	{
+		this->p_audiomgr->Release();
+		this->p_audiomgr = NULL;
+	}
+
+	if(this->p_audiodev == NULL) return FALSE;
+
+	n_ret = this->p_audiodev->Activate(__uuidof(IAudioClient), CLSCTX_ALL, NULL, (VOID**) &(this->p_audiomgr));
+	return (n_ret == S_OK);
+}
@@ -0,0 +1,87 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+/*
+	WASAPI Audio Backend:
+
+	Renders to a Windows audio device (MMDeviceAPI) in exclusive mode.
+	Free frames = audio buffer size - IAudioClient::GetCurrentPadding().
+	Output spans are the device buffer itself: acquireFrames() = IAudioRenderClient::GetBuffer(), commitFrames() = IAudioRenderClient::ReleaseBuffer().
+
+	Pacing Modes (how the play thread waits for room in the audio hardware buffer):
+
+	PACING_POLL: check the audio buffer padding every millisecond (Sleep(1)). Audio buffer is 1 second long.
+	Latency is quantized to the system scheduler tick.
+
+	PACING_EVENT: the stream is initialized with AUDCLNT_STREAMFLAGS_EVENTCALLBACK and the play thread sleeps on the device event,
+	which the audio engine signals every device period. Audio buffer is one device period long, allowing much smaller buffer segments.
+	Falls back to PACING_POLL if the audio device doesn't support event driven exclusive mode.
+*/
+
+#ifndef AUDIOBACKEND_WASAPI_HPP
+#define AUDIOBACKEND_WASAPI_HPP
+
+#include "AudioBackend.hpp"
+
+#include <mmdeviceapi.h>
+#include <audioclient.h>
+
+class AudioBackend_WASAPI : public AudioBackend {
+	public:
+		AudioBackend_WASAPI(VOID);
+		~AudioBackend_WASAPI(VOID);
+
+		enum PacingMode {
+			PACING_POLL = 0,
+			PACING_EVENT = 1
+		};
+
+		BOOL WINAPI setPacingMode(INT pacing_mode);
+		INT WINAPI getPacingMode(VOID);
+
+		BOOL WINAPI loadDeviceList(HWND p_listbox) override;
+		BOOL WINAPI chooseDevice(SIZE_T index) override;
+		BOOL WINAPI chooseDefaultDevice(VOID) override;
+
+		BOOL WINAPI open(const audiobackend_format_t *p_format) override;
+		VOID WINAPI close(VOID) override;
+		VOID WINAPI release(VOID) override;
+		BOOL WINAPI start(VOID) override;
+
+		BOOL WINAPI getFramesFree(SIZE_T *p_n_frames) override;
+		BOOL WINAPI waitFramesFree(SIZE_T n_frames) override;
+		BOOL WINAPI writeFrames(const VOID *p_frames, SIZE_T n_frames) override;
+
+		BOOL WINAPI canAcquireFrames(VOID) override;
+		BOOL WINAPI acquireFrames(SIZE_T n_frames, VOID **pp_frames) override;
+		BOOL WINAPI commitFrames(SIZE_T n_frames) override;
+
+	protected:
+		/*If the device event doesn't come within EVENT_TIMEOUT_MS, the device is assumed to have stalled.*/
+
+		static constexpr DWORD EVENT_TIMEOUT_MS = 2000u;
+
+		static constexpr SIZE_T DEVNAME_SIZE_CHARS = 256u;
+
+		IMMDeviceEnumerator *p_audiodevenum = NULL;
+		IMMDeviceCollection *p_audiodevcoll = NULL;
+
+		IMMDevice *p_audiodev = NULL;
+		IAudioClient *p_audiomgr = NULL;
+		IAudioRenderClient *p_audioout = NULL;
+
+		HANDLE p_event = NULL;
+
+		INT pacing_mode = this->PACING_POLL;
+
+		BOOL WINAPI client_init(const WAVEFORMATEX *p_wavfmt);
+		BOOL WINAPI client_init_event(const WAVEFORMATEX *p_wavfmt);
+		BOOL WINAPI client_reactivate(VOID);
+};
+
+#endif /*AUDIOBACKEND_WASAPI_HPP*/
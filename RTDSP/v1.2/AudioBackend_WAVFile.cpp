@@ -0,0 +1,394 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+#include "AudioBackend_WAVFile.hpp"
+
+AudioBackend_WAVFile::AudioBackend_WAVFile(const TCHAR *file_dir, SIZE_T audiobuffer_size_frames)
+{
+	if(file_dir != NULL) this->FILEOUT_DIR = file_dir;
+
+	this->BUFFER_SIZE_FRAMES = audiobuffer_size_frames;
+}
+
+AudioBackend_WAVFile::~AudioBackend_WAVFile(VOID)
+{
+	this->close();
+}
+
+BOOL WINAPI AudioBackend_WAVFile::open(const audiobackend_format_t *p_format)
+{
+	this->close();
+
+	if(!this->BUFFER_SIZE_FRAMES)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::open: Error: buffer size is zero.");
+		return FALSE;
+	}
+
+	if(!this->format_set(p_format)) return FALSE;
+
+	this->h_fileout = CreateFile(this->FILEOUT_DIR.c_str(), GENERIC_WRITE, (FILE_SHARE_READ | FILE_SHARE_WRITE), NULL, CREATE_ALWAYS, 0u, NULL);
+	if(this->h_fileout == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::open: Error: could not create output file.");
+		return FALSE;
+	}
+
+	this->n_frames_written = 0u;
+
+	if(!this->header_write())
+	{
+		this->close();
+		this->err_msg = TEXT("AudioBackend_WAVFile::open: Error: could not write file header.");
+		return FALSE;
+	}
+
+	this->PAGE_SIZE_FRAMES = (this->PAGE_SIZE_BYTES)/(this->FRAME_SIZE_BYTES);
+	if(this->PAGE_SIZE_FRAMES < this->BUFFER_SIZE_FRAMES) this->PAGE_SIZE_FRAMES = this->BUFFER_SIZE_FRAMES;
+
+	this->p_page = HeapAlloc(GetProcessHeap(), 0u, (this->PAGE_SIZE_FRAMES)*(this->FRAME_SIZE_BYTES));
+	if(this->p_page == NULL)
+	{
+		this->close();
+		this->err_msg = TEXT("AudioBackend_WAVFile::open: Error: memory allocate failed.");
+		return FALSE;
+	}
+
+	this->page_nframes = 0u;
+	this->page_nframes_acquired = 0u;
+
+	this->AUDIOBUFFER_SIZE_FRAMES = this->BUFFER_SIZE_FRAMES;
+	return TRUE;
+}
+
+VOID WINAPI AudioBackend_WAVFile::close(VOID)
+{
+	if(this->h_fileout == INVALID_HANDLE_VALUE) return;
+
+	/*Frames left in the write page were never written to the file*/
+
+	this->n_frames_written -= (ULONG64) this->page_nframes;
+	this->header_patch();
+
+	CloseHandle(this->h_fileout);
+	this->h_fileout = INVALID_HANDLE_VALUE;
+
+	if(this->p_page != NULL)
+	{
+		HeapFree(GetProcessHeap(), 0u, this->p_page);
+		this->p_page = NULL;
+	}
+
+	this->page_nframes = 0u;
+	this->page_nframes_acquired = 0u;
+
+	this->AUDIOBUFFER_SIZE_FRAMES = 0u;
+	return;
+}
+
+BOOL WINAPI AudioBackend_WAVFile::start(VOID)
+{
+	if(this->h_fileout == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::start: Error: output file is not open.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WAVFile::getFramesFree(SIZE_T *p_n_frames)
+{
+	if(p_n_frames == NULL) return FALSE;
+
+	*p_n_frames = this->AUDIOBUFFER_SIZE_FRAMES;
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WAVFile::waitFramesFree(SIZE_T n_frames)
+{
+	if(n_frames > this->AUDIOBUFFER_SIZE_FRAMES)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::waitFramesFree: Error: requested frames exceed the audio buffer size.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WAVFile::writeFrames(const VOID *p_frames, SIZE_T n_frames)
+{
+	static const BYTE ZEROBUF[ZEROBUF_SIZE_BYTES] = {0u};
+
+	SIZE_T size = 0u;
+	SIZE_T size_chunk = 0u;
+
+	if(this->h_fileout == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::writeFrames: Error: output file is not open.");
+		return FALSE;
+	}
+
+	if(!this->page_flush())
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::writeFrames: Error: could not write to output file.");
+		return FALSE;
+	}
+
+	size = n_frames*(this->FRAME_SIZE_BYTES);
+
+	if(p_frames != NULL)
+	{
+		if(!this->fileout_write(p_frames, size))
+		{
+			this->err_msg = TEXT("AudioBackend_WAVFile::writeFrames: Error: could not write to output file.");
+			return FALSE;
+		}
+	}
+	else while(size > 0u)
+	{
+		size_chunk = size;
+		if(size_chunk > this->ZEROBUF_SIZE_BYTES) size_chunk = this->ZEROBUF_SIZE_BYTES;
+
+		if(!this->fileout_write(ZEROBUF, size_chunk))
+		{
+			this->err_msg = TEXT("AudioBackend_WAVFile::writeFrames: Error: could not write to output file.");
+			return FALSE;
+		}
+
+		size -= size_chunk;
+	}
+
+	this->n_frames_written += (ULONG64) n_frames;
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WAVFile::canAcquireFrames(VOID)
+{
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WAVFile::acquireFrames(SIZE_T n_frames, VOID **pp_frames)
+{
+	if(pp_frames == NULL)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::acquireFrames: Error: given frame pointer is null.");
+		return FALSE;
+	}
+
+	if(this->h_fileout == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::acquireFrames: Error: output file is not open.");
+		return FALSE;
+	}
+
+	if(n_frames > this->AUDIOBUFFER_SIZE_FRAMES)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::acquireFrames: Error: requested frames exceed the audio buffer size.");
+		return FALSE;
+	}
+
+	if(n_frames > (this->PAGE_SIZE_FRAMES - this->page_nframes))
+	{
+		if(!this->page_flush())
+		{
+			this->err_msg = TEXT("AudioBackend_WAVFile::acquireFrames: Error: could not write to output file.");
+			return FALSE;
+		}
+	}
+
+	this->page_nframes_acquired = n_frames;
+
+	*pp_frames = (VOID*) (((SIZE_T) this->p_page) + (this->page_nframes)*(this->FRAME_SIZE_BYTES));
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WAVFile::commitFrames(SIZE_T n_frames)
+{
+	if(n_frames > this->page_nframes_acquired)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::commitFrames: Error: committed frames exceed the acquired span.");
+		return FALSE;
+	}
+
+	this->page_nframes += n_frames;
+	this->page_nframes_acquired = 0u;
+
+	this->n_frames_written += (ULONG64) n_frames;
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WAVFile::flush(VOID)
+{
+	if(this->h_fileout == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::flush: Error: output file is not open.");
+		return FALSE;
+	}
+
+	if(!this->page_flush())
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::flush: Error: could not write to output file.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+ULONG64 WINAPI AudioBackend_WAVFile::getFramesWritten(VOID)
+{
+	return this->n_frames_written;
+}
+
+BOOL WINAPI AudioBackend_WAVFile::reserveFrames(ULONG64 n_frames)
+{
+	LARGE_INTEGER file_pos;
+
+	if(this->h_fileout == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::reserveFrames: Error: output file is not open.");
+		return FALSE;
+	}
+
+	if(!this->page_flush())
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::reserveFrames: Error: could not write to output file.");
+		return FALSE;
+	}
+
+	file_pos.QuadPart = (LONG64) (((ULONG64) this->HEADER_SIZE_BYTES) + (this->n_frames_written + n_frames)*((ULONG64) this->FRAME_SIZE_BYTES));
+
+	if(!SetFilePointerEx(this->h_fileout, file_pos, NULL, FILE_BEGIN) || !SetEndOfFile(this->h_fileout))
+	{
+		this->err_msg = TEXT("AudioBackend_WAVFile::reserveFrames: Error: could not extend output file.");
+		return FALSE;
+	}
+
+	this->n_frames_written += n_frames;
+	return TRUE;
+}
+
+ULONG64 WINAPI AudioBackend_WAVFile::getDataOffset(VOID)
+{
+	return (ULONG64) this->HEADER_SIZE_BYTES;
+}
+
+/*
+	page_flush(): write the committed frames of the write page to the file (if any) and empty the page.
+*/
+
+BOOL WINAPI AudioBackend_WAVFile::page_flush(VOID)
+{
+	SIZE_T size = 0u;
+
+	if(!this->page_nframes) return TRUE;
+
+	size = (this->page_nframes)*(this->FRAME_SIZE_BYTES);
+	this->page_nframes = 0u;
+
+	return this->fileout_write(this->p_page, size);
+}
+
+BOOL WINAPI AudioBackend_WAVFile::fileout_write(const VOID *p_data, SIZE_T size)
+{
+	DWORD n_written = 0u;
+
+	if(!WriteFile(this->h_fileout, p_data, (DWORD) size, &n_written, NULL)) return FALSE;
+
+	return (((SIZE_T) n_written) == size);
+}
+
+/*
+	header_write(): write the RIFF/WAVE header at the beginning of the file, with data size = 0 (patched later by header_patch()).
+*/
+
+BOOL WINAPI AudioBackend_WAVFile::header_write(VOID)
+{
+	/*KSDATAFORMAT_SUBTYPE_PCM: 00000001-0000-0010-8000-00aa00389b71*/
+	static const BYTE SUBFORMAT_PCM[16] = {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71};
+
+	BYTE header[HEADER_EXTENSIBLE_SIZE_BYTES];
+	BOOL extensible = FALSE;
+	SIZE_T n_byte = 0u;
+	SIZE_T n_channel = 0u;
+	UINT32 channel_mask = 0u;
+
+	extensible = (this->format.valid_bits_per_sample < this->format.bits_per_sample);
+
+	if(extensible) this->HEADER_SIZE_BYTES = this->HEADER_EXTENSIBLE_SIZE_BYTES;
+	else this->HEADER_SIZE_BYTES = this->HEADER_PCM_SIZE_BYTES;
+
+	ZeroMemory(header, this->HEADER_EXTENSIBLE_SIZE_BYTES);
+
+	CopyMemory(&header[0], "RIFF", 4u);
+	*((UINT32*) &header[4]) = (UINT32) (this->HEADER_SIZE_BYTES - 8u);
+	CopyMemory(&header[8], "WAVE", 4u);
+
+	CopyMemory(&header[12], "fmt ", 4u);
+
+	if(extensible) *((UINT32*) &header[16]) = 40u;
+	else *((UINT32*) &header[16]) = 16u;
+
+	if(extensible) *((UINT16*) &header[20]) = 0xfffe; /*WAVE_FORMAT_EXTENSIBLE*/
+	else *((UINT16*) &header[20]) = 0x0001; /*WAVE_FORMAT_PCM*/
+
+	*((UINT16*) &header[22]) = this->format.n_channels;
+	*((UINT32*) &header[24]) = this->format.sample_rate;
+	*((UINT32*) &header[28]) = (UINT32) (this->format.sample_rate*(this->FRAME_SIZE_BYTES));
+	*((UINT16*) &header[32]) = (UINT16) this->FRAME_SIZE_BYTES;
+	*((UINT16*) &header[34]) = this->format.bits_per_sample;
+
+	n_byte = 36u;
+
+	if(extensible)
+	{
+		channel_mask = 0u;
+		for(n_channel = 0u; n_channel < this->format.n_channels; n_channel++) channel_mask |= (1 << n_channel);
+
+		*((UINT16*) &header[36]) = 22u;
+		*((UINT16*) &header[38]) = this->format.valid_bits_per_sample;
+		*((UINT32*) &header[40]) = channel_mask;
+		CopyMemory(&header[44], SUBFORMAT_PCM, 16u);
+
+		n_byte = 60u;
+	}
+
+	CopyMemory(&header[n_byte], "data", 4u);
+	*((UINT32*) &header[n_byte + 4u]) = 0u;
+
+	return this->fileout_write(header, this->HEADER_SIZE_BYTES);
+}
+
+/*
+	header_patch(): write the final RIFF chunk size and data subchunk size, based on the number of frames written.
+	Sizes are clamped to 32bit (files larger than 4GB are not valid RIFF files, but their audio data is still complete).
+*/
+
+VOID WINAPI AudioBackend_WAVFile::header_patch(VOID)
+{
+	ULONG64 data_size = 0u;
+	ULONG64 riff_size = 0u;
+	UINT32 u32 = 0u;
+	DWORD n_written = 0u;
+
+	data_size = this->n_frames_written*((ULONG64) this->FRAME_SIZE_BYTES);
+	riff_size = data_size + ((ULONG64) (this->HEADER_SIZE_BYTES - 8u));
+
+	if(riff_size > 0xffffffff) riff_size = 0xffffffff;
+	if(data_size > 0xffffffff) data_size = 0xffffffff;
+
+	u32 = (UINT32) riff_size;
+	SetFilePointer(this->h_fileout, 4, NULL, FILE_BEGIN);
+	WriteFile(this->h_fileout, &u32, 4u, &n_written, NULL);
+
+	u32 = (UINT32) data_size;
+	SetFilePointer(this->h_fileout, (LONG) (this->HEADER_SIZE_BYTES - 4u), NULL, FILE_BEGIN);
+	WriteFile(this->h_fileout, &u32, 4u, &n_written, NULL);
+
+	return;
+}
@@ -0,0 +1,102 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+/*
+	WAV File Audio Backend:
+
+	Writes every frame to a RIFF/WAVE file instead of an audio device. Needs no audio device and no Windows audio APIs.
+
+	The output never blocks (the whole buffer is always free), so the engine renders as fast as the CPU and the disk allow.
+	The file header is written on open() with placeholder sizes, which are patched on close().
+
+	Formats with valid_bits_per_sample < bits_per_sample (24bit on a 32bit container) are written as WAVE_FORMAT_EXTENSIBLE,
+	anything else as plain WAVE_FORMAT_PCM.
+
+	The file is shared for writing, so that other handles (AudioBackend_WAVRegion) may fill in frames reserved with reserveFrames().
+
+	Output spans (acquireFrames(), commitFrames()) are carved from a write page of about PAGE_SIZE_BYTES: committed frames pile up in the page,
+	which is written to the file in one go when the next span doesn't fit, and before any other file access (writeFrames(), reserveFrames(), flush()).
+	Committed frames count as written right away. close() discards whatever flush() didn't write, and sizes the header after the frames actually in the file.
+*/
+
+#ifndef AUDIOBACKEND_WAVFILE_HPP
+#define AUDIOBACKEND_WAVFILE_HPP
+
+#include "AudioBackend.hpp"
+
+class AudioBackend_WAVFile : public AudioBackend {
+	public:
+		AudioBackend_WAVFile(const TCHAR *file_dir, SIZE_T audiobuffer_size_frames);
+		~AudioBackend_WAVFile(VOID);
+
+		BOOL WINAPI open(const audiobackend_format_t *p_format) override;
+		VOID WINAPI close(VOID) override;
+		BOOL WINAPI start(VOID) override;
+
+		BOOL WINAPI getFramesFree(SIZE_T *p_n_frames) override;
+		BOOL WINAPI waitFramesFree(SIZE_T n_frames) override;
+		BOOL WINAPI writeFrames(const VOID *p_frames, SIZE_T n_frames) override;
+
+		BOOL WINAPI canAcquireFrames(VOID) override;
+		BOOL WINAPI acquireFrames(SIZE_T n_frames, VOID **pp_frames) override;
+		BOOL WINAPI commitFrames(SIZE_T n_frames) override;
+
+		BOOL WINAPI flush(VOID) override;
+
+		ULONG64 WINAPI getFramesWritten(VOID);
+
+		/*
+			reserveFrames(): extend the data chunk by n_frames frames (zero filled) without writing them.
+			Reserved frames count as written (they're part of the file size patched on close()).
+		*/
+
+		BOOL WINAPI reserveFrames(ULONG64 n_frames);
+
+		/*
+			getDataOffset(): file offset (bytes) of the first frame of the data chunk. Valid after open().
+		*/
+
+		ULONG64 WINAPI getDataOffset(VOID);
+
+	protected:
+		static constexpr SIZE_T HEADER_PCM_SIZE_BYTES = 44u;
+		static constexpr SIZE_T HEADER_EXTENSIBLE_SIZE_BYTES = 68u;
+
+		static constexpr SIZE_T ZEROBUF_SIZE_BYTES = 4096u;
+		static constexpr SIZE_T PAGE_SIZE_BYTES = 262144u;
+
+		HANDLE h_fileout = INVALID_HANDLE_VALUE;
+
+		__string FILEOUT_DIR = TEXT("");
+
+		SIZE_T BUFFER_SIZE_FRAMES = 0u;
+		SIZE_T HEADER_SIZE_BYTES = 0u;
+
+		ULONG64 n_frames_written = 0u;
+
+		/*
+			Write page:
+
+			p_page: page buffer, allocated on open() (PAGE_SIZE_FRAMES frames, never less than the audio buffer size).
+			page_nframes: number of committed frames in the page, not yet written to the file.
+			page_nframes_acquired: size of the last acquired span (starts at page_nframes).
+		*/
+
+		VOID *p_page = NULL;
+		SIZE_T PAGE_SIZE_FRAMES = 0u;
+		SIZE_T page_nframes = 0u;
+		SIZE_T page_nframes_acquired = 0u;
+
+		BOOL WINAPI page_flush(VOID);
+
+		BOOL WINAPI fileout_write(const VOID *p_data, SIZE_T size);
+		BOOL WINAPI header_write(VOID);
+		VOID WINAPI header_patch(VOID);
+};
+
+#endif /*AUDIOBACKEND_WAVFILE_HPP*/
@@ -0,0 +1,295 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+#include "AudioBackend_WAVRegion.hpp"
+
+AudioBackend_WAVRegion::AudioBackend_WAVRegion(const TCHAR *file_dir, ULONG64 data_offset, ULONG64 nframe_begin, ULONG64 n_frames_skip, ULONG64 n_frames, SIZE_T audiobuffer_size_frames)
+{
+	if(file_dir != NULL) this->FILEOUT_DIR = file_dir;
+
+	this->DATA_OFFSET = data_offset;
+	this->NFRAME_BEGIN = nframe_begin;
+	this->N_FRAMES_SKIP = n_frames_skip;
+	this->N_FRAMES = n_frames;
+
+	this->BUFFER_SIZE_FRAMES = audiobuffer_size_frames;
+}
+
+AudioBackend_WAVRegion::~AudioBackend_WAVRegion(VOID)
+{
+	this->close();
+}
+
+BOOL WINAPI AudioBackend_WAVRegion::open(const audiobackend_format_t *p_format)
+{
+	LARGE_INTEGER file_pos;
+
+	this->close();
+
+	if(!this->BUFFER_SIZE_FRAMES)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVRegion::open: Error: buffer size is zero.");
+		return FALSE;
+	}
+
+	if(!this->format_set(p_format)) return FALSE;
+
+	this->h_fileout = CreateFile(this->FILEOUT_DIR.c_str(), GENERIC_WRITE, (FILE_SHARE_READ | FILE_SHARE_WRITE), NULL, OPEN_EXISTING, 0u, NULL);
+	if(this->h_fileout == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVRegion::open: Error: could not open output file.");
+		return FALSE;
+	}
+
+	file_pos.QuadPart = (LONG64) (this->DATA_OFFSET + (this->NFRAME_BEGIN)*((ULONG64) this->FRAME_SIZE_BYTES));
+
+	if(!SetFilePointerEx(this->h_fileout, file_pos, NULL, FILE_BEGIN))
+	{
+		this->close();
+		this->err_msg = TEXT("AudioBackend_WAVRegion::open: Error: could not seek output file.");
+		return FALSE;
+	}
+
+	this->n_frames_in = 0u;
+	this->n_frames_written = 0u;
+
+	this->PAGE_SIZE_FRAMES = (this->PAGE_SIZE_BYTES)/(this->FRAME_SIZE_BYTES);
+	if(this->PAGE_SIZE_FRAMES < this->BUFFER_SIZE_FRAMES) this->PAGE_SIZE_FRAMES = this->BUFFER_SIZE_FRAMES;
+
+	this->p_page = HeapAlloc(GetProcessHeap(), 0u, (this->PAGE_SIZE_FRAMES)*(this->FRAME_SIZE_BYTES));
+	if(this->p_page == NULL)
+	{
+		this->close();
+		this->err_msg = TEXT("AudioBackend_WAVRegion::open: Error: memory allocate failed.");
+		return FALSE;
+	}
+
+	this->page_nframes = 0u;
+	this->page_nframes_acquired = 0u;
+
+	this->AUDIOBUFFER_SIZE_FRAMES = this->BUFFER_SIZE_FRAMES;
+	return TRUE;
+}
+
+VOID WINAPI AudioBackend_WAVRegion::close(VOID)
+{
+	if(this->h_fileout == INVALID_HANDLE_VALUE) return;
+
+	CloseHandle(this->h_fileout);
+	this->h_fileout = INVALID_HANDLE_VALUE;
+
+	if(this->p_page != NULL)
+	{
+		HeapFree(GetProcessHeap(), 0u, this->p_page);
+		this->p_page = NULL;
+	}
+
+	this->page_nframes = 0u;
+	this->page_nframes_acquired = 0u;
+
+	this->AUDIOBUFFER_SIZE_FRAMES = 0u;
+	return;
+}
+
+BOOL WINAPI AudioBackend_WAVRegion::start(VOID)
+{
+	if(this->h_fileout == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVRegion::start: Error: output file is not open.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WAVRegion::getFramesFree(SIZE_T *p_n_frames)
+{
+	if(p_n_frames == NULL) return FALSE;
+
+	*p_n_frames = this->AUDIOBUFFER_SIZE_FRAMES;
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WAVRegion::waitFramesFree(SIZE_T n_frames)
+{
+	if(n_frames > this->AUDIOBUFFER_SIZE_FRAMES)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVRegion::waitFramesFree: Error: requested frames exceed the audio buffer size.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WAVRegion::writeFrames(const VOID *p_frames, SIZE_T n_frames)
+{
+	if(this->h_fileout == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVRegion::writeFrames: Error: output file is not open.");
+		return FALSE;
+	}
+
+	if(!this->page_flush()) return FALSE;
+
+	return this->region_write(p_frames, n_frames);
+}
+
+BOOL WINAPI AudioBackend_WAVRegion::canAcquireFrames(VOID)
+{
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WAVRegion::acquireFrames(SIZE_T n_frames, VOID **pp_frames)
+{
+	if(pp_frames == NULL)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVRegion::acquireFrames: Error: given frame pointer is null.");
+		return FALSE;
+	}
+
+	if(this->h_fileout == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVRegion::acquireFrames: Error: output file is not open.");
+		return FALSE;
+	}
+
+	if(n_frames > this->AUDIOBUFFER_SIZE_FRAMES)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVRegion::acquireFrames: Error: requested frames exceed the audio buffer size.");
+		return FALSE;
+	}
+
+	if(n_frames > (this->PAGE_SIZE_FRAMES - this->page_nframes))
+	{
+		if(!this->page_flush()) return FALSE;
+	}
+
+	this->page_nframes_acquired = n_frames;
+
+	*pp_frames = (VOID*) (((SIZE_T) this->p_page) + (this->page_nframes)*(this->FRAME_SIZE_BYTES));
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WAVRegion::commitFrames(SIZE_T n_frames)
+{
+	if(n_frames > this->page_nframes_acquired)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVRegion::commitFrames: Error: committed frames exceed the acquired span.");
+		return FALSE;
+	}
+
+	this->page_nframes += n_frames;
+	this->page_nframes_acquired = 0u;
+	return TRUE;
+}
+
+/*
+	page_flush(): write the committed frames of the write page to the region (if any) and empty the page.
+*/
+
+BOOL WINAPI AudioBackend_WAVRegion::page_flush(VOID)
+{
+	SIZE_T n_frames = 0u;
+
+	if(!this->page_nframes) return TRUE;
+
+	n_frames = this->page_nframes;
+	this->page_nframes = 0u;
+
+	return this->region_write(this->p_page, n_frames);
+}
+
+/*
+	region_write(): write n_frames frames (silence if p_frames is NULL) to the region, discarding the frames outside of it.
+*/
+
+BOOL WINAPI AudioBackend_WAVRegion::region_write(const VOID *p_frames, SIZE_T n_frames)
+{
+	static const BYTE ZEROBUF[ZEROBUF_SIZE_BYTES] = {0u};
+
+	ULONG64 n_skip = 0u;
+	ULONG64 n_write = 0u;
+	SIZE_T size = 0u;
+	SIZE_T size_chunk = 0u;
+
+	if(this->h_fileout == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVRegion::region_write: Error: output file is not open.");
+		return FALSE;
+	}
+
+	/*Discard the frames before the region (n_skip) and past the end of the region*/
+
+	if(this->n_frames_in < this->N_FRAMES_SKIP) n_skip = this->N_FRAMES_SKIP - this->n_frames_in;
+	if(n_skip > (ULONG64) n_frames) n_skip = (ULONG64) n_frames;
+
+	this->n_frames_in += (ULONG64) n_frames;
+
+	n_write = ((ULONG64) n_frames) - n_skip;
+	if(n_write > (this->N_FRAMES - this->n_frames_written)) n_write = this->N_FRAMES - this->n_frames_written;
+
+	if(!n_write) return TRUE;
+
+	size = ((SIZE_T) n_write)*(this->FRAME_SIZE_BYTES);
+
+	if(p_frames != NULL)
+	{
+		if(!this->fileout_write((const VOID*) (((SIZE_T) p_frames) + ((SIZE_T) n_skip)*(this->FRAME_SIZE_BYTES)), size))
+		{
+			this->err_msg = TEXT("AudioBackend_WAVRegion::region_write: Error: could not write to output file.");
+			return FALSE;
+		}
+	}
+	else while(size > 0u)
+	{
+		size_chunk = size;
+		if(size_chunk > this->ZEROBUF_SIZE_BYTES) size_chunk = this->ZEROBUF_SIZE_BYTES;
+
+		if(!this->fileout_write(ZEROBUF, size_chunk))
+		{
+			this->err_msg = TEXT("AudioBackend_WAVRegion::region_write: Error: could not write to output file.");
+			return FALSE;
+		}
+
+		size -= size_chunk;
+	}
+
+	this->n_frames_written += n_write;
+	return TRUE;
+}
+
+BOOL WINAPI AudioBackend_WAVRegion::flush(VOID)
+{
+	if(this->h_fileout == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioBackend_WAVRegion::flush: Error: output file is not open.");
+		return FALSE;
+	}
+
+	if(!this->page_flush())
+	{
+		this->err_msg = TEXT("AudioBackend_WAVRegion::flush: Error: could not write to output file.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+ULONG64 WINAPI AudioBackend_WAVRegion::getFramesWritten(VOID)
+{
+	return this->n_frames_written;
+}
+
+BOOL WINAPI AudioBackend_WAVRegion::fileout_write(const VOID *p_data, SIZE_T size)
+{
+	DWORD n_written = 0u;
+
+	if(!WriteFile(this->h_fileout, p_data, (DWORD) size, &n_written, NULL)) return FALSE;
+
+	return (((SIZE_T) n_written) == size);
+}
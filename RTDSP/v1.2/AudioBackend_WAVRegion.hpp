@@ -0,0 +1,83 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+/*
+	WAV Region Audio Backend:
+
+	Writes frames into a region of the data chunk of an existing RIFF/WAVE file (created by AudioBackend_WAVFile, region reserved with reserveFrames()).
+	Does not touch the file header. Several of these may write different regions of the same file at the same time, each one on its own file handle.
+
+	data_offset: file offset (bytes) of the first frame of the data chunk (AudioBackend_WAVFile::getDataOffset()).
+	nframe_begin: index of the first frame of the region within the data chunk.
+	n_frames_skip: number of frames written to the backend that are discarded before the region starts.
+	n_frames: region length. Frames written past the end of the region are discarded.
+
+	The output never blocks (the whole buffer is always free).
+
+	Output spans are carved from a write page, the same way as AudioBackend_WAVFile: committed frames are written to the region when the page is full,
+	and before writeFrames() and flush(). getFramesWritten() only counts frames that left the page. close() discards whatever flush() didn't write.
+*/
+
+#ifndef AUDIOBACKEND_WAVREGION_HPP
+#define AUDIOBACKEND_WAVREGION_HPP
+
+#include "AudioBackend.hpp"
+
+class AudioBackend_WAVRegion : public AudioBackend {
+	public:
+		AudioBackend_WAVRegion(const TCHAR *file_dir, ULONG64 data_offset, ULONG64 nframe_begin, ULONG64 n_frames_skip, ULONG64 n_frames, SIZE_T audiobuffer_size_frames);
+		~AudioBackend_WAVRegion(VOID);
+
+		BOOL WINAPI open(const audiobackend_format_t *p_format) override;
+		VOID WINAPI close(VOID) override;
+		BOOL WINAPI start(VOID) override;
+
+		BOOL WINAPI getFramesFree(SIZE_T *p_n_frames) override;
+		BOOL WINAPI waitFramesFree(SIZE_T n_frames) override;
+		BOOL WINAPI writeFrames(const VOID *p_frames, SIZE_T n_frames) override;
+
+		BOOL WINAPI canAcquireFrames(VOID) override;
+		BOOL WINAPI acquireFrames(SIZE_T n_frames, VOID **pp_frames) override;
+		BOOL WINAPI commitFrames(SIZE_T n_frames) override;
+
+		BOOL WINAPI flush(VOID) override;
+
+		ULONG64 WINAPI getFramesWritten(VOID);
+
+	protected:
+		static constexpr SIZE_T ZEROBUF_SIZE_BYTES = 4096u;
+		static constexpr SIZE_T PAGE_SIZE_BYTES = 262144u;
+
+		HANDLE h_fileout = INVALID_HANDLE_VALUE;
+
+		__string FILEOUT_DIR = TEXT("");
+
+		SIZE_T BUFFER_SIZE_FRAMES = 0u;
+
+		ULONG64 DATA_OFFSET = 0u;
+		ULONG64 NFRAME_BEGIN = 0u;
+		ULONG64 N_FRAMES_SKIP = 0u;
+		ULONG64 N_FRAMES = 0u;
+
+		ULONG64 n_frames_in = 0u;
+		ULONG64 n_frames_written = 0u;
+
+		/*Write page (see AudioBackend_WAVFile)*/
+
+		VOID *p_page = NULL;
+		SIZE_T PAGE_SIZE_FRAMES = 0u;
+		SIZE_T page_nframes = 0u;
+		SIZE_T page_nframes_acquired = 0u;
+
+		BOOL WINAPI page_flush(VOID);
+		BOOL WINAPI region_write(const VOID *p_frames, SIZE_T n_frames);
+
+		BOOL WINAPI fileout_write(const VOID *p_data, SIZE_T size);
+};
+
+#endif /*AUDIOBACKEND_WAVREGION_HPP*/
@@ -9,11 +9,82 @@
 #include "AudioRTDSP.hpp"
 #include "cstrdef.h"
 #include "thread.h"
-#include <combaseapi.h>
+#include <stdarg.h>
+#ifdef _WIN32
+#include "AudioBackend_WASAPI.hpp"
+#else
+#include "AudioBackend_Null.hpp"
+#endif
+#include "AudioBackend_WAVFile.hpp"
+#include "AudioBackend_WAVRegion.hpp"
+
+/*
+	Telemetry hooks: compile to nothing unless __RTDSP_TELEMETRY is defined (see config.h).
+
+	TELEMETRY_VAR(qpc): declare a timestamp.
+	TELEMETRY_BEGIN(qpc): take a timestamp.
+	TELEMETRY_END(n_stage, qpc): record the time elapsed since the timestamp for the stage n_stage (see TelemetryStage).
+*/
+
+#ifdef __RTDSP_TELEMETRY
+#define TELEMETRY_VAR(qpc) LARGE_INTEGER qpc
+#define TELEMETRY_BEGIN(qpc) QueryPerformanceCounter(&(qpc))
+#define TELEMETRY_END(n_stage, qpc) this->telemetry_end(n_stage, &(qpc))
+#define TELEMETRY_PUSH() this->telemetry_push()
+#define TELEMETRY_POP() this->telemetry_pop()
+#define TELEMETRY_PADDING() this->telemetry_padding()
+#else
+#define TELEMETRY_VAR(qpc)
+#define TELEMETRY_BEGIN(qpc)
+#define TELEMETRY_END(n_stage, qpc)
+#define TELEMETRY_PUSH()
+#define TELEMETRY_POP()
+#define TELEMETRY_PADDING()
+#endif
 
 AudioRTDSP::AudioRTDSP(const audiortdsp_pb_params_t *p_params)
 {
+	SIZE_T n_slot = 0u;
+
+	this->p_heap = HeapCreate(0u, 0u, 0u);
+	if(this->p_heap == NULL) this->p_heap = GetProcessHeap();
+
+	this->p_dspkernel = dspkernel_get_table();
+#ifdef _WIN32
+	this->p_backend = new AudioBackend_WASAPI();
+#else
+	/*No audio device backend outside Windows: real time null output (4096 frame buffer) until setAudioBackend() replaces it*/
+	this->p_backend = new AudioBackend_Null(4096u, TRUE);
+#endif
 	this->setPlaybackParameters(p_params);
+
+	ZeroMemory(this->dspsnaps, sizeof(this->dspsnaps));
+	ZeroMemory(&(this->dspsnap_hold), sizeof(audiortdsp_dspsnap_t));
+	ZeroMemory(&(this->dspsnap_xfade), sizeof(audiortdsp_dspsnap_t));
+	ZeroMemory(this->cmdqueue, sizeof(this->cmdqueue));
+	ZeroMemory(this->cmd_pending, sizeof(this->cmd_pending));
+	ZeroMemory(&(this->dspengine_params), sizeof(audiortdsp_fx_params_t));
+	ZeroMemory(this->dspengine_versions, sizeof(this->dspengine_versions));
+	ZeroMemory(this->dsp_params_versions, sizeof(this->dsp_params_versions));
+
+	for(n_slot = 0u; n_slot < this->CMDQUEUE_SIZE; n_slot++) this->cmdqueue[n_slot].seq = (LONG) n_slot;
+}
+
+AudioRTDSP::~AudioRTDSP(VOID)
+{
+	if(this->p_backend != NULL)
+	{
+		delete this->p_backend;
+		this->p_backend = NULL;
+	}
+
+	/*Derived destructors have already freed the buffers*/
+
+	this->filein_close();
+	this->arena_release();
+
+	if((this->p_heap != NULL) && (this->p_heap != GetProcessHeap())) HeapDestroy(this->p_heap);
+	this->p_heap = NULL;
 }
 
 BOOL WINAPI AudioRTDSP::setPlaybackParameters(const audiortdsp_pb_params_t *p_params)
@@ -34,6 +105,125 @@ BOOL WINAPI AudioRTDSP::setPlaybackParameters(const audiortdsp_pb_params_t *p_pa
 	return TRUE;
 }
 
+BOOL WINAPI AudioRTDSP::setBufferDepth(SIZE_T n_segments)
+{
+	if(this->status > 0) return FALSE;
+
+	if((n_segments < this->BUFFEROUT_MIN_N_SEGMENTS) || (n_segments > this->BUFFEROUT_MAX_N_SEGMENTS))
+	{
+		this->err_msg = TEXT("AudioRTDSP::setBufferDepth: Error: given buffer depth is out of range.");
+		return FALSE;
+	}
+
+	this->BUFFEROUT_N_SEGMENTS = n_segments;
+	return TRUE;
+}
+
+/*
+	setAudioBackend(): replace the audio output. The AudioRTDSP object takes ownership of p_backend (deletes it when no longer used).
+	Device selection (loadAudioDeviceList(), chooseDevice(), chooseDefaultDevice()) applies to the backend set at that time.
+*/
+
+BOOL WINAPI AudioRTDSP::setAudioBackend(AudioBackend *p_backend)
+{
+	if(this->status > 0) return FALSE;
+
+	if(p_backend == NULL)
+	{
+		this->err_msg = TEXT("AudioRTDSP::setAudioBackend: Error: given backend object pointer is null.");
+		return FALSE;
+	}
+
+	if(p_backend == this->p_backend) return TRUE;
+
+	if(this->p_backend != NULL) delete this->p_backend;
+
+	this->p_backend = p_backend;
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::enableMappedInput(BOOL enable)
+{
+	if(this->status > 0) return FALSE;
+
+	this->filein_map_enable = enable;
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::enableDirectOutput(BOOL enable)
+{
+	if(this->status > 0) return FALSE;
+
+	this->bufferout_direct_enable = enable;
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::enableLargePageArena(BOOL enable)
+{
+	if(this->status > 0) return FALSE;
+
+	this->arena_large_pages = enable;
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::enableAdaptiveDepth(BOOL enable)
+{
+	if(this->status > 0) return FALSE;
+
+	this->depth_adapt = enable;
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::setDeadlineMargin(UINT32 margin_pct)
+{
+	if(this->status > 0) return FALSE;
+
+	if(margin_pct > this->DEPTH_MAX_MARGIN_PCT)
+	{
+		this->err_msg = TEXT("AudioRTDSP::setDeadlineMargin: Error: given margin is out of range.");
+		return FALSE;
+	}
+
+	this->depth_margin_pct = margin_pct;
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::enableDeadlineWatchdog(BOOL enable)
+{
+	if(this->status > 0) return FALSE;
+
+	this->watchdog_enable = enable;
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::setDegradeTapIndex(SIZE_T n_taps)
+{
+	if(this->status > 0) return FALSE;
+
+	if(n_taps > 0x7fffffff)
+	{
+		this->err_msg = TEXT("AudioRTDSP::setDegradeTapIndex: Error: given tap index is out of range.");
+		return FALSE;
+	}
+
+	this->DEGRADE_MIN_TAPS = (INT32) n_taps;
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::setReadAheadSize(SIZE_T n_bytes)
+{
+	if(this->status > 0) return FALSE;
+
+	if(n_bytes > this->READAHEAD_MAX_SIZE_BYTES)
+	{
+		this->err_msg = TEXT("AudioRTDSP::setReadAheadSize: Error: given read-ahead size is too big.");
+		return FALSE;
+	}
+
+	this->READAHEAD_SIZE_BYTES = n_bytes;
+	return TRUE;
+}
+
 BOOL WINAPI AudioRTDSP::initialize(VOID)
 {
 	if(this->status > 0) return TRUE;
@@ -54,6 +244,12 @@ BOOL WINAPI AudioRTDSP::initialize(VOID)
 		return FALSE;
 	}
 
+	this->filein_map();
+
+	/*No read-ahead means one synchronous read per segment, playback still works*/
+
+	this->readahead_init();
+
 	if(!this->buffer_alloc())
 	{
 		this->status = this->STATUS_ERROR_MEMALLOC;
@@ -69,414 +265,3388 @@ BOOL WINAPI AudioRTDSP::initialize(VOID)
 
 BOOL WINAPI AudioRTDSP::runPlayback(VOID)
 {
+	BOOL ret = FALSE;
+
 	if(this->status < 1) return FALSE;
 
 	this->status = this->STATUS_PLAYING;
-	this->playback_proc();
+	ret = this->playback_proc();
+
+	this->cmd_discard();
 
 	this->filein_close();
 	this->audio_hw_deinit_device();
 	this->buffer_free();
 
-	this->status = this->STATUS_UNINITIALIZED;
-	return TRUE;
+	if(ret) this->status = this->STATUS_UNINITIALIZED;
+	else this->status = this->STATUS_ERROR_GENERIC;
+
+	return ret;
 }
 
 VOID WINAPI AudioRTDSP::stopPlayback(VOID)
 {
-	this->stop_playback = TRUE;
+	InterlockedExchange(&(this->stop_playback), 1);
 	return;
 }
 
-BOOL WINAPI AudioRTDSP::loadAudioDeviceList(HWND p_listbox)
+BOOL WINAPI AudioRTDSP::runRender(const audiortdsp_fx_params_t *p_fx_params, const TCHAR *fileout_dir, audiortdsp_render_stats_t *p_stats)
+{
+	AudioBackend *p_backend_prev = NULL;
+	BOOL ret = FALSE;
+	ULONG64 n_frames = 0u;
+	DOUBLE elapsed_sec = 0.0;
+
+	if(this->status > 0) return FALSE;
+
+	if(fileout_dir == NULL)
+	{
+		this->err_msg = TEXT("AudioRTDSP::runRender: Error: given output file directory is null.");
+		return FALSE;
+	}
+
+	/*Swap in a WAV file output for the whole render*/
+
+	p_backend_prev = this->p_backend;
+	this->p_backend = new AudioBackend_WAVFile(fileout_dir, this->RENDER_BUFFER_SIZE_FRAMES);
+
+	ret = this->render_session(p_fx_params, &n_frames, &elapsed_sec);
+
+	if(ret) this->render_stats_set(p_stats, n_frames, elapsed_sec);
+
+	delete this->p_backend;
+	this->p_backend = p_backend_prev;
+
+	return ret;
+}
+
+BOOL WINAPI AudioRTDSP::runRenderParallel(const audiortdsp_fx_params_t *p_fx_params, const TCHAR *fileout_dir, SIZE_T n_threads, audiortdsp_render_stats_t *p_stats)
 {
-	const PROPERTYKEY* const P_PKEY = (const PROPERTYKEY*) P_PKEY_Device_FriendlyName;
-	IMMDevice *p_dev = NULL;
-	IPropertyStore *p_devprop = NULL;
-	HRESULT n_ret = 0;
-	UINT devcoll_count = 0u;
-	UINT n_dev = 0u;
-	PROPVARIANT propvar;
+	AudioBackend *p_backend_prev = NULL;
+	AudioBackend_WAVFile *p_wavfile = NULL;
+	const audiortdsp_fx_params_t *p_fx_render = NULL;
+	thread_worker_t *p_workers = NULL;
+	SIZE_T n_workers = 0u;
+	SIZE_T n_worker = 0u;
+	SIZE_T n_chunk = 0u;
+	BOOL ret = FALSE;
+
+	ULONG64 n_frames = 0u;
+	ULONG64 chunk_frames = 0u;
+
+	SYSTEM_INFO sysinfo;
+
+	LARGE_INTEGER qpc_freq;
+	LARGE_INTEGER qpc_begin;
+	LARGE_INTEGER qpc_end;
 
 	if(this->status > 0) return FALSE;
 
-	/*If p_listbox is NULL, all functions to listbox will fail, but the audio device initialization shall continue normally.*/
+	if(fileout_dir == NULL)
+	{
+		this->err_msg = TEXT("AudioRTDSP::runRenderParallel: Error: given output file directory is null.");
+		return FALSE;
+	}
+
+	/*The recursive comb state can't be rebuilt from a bounded history, the render is sequential in that mode (given parameters, or the current ones if none given)*/
+
+	if(p_fx_params != NULL) p_fx_render = p_fx_params;
+	else p_fx_render = &(this->dsp_params);
+
+	if(p_fx_render->recursive_comb) return this->runRender(p_fx_params, fileout_dir, p_stats);
+
+	if(this->cmdqueue_push != this->cmdqueue_pop) return this->runRender(p_fx_params, fileout_dir, p_stats);
+
+	if(!n_threads)
+	{
+		GetSystemInfo(&sysinfo);
+		n_threads = (SIZE_T) sysinfo.dwNumberOfProcessors;
+	}
+
+	if(n_threads > this->RENDER_MAX_N_THREADS) n_threads = this->RENDER_MAX_N_THREADS;
+	if(!n_threads) n_threads = 1u;
+
+	/*
+		This object only writes the output file header and reserves the whole data chunk.
+		The chunks are rendered by other objects of the same type, each one writing its own region of the data chunk.
+	*/
+
+	p_backend_prev = this->p_backend;
+	p_wavfile = new AudioBackend_WAVFile(fileout_dir, this->RENDER_BUFFER_SIZE_FRAMES);
+	this->p_backend = p_wavfile;
+
+	if(!this->initialize()) goto _l_runrenderparallel_restore;
+
+	if(p_fx_params != NULL)
+	{
+		if(!this->render_set_fx(p_fx_params)) goto _l_runrenderparallel_deinit;
+	}
+
+	this->status = this->STATUS_PLAYING;
+	this->stop_playback = 0;
+	this->playback_error = 0;
+
+	/*This object doesn't read the input file, the render threads add up their read statistics here*/
+
+	this->io_stats_reset();
+
+	QueryPerformanceFrequency(&qpc_freq);
+	QueryPerformanceCounter(&qpc_begin);
+
+	n_frames = (this->AUDIO_DATA_END - this->AUDIO_DATA_BEGIN)/((ULONG64) this->FILEIN_FRAME_SIZE_BYTES);
+
+	if(!p_wavfile->reserveFrames(n_frames))
+	{
+		this->err_msg = p_wavfile->getLastErrorMessage();
+		goto _l_runrenderparallel_deinit;
+	}
+
+	/*Chunk layout*/
+
+	/*History: the farthest delayed input frame any tap (or the comb correction tap) may read, n_delay*(n_feedback + 2)*/
+
+	this->render_history_frames = ((ULONG64) this->dsp_params.n_delay)*((ULONG64) (this->dsp_params.n_feedback + 2));
+	this->render_data_offset = p_wavfile->getDataOffset();
+	this->render_fileout_dir = fileout_dir;
+
+	this->render_n_chunks = n_threads*(this->RENDER_CHUNKS_PER_THREAD);
+
+	while(this->render_n_chunks > 1u)
+	{
+		chunk_frames = n_frames/((ULONG64) this->render_n_chunks);
+
+		if((chunk_frames >= this->RENDER_MIN_CHUNK_FRAMES) && (chunk_frames >= (this->render_history_frames)*(this->RENDER_MIN_CHUNK_HISTORY_RATIO))) break;
+
+		this->render_n_chunks--;
+	}
+
+	this->p_render_chunks = (audiortdsp_render_chunk_t*) HeapAlloc(this->p_heap, HEAP_ZERO_MEMORY, (this->render_n_chunks)*sizeof(audiortdsp_render_chunk_t));
+	if(this->p_render_chunks == NULL)
+	{
+		this->err_msg = TEXT("AudioRTDSP::runRenderParallel: Error: memory allocate failed.");
+		goto _l_runrenderparallel_deinit;
+	}
+
+	for(n_chunk = 0u; n_chunk < this->render_n_chunks; n_chunk++)
+	{
+		this->p_render_chunks[n_chunk].nframe_begin = (n_frames*((ULONG64) n_chunk))/((ULONG64) this->render_n_chunks);
+		this->p_render_chunks[n_chunk].nframe_end = (n_frames*((ULONG64) (n_chunk + 1u)))/((ULONG64) this->render_n_chunks);
+	}
+
+	/*Render threads*/
+
+	n_workers = n_threads;
+	if(n_workers > this->render_n_chunks) n_workers = this->render_n_chunks;
+
+	p_workers = (thread_worker_t*) HeapAlloc(this->p_heap, HEAP_ZERO_MEMORY, n_workers*sizeof(thread_worker_t));
+	if(p_workers == NULL)
+	{
+		this->err_msg = TEXT("AudioRTDSP::runRenderParallel: Error: memory allocate failed.");
+		goto _l_runrenderparallel_deinit;
+	}
+
+	this->render_chunk_next = 0;
+
+	for(n_worker = 0u; n_worker < n_workers; n_worker++)
+	{
+		if(!thread_worker_create(&p_workers[n_worker], ((DWORD (WINAPI *)(VOID*)) &AudioRTDSP::renderthread_proc), this))
+		{
+			this->playback_fail(TEXT("AudioRTDSP::runRenderParallel: Error: could not create render thread."));
+			break;
+		}
+
+		thread_worker_run(&p_workers[n_worker]);
+	}
+
+	n_workers = n_worker;
+
+	for(n_worker = 0u; n_worker < n_workers; n_worker++)
+	{
+		thread_worker_wait(&p_workers[n_worker]);
+		thread_worker_destroy(&p_workers[n_worker]);
+	}
+
+	QueryPerformanceCounter(&qpc_end);
+
+	ret = !this->playback_error;
+
+	/*Aborted with stopPlayback()*/
+
+	if(ret && ((SIZE_T) this->render_chunk_next) < this->render_n_chunks)
+	{
+		this->err_msg = TEXT("AudioRTDSP::runRenderParallel: Error: render aborted.");
+		ret = FALSE;
+	}
+
+	if(ret) this->render_stats_set(p_stats, n_frames, ((DOUBLE) (qpc_end.QuadPart - qpc_begin.QuadPart))/((DOUBLE) qpc_freq.QuadPart));
 
-	listbox_clear(p_listbox);
+_l_runrenderparallel_deinit:
+	if(p_workers != NULL) HeapFree(this->p_heap, 0u, p_workers);
 
-	this->audio_hw_deinit_all();
+	if(this->p_render_chunks != NULL)
+	{
+		HeapFree(this->p_heap, 0u, this->p_render_chunks);
+		this->p_render_chunks = NULL;
+	}
+
+	this->render_n_chunks = 0u;
+
+	this->filein_close();
+	this->audio_hw_deinit_device();
+	this->buffer_free();
+
+	this->status = this->STATUS_UNINITIALIZED;
+
+_l_runrenderparallel_restore:
+	delete this->p_backend;
+	this->p_backend = p_backend_prev;
+
+	return ret;
+}
+
+BOOL WINAPI AudioRTDSP::loadAudioDeviceList(HWND p_listbox)
+{
+	if(this->status > 0) return FALSE;
 
-	n_ret = CoCreateInstance(__uuidof(MMDeviceEnumerator), NULL, CLSCTX_ALL, __uuidof(IMMDeviceEnumerator), (VOID**) &(this->p_audiodevenum));
-	if(n_ret != S_OK)
+	if(!this->p_backend->loadDeviceList(p_listbox))
 	{
-		this->err_msg = TEXT("AudioRTDSP::loadAudioDeviceList: Error: CoCreateInstance (IMMDeviceEnumerator) failed.");
+		this->err_msg = this->p_backend->getLastErrorMessage();
 		return FALSE;
 	}
 
-	n_ret = this->p_audiodevenum->EnumAudioEndpoints(eRender, DEVICE_STATE_ACTIVE, &(this->p_audiodevcoll));
-	if(n_ret != S_OK)
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::chooseDevice(SIZE_T index)
+{
+	if(this->status > 0) return FALSE;
+
+	if(!this->p_backend->chooseDevice(index))
 	{
-		this->audio_hw_deinit_all();
-		this->err_msg = TEXT("AudioRTDSP::loadAudioDeviceList: Error: IMMDeviceEnumerator::EnumAudioEndpoints failed.");
+		this->err_msg = this->p_backend->getLastErrorMessage();
 		return FALSE;
 	}
 
-	n_ret = this->p_audiodevcoll->GetCount(&devcoll_count);
-	if(n_ret != S_OK)
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::chooseDefaultDevice(VOID)
+{
+	if(this->status > 0) return FALSE;
+
+	if(!this->p_backend->chooseDefaultDevice())
 	{
-		this->audio_hw_deinit_all();
-		this->err_msg = TEXT("AudioRTDSP::loadAudioDeviceList: Error: IMMDeviceCollection::GetCount failed.");
+		this->err_msg = this->p_backend->getLastErrorMessage();
 		return FALSE;
 	}
 
-	for(n_dev = 0u; n_dev < devcoll_count; n_dev++)
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::getFXParams(audiortdsp_fx_params_t *p_params)
+{
+	if(this->status < 1) return FALSE;
+
+	if(p_params == NULL)
 	{
-		n_ret = this->p_audiodevcoll->Item(n_dev, &p_dev);
-		if(n_ret != S_OK)
-		{
-			this->audio_hw_deinit_all();
-			this->err_msg = TEXT("AudioRTDSP::loadAudioDeviceList: Error: IMMDeviceCollection::Item failed.");
-			return FALSE;
-		}
+		this->err_msg = TEXT("AudioRTDSP::getFXParams: Error: given params object pointer is null.");
+		return FALSE;
+	}
 
-		n_ret = p_dev->OpenPropertyStore(STGM_READ, &p_devprop);
-		if(n_ret != S_OK)
-		{
-			p_dev->Release();
-			this->audio_hw_deinit_all();
-			this->err_msg = TEXT("AudioRTDSP::loadAudioDeviceList: Error: IMMDevice::OpenPropertyStore failed.");
-			return FALSE;
-		}
+	CopyMemory(p_params, &(this->dsp_params), sizeof(audiortdsp_fx_params_t));
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::getBufferStats(audiortdsp_buffer_stats_t *p_stats)
+{
+	if(p_stats == NULL) return FALSE;
+
+	CopyMemory(p_stats, &(this->bufferout_stats), sizeof(audiortdsp_buffer_stats_t));
+
+	p_stats->n_segments = this->BUFFEROUT_N_SEGMENTS;
+	p_stats->arena_size = this->arena_size;
+	p_stats->n_ready = 0u;
+
+	p_stats->n_depth = this->bufferout_depth;
+	p_stats->load_pct = this->depth_load_pct;
+
+	if(this->bufferout_direct)
+	{
+		p_stats->n_segments = 0u;
+		p_stats->n_depth = 0u;
+	}
+	else if(this->status == this->STATUS_PLAYING) p_stats->n_ready = this->bufferout_get_nready();
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::getIOStats(audiortdsp_io_stats_t *p_stats)
+{
+	LARGE_INTEGER qpc_freq;
+
+	if(p_stats == NULL) return FALSE;
+
+	QueryPerformanceFrequency(&qpc_freq);
+
+	p_stats->readahead_size = (this->READAHEAD_N_BLOCKS)*(this->READAHEAD_BLOCK_SIZE_BYTES);
+	p_stats->n_reads = (ULONG64) this->io_n_reads;
+	p_stats->n_waits = (ULONG64) this->io_n_waits;
+	p_stats->wait_sec = ((DOUBLE) this->io_wait_ticks)/((DOUBLE) qpc_freq.QuadPart);
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::getTransitionStats(audiortdsp_xfade_stats_t *p_stats)
+{
+	LARGE_INTEGER qpc_freq;
+
+	if(p_stats == NULL) return FALSE;
+
+	QueryPerformanceFrequency(&qpc_freq);
+
+	p_stats->n_transitions = (ULONG64) this->xfade_n_transitions;
+	p_stats->n_frames = (ULONG64) this->xfade_n_frames;
+	p_stats->extra_sec = ((DOUBLE) this->xfade_extra_ticks)/((DOUBLE) qpc_freq.QuadPart);
+	p_stats->dsp_sec = ((DOUBLE) this->xfade_dsp_ticks)/((DOUBLE) qpc_freq.QuadPart);
+
+	return TRUE;
+}
+
+#ifdef __RTDSP_TELEMETRY
+BOOL WINAPI AudioRTDSP::getTelemetry(audiortdsp_telemetry_t *p_telemetry)
+{
+	SIZE_T n_stage = 0u;
+
+	if(p_telemetry == NULL) return FALSE;
+
+	if(!this->telemetry_qpc_freq)
+	{
+		this->err_msg = TEXT("AudioRTDSP::getTelemetry: Error: no playback session yet.");
+		return FALSE;
+	}
+
+	for(n_stage = 0u; n_stage < AUDIORTDSP_TELEMETRY_N_STAGES; n_stage++) this->telemetry_stage_get(n_stage, &(p_telemetry->stages[n_stage]));
+
+	p_telemetry->n_played = this->bufferout_stats.n_played;
+	p_telemetry->n_underruns = this->bufferout_stats.n_underruns;
+
+	p_telemetry->padding_min = this->telemetry_padding_min;
+	p_telemetry->padding_max = this->telemetry_padding_max;
+
+	if(this->telemetry_padding_n) p_telemetry->padding_avg = ((DOUBLE) this->telemetry_padding_sum)/((DOUBLE) this->telemetry_padding_n);
+	else p_telemetry->padding_avg = 0.0;
+
+	return TRUE;
+}
+
+/*
+	Appends to the telemetry report (report_size bytes, n_chars used) and returns the new length.
+	A truncated append fills the report, every append after that is skipped.
+	No WINAPI: variadic functions can't be stdcall.
+*/
+
+static SIZE_T telemetry_report_append(CHAR *p_report, SIZE_T report_size, SIZE_T n_chars, const CHAR *format, ...)
+{
+	va_list args;
+	INT n_ret = 0;
+
+	if(n_chars >= (report_size - 1u)) return n_chars;
+
+	va_start(args, format);
+	n_ret = vsnprintf(&p_report[n_chars], report_size - n_chars, format, args);
+	va_end(args);
+
+	if(n_ret < 0) return n_chars;
+
+	n_chars += (SIZE_T) n_ret;
+	if(n_chars >= report_size) n_chars = report_size - 1u;
+
+	return n_chars;
+}
+
+BOOL WINAPI AudioRTDSP::dumpTelemetry(const TCHAR *fileout_dir)
+{
+	const CHAR *STAGE_NAMES[AUDIORTDSP_TELEMETRY_N_STAGES] = {"load", "dsp", "play", "wait", "slack"};
+
+	audiortdsp_telemetry_t telemetry;
+	const audiortdsp_telemetry_stage_t *p_stage = NULL;
+	CHAR report[8192];
+	SIZE_T n_chars = 0u;
+	SIZE_T n_stage = 0u;
+	SIZE_T n_bucket = 0u;
+	HANDLE h_fileout = INVALID_HANDLE_VALUE;
+	DWORD n_written = 0u;
+	BOOL ret = FALSE;
+
+	if(fileout_dir == NULL)
+	{
+		this->err_msg = TEXT("AudioRTDSP::dumpTelemetry: Error: file directory is NULL.");
+		return FALSE;
+	}
+
+	if(!this->getTelemetry(&telemetry)) return FALSE;
+
+	n_chars = telemetry_report_append(report, sizeof(report), n_chars, "AudioRTDSP playback telemetry\r\n\r\n");
+	n_chars = telemetry_report_append(report, sizeof(report), n_chars, "segments played: %llu, underruns: %llu\r\n", (unsigned long long) telemetry.n_played, (unsigned long long) telemetry.n_underruns);
+	n_chars = telemetry_report_append(report, sizeof(report), n_chars, "audio buffer padding (frames): min %llu, avg %.1f, max %llu\r\n\r\n", (unsigned long long) telemetry.padding_min, telemetry.padding_avg, (unsigned long long) telemetry.padding_max);
+
+	n_chars = telemetry_report_append(report, sizeof(report), n_chars, "%-8s %12s %12s %12s %12s %12s %12s\r\n", "stage", "samples", "avg us", "p50 us", "p99 us", "p99.9 us", "max us");
+
+	for(n_stage = 0u; n_stage < AUDIORTDSP_TELEMETRY_N_STAGES; n_stage++)
+	{
+		p_stage = &(telemetry.stages[n_stage]);
+		n_chars = telemetry_report_append(report, sizeof(report), n_chars, "%-8s %12llu %12.1f %12.1f %12.1f %12.1f %12.1f\r\n", STAGE_NAMES[n_stage], (unsigned long long) p_stage->n_samples, p_stage->avg_us, p_stage->p50_us, p_stage->p99_us, p_stage->p999_us, p_stage->max_us);
+	}
+
+	n_chars = telemetry_report_append(report, sizeof(report), n_chars, "\r\nhistogram (samples per bucket)\r\n%-8s %12s", "bucket", "below us");
+	for(n_stage = 0u; n_stage < AUDIORTDSP_TELEMETRY_N_STAGES; n_stage++) n_chars = telemetry_report_append(report, sizeof(report), n_chars, " %12s", STAGE_NAMES[n_stage]);
+	n_chars = telemetry_report_append(report, sizeof(report), n_chars, "\r\n");
+
+	for(n_bucket = 0u; n_bucket < AUDIORTDSP_TELEMETRY_N_BUCKETS; n_bucket++)
+	{
+		if(n_bucket < (AUDIORTDSP_TELEMETRY_N_BUCKETS - 1u)) n_chars = telemetry_report_append(report, sizeof(report), n_chars, "%-8llu %12llu", (unsigned long long) n_bucket, (unsigned long long) (1ull << n_bucket));
+		else n_chars = telemetry_report_append(report, sizeof(report), n_chars, "%-8llu %12s", (unsigned long long) n_bucket, "-");
+
+		for(n_stage = 0u; n_stage < AUDIORTDSP_TELEMETRY_N_STAGES; n_stage++) n_chars = telemetry_report_append(report, sizeof(report), n_chars, " %12llu", (unsigned long long) telemetry.stages[n_stage].hist[n_bucket]);
+		n_chars = telemetry_report_append(report, sizeof(report), n_chars, "\r\n");
+	}
+
+	h_fileout = CreateFile(fileout_dir, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, 0u, NULL);
+	if(h_fileout == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioRTDSP::dumpTelemetry: Error: could not create output file.");
+		return FALSE;
+	}
+
+	ret = WriteFile(h_fileout, report, (DWORD) n_chars, &n_written, NULL);
+	CloseHandle(h_fileout);
+
+	if(!ret || (n_written != (DWORD) n_chars))
+	{
+		this->err_msg = TEXT("AudioRTDSP::dumpTelemetry: Error: could not write output file.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+#else
+BOOL WINAPI AudioRTDSP::getTelemetry(audiortdsp_telemetry_t *p_telemetry)
+{
+	this->err_msg = TEXT("AudioRTDSP::getTelemetry: Error: telemetry is not built in (see __RTDSP_TELEMETRY in config.h).");
+	return FALSE;
+}
+
+BOOL WINAPI AudioRTDSP::dumpTelemetry(const TCHAR *fileout_dir)
+{
+	this->err_msg = TEXT("AudioRTDSP::dumpTelemetry: Error: telemetry is not built in (see __RTDSP_TELEMETRY in config.h).");
+	return FALSE;
+}
+#endif
+
+BOOL WINAPI AudioRTDSP::setFXDelay(SIZE_T n_delay)
+{
+	audiortdsp_fx_params_t fx_params;
+
+	if(this->status < 1) return FALSE;
+
+	if((((ULONG64) this->dsp_params.n_feedback + 1u)*((ULONG64) n_delay)) >= this->DSP_MAX_SPAN_FRAMES)
+	{
+		this->err_msg = TEXT("AudioRTDSP::setFXDelay: Error: given delay time value is too big.");
+		return FALSE;
+	}
+
+	CopyMemory(&fx_params, &(this->dsp_params), sizeof(audiortdsp_fx_params_t));
+	fx_params.n_delay = (INT32) n_delay;
+
+	if(!this->bufferin_grow(&fx_params))
+	{
+		this->err_msg = TEXT("AudioRTDSP::setFXDelay: Error: could not grow input buffer.");
+		return FALSE;
+	}
+
+	this->dsp_params.n_delay = (INT32) n_delay;
+	this->dsp_params_versions[this->CMD_SET_DELAY]++;
+	this->dsp_snapshot_publish();
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::setFXFeedback(SIZE_T n_feedback)
+{
+	audiortdsp_fx_params_t fx_params;
+
+	if(this->status < 1) return FALSE;
+
+	if((((ULONG64) this->dsp_params.n_delay)*((ULONG64) n_feedback + 1u)) >= this->DSP_MAX_SPAN_FRAMES)
+	{
+		this->err_msg = TEXT("AudioRTDSP::setFXFeedback: Error: given feedback count is too big.");
+		return FALSE;
+	}
+
+	if((n_feedback + 1u) > this->DSPGAINS_SIZE)
+	{
+		this->err_msg = TEXT("AudioRTDSP::setFXFeedback: Error: given feedback count is too big.");
+		return FALSE;
+	}
+
+	CopyMemory(&fx_params, &(this->dsp_params), sizeof(audiortdsp_fx_params_t));
+	fx_params.n_feedback = (INT32) n_feedback;
+
+	if(!this->bufferin_grow(&fx_params))
+	{
+		this->err_msg = TEXT("AudioRTDSP::setFXFeedback: Error: could not grow input buffer.");
+		return FALSE;
+	}
+
+	this->dsp_params.n_feedback = (INT32) n_feedback;
+	this->dsp_params_versions[this->CMD_SET_FEEDBACK]++;
+	this->dsp_snapshot_publish();
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::enableFeedbackAltPol(BOOL enable)
+{
+	if(this->status < 1) return FALSE;
+
+	this->dsp_params.feedback_alt_pol = enable;
+	this->dsp_params_versions[this->CMD_SET_FEEDBACK_ALT_POL]++;
+	this->dsp_snapshot_publish();
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::enableCycleDivIncOne(BOOL enable)
+{
+	audiortdsp_fx_params_t fx_params;
+
+	if(this->status < 1) return FALSE;
+
+	/*The recursive comb needs a bigger ring without it, the comb stays inactive if the ring can't grow (see dsp_comb_update())*/
+
+	CopyMemory(&fx_params, &(this->dsp_params), sizeof(audiortdsp_fx_params_t));
+	fx_params.cyclediv_inc_one = enable;
+	this->bufferin_grow(&fx_params);
+
+	this->dsp_params.cyclediv_inc_one = enable;
+	this->dsp_params_versions[this->CMD_SET_CYCLEDIV_INC_ONE]++;
+	this->dsp_snapshot_publish();
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::enableRecursiveComb(BOOL enable)
+{
+	audiortdsp_fx_params_t fx_params;
+
+	if(this->status < 1) return FALSE;
+
+	/*The comb stays inactive if the ring can't grow (see dsp_comb_update())*/
+
+	CopyMemory(&fx_params, &(this->dsp_params), sizeof(audiortdsp_fx_params_t));
+	fx_params.recursive_comb = enable;
+	this->bufferin_grow(&fx_params);
+
+	this->dsp_params.recursive_comb = enable;
+	this->dsp_params_versions[this->CMD_SET_RECURSIVE_COMB]++;
+	this->dsp_snapshot_publish();
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::setTransitionTime(SIZE_T n_frames)
+{
+	if(n_frames > this->XFADE_MAX_FRAMES)
+	{
+		this->err_msg = TEXT("AudioRTDSP::setTransitionTime: Error: given transition time is too big.");
+		return FALSE;
+	}
+
+	this->dsp_xfade_frames = n_frames;
+
+	/*Before initialize(): the session publishes it along with the default FX parameters*/
+
+	if(this->status > 0) this->dsp_snapshot_publish();
+	return TRUE;
+}
+
+/*
+	Bounded MPMC queue scheme (single consumer here): each slot sequence number tells whether the slot is free for the position being claimed.
+	The slot is published with an interlocked exchange (full barrier), so the load thread sees the whole command once it sees seq.
+*/
+
+BOOL WINAPI AudioRTDSP::postCommand(const audiortdsp_cmd_t *p_cmd)
+{
+	audiortdsp_cmdslot_t *p_slot = NULL;
+	LONG n_pos = 0;
+	LONG n_diff = 0;
+
+	if(p_cmd == NULL) return FALSE;
+	if(p_cmd->type > this->CMD_SEEK) return FALSE;
+
+	n_pos = this->cmdqueue_push;
+
+	while(TRUE)
+	{
+		p_slot = &(this->cmdqueue[((SIZE_T) (ULONG) n_pos) & (this->CMDQUEUE_SIZE - 1u)]);
+		n_diff = (LONG) (((ULONG) p_slot->seq) - ((ULONG) n_pos));
+
+		if(n_diff == 0)
+		{
+			if(InterlockedCompareExchange(&(this->cmdqueue_push), (LONG) (((ULONG) n_pos) + 1u), n_pos) == n_pos) break;
+		}
+		else if(n_diff < 0) return FALSE; /*Full*/
+
+		n_pos = this->cmdqueue_push;
+	}
+
+	CopyMemory(&(p_slot->cmd), p_cmd, sizeof(audiortdsp_cmd_t));
+	InterlockedExchange(&(p_slot->seq), (LONG) (((ULONG) n_pos) + 1u));
+
+	return TRUE;
+}
+
+ULONG64 WINAPI AudioRTDSP::getEngineFrame(VOID)
+{
+	return (ULONG64) this->dsp_nframe_curr;
+}
+
+__string WINAPI AudioRTDSP::getLastErrorMessage(VOID)
+{
+	if(this->status == this->STATUS_UNINITIALIZED)
+		return TEXT("Error: Audio Object has not been initialized.\r\nExtended error message: ") + this->err_msg;
+
+	return this->err_msg;
+}
+
+BOOL WINAPI AudioRTDSP::filein_open(VOID)
+{
+	this->filein_close();
+
+	this->h_filein = CreateFile(this->FILEIN_DIR.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0u, NULL);
+	if(this->h_filein == INVALID_HANDLE_VALUE) return FALSE;
+
+	this->filein_size_64.l32 = (ULONG32) GetFileSize(this->h_filein, (DWORD*) &(this->filein_size_64.h32));
+	return TRUE;
+}
+
+/*
+	filein_map(): map the whole input file (called after audio_hw_init(), once the frame size is known).
+	Leaves p_filein_data NULL (input buffer ring) if mapped input is disabled or the file can't be mapped.
+*/
+
+BOOL WINAPI AudioRTDSP::filein_map(VOID)
+{
+	ULONG64 filein_size = 0u;
+	ULONG64 data_end = 0u;
+
+	this->p_filein_data = NULL;
+	this->filein_n_frames = 0u;
+	this->DSP_MAX_SPAN_FRAMES = 0u;
+
+	if(!this->filein_map_enable) return FALSE;
+	if(this->h_filein == INVALID_HANDLE_VALUE) return FALSE;
+
+	filein_size = *((ULONG64*) &(this->filein_size_64));
+
+	data_end = this->AUDIO_DATA_END;
+	if(data_end > filein_size) data_end = filein_size;
+
+	if(data_end <= this->AUDIO_DATA_BEGIN) return FALSE;
+
+	/*The whole file must fit in the address space*/
+
+	if(filein_size > ((ULONG64) ((SIZE_T) -1))) return FALSE;
+
+	this->h_filein_map = CreateFileMapping(this->h_filein, NULL, PAGE_READONLY, 0u, 0u, NULL);
+	if(this->h_filein_map == NULL) return FALSE;
+
+	this->p_filein_map = (const BYTE*) MapViewOfFile(this->h_filein_map, FILE_MAP_READ, 0u, 0u, 0u);
+	if(this->p_filein_map == NULL)
+	{
+		CloseHandle(this->h_filein_map);
+		this->h_filein_map = NULL;
+		return FALSE;
+	}
+
+	this->p_filein_data = &(this->p_filein_map[this->AUDIO_DATA_BEGIN]);
+	this->filein_n_frames = (data_end - this->AUDIO_DATA_BEGIN)/((ULONG64) this->FILEIN_FRAME_SIZE_BYTES);
+	this->DSP_MAX_SPAN_FRAMES = 0x7fffffffu;
+
+	return TRUE;
+}
+
+VOID WINAPI AudioRTDSP::filein_close(VOID)
+{
+	this->readahead_deinit();
+
+	if(this->p_filein_map != NULL)
+	{
+		UnmapViewOfFile(this->p_filein_map);
+		this->p_filein_map = NULL;
+	}
+
+	if(this->h_filein_map != NULL)
+	{
+		CloseHandle(this->h_filein_map);
+		this->h_filein_map = NULL;
+	}
+
+	this->p_filein_data = NULL;
+	this->filein_n_frames = 0u;
+
+	if(this->h_filein == INVALID_HANDLE_VALUE) return;
+
+	CloseHandle(this->h_filein);
+	this->h_filein = INVALID_HANDLE_VALUE;
+	*((ULONG64*) &(this->filein_size_64)) = 0u;
+
+	return;
+}
+
+VOID WINAPI AudioRTDSP::filein_read(VOID *p_dest, SIZE_T n_bytes)
+{
+	audiortdsp_readahead_block_t *p_block = NULL;
+	BYTE *p_out = (BYTE*) p_dest;
+	ULONG64 filein_pos = 0u;
+	SIZE_T block_offset = 0u;
+	SIZE_T n_copy = 0u;
+	SIZE_T n_valid = 0u;
+	DWORD n_read = 0u;
+
+	LARGE_INTEGER qpc_begin;
+	LARGE_INTEGER qpc_end;
+
+	if(this->p_readahead_blocks == NULL)
+	{
+		QueryPerformanceCounter(&qpc_begin);
+
+		SetFilePointer(this->h_filein, (LONG) this->filein_pos_64.l32, (LONG*) &(this->filein_pos_64.h32), FILE_BEGIN);
+		if(!ReadFile(this->h_filein, p_out, (DWORD) n_bytes, &n_read, NULL)) n_read = 0u;
+
+		QueryPerformanceCounter(&qpc_end);
+
+		this->io_n_reads++;
+		this->io_n_waits++;
+		this->io_wait_ticks += (LONG64) (qpc_end.QuadPart - qpc_begin.QuadPart);
+
+		if(((SIZE_T) n_read) < n_bytes) ZeroMemory(&p_out[n_read], (n_bytes - ((SIZE_T) n_read)));
+
+		*((ULONG64*) &(this->filein_pos_64)) += (ULONG64) n_bytes;
+		return;
+	}
+
+	filein_pos = *((ULONG64*) &(this->filein_pos_64));
+	*((ULONG64*) &(this->filein_pos_64)) += (ULONG64) n_bytes;
+
+	while(n_bytes > 0u)
+	{
+		p_block = &(this->p_readahead_blocks[this->readahead_nblock_curr]);
+
+		/*The file position moved away from the read-ahead, start over from there*/
+
+		if((filein_pos < p_block->filein_pos) || ((filein_pos - p_block->filein_pos) >= ((ULONG64) this->READAHEAD_BLOCK_SIZE_BYTES)))
+		{
+			this->readahead_start(filein_pos);
+			p_block = &(this->p_readahead_blocks[this->readahead_nblock_curr]);
+		}
+
+		this->readahead_wait(p_block);
+
+		block_offset = (SIZE_T) (filein_pos - p_block->filein_pos);
+
+		n_copy = this->READAHEAD_BLOCK_SIZE_BYTES - block_offset;
+		if(n_copy > n_bytes) n_copy = n_bytes;
+
+		n_valid = 0u;
+		if(p_block->n_bytes > block_offset) n_valid = p_block->n_bytes - block_offset;
+		if(n_valid > n_copy) n_valid = n_copy;
+
+		if(n_valid) CopyMemory(p_out, &(p_block->p_data[block_offset]), n_valid);
+		if(n_valid < n_copy) ZeroMemory(&p_out[n_valid], (n_copy - n_valid));
+
+		p_out += n_copy;
+		filein_pos += (ULONG64) n_copy;
+		n_bytes -= n_copy;
+
+		/*Block consumed: reuse it for the block after the last one in flight*/
+
+		if((block_offset + n_copy) == this->READAHEAD_BLOCK_SIZE_BYTES)
+		{
+			this->readahead_issue(p_block, this->readahead_pos_next);
+			this->readahead_pos_next += (ULONG64) this->READAHEAD_BLOCK_SIZE_BYTES;
+
+			this->readahead_nblock_curr++;
+			this->readahead_nblock_curr %= this->READAHEAD_N_BLOCKS;
+		}
+	}
+
+	return;
+}
+
+VOID WINAPI AudioRTDSP::filein_read_begin(VOID)
+{
+	this->io_stats_reset();
+
+	if(this->p_readahead_blocks != NULL) this->readahead_start(*((ULONG64*) &(this->filein_pos_64)));
+
+	return;
+}
+
+/*
+	readahead_init(): open the overlapped input file handle and allocate the read-ahead blocks (called after filein_map(), once the frame size is known).
+	Leaves READAHEAD_N_BLOCKS at 0 (synchronous reads) if the input is mapped, the read-ahead is disabled or can't be set up.
+*/
+
+BOOL WINAPI AudioRTDSP::readahead_init(VOID)
+{
+	SIZE_T seg_size = 0u;
+	SIZE_T n_blocks = 0u;
+	SIZE_T n_block = 0u;
+
+	this->readahead_deinit();
+
+	this->READAHEAD_BLOCK_SIZE_BYTES = 0u;
+	this->READAHEAD_N_BLOCKS = 0u;
+
+	if(this->p_filein_data != NULL) return FALSE;
+	if(!this->READAHEAD_SIZE_BYTES) return FALSE;
+
+	seg_size = (this->BUFFER_SEGMENT_SIZE_FRAMES)*(this->FILEIN_FRAME_SIZE_BYTES);
+	if(!seg_size) return FALSE;
+
+	this->READAHEAD_BLOCK_SIZE_BYTES = seg_size;
+	if(seg_size < this->READAHEAD_BLOCK_TARGET_BYTES) this->READAHEAD_BLOCK_SIZE_BYTES = (this->READAHEAD_BLOCK_TARGET_BYTES/seg_size)*seg_size;
+
+	/*At least 2 blocks: one being consumed, one in flight*/
+
+	n_blocks = (this->READAHEAD_SIZE_BYTES + this->READAHEAD_BLOCK_SIZE_BYTES - 1u)/(this->READAHEAD_BLOCK_SIZE_BYTES);
+	if(n_blocks < 2u) n_blocks = 2u;
+
+	this->h_filein_async = CreateFile(this->FILEIN_DIR.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, (FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN), NULL);
+	if(this->h_filein_async == INVALID_HANDLE_VALUE) goto _l_readahead_init_error;
+
+	this->p_readahead = (BYTE*) HeapAlloc(this->p_heap, 0u, n_blocks*(this->READAHEAD_BLOCK_SIZE_BYTES));
+	this->p_readahead_blocks = (audiortdsp_readahead_block_t*) HeapAlloc(this->p_heap, HEAP_ZERO_MEMORY, n_blocks*sizeof(audiortdsp_readahead_block_t));
+
+	if((this->p_readahead == NULL) || (this->p_readahead_blocks == NULL)) goto _l_readahead_init_error;
+
+	this->READAHEAD_N_BLOCKS = n_blocks;
+
+	for(n_block = 0u; n_block < n_blocks; n_block++)
+	{
+		this->p_readahead_blocks[n_block].p_data = &(this->p_readahead[n_block*(this->READAHEAD_BLOCK_SIZE_BYTES)]);
+
+		this->p_readahead_blocks[n_block].overlapped.hEvent = event_create(TRUE);
+		if(this->p_readahead_blocks[n_block].overlapped.hEvent == NULL) goto _l_readahead_init_error;
+	}
+
+	return TRUE;
+
+_l_readahead_init_error:
+	this->readahead_deinit();
+
+	this->READAHEAD_BLOCK_SIZE_BYTES = 0u;
+	this->READAHEAD_N_BLOCKS = 0u;
+
+	return FALSE;
+}
+
+/*readahead_deinit(): cancel the reads in flight, free the read-ahead blocks and close the overlapped file handle. READAHEAD_N_BLOCKS is kept for getIOStats().*/
+
+VOID WINAPI AudioRTDSP::readahead_deinit(VOID)
+{
+	SIZE_T n_block = 0u;
+
+	if(this->p_readahead_blocks != NULL)
+	{
+		this->readahead_cancel();
+
+		for(n_block = 0u; n_block < this->READAHEAD_N_BLOCKS; n_block++)
+		{
+			if(this->p_readahead_blocks[n_block].overlapped.hEvent != NULL) event_destroy(&(this->p_readahead_blocks[n_block].overlapped.hEvent));
+		}
+
+		HeapFree(this->p_heap, 0u, this->p_readahead_blocks);
+		this->p_readahead_blocks = NULL;
+	}
+
+	if(this->p_readahead != NULL)
+	{
+		HeapFree(this->p_heap, 0u, this->p_readahead);
+		this->p_readahead = NULL;
+	}
+
+	if(this->h_filein_async != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(this->h_filein_async);
+		this->h_filein_async = INVALID_HANDLE_VALUE;
+	}
+
+	return;
+}
+
+/*readahead_start(): drop the reads in flight and issue a read for every block, starting at filein_pos.*/
+
+VOID WINAPI AudioRTDSP::readahead_start(ULONG64 filein_pos)
+{
+	SIZE_T n_block = 0u;
+
+	if(this->p_readahead_blocks == NULL) return;
+
+	this->readahead_cancel();
+
+	this->readahead_nblock_curr = 0u;
+	this->readahead_pos_next = filein_pos;
+
+	for(n_block = 0u; n_block < this->READAHEAD_N_BLOCKS; n_block++)
+	{
+		this->readahead_issue(&(this->p_readahead_blocks[n_block]), this->readahead_pos_next);
+		this->readahead_pos_next += (ULONG64) this->READAHEAD_BLOCK_SIZE_BYTES;
+	}
+
+	return;
+}
+
+/*
+	readahead_cancel(): cancel every read in flight and wait for them to finish (a block can't be reused or freed while its read is in flight).
+	The reads may have been issued by another thread (playback load thread), so CancelIoEx() is used instead of CancelIo().
+*/
+
+VOID WINAPI AudioRTDSP::readahead_cancel(VOID)
+{
+	audiortdsp_readahead_block_t *p_block = NULL;
+	SIZE_T n_block = 0u;
+	DWORD n_read = 0u;
+
+	if(this->p_readahead_blocks == NULL) return;
+
+	CancelIoEx(this->h_filein_async, NULL);
+
+	for(n_block = 0u; n_block < this->READAHEAD_N_BLOCKS; n_block++)
+	{
+		p_block = &(this->p_readahead_blocks[n_block]);
+		if(!p_block->pending) continue;
+
+		GetOverlappedResult(this->h_filein_async, &(p_block->overlapped), &n_read, TRUE);
+
+		p_block->n_bytes = 0u;
+		p_block->pending = FALSE;
+	}
+
+	return;
+}
+
+VOID WINAPI AudioRTDSP::readahead_issue(audiortdsp_readahead_block_t *p_block, ULONG64 filein_pos)
+{
+	p_block->filein_pos = filein_pos;
+	p_block->n_bytes = 0u;
+	p_block->pending = FALSE;
+
+	/*Nothing to read beyond the end of the file, the block reads zeros*/
+
+	if(filein_pos >= *((ULONG64*) &(this->filein_size_64))) return;
+
+	p_block->overlapped.Internal = 0u;
+	p_block->overlapped.InternalHigh = 0u;
+	p_block->overlapped.Offset = (DWORD) (filein_pos & 0xffffffffu);
+	p_block->overlapped.OffsetHigh = (DWORD) (filein_pos >> 32);
+
+	if(!ReadFile(this->h_filein_async, p_block->p_data, (DWORD) this->READAHEAD_BLOCK_SIZE_BYTES, NULL, &(p_block->overlapped)))
+	{
+		/*Read error (not a read in flight): the block reads zeros, same as a failed synchronous read*/
+		if(GetLastError() != ERROR_IO_PENDING) return;
+	}
+
+	p_block->pending = TRUE;
+	this->io_n_reads++;
+
+	return;
+}
+
+/*readahead_wait(): retrieve the result of a block read, waiting for it if it's still in flight (the wait time goes to the read statistics).*/
+
+VOID WINAPI AudioRTDSP::readahead_wait(audiortdsp_readahead_block_t *p_block)
+{
+	DWORD n_read = 0u;
+	BOOL wait = FALSE;
+
+	LARGE_INTEGER qpc_begin;
+	LARGE_INTEGER qpc_end;
+
+	if(!p_block->pending) return;
+
+	wait = !HasOverlappedIoCompleted(&(p_block->overlapped));
+	if(wait) QueryPerformanceCounter(&qpc_begin);
+
+	/*End of file (or read error): whatever wasn't read reads zeros*/
+
+	if(!GetOverlappedResult(this->h_filein_async, &(p_block->overlapped), &n_read, TRUE)) n_read = 0u;
+
+	if(wait)
+	{
+		QueryPerformanceCounter(&qpc_end);
+
+		this->io_n_waits++;
+		this->io_wait_ticks += (LONG64) (qpc_end.QuadPart - qpc_begin.QuadPart);
+	}
+
+	p_block->n_bytes = (SIZE_T) n_read;
+	p_block->pending = FALSE;
+
+	return;
+}
+
+VOID WINAPI AudioRTDSP::io_stats_reset(VOID)
+{
+	this->io_n_reads = 0;
+	this->io_n_waits = 0;
+	this->io_wait_ticks = 0;
+
+	return;
+}
+
+BOOL WINAPI AudioRTDSP::audio_hw_init_pcm(
+UINT16 bits_per_sample, UINT16 valid_bits_per_sample, SIZE_T filein_sample_size)
+{
+	audiobackend_format_t format;
+	SIZE_T sample_size = 0u;
+	SIZE_T period_frames = 0u;
+
+	format.sample_rate = this->SAMPLE_RATE;
+	format.n_channels = (UINT16) this->N_CHANNELS;
+	format.bits_per_sample = bits_per_sample;
+	format.valid_bits_per_sample = valid_bits_per_sample;
+
+	if(!this->p_backend->open(&format))
+	{
+		this->audio_hw_deinit_device();
+		this->err_msg = TEXT("AudioRTDSP::audio_hw_init_pcm: Error: could not open audio output.\r\nExtended error message: ") + this->p_backend->getLastErrorMessage();
+		return FALSE;
+	}
+
+	sample_size = (SIZE_T) (bits_per_sample/8u);
+
+	this->FILEIN_FRAME_SIZE_BYTES = (this->N_CHANNELS)*filein_sample_size;
+	this->BUFFER_FRAME_SIZE_BYTES = (this->N_CHANNELS)*sample_size;
+	this->DSPCOMB_FRAC_BITS = this->DSPCOMB_STATE_BITS - ((UINT32) valid_bits_per_sample);
+
+	this->AUDIOBUFFER_SIZE_FRAMES = this->p_backend->getBufferSizeFrames();
+	this->AUDIOBUFFER_SIZE_SAMPLES = (this->AUDIOBUFFER_SIZE_FRAMES)*(this->N_CHANNELS);
+	this->AUDIOBUFFER_SIZE_BYTES = this->AUDIOBUFFER_SIZE_SAMPLES*sample_size;
+
+	/*
+		Buffer segment: half the audio buffer, any frame count (nothing is indexed with power of 2 masks).
+		If the audio output has a fixed period, the segment is trimmed to a whole number of periods, so each device wakeup frees room for whole segments.
+	*/
+
+	this->AUDIOBUFFER_SEGMENT_SIZE_FRAMES = this->AUDIOBUFFER_SIZE_FRAMES/2u;
+
+	period_frames = this->p_backend->getPeriodSizeFrames();
+	if(period_frames && (period_frames <= this->AUDIOBUFFER_SEGMENT_SIZE_FRAMES)) this->AUDIOBUFFER_SEGMENT_SIZE_FRAMES -= (this->AUDIOBUFFER_SEGMENT_SIZE_FRAMES)%period_frames;
+
+	if(!this->AUDIOBUFFER_SEGMENT_SIZE_FRAMES)
+	{
+		this->audio_hw_deinit_device();
+		this->err_msg = TEXT("AudioRTDSP::audio_hw_init_pcm: Error: audio buffer is too small.");
+		return FALSE;
+	}
+
+	this->AUDIOBUFFER_SEGMENT_SIZE_SAMPLES = (this->AUDIOBUFFER_SEGMENT_SIZE_FRAMES)*(this->N_CHANNELS);
+	this->AUDIOBUFFER_SEGMENT_SIZE_BYTES = this->AUDIOBUFFER_SEGMENT_SIZE_SAMPLES*sample_size;
+
+	this->BUFFER_SEGMENT_SIZE_FRAMES = this->AUDIOBUFFER_SEGMENT_SIZE_FRAMES;
+	this->BUFFER_SEGMENT_SIZE_SAMPLES = (this->BUFFER_SEGMENT_SIZE_FRAMES)*(this->N_CHANNELS);
+	this->BUFFER_SEGMENT_SIZE_BYTES = this->BUFFER_SEGMENT_SIZE_SAMPLES*sample_size;
+
+	this->BUFFEROUT_SIZE_FRAMES = (this->BUFFER_SEGMENT_SIZE_FRAMES)*(this->BUFFEROUT_N_SEGMENTS);
+	this->BUFFEROUT_SIZE_SAMPLES = (this->BUFFEROUT_SIZE_FRAMES)*(this->N_CHANNELS);
+	this->BUFFEROUT_SIZE_BYTES = this->BUFFEROUT_SIZE_SAMPLES*sample_size;
+
+	this->DSPBUFFER_SIZE_BYTES = (this->DSPBUFFER_SAMPLE_SIZE_BYTES)*(this->BUFFER_SEGMENT_SIZE_SAMPLES);
+
+	return TRUE;
+}
+
+VOID WINAPI AudioRTDSP::audio_hw_deinit_device(VOID)
+{
+	this->p_backend->close();
+	return;
+}
+
+VOID WINAPI AudioRTDSP::audio_hw_deinit_all(VOID)
+{
+	this->p_backend->release();
+	return;
+}
+
+VOID WINAPI AudioRTDSP::stop_all_threads(VOID)
+{
+	thread_worker_stop(&(this->loadworker), 0u);
+	thread_worker_stop(&(this->playworker), 0u);
+
+	return;
+}
+
+BOOL WINAPI AudioRTDSP::buffer_alloc(VOID)
+{
+	SIZE_T n_seg = 0u;
+	SIZE_T n_snap = 0u;
+
+	this->buffer_free();
+
+	if(!this->bufferin_reserve())
+	{
+		this->buffer_free();
+		return FALSE;
+	}
+
+	if(!this->arena_begin(this->buffer_arena_size()))
+	{
+		this->buffer_free();
+		return FALSE;
+	}
+
+	/*The input buffer ring only holds history the mapped file already has*/
+
+	if(this->p_filein_data != NULL)
+	{
+		this->p_dspzero = this->arena_carve(this->BUFFER_SEGMENT_SIZE_BYTES);
+
+		if(this->p_dspzero == NULL)
+		{
+			this->buffer_free();
+			return FALSE;
+		}
+
+		/*The only arena buffer that is read before being written*/
+
+		if(this->arena_reused) ZeroMemory(this->p_dspzero, this->BUFFER_SEGMENT_SIZE_BYTES);
+	}
+
+	this->p_bufferoutput = this->arena_carve(this->BUFFEROUT_SIZE_BYTES);
+
+	this->pp_bufferout_segments = (VOID**) this->arena_carve(this->BUFFEROUT_N_SEGMENTS*sizeof(VOID*));
+
+	this->p_dspbuffer = (INT32*) this->arena_carve(this->DSPBUFFER_SIZE_BYTES);
+
+	this->p_dspxfade = (INT32*) this->arena_carve(this->DSPBUFFER_SIZE_BYTES);
+
+	if(this->p_bufferoutput == NULL)
+	{
+		this->buffer_free();
+		return FALSE;
+	}
+
+	if(this->pp_bufferout_segments == NULL)
+	{
+		this->buffer_free();
+		return FALSE;
+	}
+
+	if(this->p_dspbuffer == NULL)
+	{
+		this->buffer_free();
+		return FALSE;
+	}
+
+	if(this->p_dspxfade == NULL)
+	{
+		this->buffer_free();
+		return FALSE;
+	}
+
+	ZeroMemory(&(this->dspsnap_xfade), sizeof(audiortdsp_dspsnap_t));
+	this->dspsnap_xfade.p_gains = (dspkernel_gain_t*) this->arena_carve(this->DSPGAINS_SIZE_BYTES);
+
+	if(this->dspsnap_xfade.p_gains == NULL)
+	{
+		this->buffer_free();
+		return FALSE;
+	}
+
+	ZeroMemory(&(this->dspsnap_hold), sizeof(audiortdsp_dspsnap_t));
+	this->dspsnap_hold.p_gains = (dspkernel_gain_t*) this->arena_carve(this->DSPGAINS_SIZE_BYTES);
+
+	if(this->dspsnap_hold.p_gains == NULL)
+	{
+		this->buffer_free();
+		return FALSE;
+	}
+
+	for(n_snap = 0u; n_snap < this->DSPSNAP_COUNT; n_snap++)
+	{
+		ZeroMemory(&(this->dspsnaps[n_snap]), sizeof(audiortdsp_dspsnap_t));
+		this->dspsnaps[n_snap].p_gains = (dspkernel_gain_t*) this->arena_carve(this->DSPGAINS_SIZE_BYTES);
+
+		if(this->dspsnaps[n_snap].p_gains == NULL)
+		{
+			this->buffer_free();
+			return FALSE;
+		}
+	}
+
+	this->dspsnap_back = 0u;
+	this->dspsnap_mid = 1;
+	this->dspsnap_front = 2u;
+
+	/*Initial ring size, for the FX parameters already set*/
+
+	if(!this->bufferin_grow(&(this->dsp_params)))
+	{
+		this->buffer_free();
+		return FALSE;
+	}
+
+	this->bufferin_set_size((SIZE_T) this->bufferin_size_next);
+
+	for(n_seg = 0u; n_seg < this->BUFFEROUT_N_SEGMENTS; n_seg++) this->pp_bufferout_segments[n_seg] = (VOID*) (((SIZE_T) this->p_bufferoutput) + n_seg*(this->BUFFER_SEGMENT_SIZE_BYTES));
+
+	this->dsp_snapshot_publish();
+
+	return TRUE;
+}
+
+VOID WINAPI AudioRTDSP::buffer_free(VOID)
+{
+	this->vbuffer_release(&(this->bufferin_vbuf));
+	this->vbuffer_release(&(this->dspcomb_vbuf));
+
+	this->p_bufferinput = NULL;
+	this->p_dspcomb_state = NULL;
+
+	this->bufferin_size_next = 0;
+	this->bufferin_set_size(0u);
+
+	/*The arena block itself is kept for the next session*/
+
+	this->p_bufferoutput = NULL;
+	this->pp_bufferout_segments = NULL;
+	this->p_dspbuffer = NULL;
+	this->p_dspxfade = NULL;
+	this->p_dspzero = NULL;
+
+	this->arena_used = 0u;
+
+	ZeroMemory(this->dspsnaps, sizeof(this->dspsnaps));
+	ZeroMemory(&(this->dspsnap_hold), sizeof(audiortdsp_dspsnap_t));
+	ZeroMemory(&(this->dspsnap_xfade), sizeof(audiortdsp_dspsnap_t));
+
+	return;
+}
+
+SIZE_T WINAPI AudioRTDSP::buffer_arena_size(VOID)
+{
+	SIZE_T size = 0u;
+
+	size = this->arena_align(this->BUFFEROUT_SIZE_BYTES);
+	size += this->arena_align(this->BUFFEROUT_N_SEGMENTS*sizeof(VOID*));
+	size += 2u*(this->arena_align(this->DSPBUFFER_SIZE_BYTES));
+	size += (this->DSPSNAP_COUNT + 2u)*(this->arena_align(this->DSPGAINS_SIZE_BYTES));
+
+	if(this->p_filein_data != NULL) size += this->arena_align(this->BUFFER_SEGMENT_SIZE_BYTES);
+
+	return size;
+}
+
+SIZE_T WINAPI AudioRTDSP::arena_align(SIZE_T size)
+{
+	return (size + this->ARENA_ALIGN - 1u) & ~(this->ARENA_ALIGN - 1u);
+}
+
+BOOL WINAPI AudioRTDSP::arena_begin(SIZE_T size)
+{
+	SIZE_T large_page_size = 0u;
+	SIZE_T large_size = 0u;
+
+	this->arena_used = 0u;
+	this->arena_reused = FALSE;
+
+	if((this->p_arena != NULL) && (size <= this->arena_size))
+	{
+		this->arena_reused = TRUE;
+		return TRUE;
+	}
+
+	this->arena_release();
+
+	if(!size) return FALSE;
+
+	if(this->arena_large_pages)
+	{
+		large_page_size = GetLargePageMinimum();
+
+		if(large_page_size)
+		{
+			large_size = ((size + large_page_size - 1u)/large_page_size)*large_page_size;
+			this->p_arena = (BYTE*) VirtualAlloc(NULL, large_size, (MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES), PAGE_READWRITE);
+
+			if(this->p_arena != NULL)
+			{
+				this->arena_size = large_size;
+				return TRUE;
+			}
+		}
+	}
+
+	/*Committed pages start zeroed, page aligned (so ARENA_ALIGN aligned)*/
+
+	this->p_arena = (BYTE*) VirtualAlloc(NULL, size, (MEM_RESERVE | MEM_COMMIT), PAGE_READWRITE);
+	if(this->p_arena == NULL) return FALSE;
+
+	this->arena_size = size;
+	return TRUE;
+}
+
+VOID* WINAPI AudioRTDSP::arena_carve(SIZE_T size)
+{
+	VOID *p_buf = NULL;
+
+	size = this->arena_align(size);
+
+	if(this->p_arena == NULL) return NULL;
+	if(size > (this->arena_size - this->arena_used)) return NULL;
+
+	p_buf = (VOID*) &(this->p_arena[this->arena_used]);
+	this->arena_used += size;
+
+	return p_buf;
+}
+
+VOID WINAPI AudioRTDSP::arena_release(VOID)
+{
+	if(this->p_arena != NULL) VirtualFree(this->p_arena, 0u, MEM_RELEASE);
+
+	this->p_arena = NULL;
+	this->arena_size = 0u;
+	this->arena_used = 0u;
+	this->arena_reused = FALSE;
+
+	return;
+}
+
+/*
+	vbuffer_reserve(): reserve size bytes of address space (nothing committed), releases the previous reservation.
+	vbuffer_commit(): commit the first size bytes, a vbuffer never shrinks. Fails if size is beyond the reservation.
+*/
+
+BOOL WINAPI AudioRTDSP::vbuffer_reserve(audiortdsp_vbuffer_t *p_vbuf, SIZE_T size)
+{
+	this->vbuffer_release(p_vbuf);
+
+	if(!size) return FALSE;
+
+	p_vbuf->p_base = (BYTE*) VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_READWRITE);
+	if(p_vbuf->p_base == NULL) return FALSE;
+
+	p_vbuf->reserve_size = size;
+	return TRUE;
+}
+
+/*
+	The new pages are touched right away (zero filled, as committed), so the thread that commits them takes the page faults, not the load thread.
+*/
+
+BOOL WINAPI AudioRTDSP::vbuffer_commit(audiortdsp_vbuffer_t *p_vbuf, SIZE_T size)
+{
+	if(size <= p_vbuf->commit_size) return TRUE;
+	if(size > p_vbuf->reserve_size) return FALSE;
+
+	if(VirtualAlloc(p_vbuf->p_base, size, MEM_COMMIT, PAGE_READWRITE) == NULL) return FALSE;
+
+	ZeroMemory(&(p_vbuf->p_base[p_vbuf->commit_size]), size - p_vbuf->commit_size);
+
+	p_vbuf->commit_size = size;
+	return TRUE;
+}
+
+VOID WINAPI AudioRTDSP::vbuffer_release(audiortdsp_vbuffer_t *p_vbuf)
+{
+	if(p_vbuf->p_base != NULL) VirtualFree(p_vbuf->p_base, 0u, MEM_RELEASE);
+
+	p_vbuf->p_base = NULL;
+	p_vbuf->reserve_size = 0u;
+	p_vbuf->commit_size = 0u;
+
+	return;
+}
+
+/*
+	bufferin_reserve(): reserve the input buffer ring (not with the mapped input) and the comb state, nothing is committed yet.
+	Sets BUFFERIN_MAX_SIZE_FRAMES, and DSP_MAX_SPAN_FRAMES for the input buffer ring.
+*/
+
+BOOL WINAPI AudioRTDSP::bufferin_reserve(VOID)
+{
+	SIZE_T reserve_frames = 0u;
+
+	reserve_frames = this->BUFFERIN_RESERVE_FRAMES;
+
+	while(reserve_frames >= this->BUFFERIN_MIN_RESERVE_FRAMES)
+	{
+		if(this->vbuffer_reserve(&(this->dspcomb_vbuf), reserve_frames*(this->N_CHANNELS)*sizeof(INT32)))
+		{
+			if(this->p_filein_data != NULL) break;
+			if(this->vbuffer_reserve(&(this->bufferin_vbuf), reserve_frames*(this->BUFFER_FRAME_SIZE_BYTES))) break;
+		}
+
+		this->vbuffer_release(&(this->dspcomb_vbuf));
+		reserve_frames = (reserve_frames >> 1);
+	}
+
+	if(reserve_frames < this->BUFFERIN_MIN_RESERVE_FRAMES) return FALSE;
+
+	this->p_bufferinput = (VOID*) this->bufferin_vbuf.p_base;
+	this->p_dspcomb_state = (INT32*) this->dspcomb_vbuf.p_base;
+
+	/*The ring is a whole number of segments*/
+
+	this->BUFFERIN_MAX_SIZE_FRAMES = reserve_frames - reserve_frames%(this->BUFFER_SEGMENT_SIZE_FRAMES);
+
+	this->bufferin_size_next = 0;
+	this->bufferin_set_size(0u);
+
+	if(this->p_filein_data == NULL) this->DSP_MAX_SPAN_FRAMES = (ULONG64) (this->BUFFERIN_MAX_SIZE_FRAMES - this->BUFFER_SEGMENT_SIZE_FRAMES);
+
+	return TRUE;
+}
+
+/*
+	bufferin_size_for(): input buffer ring size (frames) for the given FX parameters.
+	Clamped to BUFFERIN_MAX_SIZE_FRAMES: the recursive comb span may not fit, then the comb stays inactive (see dsp_comb_update()).
+*/
+
+SIZE_T WINAPI AudioRTDSP::bufferin_size_for(const audiortdsp_fx_params_t *p_params)
+{
+	ULONG64 n_delay = 0u;
+	ULONG64 span = 0u;
+	ULONG64 comb_span = 0u;
+	ULONG64 size = 0u;
+
+	if(p_params->n_delay > 0)
+	{
+		n_delay = (ULONG64) p_params->n_delay;
+
+		if(this->p_filein_data == NULL) span = n_delay*((ULONG64) p_params->n_feedback + 1u);
+
+		if(p_params->recursive_comb && !p_params->cyclediv_inc_one)
+		{
+			comb_span = n_delay;
+
+			if((this->p_filein_data == NULL) && ((((ULONG64) p_params->n_feedback) + 2u) < ((ULONG64) this->DSPCOMB_STATE_BITS)))
+				comb_span = n_delay*((ULONG64) p_params->n_feedback + 2u);
+
+			if(comb_span > span) span = comb_span;
+		}
+	}
+
+	size = span + ((ULONG64) this->BUFFER_SEGMENT_SIZE_FRAMES);
+	if(size >= ((ULONG64) this->BUFFERIN_MAX_SIZE_FRAMES)) return this->BUFFERIN_MAX_SIZE_FRAMES;
+
+	/*Round up to a whole number of segments, then to the next power of 2 number of segments (bounds the number of ring resizes)*/
+
+	size = (size + ((ULONG64) this->BUFFER_SEGMENT_SIZE_FRAMES) - 1u)/((ULONG64) this->BUFFER_SEGMENT_SIZE_FRAMES);
+	size = ((ULONG64) _get_closest_power2_ceil((SIZE_T) size))*((ULONG64) this->BUFFER_SEGMENT_SIZE_FRAMES);
+
+	if(size > ((ULONG64) this->BUFFERIN_MAX_SIZE_FRAMES)) return this->BUFFERIN_MAX_SIZE_FRAMES;
+
+	return (SIZE_T) size;
+}
+
+/*
+	bufferin_grow(): commit the input buffer ring (and the comb state, once used) for the given FX parameters, before they're applied.
+	The new size is published to bufferin_size_next once its pages are committed, the load thread switches to it in bufferin_resize().
+*/
+
+BOOL WINAPI AudioRTDSP::bufferin_grow(const audiortdsp_fx_params_t *p_params)
+{
+	SIZE_T size = 0u;
+	SIZE_T size_next = 0u;
+
+	if(!this->BUFFERIN_MAX_SIZE_FRAMES) return TRUE;
+
+	size_next = (SIZE_T) this->bufferin_size_next;
+
+	size = this->bufferin_size_for(p_params);
+	if(size < size_next) size = size_next;
+
+	if(p_params->recursive_comb || this->dspcomb_vbuf.commit_size)
+	{
+		if(!this->vbuffer_commit(&(this->dspcomb_vbuf), size*(this->N_CHANNELS)*sizeof(INT32))) return FALSE;
+	}
+
+	if(size == size_next) return TRUE;
+
+	if(this->p_filein_data == NULL)
+	{
+		if(!this->vbuffer_commit(&(this->bufferin_vbuf), size*(this->BUFFER_FRAME_SIZE_BYTES))) return FALSE;
+	}
+
+	InterlockedExchange(&(this->bufferin_size_next), (LONG) size);
+	return TRUE;
+}
+
+/*
+	bufferin_resize(): switch to bufferin_size_next, if the ring grew. Called by the load thread once it has read the FX parameters of the current segment.
+
+	The switch waits until the current segment is the last one of the ring in use: every frame of the ring in use then keeps its place and its distance to the current segment,
+	and the frames added after it (zeros, see vbuffer_commit()) are older than any history so far. Nothing is moved, the switch costs the same as any other segment.
+*/
+
+VOID WINAPI AudioRTDSP::bufferin_resize(VOID)
+{
+	SIZE_T size_next = 0u;
+
+	MemoryBarrier();
+
+	size_next = (SIZE_T) this->bufferin_size_next;
+	if(size_next <= this->BUFFERIN_SIZE_FRAMES) return;
+
+	if((this->bufferin_nseg_curr + 1u) < this->BUFFERIN_N_SEGMENTS) return;
+
+	this->bufferin_set_size(size_next);
+	return;
+}
+
+VOID WINAPI AudioRTDSP::bufferin_set_size(SIZE_T size_frames)
+{
+	this->BUFFERIN_SIZE_FRAMES = size_frames;
+	this->BUFFERIN_SIZE_SAMPLES = (this->BUFFERIN_SIZE_FRAMES)*(this->N_CHANNELS);
+	this->BUFFERIN_SIZE_BYTES = (this->BUFFERIN_SIZE_FRAMES)*(this->BUFFER_FRAME_SIZE_BYTES);
+
+	this->BUFFERIN_N_SEGMENTS = 0u;
+	if(this->BUFFER_SEGMENT_SIZE_FRAMES) this->BUFFERIN_N_SEGMENTS = this->BUFFERIN_SIZE_FRAMES/this->BUFFER_SEGMENT_SIZE_FRAMES;
+
+	return;
+}
+
+VOID* WINAPI AudioRTDSP::bufferin_segment(SIZE_T nseg)
+{
+	return (VOID*) (((SIZE_T) this->p_bufferinput) + nseg*(this->BUFFER_SEGMENT_SIZE_BYTES));
+}
+
+BOOL WINAPI AudioRTDSP::playback_proc(VOID)
+{
+	if(!this->playback_init()) return FALSE;
+
+	return this->playback_loop();
+}
+
+BOOL WINAPI AudioRTDSP::render_set_fx(const audiortdsp_fx_params_t *p_fx_params)
+{
+	if((p_fx_params->n_delay < 0) || (p_fx_params->n_feedback < 0))
+	{
+		this->err_msg = TEXT("AudioRTDSP::render_set_fx: Error: invalid FX parameters.");
+		return FALSE;
+	}
+
+	/*Feedback goes down to 0 first, so the new delay time is checked against the new feedback count only*/
+
+	if(!this->setFXFeedback(0u)) return FALSE;
+	if(!this->setFXDelay((SIZE_T) p_fx_params->n_delay)) return FALSE;
+	if(!this->setFXFeedback((SIZE_T) p_fx_params->n_feedback)) return FALSE;
+
+	this->enableFeedbackAltPol(p_fx_params->feedback_alt_pol);
+	this->enableCycleDivIncOne(p_fx_params->cyclediv_inc_one);
+	this->enableRecursiveComb(p_fx_params->recursive_comb);
+
+	return TRUE;
+}
+
+/*
+	render_session(): initialize, run the offline render loop on the audio backend in use, deinitialize.
+	p_elapsed_sec receives the time spent in the render loop (set to NULL if unused).
+*/
+
+BOOL WINAPI AudioRTDSP::render_session(const audiortdsp_fx_params_t *p_fx_params, ULONG64 *p_n_frames, DOUBLE *p_elapsed_sec)
+{
+	BOOL ret = FALSE;
+
+	LARGE_INTEGER qpc_freq;
+	LARGE_INTEGER qpc_begin;
+	LARGE_INTEGER qpc_end;
+
+	if(!this->initialize()) return FALSE;
+
+	if(p_fx_params != NULL)
+	{
+		if(!this->render_set_fx(p_fx_params)) goto _l_render_session_deinit;
+	}
+
+	this->status = this->STATUS_PLAYING;
+
+	QueryPerformanceFrequency(&qpc_freq);
+	QueryPerformanceCounter(&qpc_begin);
+
+	ret = this->render_proc(p_n_frames);
+
+	QueryPerformanceCounter(&qpc_end);
+
+	if(p_elapsed_sec != NULL) *p_elapsed_sec = ((DOUBLE) (qpc_end.QuadPart - qpc_begin.QuadPart))/((DOUBLE) qpc_freq.QuadPart);
+
+_l_render_session_deinit:
+	this->cmd_discard();
+
+	this->filein_close();
+	this->audio_hw_deinit_device();
+	this->buffer_free();
+
+	this->status = this->STATUS_UNINITIALIZED;
+	return ret;
+}
+
+/*
+	render_chunk(): render one parallel render chunk on a new object of the same type. Called from the render threads.
+
+	The chunk object reads the input from (nframe_begin - history) and writes its output through an AudioBackend_WAVRegion,
+	which discards the history frames and writes the rest at nframe_begin in the output file.
+*/
+
+BOOL WINAPI AudioRTDSP::render_chunk(const audiortdsp_render_chunk_t *p_chunk)
+{
+	AudioRTDSP *p_chunk_audio = NULL;
+	ULONG64 nframe_in_begin = 0u;
+	ULONG64 n_frames = 0u;
+	BOOL ret = FALSE;
+
+	audiortdsp_pb_params_t pb_params;
+
+	/*
+		The history start is rounded down to the segment grid of the sequential render, so the input buffer ring holds the exact same frames at every segment.
+	*/
+
+	nframe_in_begin = 0u;
+	if(p_chunk->nframe_begin > this->render_history_frames) nframe_in_begin = p_chunk->nframe_begin - this->render_history_frames;
+
+	nframe_in_begin -= nframe_in_begin%((ULONG64) this->BUFFER_SEGMENT_SIZE_FRAMES);
+
+	pb_params.file_dir = this->FILEIN_DIR.c_str();
+	pb_params.audio_data_begin = this->AUDIO_DATA_BEGIN + nframe_in_begin*((ULONG64) this->FILEIN_FRAME_SIZE_BYTES);
+	pb_params.audio_data_end = this->AUDIO_DATA_BEGIN + (p_chunk->nframe_end)*((ULONG64) this->FILEIN_FRAME_SIZE_BYTES);
+	pb_params.sample_rate = this->SAMPLE_RATE;
+	pb_params.n_channels = (UINT16) this->N_CHANNELS;
+
+	p_chunk_audio = this->instance_create(&pb_params);
+	if(p_chunk_audio == NULL)
+	{
+		this->playback_fail(TEXT("AudioRTDSP::render_chunk: Error: failed to create audio object instance."));
+		return FALSE;
+	}
+
+	p_chunk_audio->enableMappedInput(this->filein_map_enable);
+	p_chunk_audio->setReadAheadSize(this->READAHEAD_SIZE_BYTES);
+	p_chunk_audio->setAudioBackend(new AudioBackend_WAVRegion(this->render_fileout_dir.c_str(), this->render_data_offset, p_chunk->nframe_begin, (p_chunk->nframe_begin - nframe_in_begin), (p_chunk->nframe_end - p_chunk->nframe_begin), this->RENDER_BUFFER_SIZE_FRAMES));
+
+	ret = p_chunk_audio->render_session(&(this->dsp_params), &n_frames, NULL);
+	if(!ret) this->playback_fail(p_chunk_audio->getLastErrorMessage().c_str());
+
+	InterlockedExchangeAdd64(&(this->io_n_reads), p_chunk_audio->io_n_reads);
+	InterlockedExchangeAdd64(&(this->io_n_waits), p_chunk_audio->io_n_waits);
+	InterlockedExchangeAdd64(&(this->io_wait_ticks), p_chunk_audio->io_wait_ticks);
+
+	delete p_chunk_audio;
+	return ret;
+}
+
+VOID WINAPI AudioRTDSP::render_stats_set(audiortdsp_render_stats_t *p_stats, ULONG64 n_frames, DOUBLE elapsed_sec)
+{
+	audiortdsp_io_stats_t io_stats;
+
+	if(p_stats == NULL) return;
+
+	this->getIOStats(&io_stats);
+
+	p_stats->n_frames = n_frames;
+	p_stats->elapsed_sec = elapsed_sec;
+	p_stats->frames_per_sec = 0.0;
+	p_stats->realtime_factor = 0.0;
+	p_stats->io_wait_sec = io_stats.wait_sec;
+	p_stats->arena_size = this->arena_size;
+
+	if(p_stats->elapsed_sec > 0.0)
+	{
+		p_stats->frames_per_sec = ((DOUBLE) n_frames)/(p_stats->elapsed_sec);
+		p_stats->realtime_factor = (p_stats->frames_per_sec)/((DOUBLE) this->SAMPLE_RATE);
+	}
+
+	return;
+}
+
+/*
+	render_proc(): offline render loop. Same load/DSP stages as the playback session, run back to back on the calling thread.
+	The output file gets exactly the frames within the input audio data (the last segment is trimmed), up to a CMD_STOP command if any.
+*/
+
+BOOL WINAPI AudioRTDSP::render_proc(ULONG64 *p_n_frames)
+{
+	ULONG64 n_frames_total = 0u;
+	VOID *p_out = NULL;
+
+	*((ULONG64*) &(this->filein_pos_64)) = this->AUDIO_DATA_BEGIN;
+	this->filein_read_begin();
+
+	this->stop_playback = 0;
+
+	this->bufferout_nseg_load = 0u;
+	this->bufferout_nseg_play = 0u;
+
+	this->bufferin_nseg_curr = 0u;
+
+	/*No history yet: the input buffer ring takes the size of the latest FX parameters right away*/
+
+	MemoryBarrier();
+	this->bufferin_set_size((SIZE_T) this->bufferin_size_next);
+
+	this->cmd_session_begin();
+
+	/*Write straight into the output file writer if it supports output spans*/
+
+	this->bufferout_direct = this->p_backend->canAcquireFrames();
+
+	if(!this->p_backend->start())
+	{
+		this->err_msg = this->p_backend->getLastErrorMessage();
+		return FALSE;
+	}
+
+	while(TRUE)
+	{
+		this->buffer_load();
+		if(this->stop_playback) break;
+
+		if(this->bufferout_direct)
+		{
+			if(!this->p_backend->acquireFrames(this->BUFFER_SEGMENT_SIZE_FRAMES, &p_out))
+			{
+				this->err_msg = this->p_backend->getLastErrorMessage();
+				return FALSE;
+			}
+
+			this->dsp_proc(p_out);
+
+			if(!this->p_backend->commitFrames(this->bufferout_nframes_valid))
+			{
+				this->err_msg = this->p_backend->getLastErrorMessage();
+				return FALSE;
+			}
+		}
+		else
+		{
+			p_out = this->pp_bufferout_segments[this->bufferout_nseg_load];
+
+			this->dsp_proc(p_out);
+
+			if(!this->p_backend->writeFrames(p_out, this->bufferout_nframes_valid))
+			{
+				this->err_msg = this->p_backend->getLastErrorMessage();
+				return FALSE;
+			}
+		}
+
+		n_frames_total += (ULONG64) this->bufferout_nframes_valid;
+
+		if(this->cmd_stop) break;
+
+		this->bufferin_nseg_curr++;
+		this->bufferin_nseg_curr %= this->BUFFERIN_N_SEGMENTS;
+	}
+
+	if(!this->p_backend->flush())
+	{
+		this->err_msg = this->p_backend->getLastErrorMessage();
+		return FALSE;
+	}
+
+	*p_n_frames = n_frames_total;
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::playback_init(VOID)
+{
+	*((ULONG64*) &(this->filein_pos_64)) = this->AUDIO_DATA_BEGIN;
+	this->filein_read_begin();
+
+	this->stop_playback = 0;
+	this->playback_error = 0;
+
+	this->bufferout_nseg_load = 0u;
+	this->bufferout_nseg_play = 0u;
+
+	this->bufferin_nseg_curr = 0u;
+
+	/*No history yet: the input buffer ring takes the size of the latest FX parameters right away*/
+
+	MemoryBarrier();
+	this->bufferin_set_size((SIZE_T) this->bufferin_size_next);
+
+	this->bufferout_reset();
+
+	this->bufferout_direct = (this->bufferout_direct_enable && this->p_backend->canAcquireFrames());
+
+	/*Default FX Initialization*/
+
+	this->setFXDelay(240u);
+	this->setFXFeedback(20u);
+	this->enableFeedbackAltPol(TRUE);
+	this->enableCycleDivIncOne(TRUE);
+
+	this->cmd_session_begin();
+
+	/*Prime the whole audio buffer with silence before starting the output*/
+
+	if(!this->p_backend->writeFrames(NULL, this->AUDIOBUFFER_SIZE_FRAMES))
+	{
+		this->playback_fail(this->p_backend->getLastErrorMessage().c_str());
+		return FALSE;
+	}
+
+	if(!this->p_backend->start())
+	{
+		this->playback_fail(this->p_backend->getLastErrorMessage().c_str());
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP::playback_loop(VOID)
+{
+	BOOL ret = FALSE;
+
+	this->p_event_bufferout_ready = event_create(FALSE);
+	this->p_event_bufferout_free = event_create(FALSE);
+
+	if((this->p_event_bufferout_ready == NULL) || (this->p_event_bufferout_free == NULL))
+	{
+		this->playback_fail(TEXT("AudioRTDSP::playback_loop: Error: could not create output buffer events."));
+		goto _l_playback_loop_end;
+	}
+
+	if(this->bufferout_direct)
+	{
+		/*Direct output: the play thread does it all, there's no segment to hand off*/
+
+		if(!thread_worker_create(&(this->playworker), ((DWORD (WINAPI *)(VOID*)) &AudioRTDSP::directthread_proc), this))
+		{
+			this->playback_fail(TEXT("AudioRTDSP::playback_loop: Error: could not create play thread."));
+			goto _l_playback_loop_end;
+		}
+
+		thread_worker_run(&(this->playworker));
+		thread_worker_wait(&(this->playworker));
+		goto _l_playback_loop_end;
+	}
+
+	if(!thread_worker_create(&(this->playworker), ((DWORD (WINAPI *)(VOID*)) &AudioRTDSP::playthread_proc), this))
+	{
+		this->playback_fail(TEXT("AudioRTDSP::playback_loop: Error: could not create play thread."));
+		goto _l_playback_loop_end;
+	}
+
+	if(!thread_worker_create(&(this->loadworker), ((DWORD (WINAPI *)(VOID*)) &AudioRTDSP::loadthread_proc), this))
+	{
+		this->playback_fail(TEXT("AudioRTDSP::playback_loop: Error: could not create load thread."));
+		goto _l_playback_loop_end;
+	}
+
+	/*
+		The load thread and the play thread run free until the end of the playback session,
+		handing off processed segments through the output buffer ring.
+	*/
+
+	thread_worker_run(&(this->playworker));
+	thread_worker_run(&(this->loadworker));
+	thread_worker_wait(&(this->loadworker));
+	thread_worker_wait(&(this->playworker));
+
+_l_playback_loop_end:
+	if(!this->playback_error)
+	{
+		if(!this->p_backend->flush()) this->playback_fail(this->p_backend->getLastErrorMessage().c_str());
+	}
+
+	thread_worker_destroy(&(this->loadworker));
+	thread_worker_destroy(&(this->playworker));
+
+	if(this->p_event_bufferout_ready != NULL) event_destroy(&(this->p_event_bufferout_ready));
+	if(this->p_event_bufferout_free != NULL) event_destroy(&(this->p_event_bufferout_free));
+
+	ret = !this->playback_error;
+	return ret;
+}
+
+/*
+	playback_fail(): called from any playback thread when the playback session can't go on.
+	Records the error (first one only) and wakes up both threads so they can quit.
+*/
+
+VOID WINAPI AudioRTDSP::playback_fail(const TCHAR *err_msg)
+{
+	if(InterlockedCompareExchange(&(this->playback_error), 1, 0) == 0) this->err_msg = err_msg;
+
+	InterlockedExchange(&(this->stop_playback), 1);
+
+	if(this->p_event_bufferout_ready != NULL) event_signal(this->p_event_bufferout_ready);
+	if(this->p_event_bufferout_free != NULL) event_signal(this->p_event_bufferout_free);
+
+	return;
+}
+
+VOID WINAPI AudioRTDSP::bufferout_reset(VOID)
+{
+	LARGE_INTEGER qpc_freq;
+
+	this->bufferout_ring.n_push = 0;
+	this->bufferout_ring.n_pop = 0;
+
+	this->bufferout_load_done = 0;
+
+	this->bufferout_stats.n_segments = this->BUFFEROUT_N_SEGMENTS;
+	this->bufferout_stats.n_ready = 0u;
+	this->bufferout_stats.n_ready_high = 0u;
+	this->bufferout_stats.n_ready_low = this->BUFFEROUT_N_SEGMENTS;
+	this->bufferout_stats.n_underruns = 0u;
+	this->bufferout_stats.n_played = 0u;
+
+	/*The adaptive depth starts at the full depth, until the first segments have been measured*/
+
+	QueryPerformanceFrequency(&qpc_freq);
+
+	this->bufferout_depth = this->BUFFEROUT_N_SEGMENTS;
+	this->depth_period_ticks = (LONG64) ((((ULONG64) this->BUFFER_SEGMENT_SIZE_FRAMES)*((ULONG64) qpc_freq.QuadPart))/((ULONG64) this->SAMPLE_RATE));
+	this->depth_unit_ticks = 0;
+	this->depth_load_pct = 0u;
+
+	this->dsp_tap_limit = 0;
+	this->bufferout_stats.n_degrade_events = 0u;
+	this->bufferout_stats.n_degraded_segments = 0u;
+
+#ifdef __RTDSP_TELEMETRY
+	this->telemetry_reset();
+#endif
+	return;
+}
+
+SIZE_T WINAPI AudioRTDSP::bufferout_get_nready(VOID)
+{
+	SIZE_T n_ready = 0u;
+
+	n_ready = (SIZE_T) (((ULONG) this->bufferout_ring.n_push) - ((ULONG) this->bufferout_ring.n_pop));
+	MemoryBarrier();
+
+	return n_ready;
+}
+
+/*
+	bufferout_wait_free(): called by the load thread before loading a new segment.
+	Waits until there's a free segment in the output buffer.
+	returns FALSE if playback should stop, TRUE otherwise.
+*/
+
+BOOL WINAPI AudioRTDSP::bufferout_wait_free(VOID)
+{
+	while(this->bufferout_get_nready() >= this->bufferout_depth)
+	{
+		if(this->stop_playback) return FALSE;
+
+		event_wait(this->p_event_bufferout_free, INFINITE);
+	}
+
+	return (!this->stop_playback);
+}
+
+/*
+	bufferout_push(): called by the load thread once the segment at bufferout_nseg_load has been processed.
+	Makes it available to the play thread and moves on to the next input and output segments.
+*/
+
+VOID WINAPI AudioRTDSP::bufferout_push(VOID)
+{
+	this->bufferin_nseg_curr++;
+	this->bufferin_nseg_curr %= this->BUFFERIN_N_SEGMENTS;
+
+	this->bufferout_nseg_load++;
+	this->bufferout_nseg_load %= this->BUFFEROUT_N_SEGMENTS;
+
+	InterlockedIncrement(&(this->bufferout_ring.n_push));
+	event_signal(this->p_event_bufferout_ready);
+
+	return;
+}
+
+/*
+	bufferout_wait_ready(): called by the play thread before playing a segment.
+	Waits until there's a processed segment ready at bufferout_nseg_play.
+	returns FALSE if there are no more segments to play (the load thread is done and the ring is empty), TRUE otherwise.
+*/
+
+BOOL WINAPI AudioRTDSP::bufferout_wait_ready(VOID)
+{
+	SIZE_T n_ready = 0u;
+
+	n_ready = this->bufferout_get_nready();
+
+	if(!n_ready && !this->bufferout_load_done && (this->bufferout_stats.n_played > 0u)) this->bufferout_stats.n_underruns++;
+
+	if(this->bufferout_stats.n_played > 0u)
+	{
+		if(n_ready > this->bufferout_stats.n_ready_high) this->bufferout_stats.n_ready_high = n_ready;
+		if(n_ready < this->bufferout_stats.n_ready_low) this->bufferout_stats.n_ready_low = n_ready;
+	}
+
+	while(!n_ready)
+	{
+		if(this->playback_error) return FALSE;
+
+		if(this->bufferout_load_done)
+		{
+			/*The last segment may have been pushed right before bufferout_load_done was set*/
+			n_ready = this->bufferout_get_nready();
+			return (n_ready > 0u);
+		}
+
+		event_wait(this->p_event_bufferout_ready, INFINITE);
+		n_ready = this->bufferout_get_nready();
+	}
+
+	return TRUE;
+}
+
+/*
+	bufferout_pop(): called by the play thread once the segment at bufferout_nseg_play has been copied to the audio hardware buffer.
+	Releases it back to the load thread and moves on to the next output segment.
+*/
+
+VOID WINAPI AudioRTDSP::bufferout_pop(VOID)
+{
+	this->bufferout_nseg_play++;
+	this->bufferout_nseg_play %= this->BUFFEROUT_N_SEGMENTS;
+
+	this->bufferout_stats.n_played++;
+
+	InterlockedIncrement(&(this->bufferout_ring.n_pop));
+	event_signal(this->p_event_bufferout_free);
+
+	return;
+}
+
+/*
+	Expected load stage cost: depth_unit_ticks times the DSP units of the FX parameters in use (front snapshot), so it follows every FX parameter change.
+	While the load thread works on a segment, at most (bufferout_depth - 1) processed segments are queued for the play thread:
+	the active depth covers the expected cost plus the margin with queued segments, plus 1.
+*/
+
+VOID WINAPI AudioRTDSP::depth_update(LONG64 load_ticks)
+{
+	const audiortdsp_dspsnap_t *p_snap = NULL;
+	LONG64 n_units = 0;
+	LONG64 unit_ticks = 0;
+	LONG64 cost_ticks = 0;
+	LONG64 deadline_ticks = 0;
+	LONG64 n_depth = 0;
+	LONG64 load_pct = 0;
+
+	if(this->depth_period_ticks <= 0) return;
+
+	p_snap = &(this->dspsnaps[this->dspsnap_front]);
+
+	if(p_snap->comb_active) n_units = 2;
+	else if((this->dsp_tap_limit > 0) && (p_snap->n_taps > this->dsp_tap_limit)) n_units = ((LONG64) this->dsp_tap_limit) + 1;
+	else n_units = ((LONG64) p_snap->n_taps) + 1;
+
+	/*Decaying peak: a cost spike raises it right away, then it decays by 1/DEPTH_DECAY_SEGMENTS per segment*/
+
+	unit_ticks = load_ticks/n_units;
+
+	this->depth_unit_ticks -= (this->depth_unit_ticks)/((LONG64) this->DEPTH_DECAY_SEGMENTS);
+	if(unit_ticks > this->depth_unit_ticks) this->depth_unit_ticks = unit_ticks;
+
+	/*Expected cost for all the taps, the ones the watchdog dropped included*/
+
+	if(!p_snap->comb_active) n_units = ((LONG64) p_snap->n_taps) + 1;
+
+	cost_ticks = (this->depth_unit_ticks)*n_units;
+
+	load_pct = (cost_ticks*100)/(this->depth_period_ticks);
+	if(load_pct > 0xffffffff) load_pct = 0xffffffff;
+
+	this->depth_load_pct = (UINT32) load_pct;
+
+	if(!this->depth_adapt) return;
+
+	/*Queued segments: ceil(cost*(100 + margin)/(100*period))*/
+
+	deadline_ticks = 100*(this->depth_period_ticks);
+
+	n_depth = (cost_ticks*((LONG64) (100u + this->depth_margin_pct)) + deadline_ticks - 1)/deadline_ticks;
+	n_depth++;
+
+	if(n_depth < (LONG64) this->BUFFEROUT_MIN_N_SEGMENTS) n_depth = (LONG64) this->BUFFEROUT_MIN_N_SEGMENTS;
+	if(n_depth > (LONG64) this->BUFFEROUT_N_SEGMENTS) n_depth = (LONG64) this->BUFFEROUT_N_SEGMENTS;
+
+	this->bufferout_depth = (SIZE_T) n_depth;
+	return;
+}
+
+/*
+	Budget: the processed segments still queued, one segment period each (the device buffer is left as extra slack).
+	Taps that fit: budget/(unit cost plus the margin), minus 1 for the current segment.
+	Nothing is dropped before the first segment is played (the ring is still filling up), nor before the cost has been measured.
+*/
+
+VOID WINAPI AudioRTDSP::dsp_watchdog(VOID)
+{
+	const audiortdsp_dspsnap_t *p_snap = NULL;
+	LONG64 budget_ticks = 0;
+	LONG64 unit_ticks = 0;
+	LONG64 n_units = 0;
+	INT32 tap_limit = 0;
+	BOOL degraded = FALSE;
+
+	degraded = (this->dsp_tap_limit > 0);
+	this->dsp_tap_limit = 0;
+
+	if(!this->bufferout_stats.n_played) return;
+	if(this->depth_unit_ticks <= 0) return;
+
+	p_snap = &(this->dspsnaps[this->dspsnap_front]);
+
+	if(p_snap->comb_active) return;
+	if(p_snap->n_taps <= this->DEGRADE_MIN_TAPS) return;
+
+	budget_ticks = ((LONG64) this->bufferout_get_nready())*(this->depth_period_ticks);
+	unit_ticks = ((this->depth_unit_ticks)*((LONG64) (100u + this->depth_margin_pct)))/100;
+
+	n_units = budget_ticks/unit_ticks;
+	if(n_units > (LONG64) p_snap->n_taps) return;
+
+	tap_limit = (INT32) (n_units - 1);
+	if(tap_limit < this->DEGRADE_MIN_TAPS) tap_limit = this->DEGRADE_MIN_TAPS;
+
+	/*Keep at least 1 tap, 0 means no limit*/
+
+	if(tap_limit < 1) tap_limit = 1;
+
+	this->dsp_tap_limit = tap_limit;
+
+	this->bufferout_stats.n_degraded_segments++;
+	if(!degraded) this->bufferout_stats.n_degrade_events++;
+
+	return;
+}
+
+#ifdef __RTDSP_TELEMETRY
+VOID WINAPI AudioRTDSP::telemetry_reset(VOID)
+{
+	LARGE_INTEGER qpc_freq;
+
+	QueryPerformanceFrequency(&qpc_freq);
+
+	ZeroMemory(this->telemetry_counters, sizeof(this->telemetry_counters));
+	ZeroMemory(this->telemetry_push_ticks, sizeof(this->telemetry_push_ticks));
+
+	this->telemetry_padding_min = 0u;
+	this->telemetry_padding_max = 0u;
+	this->telemetry_padding_sum = 0u;
+	this->telemetry_padding_n = 0u;
+
+	this->telemetry_qpc_freq = (LONG64) qpc_freq.QuadPart;
+	return;
+}
+
+/*
+	Bucket: number of significant bits of the duration in microseconds (0 for less than 1 microsecond), clamped to the last bucket.
+*/
+
+VOID WINAPI AudioRTDSP::telemetry_record(SIZE_T n_stage, LONG64 n_ticks)
+{
+	audiortdsp_telemetry_counter_t *p_counter = NULL;
+	ULONG64 n_us = 0u;
+	SIZE_T n_bucket = 0u;
+
+	if(n_ticks < 0) n_ticks = 0;
+
+	p_counter = &(this->telemetry_counters[n_stage]);
+
+	n_us = (((ULONG64) n_ticks)*1000000u)/((ULONG64) this->telemetry_qpc_freq);
+
+	while(n_us && (n_bucket < (AUDIORTDSP_TELEMETRY_N_BUCKETS - 1u)))
+	{
+		n_us = (n_us >> 1);
+		n_bucket++;
+	}
+
+	p_counter->n_samples++;
+	p_counter->sum_ticks += (ULONG64) n_ticks;
+	if(((ULONG64) n_ticks) > p_counter->max_ticks) p_counter->max_ticks = (ULONG64) n_ticks;
+	p_counter->hist[n_bucket]++;
+
+	return;
+}
+
+VOID WINAPI AudioRTDSP::telemetry_end(SIZE_T n_stage, const LARGE_INTEGER *p_qpc_begin)
+{
+	LARGE_INTEGER qpc_end;
+
+	QueryPerformanceCounter(&qpc_end);
+
+	this->telemetry_record(n_stage, (LONG64) (qpc_end.QuadPart - p_qpc_begin->QuadPart));
+	return;
+}
+
+/*
+	The timestamp is written before bufferout_push() publishes the segment, the play thread reads it after bufferout_wait_ready() saw it.
+*/
+
+VOID WINAPI AudioRTDSP::telemetry_push(VOID)
+{
+	LARGE_INTEGER qpc;
+
+	QueryPerformanceCounter(&qpc);
+
+	this->telemetry_push_ticks[this->bufferout_nseg_load] = (LONG64) qpc.QuadPart;
+	return;
+}
+
+VOID WINAPI AudioRTDSP::telemetry_pop(VOID)
+{
+	LARGE_INTEGER qpc;
+
+	QueryPerformanceCounter(&qpc);
+
+	this->telemetry_record(this->TELEMETRY_SLACK, ((LONG64) qpc.QuadPart) - this->telemetry_push_ticks[this->bufferout_nseg_play]);
+	return;
+}
+
+VOID WINAPI AudioRTDSP::telemetry_padding(VOID)
+{
+	SIZE_T n_free = 0u;
+	SIZE_T n_padding = 0u;
+
+	if(!this->p_backend->getFramesFree(&n_free)) return;
+
+	if(n_free < this->AUDIOBUFFER_SIZE_FRAMES) n_padding = this->AUDIOBUFFER_SIZE_FRAMES - n_free;
+
+	if(!this->telemetry_padding_n || (n_padding < this->telemetry_padding_min)) this->telemetry_padding_min = n_padding;
+	if(n_padding > this->telemetry_padding_max) this->telemetry_padding_max = n_padding;
+
+	this->telemetry_padding_sum += (ULONG64) n_padding;
+	this->telemetry_padding_n++;
+
+	return;
+}
+
+/*
+	Percentiles: upper bound of the first bucket where the cumulative count reaches the percentile rank (the longest duration for the last bucket).
+*/
+
+VOID WINAPI AudioRTDSP::telemetry_stage_get(SIZE_T n_stage, audiortdsp_telemetry_stage_t *p_stage)
+{
+	const ULONG64 PERMILLES[3] = {500u, 990u, 999u};
+
+	const audiortdsp_telemetry_counter_t *p_counter = NULL;
+	DOUBLE percentiles[3];
+	DOUBLE us_per_tick = 0.0;
+	ULONG64 n_rank = 0u;
+	ULONG64 n_count = 0u;
+	SIZE_T n_bucket = 0u;
+	SIZE_T n_pct = 0u;
+
+	p_counter = &(this->telemetry_counters[n_stage]);
+
+	us_per_tick = 1000000.0/((DOUBLE) this->telemetry_qpc_freq);
+
+	CopyMemory(p_stage->hist, p_counter->hist, sizeof(p_stage->hist));
+
+	p_stage->n_samples = p_counter->n_samples;
+	p_stage->max_us = ((DOUBLE) p_counter->max_ticks)*us_per_tick;
+
+	if(p_stage->n_samples) p_stage->avg_us = (((DOUBLE) p_counter->sum_ticks)*us_per_tick)/((DOUBLE) p_stage->n_samples);
+	else p_stage->avg_us = 0.0;
+
+	for(n_pct = 0u; n_pct < 3u; n_pct++)
+	{
+		percentiles[n_pct] = 0.0;
+
+		n_rank = ((p_stage->n_samples)*PERMILLES[n_pct] + 999u)/1000u;
+		if(!n_rank) continue;
+
+		n_count = 0u;
+
+		for(n_bucket = 0u; n_bucket < AUDIORTDSP_TELEMETRY_N_BUCKETS; n_bucket++)
+		{
+			n_count += p_stage->hist[n_bucket];
+			if(n_count >= n_rank) break;
+		}
+
+		if(n_bucket < (AUDIORTDSP_TELEMETRY_N_BUCKETS - 1u)) percentiles[n_pct] = (DOUBLE) (1ull << n_bucket);
+		else percentiles[n_pct] = p_stage->max_us;
+
+		if(percentiles[n_pct] > p_stage->max_us) percentiles[n_pct] = p_stage->max_us;
+	}
+
+	p_stage->p50_us = percentiles[0];
+	p_stage->p99_us = percentiles[1];
+	p_stage->p999_us = percentiles[2];
+
+	return;
+}
+#endif
+
+VOID WINAPI AudioRTDSP::buffer_load(VOID)
+{
+	ULONG64 filein_pos = 0u;
+	ULONG64 nframe_seek = 0u;
+	SIZE_T seek_seg_nframe = 0u;
+	SIZE_T n_valid = 0u;
+	SIZE_T n_valid_seek = 0u;
+	BOOL seek = FALSE;
+
+	this->cmd_collect();
+
+	seek = this->cmd_seek_take(&seek_seg_nframe, &nframe_seek);
+
+	filein_pos = *((ULONG64*) &(this->filein_pos_64));
+
+	if(!seek && (filein_pos >= this->AUDIO_DATA_END))
+	{
+		InterlockedExchange(&(this->stop_playback), 1);
+		return;
+	}
+
+	if(!seek) seek_seg_nframe = this->BUFFER_SEGMENT_SIZE_FRAMES;
+
+	this->bufferin_seek_seg_nframe = seek_seg_nframe;
+	this->filein_nframe_curr = (filein_pos - this->AUDIO_DATA_BEGIN)/((ULONG64) this->FILEIN_FRAME_SIZE_BYTES);
+	this->filein_nframe_seek = nframe_seek;
+
+	n_valid = this->buffer_load_span(0u, seek_seg_nframe);
+
+	/*The input continues from the seek target, the frames before the seek are kept as they are*/
+
+	if(seek)
+	{
+		*((ULONG64*) &(this->filein_pos_64)) = this->AUDIO_DATA_BEGIN + nframe_seek*((ULONG64) this->FILEIN_FRAME_SIZE_BYTES);
+
+		n_valid_seek = this->buffer_load_span(seek_seg_nframe, (this->BUFFER_SEGMENT_SIZE_FRAMES - seek_seg_nframe));
+		if(n_valid_seek) n_valid = seek_seg_nframe + n_valid_seek;
+	}
+
+	this->bufferout_nframes_valid = n_valid;
+	return;
+}
+
+SIZE_T WINAPI AudioRTDSP::buffer_load_span(SIZE_T seg_nframe, SIZE_T n_frames)
+{
+	ULONG64 filein_pos = 0u;
+	ULONG64 n_frames_left = 0u;
+
+	if(!n_frames) return 0u;
+
+	filein_pos = *((ULONG64*) &(this->filein_pos_64));
+
+	if(filein_pos < this->AUDIO_DATA_END) n_frames_left = (this->AUDIO_DATA_END - filein_pos)/((ULONG64) this->FILEIN_FRAME_SIZE_BYTES);
+
+	if(this->p_filein_data == NULL) this->buffer_read(seg_nframe, n_frames);
+	else *((ULONG64*) &(this->filein_pos_64)) += ((ULONG64) n_frames)*((ULONG64) this->FILEIN_FRAME_SIZE_BYTES);
+
+	if(n_frames_left < ((ULONG64) n_frames)) return (SIZE_T) n_frames_left;
+
+	return n_frames;
+}
+
+/*
+	Without commands (and seek), the whole segment is 1 block.
+	A CMD_STOP command ends the segment where it applies: the rest of the segment is silence.
+*/
+
+VOID WINAPI AudioRTDSP::dsp_proc(VOID *p_out)
+{
+	audiortdsp_dspsnap_t *p_snap = NULL;
+	audiortdsp_fx_params_t fx_params_prev;
+
+	LARGE_INTEGER qpc_begin;
+	LARGE_INTEGER qpc_end;
+
+	SIZE_T seg_nframe = 0u;
+	SIZE_T n_frames = 0u;
+	BOOL xfade = FALSE;
+
+	CopyMemory(&fx_params_prev, &(this->dspengine_params), sizeof(audiortdsp_fx_params_t));
+
+	/*A new snapshot waits for the running transition to end*/
+
+	if(this->xfade_len) p_snap = &(this->dspsnaps[this->dspsnap_front]);
+	else p_snap = this->dsp_snapshot_acquire();
+
+	if(p_snap->xfade_frames || this->xfade_len) QueryPerformanceCounter(&qpc_begin);
+
+	this->bufferin_resize();
+
+	/*A snapshot built for a ring the load thread hasn't switched to yet waits, the FX parameters in use go on meanwhile*/
+
+	if(p_snap->ring_frames > this->BUFFERIN_SIZE_FRAMES) p_snap = this->dsp_snapshot_hold(p_snap);
+
+	this->dsp_snapshot_merge(p_snap);
+	this->dsp_xfade_begin(p_snap, &fx_params_prev, 0u);
+
+	seg_nframe = 0u;
+	while(seg_nframe < this->BUFFER_SEGMENT_SIZE_FRAMES)
+	{
+		n_frames = this->cmd_apply(p_snap, seg_nframe);
+		if(!n_frames) break;
+
+		if(this->xfade_len)
+		{
+			this->dsp_xfade_block(p_snap, seg_nframe, n_frames);
+			xfade = TRUE;
+		}
+		else if(this->p_filein_data != NULL) this->dsp_proc_block_mapped(p_snap, this->p_dspbuffer, seg_nframe, n_frames);
+		else this->dsp_proc_block(p_snap, this->p_dspbuffer, seg_nframe, n_frames);
+
+		seg_nframe += n_frames;
+	}
+
+	if(seg_nframe < this->BUFFER_SEGMENT_SIZE_FRAMES)
+	{
+		ZeroMemory(&(this->p_dspbuffer[seg_nframe*(this->N_CHANNELS)]), (this->BUFFER_SEGMENT_SIZE_FRAMES - seg_nframe)*(this->N_CHANNELS)*sizeof(INT32));
+		if(this->bufferout_nframes_valid > seg_nframe) this->bufferout_nframes_valid = seg_nframe;
+	}
+
+	this->dsp_saturate(p_out, this->p_dspbuffer, this->BUFFER_SEGMENT_SIZE_SAMPLES);
+
+	if(xfade)
+	{
+		QueryPerformanceCounter(&qpc_end);
+		this->xfade_dsp_ticks += (LONG64) (qpc_end.QuadPart - qpc_begin.QuadPart);
+	}
+
+	InterlockedExchange64(&(this->dsp_nframe_curr), (this->dsp_nframe_curr + ((LONG64) this->BUFFER_SEGMENT_SIZE_FRAMES)));
+	return;
+}
+
+VOID WINAPI AudioRTDSP::dsp_proc_block(const audiortdsp_dspsnap_t *p_snap, INT32 *p_dsp, SIZE_T seg_begin, SIZE_T n_frames)
+{
+	BYTE *p_bufferin = NULL;
+	INT32 *p_acc = NULL;
+
+	SIZE_T currin_buf_nframe = 0u;
+	SIZE_T previn_buf_nframe = 0u;
+	SIZE_T span1_nframes = 0u;
+	SIZE_T span1_nsamples = 0u;
+	SIZE_T n_samples = 0u;
+
+	SIZE_T seg_end = 0u;
+	SIZE_T seg_nframe = 0u;
+	SIZE_T n_frames_comb = 0u;
+	SIZE_T corr_buf_nframe = 0u;
+	SIZE_T corr_delay = 0u;
+	const VOID *p_corr_src = NULL;
+
+	SIZE_T tap2_buf_nframe = 0u;
+	SIZE_T tap2_span1_nframes = 0u;
+	SIZE_T n_frame = 0u;
+	SIZE_T n_frames_span = 0u;
+	const BYTE *p_src1 = NULL;
+	const BYTE *p_src2 = NULL;
+
+	INT32 n_cycle = 0;
+	INT32 n_taps = 0;
+	INT32 n_delay = 0;
+
+	const dspkernel_gain_t *p_gain = NULL;
+
+	dspkernel_comb_t comb;
+
+	p_bufferin = (BYTE*) this->p_bufferinput;
+
+	n_taps = p_snap->n_taps;
+	if(p_snap->comb_active) n_taps = 0;
+	if((this->dsp_tap_limit > 0) && (n_taps > this->dsp_tap_limit)) n_taps = this->dsp_tap_limit;
+
+	currin_buf_nframe = (this->bufferin_nseg_curr)*(this->BUFFER_SEGMENT_SIZE_FRAMES);
+
+	seg_end = seg_begin + n_frames;
+	n_samples = n_frames*(this->N_CHANNELS);
+	p_acc = &p_dsp[seg_begin*(this->N_CHANNELS)];
+
+	this->dsp_load(p_acc, &p_bufferin[(currin_buf_nframe + seg_begin)*(this->BUFFER_FRAME_SIZE_BYTES)], n_samples);
+
+	/*
+		Recursive comb: all feedback taps at once, one block of up to n_delay frames at a time.
+		The comb state of the current segment is written to the same frames of p_dspcomb_state.
+	*/
+
+	if(p_snap->comb_active)
+	{
+		CopyMemory(&comb, &(p_snap->comb), sizeof(dspkernel_comb_t));
+		corr_delay = p_snap->comb_corr_delay;
+
+		seg_nframe = seg_begin;
+		while(seg_nframe < seg_end)
+		{
+			if(!this->dsp_comb_span(seg_nframe, (SIZE_T) p_snap->fx_params.n_delay, corr_delay, &previn_buf_nframe, &corr_buf_nframe, &n_frames_comb)) break;
+			if(n_frames_comb > (seg_end - seg_nframe)) n_frames_comb = seg_end - seg_nframe;
+
+			p_corr_src = NULL;
+			if(corr_delay) p_corr_src = &p_bufferin[corr_buf_nframe*(this->BUFFER_FRAME_SIZE_BYTES)];
+
+			this->dsp_comb(&(this->p_dspcomb_state[(currin_buf_nframe + seg_nframe)*(this->N_CHANNELS)]), &p_dsp[seg_nframe*(this->N_CHANNELS)], &p_bufferin[previn_buf_nframe*(this->BUFFER_FRAME_SIZE_BYTES)], &(this->p_dspcomb_state[previn_buf_nframe*(this->N_CHANNELS)]), p_corr_src, n_frames_comb*(this->N_CHANNELS), &comb);
+
+			seg_nframe += n_frames_comb;
+		}
+	}
+
+	/*
+		Process the feedback taps two at a time over the whole block (one accumulator pass per pair of taps).
+		The delayed source of a tap is a contiguous span of the input buffer, split at most once at the ring wrap.
+		A pair of taps is processed in up to 3 spans, split wherever either of its sources wraps.
+	*/
+
+	n_cycle = 1;
+
+	while(n_cycle < n_taps)
+	{
+		p_gain = &(p_snap->p_gains[n_cycle - 1]);
+
+		n_delay = n_cycle*(p_snap->fx_params.n_delay);
+
+		this->retrieve_previn_span(this->bufferin_nseg_curr, seg_begin, n_frames, (SIZE_T) n_delay, &previn_buf_nframe, &span1_nframes);
+		this->retrieve_previn_span(this->bufferin_nseg_curr, seg_begin, n_frames, (SIZE_T) (n_delay + p_snap->fx_params.n_delay), &tap2_buf_nframe, &tap2_span1_nframes);
+
+		n_frame = 0u;
+		while(n_frame < n_frames)
+		{
+			n_frames_span = n_frames - n_frame;
+
+			if(n_frame < span1_nframes)
+			{
+				p_src1 = &p_bufferin[(previn_buf_nframe + n_frame)*(this->BUFFER_FRAME_SIZE_BYTES)];
+				if((span1_nframes - n_frame) < n_frames_span) n_frames_span = span1_nframes - n_frame;
+			}
+			else p_src1 = &p_bufferin[(n_frame - span1_nframes)*(this->BUFFER_FRAME_SIZE_BYTES)];
+
+			if(n_frame < tap2_span1_nframes)
+			{
+				p_src2 = &p_bufferin[(tap2_buf_nframe + n_frame)*(this->BUFFER_FRAME_SIZE_BYTES)];
+				if((tap2_span1_nframes - n_frame) < n_frames_span) n_frames_span = tap2_span1_nframes - n_frame;
+			}
+			else p_src2 = &p_bufferin[(n_frame - tap2_span1_nframes)*(this->BUFFER_FRAME_SIZE_BYTES)];
+
+			this->dsp_accumulate2(&p_acc[n_frame*(this->N_CHANNELS)], p_src1, p_src2, n_frames_span*(this->N_CHANNELS), p_gain);
+
+			n_frame += n_frames_span;
+		}
+
+		n_cycle += 2;
+	}
+
+	/*Last tap of an odd number of taps*/
+
+	if(n_cycle == n_taps)
+	{
+		p_gain = &(p_snap->p_gains[n_cycle - 1]);
+
+		n_delay = n_cycle*(p_snap->fx_params.n_delay);
+
+		this->retrieve_previn_span(this->bufferin_nseg_curr, seg_begin, n_frames, (SIZE_T) n_delay, &previn_buf_nframe, &span1_nframes);
+
+		span1_nsamples = span1_nframes*(this->N_CHANNELS);
+
+		this->dsp_accumulate(p_acc, &p_bufferin[previn_buf_nframe*(this->BUFFER_FRAME_SIZE_BYTES)], span1_nsamples, p_gain);
+
+		if(span1_nsamples < n_samples)
+			this->dsp_accumulate(&p_acc[span1_nsamples], p_bufferin, (n_samples - span1_nsamples), p_gain);
+	}
+
+	return;
+}
+
+/*
+	dsp_proc_block_mapped(): dsp_proc_block() for the mapped input.
+	Same processing as the input buffer ring, with every input span read from the mapped audio data (zeros outside of it, see dsp_mapped_src()).
+	Tap spans that fall entirely before the first frame are skipped (they only add zeros).
+	A block never crosses the seek of the segment, so its input frames are contiguous in the file.
+*/
+
+VOID WINAPI AudioRTDSP::dsp_proc_block_mapped(const audiortdsp_dspsnap_t *p_snap, INT32 *p_dsp, SIZE_T seg_begin, SIZE_T n_frames)
+{
+	const VOID *p_src = NULL;
+	const VOID *p_src2 = NULL;
+	const VOID *p_corr_src = NULL;
+
+	LONG64 nframe_curr = 0;
+	LONG64 nframe_src = 0;
+	LONG64 nframe_src2 = 0;
+
+	SIZE_T currin_buf_nframe = 0u;
+	SIZE_T previn_buf_nframe = 0u;
+	SIZE_T seg_end = 0u;
+	SIZE_T seg_nframe = 0u;
+	SIZE_T n_frames_src = 0u;
+	SIZE_T corr_delay = 0u;
+
+	INT32 n_cycle = 0;
+	INT32 n_taps = 0;
+
+	const dspkernel_gain_t *p_gain = NULL;
+
+	dspkernel_comb_t comb;
+
+	n_taps = p_snap->n_taps;
+	if(p_snap->comb_active) n_taps = 0;
+	if((this->dsp_tap_limit > 0) && (n_taps > this->dsp_tap_limit)) n_taps = this->dsp_tap_limit;
+
+	/*nframe_curr: file frame of the first frame of the segment, as seen from this block*/
+
+	if(seg_begin < this->bufferin_seek_seg_nframe) nframe_curr = (LONG64) this->filein_nframe_curr;
+	else nframe_curr = ((LONG64) this->filein_nframe_seek) - ((LONG64) this->bufferin_seek_seg_nframe);
+
+	seg_end = seg_begin + n_frames;
+
+	seg_nframe = seg_begin;
+	while(seg_nframe < seg_end)
+	{
+		n_frames_src = seg_end - seg_nframe;
+		p_src = this->dsp_mapped_src(nframe_curr + ((LONG64) seg_nframe), &n_frames_src);
+
+		this->dsp_load(&p_dsp[seg_nframe*(this->N_CHANNELS)], p_src, n_frames_src*(this->N_CHANNELS));
+
+		seg_nframe += n_frames_src;
+	}
+
+	/*
+		Recursive comb: the comb state still lives in p_dspcomb_state (input buffer ring layout), the input and correction tap come from the mapped data.
+	*/
+
+	if(p_snap->comb_active)
+	{
+		CopyMemory(&comb, &(p_snap->comb), sizeof(dspkernel_comb_t));
+		corr_delay = p_snap->comb_corr_delay;
+
+		currin_buf_nframe = (this->bufferin_nseg_curr)*(this->BUFFER_SEGMENT_SIZE_FRAMES);
+
+		seg_nframe = seg_begin;
+		while(seg_nframe < seg_end)
+		{
+			if(!this->dsp_comb_span(seg_nframe, (SIZE_T) p_snap->fx_params.n_delay, 0u, &previn_buf_nframe, NULL, &n_frames_src)) break;
+			if(n_frames_src > (seg_end - seg_nframe)) n_frames_src = seg_end - seg_nframe;
+
+			p_src = this->dsp_mapped_src(nframe_curr + ((LONG64) seg_nframe) - ((LONG64) p_snap->fx_params.n_delay), &n_frames_src);
+
+			p_corr_src = NULL;
+			if(corr_delay) p_corr_src = this->dsp_mapped_src(nframe_curr + ((LONG64) seg_nframe) - ((LONG64) corr_delay), &n_frames_src);
+
+			this->dsp_comb(&(this->p_dspcomb_state[(currin_buf_nframe + seg_nframe)*(this->N_CHANNELS)]), &p_dsp[seg_nframe*(this->N_CHANNELS)], p_src, &(this->p_dspcomb_state[previn_buf_nframe*(this->N_CHANNELS)]), p_corr_src, n_frames_src*(this->N_CHANNELS), &comb);
+
+			seg_nframe += n_frames_src;
+		}
+	}
+
+	/*
+		Feedback taps two at a time, as with the input buffer ring.
+		Each span is shortened to fit both sources. A span with a single source within the audio data falls back to a single tap.
+	*/
+
+	n_cycle = 1;
+
+	while(n_cycle <= n_taps)
+	{
+		p_gain = &(p_snap->p_gains[n_cycle - 1]);
+
+		nframe_src = nframe_curr - ((LONG64) n_cycle)*((LONG64) p_snap->fx_params.n_delay);
+		nframe_src2 = nframe_src - ((LONG64) p_snap->fx_params.n_delay);
+
+		/*Every tap from this one onwards is before the first frame*/
+
+		if((nframe_src + ((LONG64) seg_end)) <= 0) break;
+
+		seg_nframe = seg_begin;
+		while(seg_nframe < seg_end)
+		{
+			n_frames_src = seg_end - seg_nframe;
+			p_src = this->dsp_mapped_src(nframe_src + ((LONG64) seg_nframe), &n_frames_src);
+
+			p_src2 = this->p_dspzero;
+			if(n_cycle < n_taps) p_src2 = this->dsp_mapped_src(nframe_src2 + ((LONG64) seg_nframe), &n_frames_src);
+
+			if(p_src2 == this->p_dspzero)
+			{
+				if(p_src != this->p_dspzero) this->dsp_accumulate(&p_dsp[seg_nframe*(this->N_CHANNELS)], p_src, n_frames_src*(this->N_CHANNELS), p_gain);
+			}
+			else if(p_src == this->p_dspzero) this->dsp_accumulate(&p_dsp[seg_nframe*(this->N_CHANNELS)], p_src2, n_frames_src*(this->N_CHANNELS), &p_gain[1]);
+			else this->dsp_accumulate2(&p_dsp[seg_nframe*(this->N_CHANNELS)], p_src, p_src2, n_frames_src*(this->N_CHANNELS), p_gain);
+
+			seg_nframe += n_frames_src;
+		}
+
+		n_cycle += 2;
+	}
+
+	return;
+}
+
+/*
+	A transition starts whenever the FX parameters in use change (new snapshot or command), except at the very first frame of the session (nothing to fade from).
+	The old parameters fit the ring in use (they were in use), and are rendered with the feedback taps: the comb state only follows the new ones.
+*/
+
+VOID WINAPI AudioRTDSP::dsp_xfade_begin(const audiortdsp_dspsnap_t *p_snap, const audiortdsp_fx_params_t *p_prev, SIZE_T seg_nframe)
+{
+	SIZE_T len = 0u;
+
+	if(this->xfade_len) return;
+	if(!p_snap->xfade_frames) return;
+	if(this->dspsnap_xfade.p_gains == NULL) return;
+	if(!this->dsp_nframe_curr && !seg_nframe) return;
+
+	if(RtlEqualMemory(p_prev, &(p_snap->fx_params), sizeof(audiortdsp_fx_params_t))) return;
+
+	len = p_snap->xfade_frames;
+	if(len > (this->XFADE_MAX_SAMPLES/this->N_CHANNELS)) len = this->XFADE_MAX_SAMPLES/this->N_CHANNELS;
+	if(!len) return;
+
+	CopyMemory(&(this->dspsnap_xfade.fx_params), p_prev, sizeof(audiortdsp_fx_params_t));
+	this->dsp_gains_update(&(this->dspsnap_xfade), this->BUFFERIN_SIZE_FRAMES);
+	this->dspsnap_xfade.comb_active = FALSE;
+
+	this->xfade_len = len;
+	this->xfade_nframe = 0u;
+	this->xfade_n_transitions++;
+	return;
+}
+
+/*
+	The ramp runs over the xfade_len*N_CHANNELS interleaved samples of the transition: weight (ramp_pos >> 16)/2^16, ramp_pos += ramp_step on every sample.
+	ramp_step is rounded down, so the ramp never wraps, the last sample of the transition is within 1/256 of the new parameters (see XFADE_MAX_SAMPLES).
+*/
+
+VOID WINAPI AudioRTDSP::dsp_xfade_block(const audiortdsp_dspsnap_t *p_snap, SIZE_T seg_begin, SIZE_T n_frames)
+{
+	LARGE_INTEGER qpc_begin;
+	LARGE_INTEGER qpc_end;
+
+	UINT32 ramp_step = 0u;
+	UINT32 ramp_pos = 0u;
+
+	ramp_step = (UINT32) ((((ULONG64) 1u) << 32)/(((ULONG64) this->xfade_len)*((ULONG64) this->N_CHANNELS)));
+	ramp_pos = (UINT32) (((ULONG64) this->xfade_nframe)*((ULONG64) this->N_CHANNELS)*((ULONG64) ramp_step));
+
+	if(this->p_filein_data != NULL) this->dsp_proc_block_mapped(p_snap, this->p_dspbuffer, seg_begin, n_frames);
+	else this->dsp_proc_block(p_snap, this->p_dspbuffer, seg_begin, n_frames);
+
+	QueryPerformanceCounter(&qpc_begin);
+
+	if(this->p_filein_data != NULL) this->dsp_proc_block_mapped(&(this->dspsnap_xfade), this->p_dspxfade, seg_begin, n_frames);
+	else this->dsp_proc_block(&(this->dspsnap_xfade), this->p_dspxfade, seg_begin, n_frames);
+
+	this->p_dspkernel->p_xfade_i32(&(this->p_dspbuffer[seg_begin*(this->N_CHANNELS)]), &(this->p_dspxfade[seg_begin*(this->N_CHANNELS)]), n_frames*(this->N_CHANNELS), ramp_pos, ramp_step);
+
+	QueryPerformanceCounter(&qpc_end);
+
+	this->xfade_extra_ticks += (LONG64) (qpc_end.QuadPart - qpc_begin.QuadPart);
+	this->xfade_n_frames += (LONG64) n_frames;
+
+	this->xfade_nframe += n_frames;
+	if(this->xfade_nframe >= this->xfade_len) this->xfade_len = 0u;
+
+	return;
+}
+
+const VOID* WINAPI AudioRTDSP::dsp_mapped_src(LONG64 nframe, SIZE_T *p_n_frames)
+{
+	ULONG64 n_frames_left = 0u;
+
+	if(nframe < 0)
+	{
+		if(((ULONG64) -nframe) < ((ULONG64) *p_n_frames)) *p_n_frames = (SIZE_T) -nframe;
+		return this->p_dspzero;
+	}
+
+	if(((ULONG64) nframe) >= this->filein_n_frames) return this->p_dspzero;
+
+	n_frames_left = this->filein_n_frames - ((ULONG64) nframe);
+	if(n_frames_left < ((ULONG64) *p_n_frames)) *p_n_frames = (SIZE_T) n_frames_left;
+
+	return &(this->p_filein_data[((ULONG64) nframe)*((ULONG64) this->FILEIN_FRAME_SIZE_BYTES)]);
+}
+
+/*
+	The control thread snapshot is published with an interlocked exchange (full barrier): its contents, and the ring size published before it by bufferin_grow(),
+	are visible to the load thread once it takes the snapshot.
+*/
+
+VOID WINAPI AudioRTDSP::dsp_snapshot_publish(VOID)
+{
+	audiortdsp_dspsnap_t *p_snap = NULL;
+	LONG n_prev = 0;
+
+	p_snap = &(this->dspsnaps[this->dspsnap_back]);
+	if(p_snap->p_gains == NULL) return;
+
+	CopyMemory(&(p_snap->fx_params), &(this->dsp_params), sizeof(audiortdsp_fx_params_t));
+	CopyMemory(p_snap->fx_versions, this->dsp_params_versions, sizeof(this->dsp_params_versions));
+	p_snap->xfade_frames = this->dsp_xfade_frames;
+	this->dsp_gains_update(p_snap, (SIZE_T) this->bufferin_size_next);
+
+	n_prev = InterlockedExchange(&(this->dspsnap_mid), (((LONG) this->dspsnap_back) | this->DSPSNAP_NEW));
+	this->dspsnap_back = (SIZE_T) (n_prev & this->DSPSNAP_INDEX_MASK);
+
+	return;
+}
+
+audiortdsp_dspsnap_t* WINAPI AudioRTDSP::dsp_snapshot_acquire(VOID)
+{
+	LONG n_prev = 0;
+
+	if(this->dspsnap_mid & this->DSPSNAP_NEW)
+	{
+		n_prev = InterlockedExchange(&(this->dspsnap_mid), (LONG) this->dspsnap_front);
+		this->dspsnap_front = (SIZE_T) (n_prev & this->DSPSNAP_INDEX_MASK);
+	}
+
+	return &(this->dspsnaps[this->dspsnap_front]);
+}
+
+/*
+	The held snapshot carries the versions already merged, so dsp_snapshot_merge() keeps every FX parameter in use (commands included).
+	The gain table is only rebuilt when the FX parameters in use changed since the last held segment.
+*/
+
+audiortdsp_dspsnap_t* WINAPI AudioRTDSP::dsp_snapshot_hold(const audiortdsp_dspsnap_t *p_snap)
+{
+	audiortdsp_dspsnap_t *p_hold = NULL;
+
+	p_hold = &(this->dspsnap_hold);
+
+	CopyMemory(p_hold->fx_versions, this->dspengine_versions, sizeof(this->dspengine_versions));
+	p_hold->xfade_frames = p_snap->xfade_frames;
+
+	if((p_hold->ring_frames == this->BUFFERIN_SIZE_FRAMES) && RtlEqualMemory(&(p_hold->fx_params), &(this->dspengine_params), sizeof(audiortdsp_fx_params_t))) return p_hold;
+
+	CopyMemory(&(p_hold->fx_params), &(this->dspengine_params), sizeof(audiortdsp_fx_params_t));
+	this->dsp_gains_update(p_hold, this->BUFFERIN_SIZE_FRAMES);
+
+	return p_hold;
+}
+
+/*
+	A snapshot only carries the control thread values. Each FX parameter whose setter version didn't change since the load thread last merged keeps the value in use (commands included).
+	If the merged parameters don't fit the ring, the snapshot is used as is.
+*/
+
+VOID WINAPI AudioRTDSP::dsp_snapshot_merge(audiortdsp_dspsnap_t *p_snap)
+{
+	audiortdsp_fx_params_t fx_params;
+	BOOL merge = FALSE;
+
+	CopyMemory(&fx_params, &(p_snap->fx_params), sizeof(audiortdsp_fx_params_t));
+
+	if((p_snap->fx_versions[this->CMD_SET_DELAY] == this->dspengine_versions[this->CMD_SET_DELAY]) && (fx_params.n_delay != this->dspengine_params.n_delay))
+	{
+		fx_params.n_delay = this->dspengine_params.n_delay;
+		merge = TRUE;
+	}
+
+	if((p_snap->fx_versions[this->CMD_SET_FEEDBACK] == this->dspengine_versions[this->CMD_SET_FEEDBACK]) && (fx_params.n_feedback != this->dspengine_params.n_feedback))
+	{
+		fx_params.n_feedback = this->dspengine_params.n_feedback;
+		merge = TRUE;
+	}
+
+	if((p_snap->fx_versions[this->CMD_SET_FEEDBACK_ALT_POL] == this->dspengine_versions[this->CMD_SET_FEEDBACK_ALT_POL]) && (fx_params.feedback_alt_pol != this->dspengine_params.feedback_alt_pol))
+	{
+		fx_params.feedback_alt_pol = this->dspengine_params.feedback_alt_pol;
+		merge = TRUE;
+	}
+
+	if((p_snap->fx_versions[this->CMD_SET_CYCLEDIV_INC_ONE] == this->dspengine_versions[this->CMD_SET_CYCLEDIV_INC_ONE]) && (fx_params.cyclediv_inc_one != this->dspengine_params.cyclediv_inc_one))
+	{
+		fx_params.cyclediv_inc_one = this->dspengine_params.cyclediv_inc_one;
+		merge = TRUE;
+	}
+
+	if((p_snap->fx_versions[this->CMD_SET_RECURSIVE_COMB] == this->dspengine_versions[this->CMD_SET_RECURSIVE_COMB]) && (fx_params.recursive_comb != this->dspengine_params.recursive_comb))
+	{
+		fx_params.recursive_comb = this->dspengine_params.recursive_comb;
+		merge = TRUE;
+	}
+
+	CopyMemory(this->dspengine_versions, p_snap->fx_versions, sizeof(this->dspengine_versions));
+
+	if(merge && this->dsp_params_fit(&fx_params))
+	{
+		CopyMemory(&(p_snap->fx_params), &fx_params, sizeof(audiortdsp_fx_params_t));
+		this->dsp_gains_update(p_snap, this->BUFFERIN_SIZE_FRAMES);
+	}
+
+	CopyMemory(&(this->dspengine_params), &(p_snap->fx_params), sizeof(audiortdsp_fx_params_t));
+	return;
+}
+
+VOID WINAPI AudioRTDSP::dsp_gains_update(audiortdsp_dspsnap_t *p_snap, SIZE_T ring_frames)
+{
+	INT32 n_cycle = 0;
+	INT32 n_taps = 0;
+	INT32 pol = 0;
+
+	dspkernel_gain_t *p_gain = NULL;
+
+	if(p_snap->p_gains == NULL) return;
+
+	p_snap->ring_frames = ring_frames;
+
+	/*
+		Same tap sequence as the original per sample math:
+		pol toggles between 1 and -1 on every tap (if feedback_alt_pol), cycle_div is (n_cycle + 1) or (2^n_cycle).
+		cycle_div only grows, so the first tap that is zero for every sample value ends the table.
+	*/
+
+	pol = 1;
+	n_cycle = 1;
+
+	while(n_cycle <= (p_snap->fx_params.n_feedback + 1))
+	{
+		if(p_snap->fx_params.feedback_alt_pol) pol ^= 0xfffffffe; /*Toggle between -1 and 1*/
+
+		p_gain = &(p_snap->p_gains[n_cycle - 1]);
+
+		if(p_snap->fx_params.cyclediv_inc_one) dspkernel_gain_init_div(p_gain, pol, (UINT32) (n_cycle + 1));
+		else dspkernel_gain_init_shift(p_gain, pol, (UINT32) n_cycle);
+
+		if(!p_gain->mul) break;
+
+		n_taps = n_cycle;
+		n_cycle++;
+	}
+
+	p_snap->n_taps = n_taps;
+
+	this->dsp_comb_update(p_snap, ring_frames);
+	return;
+}
+
+VOID WINAPI AudioRTDSP::dsp_comb_update(audiortdsp_dspsnap_t *p_snap, SIZE_T ring_frames)
+{
+	SIZE_T n_delay = 0u;
+	SIZE_T corr_shift = 0u;
+	SIZE_T span = 0u;
+	dspkernel_comb_t comb;
+
+	p_snap->comb_active = FALSE;
+
+	if(!p_snap->fx_params.recursive_comb) return;
+	if(p_snap->fx_params.cyclediv_inc_one) return;
+	if(p_snap->fx_params.n_delay < 1) return;
+	if(p_snap->n_taps < 1) return;
+
+	/*
+		Tap n_cycle has gain pol^n_cycle/2^n_cycle, pol = -1 if feedback_alt_pol (see dsp_gains_update()).
+		The correction tap removes taps (n_feedback + 2) onwards from the comb, unless they're all below the comb state resolution.
+	*/
 
-		PropVariantInit(&propvar);
+	n_delay = (SIZE_T) p_snap->fx_params.n_delay;
+	corr_shift = ((SIZE_T) p_snap->fx_params.n_feedback) + 2u;
 
-		n_ret = p_devprop->GetValue(*P_PKEY, &propvar);
-		if(n_ret != S_OK)
-		{
-			p_devprop->Release();
-			p_dev->Release();
-			this->audio_hw_deinit_all();
-			this->err_msg = TEXT("AudioRTDSP::loadAudioDeviceList: Error: IPropertyStore::GetValue failed.");
-			return FALSE;
-		}
+	comb.frac_bits = this->DSPCOMB_FRAC_BITS;
+	comb.pol_mask = 0;
+	comb.corr_pol_mask = 0;
+	comb.corr_shift = 0u;
 
-		if(propvar.vt == VT_EMPTY) __SPRINTF(textbuf, TEXTBUF_SIZE_CHARS, TEXT("Unknown Audio Device"));
-		else cstr_wchar_to_tchar(propvar.pwszVal, textbuf, TEXTBUF_SIZE_CHARS);
+	if(p_snap->fx_params.feedback_alt_pol)
+	{
+		comb.pol_mask = -1;
+		if(corr_shift & 1u) comb.corr_pol_mask = -1;
+	}
 
-		listbox_add_item(p_listbox, textbuf);
+	if(corr_shift < this->DSPCOMB_STATE_BITS)
+	{
+		comb.corr_shift = (UINT32) corr_shift;
+		span = corr_shift*n_delay;
+	}
+	else span = n_delay;
 
-		PropVariantClear(&propvar);
+	p_snap->comb = comb;
+	p_snap->comb_corr_delay = 0u;
+	if(comb.corr_shift) p_snap->comb_corr_delay = span;
 
-		p_devprop->Release();
-		p_devprop = NULL;
+	/*With the mapped input, only the comb state is read from the input buffer ring layout*/
 
-		p_dev->Release();
-		p_dev = NULL;
-	}
+	if(this->p_filein_data != NULL) span = n_delay;
 
-	PropVariantClear(&propvar);
+	/*Checked against the ring size the snapshot is used with (the control thread checks the size the load thread switches to, before it takes the snapshot)*/
 
-	if(p_devprop != NULL) p_devprop->Release();
-	if(p_dev != NULL) p_dev->Release();
+	if((span + this->BUFFER_SEGMENT_SIZE_FRAMES) > ring_frames) return;
+	if(this->dspcomb_vbuf.commit_size < ring_frames*(this->N_CHANNELS)*sizeof(INT32)) return;
 
-	return TRUE;
+	p_snap->comb_active = TRUE;
+	return;
 }
 
-BOOL WINAPI AudioRTDSP::chooseDevice(SIZE_T index)
+/*
+	Same limits as setFXDelay() and setFXFeedback(), except that the ring doesn't grow: the feedback taps must fit the ring in use.
+	The recursive comb falls back to the feedback taps if it doesn't fit (see dsp_comb_update()).
+*/
+
+BOOL WINAPI AudioRTDSP::dsp_params_fit(const audiortdsp_fx_params_t *p_params)
 {
-	HRESULT n_ret = 0;
+	ULONG64 span = 0u;
 
-	if(this->status > 0) return FALSE;
+	if((p_params->n_delay < 0) || (p_params->n_feedback < 0)) return FALSE;
+	if((((SIZE_T) p_params->n_feedback) + 1u) > this->DSPGAINS_SIZE) return FALSE;
 
-	if(this->p_audiodevcoll == NULL)
-	{
-		this->err_msg = TEXT("AudioRTDSP::chooseDevice: Error: p_audiodevcoll is NULL.");
-		return FALSE;
-	}
+	span = ((ULONG64) p_params->n_delay)*((ULONG64) p_params->n_feedback + 1u);
 
-	this->audio_hw_deinit_device();
+	if(span >= this->DSP_MAX_SPAN_FRAMES) return FALSE;
 
-	n_ret = this->p_audiodevcoll->Item((UINT) index, &(this->p_audiodev));
-	if(n_ret != S_OK)
+	if(this->p_filein_data == NULL)
 	{
-		this->err_msg = TEXT("AudioRTDSP::chooseDevice: Error: IMMDeviceCollection::Item failed.");
-		return FALSE;
+		if((span + ((ULONG64) this->BUFFER_SEGMENT_SIZE_FRAMES)) > ((ULONG64) this->BUFFERIN_SIZE_FRAMES)) return FALSE;
 	}
 
 	return TRUE;
 }
 
-BOOL WINAPI AudioRTDSP::chooseDefaultDevice(VOID)
+BOOL WINAPI AudioRTDSP::cmd_pop(audiortdsp_cmd_t *p_cmd)
 {
-	HRESULT n_ret = 0;
+	audiortdsp_cmdslot_t *p_slot = NULL;
 
-	if(this->status > 0) return FALSE;
+	p_slot = &(this->cmdqueue[((SIZE_T) (ULONG) this->cmdqueue_pop) & (this->CMDQUEUE_SIZE - 1u)]);
 
-	if(this->p_audiodevenum == NULL)
-	{
-		this->err_msg = TEXT("AudioRTDSP::chooseDefaultDevice: Error: p_audiodevnum is NULL.");
-		return FALSE;
-	}
+	if(p_slot->seq != ((LONG) (((ULONG) this->cmdqueue_pop) + 1u))) return FALSE;
 
-	this->audio_hw_deinit_device();
+	MemoryBarrier();
 
-	n_ret = this->p_audiodevenum->GetDefaultAudioEndpoint(eRender, eMultimedia, &(this->p_audiodev));
-	if(n_ret != S_OK)
-	{
-		this->err_msg = TEXT("AudioRTDSP::chooseDefaultDevice: Error: IMMDeviceEnumerator::GetDefaultAudioEndpoint failed.");
-		return FALSE;
-	}
+	CopyMemory(p_cmd, &(p_slot->cmd), sizeof(audiortdsp_cmd_t));
+
+	InterlockedExchange(&(p_slot->seq), (LONG) (((ULONG) this->cmdqueue_pop) + ((ULONG) this->CMDQUEUE_SIZE)));
+	this->cmdqueue_pop = (LONG) (((ULONG) this->cmdqueue_pop) + 1u);
 
 	return TRUE;
 }
 
-BOOL WINAPI AudioRTDSP::getFXParams(audiortdsp_fx_params_t *p_params)
+VOID WINAPI AudioRTDSP::cmd_collect(VOID)
 {
-	if(this->status < 1) return FALSE;
+	audiortdsp_cmd_t cmd;
 
-	if(p_params == NULL)
+	while(this->cmd_n_pending < this->CMDQUEUE_SIZE)
 	{
-		this->err_msg = TEXT("AudioRTDSP::getFXParams: Error: given params object pointer is null.");
-		return FALSE;
+		if(!this->cmd_pop(&cmd)) break;
+		this->cmd_insert(&cmd);
 	}
 
-	CopyMemory(p_params, &(this->dsp_params), sizeof(audiortdsp_fx_params_t));
-
-	return TRUE;
+	return;
 }
 
-BOOL WINAPI AudioRTDSP::setFXDelay(SIZE_T n_delay)
+VOID WINAPI AudioRTDSP::cmd_insert(const audiortdsp_cmd_t *p_cmd)
 {
-	if(this->status < 1) return FALSE;
+	SIZE_T n_cmd = 0u;
+
+	if(this->cmd_n_pending >= this->CMDQUEUE_SIZE) return;
 
-	if((((SIZE_T) this->dsp_params.n_feedback + 1u)*n_delay) >= this->BUFFERIN_SIZE_FRAMES)
+	n_cmd = this->cmd_n_pending;
+	while(n_cmd > 0u)
 	{
-		this->err_msg = TEXT("AudioRTDSP::setFXDelay: Error: given delay time value is too big.");
-		return FALSE;
+		if(this->cmd_pending[n_cmd - 1u].nframe <= p_cmd->nframe) break;
+		n_cmd--;
 	}
 
-	this->dsp_params.n_delay = (INT32) n_delay;
-	return TRUE;
+	MoveMemory(&(this->cmd_pending[n_cmd + 1u]), &(this->cmd_pending[n_cmd]), (this->cmd_n_pending - n_cmd)*sizeof(audiortdsp_cmd_t));
+	CopyMemory(&(this->cmd_pending[n_cmd]), p_cmd, sizeof(audiortdsp_cmd_t));
+
+	this->cmd_n_pending++;
+	return;
 }
 
-BOOL WINAPI AudioRTDSP::setFXFeedback(SIZE_T n_feedback)
+/*
+	The seek is taken at load time (the input is read around it), every other command is applied by dsp_proc().
+*/
+
+BOOL WINAPI AudioRTDSP::cmd_seek_take(SIZE_T *p_seg_nframe, ULONG64 *p_nframe_target)
 {
-	if(this->status < 1) return FALSE;
+	audiortdsp_cmd_t cmd;
+	ULONG64 nframe_curr = 0u;
+	ULONG64 nframe_end = 0u;
+	SIZE_T n_cmd = 0u;
+	BOOL seek = FALSE;
+
+	nframe_curr = (ULONG64) this->dsp_nframe_curr;
+	nframe_end = nframe_curr + ((ULONG64) this->BUFFER_SEGMENT_SIZE_FRAMES);
 
-	if((((SIZE_T) this->dsp_params.n_delay)*(n_feedback + 1u)) >= this->BUFFERIN_SIZE_FRAMES)
+	n_cmd = 0u;
+	while(n_cmd < this->cmd_n_pending)
 	{
-		this->err_msg = TEXT("AudioRTDSP::setFXFeedback: Error: given feedback count is too big.");
-		return FALSE;
+		if(this->cmd_pending[n_cmd].nframe >= nframe_end) break;
+
+		if(this->cmd_pending[n_cmd].type != this->CMD_SEEK)
+		{
+			n_cmd++;
+			continue;
+		}
+
+		CopyMemory(&cmd, &(this->cmd_pending[n_cmd]), sizeof(audiortdsp_cmd_t));
+
+		this->cmd_n_pending--;
+		MoveMemory(&(this->cmd_pending[n_cmd]), &(this->cmd_pending[n_cmd + 1u]), (this->cmd_n_pending - n_cmd)*sizeof(audiortdsp_cmd_t));
+
+		if(seek)
+		{
+			cmd.nframe = nframe_end;
+			this->cmd_insert(&cmd);
+			continue;
+		}
+
+		seek = TRUE;
+
+		*p_seg_nframe = 0u;
+		if(cmd.nframe > nframe_curr) *p_seg_nframe = (SIZE_T) (cmd.nframe - nframe_curr);
+
+		*p_nframe_target = 0u;
+		if(cmd.value > 0) *p_nframe_target = (ULONG64) cmd.value;
 	}
 
-	this->dsp_params.n_feedback = (INT32) n_feedback;
-	return TRUE;
+	return seek;
 }
 
-BOOL WINAPI AudioRTDSP::enableFeedbackAltPol(BOOL enable)
+SIZE_T WINAPI AudioRTDSP::cmd_apply(audiortdsp_dspsnap_t *p_snap, SIZE_T seg_nframe)
 {
-	if(this->status < 1) return FALSE;
+	const audiortdsp_cmd_t *p_cmd = NULL;
+	ULONG64 nframe = 0u;
+	SIZE_T n_frames = 0u;
+	SIZE_T n_cmd = 0u;
+	SIZE_T n_keep = 0u;
+	BOOL update = FALSE;
+	BOOL xfade = FALSE;
 
-	this->dsp_params.feedback_alt_pol = enable;
-	return TRUE;
-}
+	audiortdsp_fx_params_t fx_params;
+	audiortdsp_fx_params_t fx_params_cmd;
+	audiortdsp_fx_params_t fx_params_prev;
 
-BOOL WINAPI AudioRTDSP::enableCycleDivIncOne(BOOL enable)
-{
-	if(this->status < 1) return FALSE;
+	nframe = ((ULONG64) this->dsp_nframe_curr) + ((ULONG64) seg_nframe);
 
-	this->dsp_params.cyclediv_inc_one = enable;
-	return TRUE;
-}
+	CopyMemory(&fx_params, &(p_snap->fx_params), sizeof(audiortdsp_fx_params_t));
+	CopyMemory(&fx_params_prev, &fx_params, sizeof(audiortdsp_fx_params_t));
 
-__string WINAPI AudioRTDSP::getLastErrorMessage(VOID)
-{
-	if(this->status == this->STATUS_UNINITIALIZED)
-		return TEXT("Error: Audio Object has not been initialized.\r\nExtended error message: ") + this->err_msg;
+	xfade = (this->xfade_len != 0u);
 
-	return this->err_msg;
-}
+	n_cmd = 0u;
+	n_keep = 0u;
+	while(n_cmd < this->cmd_n_pending)
+	{
+		p_cmd = &(this->cmd_pending[n_cmd]);
+		if(p_cmd->nframe > nframe) break;
 
-BOOL WINAPI AudioRTDSP::filein_open(VOID)
-{
-	this->filein_close();
+		/*FX parameter commands wait for the running transition to end (kept at the head of cmd_pending, in order)*/
 
-	this->h_filein = CreateFile(this->FILEIN_DIR.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0u, NULL);
-	if(this->h_filein == INVALID_HANDLE_VALUE) return FALSE;
+		if(xfade && (p_cmd->type < this->CMD_STOP))
+		{
+			if(n_keep != n_cmd) CopyMemory(&(this->cmd_pending[n_keep]), p_cmd, sizeof(audiortdsp_cmd_t));
 
-	this->filein_size_64.l32 = (ULONG32) GetFileSize(this->h_filein, (DWORD*) &(this->filein_size_64.h32));
-	return TRUE;
-}
+			n_keep++;
+			n_cmd++;
+			continue;
+		}
 
-VOID WINAPI AudioRTDSP::filein_close(VOID)
-{
-	if(this->h_filein == INVALID_HANDLE_VALUE) return;
+		CopyMemory(&fx_params_cmd, &fx_params, sizeof(audiortdsp_fx_params_t));
 
-	CloseHandle(this->h_filein);
-	this->h_filein = INVALID_HANDLE_VALUE;
-	*((ULONG64*) &(this->filein_size_64)) = 0u;
+		switch(p_cmd->type)
+		{
+			case AudioRTDSP::CMD_SET_DELAY:
+				if((p_cmd->value >= 0) && (p_cmd->value <= 0x7fffffff)) fx_params_cmd.n_delay = (INT32) p_cmd->value;
+				break;
 
-	return;
-}
+			case AudioRTDSP::CMD_SET_FEEDBACK:
+				if((p_cmd->value >= 0) && (p_cmd->value <= 0x7fffffff)) fx_params_cmd.n_feedback = (INT32) p_cmd->value;
+				break;
 
-VOID WINAPI AudioRTDSP::audio_hw_deinit_device(VOID)
-{
-	if(this->p_audiomgr != NULL) this->p_audiomgr->Stop();
+			case AudioRTDSP::CMD_SET_FEEDBACK_ALT_POL:
+				fx_params_cmd.feedback_alt_pol = (p_cmd->value != 0);
+				break;
 
-	if(this->p_audioout != NULL)
-	{
-		this->p_audioout->Release();
-		this->p_audioout = NULL;
+			case AudioRTDSP::CMD_SET_CYCLEDIV_INC_ONE:
+				fx_params_cmd.cyclediv_inc_one = (p_cmd->value != 0);
+				break;
+
+			case AudioRTDSP::CMD_SET_RECURSIVE_COMB:
+				fx_params_cmd.recursive_comb = (p_cmd->value != 0);
+				break;
+
+			case AudioRTDSP::CMD_STOP:
+				this->cmd_stop = TRUE;
+				break;
+		}
+
+		/*Commands that don't fit the ring in use are dropped (counted)*/
+
+		if(p_cmd->type < this->CMD_STOP)
+		{
+			if(this->dsp_params_fit(&fx_params_cmd))
+			{
+				CopyMemory(&fx_params, &fx_params_cmd, sizeof(audiortdsp_fx_params_t));
+				update = TRUE;
+			}
+			else this->bufferout_stats.n_cmd_dropped++;
+		}
+
+		n_cmd++;
 	}
 
-	if(this->p_audiomgr != NULL)
+	if(n_cmd > n_keep)
 	{
-		this->p_audiomgr->Release();
-		this->p_audiomgr = NULL;
+		this->cmd_n_pending -= (n_cmd - n_keep);
+		MoveMemory(&(this->cmd_pending[n_keep]), &(this->cmd_pending[n_cmd]), (this->cmd_n_pending - n_keep)*sizeof(audiortdsp_cmd_t));
 	}
 
-	if(this->p_audiodev != NULL)
+	if(update)
 	{
-		this->p_audiodev->Release();
-		this->p_audiodev = NULL;
+		CopyMemory(&(p_snap->fx_params), &fx_params, sizeof(audiortdsp_fx_params_t));
+		CopyMemory(&(this->dspengine_params), &fx_params, sizeof(audiortdsp_fx_params_t));
+		this->dsp_gains_update(p_snap, this->BUFFERIN_SIZE_FRAMES);
+
+		this->dsp_xfade_begin(p_snap, &fx_params_prev, seg_nframe);
 	}
 
-	return;
-}
+	if(this->cmd_stop) return 0u;
 
-VOID WINAPI AudioRTDSP::audio_hw_deinit_all(VOID)
-{
-	this->audio_hw_deinit_device();
+	n_frames = this->BUFFER_SEGMENT_SIZE_FRAMES - seg_nframe;
+
+	/*The first command not due yet (the ones before it wait for the transition)*/
 
-	if(this->p_audiodevcoll != NULL)
+	if(n_keep < this->cmd_n_pending)
 	{
-		this->p_audiodevcoll->Release();
-		this->p_audiodevcoll = NULL;
+		if((this->cmd_pending[n_keep].nframe - nframe) < ((ULONG64) n_frames)) n_frames = (SIZE_T) (this->cmd_pending[n_keep].nframe - nframe);
 	}
 
-	if(this->p_audiodevenum != NULL)
+	if(this->xfade_len)
 	{
-		this->p_audiodevenum->Release();
-		this->p_audiodevenum = NULL;
+		if((this->xfade_len - this->xfade_nframe) < n_frames) n_frames = this->xfade_len - this->xfade_nframe;
 	}
 
-	return;
+	if(seg_nframe < this->bufferin_seek_seg_nframe)
+	{
+		if((this->bufferin_seek_seg_nframe - seg_nframe) < n_frames) n_frames = this->bufferin_seek_seg_nframe - seg_nframe;
+	}
+
+	return n_frames;
 }
 
-VOID WINAPI AudioRTDSP::stop_all_threads(VOID)
+/*
+	cmd_session_begin(): called before the first segment of a session, once the default FX parameters are set (no load thread running yet).
+	Commands already queued stay queued, their frames count from the start of the session.
+*/
+
+VOID WINAPI AudioRTDSP::cmd_session_begin(VOID)
 {
-	thread_stop(&(this->p_loadthread), 0u);
-	thread_stop(&(this->p_playthread), 0u);
+	this->cmd_stop = FALSE;
+	this->bufferout_stats.n_cmd_dropped = 0u;
+	this->bufferin_seek_seg_nframe = this->BUFFER_SEGMENT_SIZE_FRAMES;
+	this->bufferout_nframes_valid = 0u;
 
-	return;
-}
+	InterlockedExchange64(&(this->dsp_nframe_curr), 0);
 
-VOID WINAPI AudioRTDSP::playback_proc(VOID)
-{
-	this->playback_init();
-	this->playback_loop();
+	this->xfade_len = 0u;
+	this->xfade_nframe = 0u;
+	this->xfade_n_transitions = 0;
+	this->xfade_n_frames = 0;
+	this->xfade_extra_ticks = 0;
+	this->xfade_dsp_ticks = 0;
+
+	CopyMemory(&(this->dspengine_params), &(this->dsp_params), sizeof(audiortdsp_fx_params_t));
+	CopyMemory(this->dspengine_versions, this->dsp_params_versions, sizeof(this->dspengine_versions));
 
 	return;
 }
 
-VOID WINAPI AudioRTDSP::playback_init(VOID)
+VOID WINAPI AudioRTDSP::cmd_discard(VOID)
 {
-	HRESULT n_ret = 0;
+	audiortdsp_cmd_t cmd;
 
-	*((ULONG64*) &(this->filein_pos_64)) = this->AUDIO_DATA_BEGIN;
-	this->stop_playback = FALSE;
-
-	this->bufferout_nseg_load = 0u;
-	this->bufferout_nseg_play = 1u;
+	while(this->cmd_pop(&cmd));
 
-	this->bufferin_nseg_curr = 0u;
+	this->cmd_n_pending = 0u;
+	this->cmd_stop = FALSE;
 
-	/*Default FX Initialization*/
+	return;
+}
 
-	this->setFXDelay(240u);
-	this->setFXFeedback(20u);
-	this->enableFeedbackAltPol(TRUE);
-	this->enableCycleDivIncOne(TRUE);
+BOOL WINAPI AudioRTDSP::dsp_comb_span(SIZE_T seg_nframe, SIZE_T n_delay, SIZE_T corr_delay, SIZE_T *p_src_buf_nframe, SIZE_T *p_corr_buf_nframe, SIZE_T *p_n_frames)
+{
+	SIZE_T src_buf_nframe = 0u;
+	SIZE_T corr_buf_nframe = 0u;
+	SIZE_T n_frames = 0u;
 
-	n_ret = this->p_audioout->GetBuffer((UINT32) this->AUDIOBUFFER_SIZE_FRAMES, (BYTE**) &(this->p_audiobuffer));
-	if(n_ret != S_OK) app_exit(1u, TEXT("AudioRTDSP::playback_init: Error: IAudioRenderClient::GetBuffer failed."));
+	if(p_src_buf_nframe == NULL) return FALSE;
+	if(p_n_frames == NULL) return FALSE;
+	if(seg_nframe >= this->BUFFER_SEGMENT_SIZE_FRAMES) return FALSE;
+	if(!n_delay) return FALSE;
 
-	ZeroMemory(this->p_audiobuffer, this->AUDIOBUFFER_SIZE_BYTES);
+	if(!this->retrieve_previn_nframe(this->bufferin_nseg_curr, seg_nframe, n_delay, &src_buf_nframe, NULL, NULL)) return FALSE;
 
-	n_ret = this->p_audioout->ReleaseBuffer((UINT32) this->AUDIOBUFFER_SIZE_FRAMES, 0u);
-	if(n_ret != S_OK) app_exit(1u, TEXT("AudioRTDSP::playback_init: Error: IAudioRenderClient::ReleaseBuffer failed."));
+	n_frames = this->BUFFER_SEGMENT_SIZE_FRAMES - seg_nframe;
+	if(n_frames > n_delay) n_frames = n_delay;
+	if(n_frames > (this->BUFFERIN_SIZE_FRAMES - src_buf_nframe)) n_frames = this->BUFFERIN_SIZE_FRAMES - src_buf_nframe;
 
-	n_ret = this->p_audiomgr->Start();
-	if(n_ret != S_OK) app_exit(1u, TEXT("AudioRTDSP::playback_init: Error: IAudioClient::Start failed."));
+	if(corr_delay)
+	{
+		if(!this->retrieve_previn_nframe(this->bufferin_nseg_curr, seg_nframe, corr_delay, &corr_buf_nframe, NULL, NULL)) return FALSE;
+		if(n_frames > (this->BUFFERIN_SIZE_FRAMES - corr_buf_nframe)) n_frames = this->BUFFERIN_SIZE_FRAMES - corr_buf_nframe;
+	}
 
-	this->buffer_load();
-	this->dsp_proc();
-	this->audio_hw_wait();
+	*p_src_buf_nframe = src_buf_nframe;
+	if(p_corr_buf_nframe != NULL) *p_corr_buf_nframe = corr_buf_nframe;
+	*p_n_frames = n_frames;
 
-	this->buffer_segment_update();
-	return;
+	return TRUE;
 }
 
-VOID WINAPI AudioRTDSP::playback_loop(VOID)
+BOOL WINAPI AudioRTDSP::buffer_play(VOID)
 {
-	while(!this->stop_playback)
+	if(!this->p_backend->writeFrames(this->pp_bufferout_segments[this->bufferout_nseg_play], this->AUDIOBUFFER_SEGMENT_SIZE_FRAMES))
 	{
-		this->p_playthread = thread_create_default(((DWORD (WINAPI *)(VOID*)) &AudioRTDSP::playthread_proc), this, NULL);
-		this->p_loadthread = thread_create_default(((DWORD (WINAPI *)(VOID*)) &AudioRTDSP::loadthread_proc), this, NULL);
-		thread_wait(&(this->p_loadthread));
-		thread_wait(&(this->p_playthread));
-
-		this->buffer_segment_update();
+		this->playback_fail(this->p_backend->getLastErrorMessage().c_str());
+		return FALSE;
 	}
 
-	return;
+	return TRUE;
 }
 
-VOID WINAPI AudioRTDSP::buffer_segment_update(VOID)
-{
-	this->bufferin_nseg_curr++;
-	this->bufferin_nseg_curr %= this->BUFFERIN_N_SEGMENTS;
-
-	this->bufferout_nseg_load++;
-	this->bufferout_nseg_load %= this->BUFFEROUT_N_SEGMENTS;
-
-	this->bufferout_nseg_play++;
-	this->bufferout_nseg_play %= this->BUFFEROUT_N_SEGMENTS;
-
-	return;
-}
+/*
+	buffer_play_direct(): direct output counterpart of buffer_play(). Processes the loaded segment straight into the audio hardware buffer.
+	The whole segment is played, like a segment of the output buffer ring (the part past bufferout_nframes_valid is silence).
+*/
 
-VOID WINAPI AudioRTDSP::buffer_play(VOID)
+BOOL WINAPI AudioRTDSP::buffer_play_direct(VOID)
 {
-	HRESULT n_ret = 0;
+	VOID *p_out = NULL;
+	TELEMETRY_VAR(qpc_stage);
 
-	n_ret = this->p_audioout->GetBuffer((UINT32) this->AUDIOBUFFER_SEGMENT_SIZE_FRAMES, (BYTE**) &(this->p_audiobuffer));
-	if(n_ret != S_OK) app_exit(1u, TEXT("AudioRTDSP::buffer_play: Error: IAudioRenderClient::GetBuffer failed."));
+	if(!this->p_backend->acquireFrames(this->AUDIOBUFFER_SEGMENT_SIZE_FRAMES, &p_out))
+	{
+		this->playback_fail(this->p_backend->getLastErrorMessage().c_str());
+		return FALSE;
+	}
 
-	CopyMemory(this->p_audiobuffer, this->pp_bufferout_segments[this->bufferout_nseg_play], this->AUDIOBUFFER_SEGMENT_SIZE_BYTES);
+	TELEMETRY_BEGIN(qpc_stage);
+	this->dsp_proc(p_out);
+	TELEMETRY_END(this->TELEMETRY_DSP, qpc_stage);
 
-	n_ret = this->p_audioout->ReleaseBuffer((UINT32) this->AUDIOBUFFER_SEGMENT_SIZE_FRAMES, 0u);
-	if(n_ret != S_OK) app_exit(1u, TEXT("AudioRTDSP::buffer_play: Error: IAudioRenderClient::ReleaseBuffer failed."));
+	TELEMETRY_BEGIN(qpc_stage);
+	if(!this->p_backend->commitFrames(this->AUDIOBUFFER_SEGMENT_SIZE_FRAMES))
+	{
+		this->playback_fail(this->p_backend->getLastErrorMessage().c_str());
+		return FALSE;
+	}
+	TELEMETRY_END(this->TELEMETRY_PLAY, qpc_stage);
 
-	return;
+	this->bufferout_stats.n_played++;
+	return TRUE;
 }
 
-VOID WINAPI AudioRTDSP::audio_hw_wait(VOID)
+BOOL WINAPI AudioRTDSP::audio_hw_wait(VOID)
 {
-	SIZE_T n_frames_free = 0u;
-	HRESULT n_ret = 0;
-	UINT32 u32 = 0u;
-
-	do{
-		n_ret = this->p_audiomgr->GetCurrentPadding(&u32);
-		if(n_ret != S_OK) app_exit(1u, TEXT("AudioRTDSP::audio_hw_wait: Error: IAudioClient::GetCurrentPadding failed."));
-
-		n_frames_free = this->AUDIOBUFFER_SIZE_FRAMES - ((SIZE_T) u32);
-
-		Sleep(1u);
-	}while(n_frames_free < this->AUDIOBUFFER_SEGMENT_SIZE_FRAMES);
+	if(!this->p_backend->waitFramesFree(this->AUDIOBUFFER_SEGMENT_SIZE_FRAMES))
+	{
+		this->playback_fail(this->p_backend->getLastErrorMessage().c_str());
+		return FALSE;
+	}
 
-	return;
+	return TRUE;
 }
 
 /*
@@ -544,19 +3714,157 @@ BOOL WINAPI AudioRTDSP::retrieve_previn_nframe(SIZE_T currin_nseg, SIZE_T currin
 	return this->retrieve_previn_nframe(currin_buf_nframe, n_delay, p_previn_buf_nframe, p_previn_nseg, p_previn_seg_nframe);
 }
 
+/*
+	retrieve_previn_span() : Retrieve (calculates) the source span(s) within the input buffer for a block of an input buffer segment delayed by n_delay frames.
+
+	A delayed block occupies n_frames contiguous frames of the input buffer, unless it crosses the end of the buffer (ring wrap).
+	In that case it's split into 2 spans: the first one ends at the last frame of the input buffer, the second one starts at frame 0.
+
+	Inputs:
+
+	currin_nseg: the current input buffer segment index in context.
+	currin_seg_nframe: the first frame of the block within the segment.
+	n_frames: block length (number of frames).
+	n_delay: delay time (number of frames).
+
+	Outputs:
+
+	p_previn_buf_nframe: pointer to variable that receives the index of the first frame of the first span within the whole input buffer.
+	p_span1_nframes: pointer to variable that receives the length (number of frames) of the first span.
+	The second span (if any) is (n_frames - *p_span1_nframes) frames long, starting at frame 0.
+
+	returns true if successful, false otherwise.
+*/
+
+BOOL WINAPI AudioRTDSP::retrieve_previn_span(SIZE_T currin_nseg, SIZE_T currin_seg_nframe, SIZE_T n_frames, SIZE_T n_delay, SIZE_T *p_previn_buf_nframe, SIZE_T *p_span1_nframes)
+{
+	SIZE_T previn_buf_nframe = 0u;
+	SIZE_T span1_nframes = 0u;
+
+	if(p_previn_buf_nframe == NULL) return FALSE;
+	if(p_span1_nframes == NULL) return FALSE;
+
+	if(!this->retrieve_previn_nframe(currin_nseg, currin_seg_nframe, n_delay, &previn_buf_nframe, NULL, NULL)) return FALSE;
+
+	span1_nframes = this->BUFFERIN_SIZE_FRAMES - previn_buf_nframe;
+	if(span1_nframes > n_frames) span1_nframes = n_frames;
+
+	*p_previn_buf_nframe = previn_buf_nframe;
+	*p_span1_nframes = span1_nframes;
+
+	return TRUE;
+}
+
 DWORD WINAPI AudioRTDSP::loadthread_proc(VOID *p_args)
 {
-	this->buffer_load();
-	if(this->stop_playback) return 0u;
+	LARGE_INTEGER qpc_begin;
+	LARGE_INTEGER qpc_end;
+	TELEMETRY_VAR(qpc_stage);
+
+	while(this->bufferout_wait_free())
+	{
+		if(this->watchdog_enable) this->dsp_watchdog();
+
+		if(this->depth_adapt || this->watchdog_enable) QueryPerformanceCounter(&qpc_begin);
+
+		TELEMETRY_BEGIN(qpc_stage);
+		this->buffer_load();
+		if(this->stop_playback) break;
+		TELEMETRY_END(this->TELEMETRY_LOAD, qpc_stage);
+
+		TELEMETRY_BEGIN(qpc_stage);
+		this->dsp_proc(this->pp_bufferout_segments[this->bufferout_nseg_load]);
+		TELEMETRY_END(this->TELEMETRY_DSP, qpc_stage);
+
+		if(this->depth_adapt || this->watchdog_enable)
+		{
+			QueryPerformanceCounter(&qpc_end);
+			this->depth_update((LONG64) (qpc_end.QuadPart - qpc_begin.QuadPart));
+		}
+
+		TELEMETRY_PUSH();
+		this->bufferout_push();
+
+		if(this->cmd_stop) break;
+	}
+
+	InterlockedExchange(&(this->bufferout_load_done), 1);
+	event_signal(this->p_event_bufferout_ready);
 
-	this->dsp_proc();
 	return 0u;
 }
 
 DWORD WINAPI AudioRTDSP::playthread_proc(VOID *p_args)
 {
-	this->buffer_play();
-	this->audio_hw_wait();
+	TELEMETRY_VAR(qpc_stage);
+
+	if(!this->audio_hw_wait()) return 0u;
+
+	while(this->bufferout_wait_ready())
+	{
+		TELEMETRY_POP();
+		TELEMETRY_PADDING();
+
+		TELEMETRY_BEGIN(qpc_stage);
+		if(!this->buffer_play()) break;
+		TELEMETRY_END(this->TELEMETRY_PLAY, qpc_stage);
+
+		this->bufferout_pop();
+
+		TELEMETRY_BEGIN(qpc_stage);
+		if(!this->audio_hw_wait()) break;
+		TELEMETRY_END(this->TELEMETRY_WAIT, qpc_stage);
+	}
+
+	return 0u;
+}
+
+DWORD WINAPI AudioRTDSP::directthread_proc(VOID *p_args)
+{
+	TELEMETRY_VAR(qpc_stage);
+
+	if(!this->audio_hw_wait()) return 0u;
+
+	while(TRUE)
+	{
+		TELEMETRY_BEGIN(qpc_stage);
+		this->buffer_load();
+		if(this->stop_playback) break;
+		TELEMETRY_END(this->TELEMETRY_LOAD, qpc_stage);
+
+		TELEMETRY_PADDING();
+
+		if(!this->buffer_play_direct()) break;
+		if(this->cmd_stop) break;
+
+		this->bufferin_nseg_curr++;
+		this->bufferin_nseg_curr %= this->BUFFERIN_N_SEGMENTS;
+
+		TELEMETRY_BEGIN(qpc_stage);
+		if(!this->audio_hw_wait()) break;
+		TELEMETRY_END(this->TELEMETRY_WAIT, qpc_stage);
+	}
+
+	return 0u;
+}
+
+DWORD WINAPI AudioRTDSP::renderthread_proc(VOID *p_args)
+{
+	LONG n_chunk = 0;
+
+	while(!this->stop_playback)
+	{
+		n_chunk = InterlockedIncrement(&(this->render_chunk_next)) - 1;
+
+		if(((SIZE_T) n_chunk) >= this->render_n_chunks)
+		{
+			/*Keep render_chunk_next at render_n_chunks, so runRenderParallel() can tell a complete render from an aborted one*/
+			InterlockedDecrement(&(this->render_chunk_next));
+			break;
+		}
+
+		if(!this->render_chunk(&(this->p_render_chunks[(SIZE_T) n_chunk]))) break;
+	}
 
 	return 0u;
 }
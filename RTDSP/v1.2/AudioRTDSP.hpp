@@ -13,9 +13,9 @@
 
 #include "strdef.hpp"
 #include "shared.hpp"
-
-#include <mmdeviceapi.h>
-#include <audioclient.h>
+#include "AudioRTDSP_kernel.hpp"
+#include "thread.h"
+#include "AudioBackend.hpp"
 
 struct _audiortdsp_pb_params {
 	const TCHAR *file_dir;
@@ -30,31 +30,494 @@ struct _audiortdsp_fx_params {
 	INT32 n_feedback;
 	BOOL feedback_alt_pol;
 	BOOL cyclediv_inc_one;
+	BOOL recursive_comb;
+};
+
+/*
+	Runtime control command (see AudioRTDSP::postCommand()):
+
+	type: command type (AudioRTDSP::CMD_...).
+	nframe: engine frame the command takes effect at (see AudioRTDSP::getEngineFrame()).
+	value: command value (delay time, feedback count, 0/1 for the switches, input frame for CMD_SEEK, unused for CMD_STOP).
+*/
+
+struct _audiortdsp_cmd {
+	UINT32 type;
+	ULONG64 nframe;
+	LONG64 value;
+};
+
+/*
+	Output buffer statistics:
+
+	n_segments: output buffer depth (number of segments), 0 with direct output (see AudioRTDSP::enableDirectOutput()).
+	n_ready: number of processed segments currently waiting to be played.
+	n_ready_high: high watermark, the highest n_ready seen by the play thread when taking a segment.
+	n_ready_low: low watermark, the lowest n_ready seen by the play thread when taking a segment (0 means it had to wait).
+	n_underruns: number of times the play thread found no processed segment ready (load/DSP didn't keep up).
+	n_played: number of segments played so far.
+	arena_size: size of the buffer arena (bytes, see enableLargePageArena()).
+	n_depth: active output buffer depth (n_segments unless the depth is adaptive, see AudioRTDSP::enableAdaptiveDepth()).
+	load_pct: load stage cost (file read + DSP) per segment expected for the current FX parameters, percent of the segment period (adaptive depth or deadline watchdog only, 0 otherwise).
+	n_degrade_events: number of times the deadline watchdog started dropping feedback taps (see AudioRTDSP::enableDeadlineWatchdog()).
+	n_degraded_segments: number of segments processed with dropped feedback taps.
+	n_cmd_dropped: number of CMD_SET_DELAY/CMD_SET_FEEDBACK commands dropped because the new parameters don't fit the input buffer ring (see AudioRTDSP::postCommand()), offline render included.
+
+	Watermarks and underruns are not counted for the first segment of the playback session, nor with direct output (there's no output buffer ring).
+*/
+
+struct _audiortdsp_buffer_stats {
+	SIZE_T n_segments;
+	SIZE_T n_ready;
+	SIZE_T n_ready_high;
+	SIZE_T n_ready_low;
+	ULONG64 n_underruns;
+	ULONG64 n_played;
+	SIZE_T arena_size;
+	SIZE_T n_depth;
+	UINT32 load_pct;
+	ULONG64 n_degrade_events;
+	ULONG64 n_degraded_segments;
+	ULONG64 n_cmd_dropped;
+};
+
+/*
+	Offline render statistics:
+
+	n_frames: number of frames written to the output file.
+	elapsed_sec: render time (seconds), from the first segment loaded to the last segment written.
+	frames_per_sec: render throughput (n_frames/elapsed_sec).
+	realtime_factor: how many times faster than real time the render ran (frames_per_sec/sample_rate).
+	io_wait_sec: time spent waiting on input file reads (seconds, see audiortdsp_io_stats_t).
+	arena_size: size of the buffer arena (bytes, see enableLargePageArena()).
+*/
+
+struct _audiortdsp_render_stats {
+	ULONG64 n_frames;
+	DOUBLE elapsed_sec;
+	DOUBLE frames_per_sec;
+	DOUBLE realtime_factor;
+	DOUBLE io_wait_sec;
+	SIZE_T arena_size;
+};
+
+/*
+	Input file read statistics (last playback/render session):
+
+	readahead_size: read-ahead depth (bytes), 0 if the input file is read synchronously (or mapped, see enableMappedInput()).
+	n_reads: number of file reads issued.
+	n_waits: number of times the load stage had to wait for a read to complete (every synchronous read is a wait).
+	wait_sec: total time the load stage spent waiting for reads (seconds).
+
+	With runRenderParallel() these add up the reads of every render thread.
+*/
+
+struct _audiortdsp_io_stats {
+	SIZE_T readahead_size;
+	ULONG64 n_reads;
+	ULONG64 n_waits;
+	DOUBLE wait_sec;
+};
+
+/*
+	FX parameter transition statistics (last playback/render session, see setTransitionTime()):
+
+	n_transitions: number of transitions started.
+	n_frames: number of frames processed within a transition.
+	extra_sec: DSP time added by the transitions (seconds): rendering the old parameters plus the crossfade.
+	dsp_sec: whole DSP time of the segments a transition ran in (seconds), extra_sec included.
+*/
+
+struct _audiortdsp_xfade_stats {
+	ULONG64 n_transitions;
+	ULONG64 n_frames;
+	DOUBLE extra_sec;
+	DOUBLE dsp_sec;
+};
+
+/*
+	Playback telemetry (last playback session, only built with __RTDSP_TELEMETRY defined, see config.h):
+
+	Every stage is timed once per segment, into a histogram of AUDIORTDSP_TELEMETRY_N_BUCKETS power of 2 buckets:
+	bucket 0 counts durations under 1 microsecond, bucket n counts durations from 2^(n - 1) up to 2^n microseconds, the last bucket counts anything longer.
+
+	Stage timing (stages indexed by AudioRTDSP::TelemetryStage):
+
+	n_samples: number of timed segments.
+	avg_us, max_us: average and longest duration (microseconds).
+	p50_us, p99_us, p999_us: 50th, 99th and 99.9th percentiles (microseconds, upper bound of the bucket the percentile falls in, at most max_us).
+	hist: histogram.
+
+	Telemetry:
+
+	stages: stage timing.
+	n_played: number of segments played.
+	n_underruns: number of times the play thread found no processed segment ready (see audiortdsp_buffer_stats_t).
+	padding_min, padding_avg, padding_max: audio buffer padding (frames queued in the audio output, IAudioClient::GetCurrentPadding() with WASAPI),
+	seen by the play thread right before each segment is written.
+*/
+
+#define AUDIORTDSP_TELEMETRY_N_BUCKETS 24u
+#define AUDIORTDSP_TELEMETRY_N_STAGES 5u
+
+struct _audiortdsp_telemetry_stage {
+	ULONG64 n_samples;
+	DOUBLE avg_us;
+	DOUBLE max_us;
+	DOUBLE p50_us;
+	DOUBLE p99_us;
+	DOUBLE p999_us;
+	ULONG64 hist[AUDIORTDSP_TELEMETRY_N_BUCKETS];
+};
+
+struct _audiortdsp_telemetry {
+	struct _audiortdsp_telemetry_stage stages[AUDIORTDSP_TELEMETRY_N_STAGES];
+	ULONG64 n_played;
+	ULONG64 n_underruns;
+	SIZE_T padding_min;
+	DOUBLE padding_avg;
+	SIZE_T padding_max;
+};
+
+/*
+	Input file read-ahead block:
+
+	overlapped: overlapped read of the block (overlapped.hEvent is signaled once the read is complete).
+	p_data: block data (READAHEAD_BLOCK_SIZE_BYTES bytes within p_readahead).
+	filein_pos: file position of the first byte of the block.
+	n_bytes: number of bytes read (valid once pending is cleared, short or 0 at the end of the file).
+	pending: the read was issued and its result wasn't retrieved yet.
+*/
+
+struct _audiortdsp_readahead_block {
+	OVERLAPPED overlapped;
+	BYTE *p_data;
+	ULONG64 filein_pos;
+	SIZE_T n_bytes;
+	BOOL pending;
+};
+
+/*
+	Output buffer ring indexes (single producer: load thread, single consumer: play thread).
+
+	n_push: number of segments processed (written by the load thread only).
+	n_pop: number of segments played (written by the play thread only).
+
+	Both are free running counters, (n_push - n_pop) is the number of segments ready to be played.
+	Each counter is padded to its own cache line, so that the load thread and play thread don't keep invalidating each other's cache line.
+*/
+
+#define AUDIORTDSP_CACHELINE_SIZE 64u
+
+struct _audiortdsp_segring {
+	BYTE pad_begin[AUDIORTDSP_CACHELINE_SIZE];
+	volatile LONG n_push;
+	BYTE pad_push[AUDIORTDSP_CACHELINE_SIZE - sizeof(LONG)];
+	volatile LONG n_pop;
+	BYTE pad_pop[AUDIORTDSP_CACHELINE_SIZE - sizeof(LONG)];
+};
+
+/*
+	Telemetry counter: raw timing of 1 stage (QueryPerformanceCounter() ticks), written by a single thread, read without locking.
+	Padded to whole cache lines, so the counters of the load thread and the play thread don't share one.
+*/
+
+struct _audiortdsp_telemetry_counter {
+	ULONG64 n_samples;
+	ULONG64 sum_ticks;
+	ULONG64 max_ticks;
+	ULONG64 hist[AUDIORTDSP_TELEMETRY_N_BUCKETS];
+	BYTE pad[AUDIORTDSP_CACHELINE_SIZE - ((3u + AUDIORTDSP_TELEMETRY_N_BUCKETS)*sizeof(ULONG64))%AUDIORTDSP_CACHELINE_SIZE];
+};
+
+/*
+	DSP parameter snapshot: everything dsp_proc() needs from the FX parameters, built by the control thread (see dsp_snapshot_publish()).
+
+	fx_params: FX parameters.
+	p_gains: feedback tap gain table (p_gains[n_cycle - 1] is the gain for tap n_cycle, see dsp_gains_update()).
+	n_taps: number of taps to process. Taps beyond it are either not enabled or zero for every sample value.
+	comb: recursive comb kernel parameters (see dsp_comb_update()).
+	comb_corr_delay: correction tap delay (n_delay*(n_feedback + 2)), 0 if the correction tap is below the comb state resolution.
+	comb_active: dsp_proc() runs the comb instead of the feedback taps.
+	fx_versions: version of each FX parameter (see dsp_params_versions), indexed by its command type (CMD_SET_DELAY to CMD_SET_RECURSIVE_COMB).
+	xfade_frames: FX parameter transition length (see setTransitionTime()).
+	ring_frames: input buffer ring size the gain table and comb parameters were built for (see dsp_gains_update()).
+*/
+
+#define AUDIORTDSP_FX_PARAMS_COUNT 5u
+
+struct _audiortdsp_dspsnap {
+	struct _audiortdsp_fx_params fx_params;
+	dspkernel_gain_t *p_gains;
+	INT32 n_taps;
+	dspkernel_comb_t comb;
+	SIZE_T comb_corr_delay;
+	BOOL comb_active;
+	UINT32 fx_versions[AUDIORTDSP_FX_PARAMS_COUNT];
+	SIZE_T xfade_frames;
+	SIZE_T ring_frames;
+};
+
+/*
+	Command queue slot: seq is the queue position the slot is free for (producers), or that position + 1 once the command is stored (consumer).
+*/
+
+struct _audiortdsp_cmdslot {
+	volatile LONG seq;
+	struct _audiortdsp_cmd cmd;
+};
+
+/*
+	Parallel render chunk: output frames [nframe_begin, nframe_end) of the input audio data.
+*/
+
+struct _audiortdsp_render_chunk {
+	ULONG64 nframe_begin;
+	ULONG64 nframe_end;
+};
+
+/*
+	Virtual memory buffer: an address range reserved once (reserve_size bytes), of which only the first commit_size bytes are committed (usable).
+	Pages are committed as the buffer grows (committed pages start zeroed), and everything is released at once.
+*/
+
+struct _audiortdsp_vbuffer {
+	BYTE *p_base;
+	SIZE_T reserve_size;
+	SIZE_T commit_size;
 };
 
 typedef struct _audiortdsp_pb_params audiortdsp_pb_params_t;
 typedef struct _audiortdsp_fx_params audiortdsp_fx_params_t;
+typedef struct _audiortdsp_cmd audiortdsp_cmd_t;
+typedef struct _audiortdsp_buffer_stats audiortdsp_buffer_stats_t;
+typedef struct _audiortdsp_render_stats audiortdsp_render_stats_t;
+typedef struct _audiortdsp_io_stats audiortdsp_io_stats_t;
+typedef struct _audiortdsp_xfade_stats audiortdsp_xfade_stats_t;
+typedef struct _audiortdsp_telemetry_stage audiortdsp_telemetry_stage_t;
+typedef struct _audiortdsp_telemetry audiortdsp_telemetry_t;
+typedef struct _audiortdsp_telemetry_counter audiortdsp_telemetry_counter_t;
+typedef struct _audiortdsp_readahead_block audiortdsp_readahead_block_t;
+typedef struct _audiortdsp_segring audiortdsp_segring_t;
+typedef struct _audiortdsp_dspsnap audiortdsp_dspsnap_t;
+typedef struct _audiortdsp_cmdslot audiortdsp_cmdslot_t;
+typedef struct _audiortdsp_render_chunk audiortdsp_render_chunk_t;
+typedef struct _audiortdsp_vbuffer audiortdsp_vbuffer_t;
 
 class AudioRTDSP {
 	public:
 		AudioRTDSP(const audiortdsp_pb_params_t *p_params);
+		virtual ~AudioRTDSP(VOID);
 
 		BOOL WINAPI setPlaybackParameters(const audiortdsp_pb_params_t *p_params);
+		BOOL WINAPI setBufferDepth(SIZE_T n_segments);
+		BOOL WINAPI setAudioBackend(AudioBackend *p_backend);
+
+		/*
+			enableMappedInput(): read the input file through a file mapping instead of the input buffer ring. Must be called before initialize().
+
+			dsp_proc() reads the current segment and every feedback tap straight from the mapped audio data (taps before the first frame read zeros),
+			so there's no file read per segment and n_delay*(n_feedback + 1) is no longer limited by the input buffer size.
+			16bit data is read as is (enabled by default).
+			24bit data is unpacked as it's read, once per tap span instead of once per segment (disabled by default, slower for more than a few taps).
+
+			Falls back to the input buffer ring if the file can't be mapped (e.g. not enough address space on 32bit builds).
+		*/
+
+		BOOL WINAPI enableMappedInput(BOOL enable);
+
+		/*
+			enableDirectOutput(): play without the output buffer ring (disabled by default). Must be called before initialize().
+
+			The play thread loads and processes each segment itself, as soon as the audio output has room for it,
+			and the DSP writes the output samples straight into the audio device buffer (see AudioBackend::acquireFrames()): no load thread, no output copy.
+			The DSP must then keep up with every single segment on its own, there's no output buffer depth to absorb a slow one (see setBufferDepth()).
+			Falls back to the output buffer ring if the audio backend doesn't support output spans.
+
+			The offline render always writes straight into the output file when the backend supports output spans.
+		*/
+
+		BOOL WINAPI enableDirectOutput(BOOL enable);
+
+		/*
+			setReadAheadSize(): input file read-ahead depth (bytes, 0 disables the read-ahead). Must be called before initialize().
+
+			Without a mapped input, the input file is read in large blocks (a whole number of segments, about 256 KiB each) through overlapped I/O,
+			keeping up to n_bytes in flight ahead of the load stage, which only copies already resident data into the input buffer ring.
+			The load stage only waits if the disk falls behind (see getIOStats()). Defaults to 2 MiB, up to READAHEAD_MAX_SIZE_BYTES.
+
+			Falls back to one synchronous read per segment if the read-ahead can't be set up.
+		*/
+
+		BOOL WINAPI setReadAheadSize(SIZE_T n_bytes);
+
+		/*
+			enableLargePageArena(): allocate the buffer arena on large pages (disabled by default). Must be called before initialize().
+
+			Every per-session buffer (output buffer, DSP buffers, segment tables, byte buffers) is carved from one arena block, 64-byte aligned.
+			The arena is kept when the session ends and reused by the next one if it's big enough, so a new session doesn't allocate nor zero pages.
+			Falls back to regular pages if large pages aren't available (the process needs the lock pages in memory privilege).
+		*/
+
+		BOOL WINAPI enableLargePageArena(BOOL enable);
+
+		/*
+			enableAdaptiveDepth(): let the playback session pick the output buffer depth from the measured DSP cost (disabled by default). Must be called before initialize().
+
+			The load thread times every segment it loads and processes, against the segment period (the time the play thread takes to play one segment).
+			The active depth is the smallest number of segments that keeps the expected cost plus the safety margin (setDeadlineMargin()) within the queued segments,
+			bounded by setBufferDepth(). The load thread runs ahead of the play thread by no more than the active depth.
+
+			The expected cost follows the FX parameters (it's measured per tap), so the depth is renegotiated on every FX parameter change:
+			light parameters play with the lowest latency, and a large feedback count raises the depth before the play thread runs out of segments.
+			Cost spikes raise the depth right away, it decays back over DEPTH_DECAY_SEGMENTS segments.
+		*/
+
+		BOOL WINAPI enableAdaptiveDepth(BOOL enable);
+
+		/*
+			setDeadlineMargin(): safety margin of the adaptive depth, percent of the segment period (0 to DEPTH_MAX_MARGIN_PCT, default 50). Must be called before initialize().
+		*/
+
+		BOOL WINAPI setDeadlineMargin(UINT32 margin_pct);
+
+		/*
+			enableDeadlineWatchdog(): let the DSP stage degrade when it's about to miss the play deadline (disabled by default). Must be called before initialize().
+
+			Before each segment, the load thread checks the time left until the play thread needs it (the processed segments still queued)
+			against the expected cost of the segment plus the safety margin (same estimate and margin as enableAdaptiveDepth()).
+			If the budget would run out, the segment is processed without the tail feedback taps that don't fit (the quietest ones, tap gains only decrease),
+			always keeping the first setDegradeTapIndex() taps. Full quality comes back as soon as the budget allows it.
+
+			The recursive comb is never degraded (its cost doesn't depend on the feedback count). Only applies to the output buffer ring (see enableDirectOutput()).
+			Degradations are counted in the output buffer statistics (see getBufferStats()).
+		*/
+
+		BOOL WINAPI enableDeadlineWatchdog(BOOL enable);
+
+		/*
+			setDegradeTapIndex(): number of feedback taps the deadline watchdog always keeps (default 8). Taps beyond it may be dropped. Must be called before initialize().
+		*/
+
+		BOOL WINAPI setDegradeTapIndex(SIZE_T n_taps);
+
 		BOOL WINAPI initialize(VOID);
 		BOOL WINAPI runPlayback(VOID);
 		VOID WINAPI stopPlayback(VOID);
 
+		/*
+			runRender(): offline render. Processes the whole input file as fast as the CPU allows and writes the result to a RIFF/WAVE file.
+			No audio device is used. Runs on the calling thread, can be aborted with stopPlayback().
+
+			Must be called on an uninitialized object (instead of initialize() + runPlayback()). The audio backend in use is kept and restored afterwards.
+			p_fx_params: FX parameters for the whole render. Set to NULL to use the default FX parameters.
+			p_stats: pointer to object that receives the render statistics. Set to NULL if unused.
+
+			returns true if successful, false otherwise.
+		*/
+
+		BOOL WINAPI runRender(const audiortdsp_fx_params_t *p_fx_params, const TCHAR *fileout_dir, audiortdsp_render_stats_t *p_stats);
+
+		/*
+			runRenderParallel(): offline render split across n_threads threads (0 means one thread per logical processor). Same usage as runRender().
+
+			The timeline is split into chunks, each one rendered by its own AudioRTDSP object straight into its region of the output file.
+			Every output frame only depends on the input frames up to n_delay*(n_feedback + 1) frames before it (the feedback taps read the input buffer, not previous outputs),
+			so each chunk starts that many frames early (history, rounded to the segment grid) and discards the output of the history frames.
+			The output file is bit-identical to runRender().
+
+			The recursive comb (recursive_comb) carries its state through the whole file, so it can't be split into chunks: runRender() is used instead.
+			Same with pending commands (see postCommand()), they're applied on a single timeline.
+
+			stopPlayback() aborts the render once the chunks in progress are done.
+		*/
+
+		BOOL WINAPI runRenderParallel(const audiortdsp_fx_params_t *p_fx_params, const TCHAR *fileout_dir, SIZE_T n_threads, audiortdsp_render_stats_t *p_stats);
+
 		BOOL WINAPI loadAudioDeviceList(HWND p_listbox);
 		BOOL WINAPI chooseDevice(SIZE_T index);
 		BOOL WINAPI chooseDefaultDevice(VOID);
 
 		BOOL WINAPI getFXParams(audiortdsp_fx_params_t *p_params);
+		BOOL WINAPI getBufferStats(audiortdsp_buffer_stats_t *p_stats);
+		BOOL WINAPI getIOStats(audiortdsp_io_stats_t *p_stats);
+		BOOL WINAPI getTransitionStats(audiortdsp_xfade_stats_t *p_stats);
+
+		/*
+			getTelemetry(): retrieve the playback telemetry (see audiortdsp_telemetry_t). May be called while playing.
+			dumpTelemetry(): write the playback telemetry as a text report to the given file.
+
+			Only available if built with __RTDSP_TELEMETRY defined (see config.h), both return false otherwise.
+			returns true if successful, false otherwise.
+		*/
+
+		BOOL WINAPI getTelemetry(audiortdsp_telemetry_t *p_telemetry);
+		BOOL WINAPI dumpTelemetry(const TCHAR *fileout_dir);
 
 		BOOL WINAPI setFXDelay(SIZE_T n_delay);
 		BOOL WINAPI setFXFeedback(SIZE_T n_feedback);
 		BOOL WINAPI enableFeedbackAltPol(BOOL enable);
 		BOOL WINAPI enableCycleDivIncOne(BOOL enable);
 
+		/*
+			enableRecursiveComb(): process the feedback taps as a recursive comb (plus 1 correction tap) instead of one tap at a time.
+			Only used with power of 2 dividers (cyclediv_inc_one disabled), the per sample cost doesn't depend on n_feedback.
+			Falls back to the feedback taps whenever the comb can't be used (cyclediv_inc_one enabled, n_delay = 0 or the correction tap beyond the input buffer).
+
+			Error bound against the feedback taps: each feedback tap truncates its own term, the comb rounds the whole sum once.
+			The feedback sum before the final /2 differs by less than (number of non-zero taps + 1), so output samples differ by at most (n_taps + 2)/2 LSB,
+			where n_taps = min(n_feedback + 1, sample bits - 1) (8 LSB on 16bit, 12 LSB on 24bit in the worst case, usually much less with feedback_alt_pol).
+
+			Changing the FX parameters while the comb is running leaves a transient on the comb state that decays by half every n_delay frames.
+		*/
+
+		BOOL WINAPI enableRecursiveComb(BOOL enable);
+
+		/*
+			setTransitionTime(): crossfade every FX parameter change over n_frames frames (0 disables the transitions, default). Up to XFADE_MAX_FRAMES.
+			Unlike the FX parameter setters, may be called at any time: before initialize() or runRender() too, the next session starts with it.
+
+			Whenever the FX parameters in use change (setters or commands), the load thread renders both the old and the new parameters for n_frames frames
+			and crossfades from the old output to the new one, so a delay/feedback change doesn't click. Costs 1 extra DSP pass per transition frame (see getTransitionStats()).
+			The ramp runs over the interleaved samples (the channels of a frame are within 1 ramp step), shorter on streams with many channels (XFADE_MAX_SAMPLES).
+
+			FX parameter changes made while a transition is running (setters and commands) wait for it to end, CMD_STOP and CMD_SEEK don't.
+			The old parameters are rendered with the feedback taps: if they used the recursive comb, the first frames of the transition may differ from it by its error bound.
+			No transition at the very first frame of a session.
+		*/
+
+		BOOL WINAPI setTransitionTime(SIZE_T n_frames);
+
+		/*
+			postCommand(): queue a runtime control command. Can be called from any number of threads at once, never blocks nor takes a lock.
+
+			The load thread applies the command at exactly engine frame p_cmd->nframe, splitting the segment in progress at that frame if needed.
+			Commands are taken once per segment, in frame order (same frame: posting order). A command whose frame has already been processed applies as soon as it's taken.
+			Commands still pending when the playback/render session ends are discarded, commands posted between sessions apply to the next one.
+
+			CMD_SET_DELAY, CMD_SET_FEEDBACK: same as setFXDelay(), setFXFeedback(). Dropped if n_delay*(n_feedback + 1) doesn't fit the input buffer ring as it is:
+			the load thread doesn't grow the ring, call the setters beforehand to size it for the largest values the commands will use.
+			Dropped commands are counted in getBufferStats() (n_cmd_dropped).
+			CMD_SET_FEEDBACK_ALT_POL, CMD_SET_CYCLEDIV_INC_ONE, CMD_SET_RECURSIVE_COMB: same as enableFeedbackAltPol(), enableCycleDivIncOne(), enableRecursiveComb().
+			A setter called later overrides the command value of its own FX parameter only.
+
+			CMD_STOP: end the session at that frame (frames from it onwards are silence, the offline render output ends there). stopPlayback() still aborts right away.
+			CMD_SEEK: engine frame nframe onwards reads the input from input frame value (frames past the end of the audio data end the session, as usual).
+			At most 1 seek per segment: a second seek within the same segment is applied at the start of the next one.
+			The feedback taps keep the input that was actually played before the seek. With the mapped input, they read the input file before the seek target instead.
+
+			returns true if the command was queued, false if the queue is full or the command type is invalid (doesn't set the error message).
+		*/
+
+		BOOL WINAPI postCommand(const audiortdsp_cmd_t *p_cmd);
+
+		/*
+			getEngineFrame(): engine frame of the next segment to be processed (frames processed so far in the current session, seeks don't change it).
+			The playback output runs behind it by up to the output buffer depth plus the audio buffer.
+		*/
+
+		ULONG64 WINAPI getEngineFrame(VOID);
+
 		__string WINAPI getLastErrorMessage(VOID);
 
 		enum Status {
@@ -67,7 +530,44 @@ class AudioRTDSP {
 			STATUS_PLAYING = 2
 		};
 
+		enum Command {
+			CMD_SET_DELAY = 0,
+			CMD_SET_FEEDBACK = 1,
+			CMD_SET_FEEDBACK_ALT_POL = 2,
+			CMD_SET_CYCLEDIV_INC_ONE = 3,
+			CMD_SET_RECURSIVE_COMB = 4,
+			CMD_STOP = 5,
+			CMD_SEEK = 6
+		};
+
+		/*
+			Telemetry stages:
+
+			TELEMETRY_LOAD: buffer_load() (load thread).
+			TELEMETRY_DSP: dsp_proc() (load thread).
+			TELEMETRY_PLAY: buffer_play(), writing the segment to the audio output (play thread).
+			TELEMETRY_WAIT: audio_hw_wait(), waiting for room in the audio output (play thread).
+			TELEMETRY_SLACK: deadline slack, how long a processed segment waited in the output buffer ring before the play thread took it (play thread).
+			Close to 0 means the play thread was waiting for it. Not recorded with direct output.
+		*/
+
+		enum TelemetryStage {
+			TELEMETRY_LOAD = 0,
+			TELEMETRY_DSP = 1,
+			TELEMETRY_PLAY = 2,
+			TELEMETRY_WAIT = 3,
+			TELEMETRY_SLACK = 4
+		};
+
 	protected:
+		/*
+			p_heap: private heap for every buffer of this object (created in the constructor, destroyed in the destructor).
+			Each AudioRTDSP object only touches its own heap, handles and buffers, so multiple objects can run concurrently on different threads.
+			Falls back to the process heap if a private heap can't be created.
+		*/
+
+		HANDLE p_heap = NULL;
+
 		HANDLE h_filein = INVALID_HANDLE_VALUE;
 
 		fileptr64_t filein_size_64 = {
@@ -83,21 +583,96 @@ class AudioRTDSP {
 		ULONG64 AUDIO_DATA_BEGIN = 0u;
 		ULONG64 AUDIO_DATA_END = 0u;
 
-		IMMDeviceEnumerator *p_audiodevenum = NULL;
-		IMMDeviceCollection *p_audiodevcoll = NULL;
+		/*Input file frame size (bytes). Set by audio_hw_init().*/
+
+		SIZE_T FILEIN_FRAME_SIZE_BYTES = 0u;
+
+		/*Input/output buffer frame size (bytes). Set by audio_hw_init().*/
+
+		SIZE_T BUFFER_FRAME_SIZE_BYTES = 0u;
+
+		/*
+			Mapped input (see enableMappedInput()):
+
+			h_filein_map, p_filein_map: file mapping and view of the whole input file.
+			p_filein_data: first frame of the audio data within the view. NULL if the input buffer ring is in use.
+			filein_n_frames: number of whole frames within the audio data.
+			filein_nframe_curr: first frame of the current segment (set by buffer_load()).
+			filein_nframe_seek: frame the current segment continues from at its seek (bufferin_seek_seg_nframe), if any.
+
+			DSP_MAX_SPAN_FRAMES: n_delay*(n_feedback + 1) must stay below it (input buffer reserved size minus 1 segment, or the INT32 range if the input is mapped).
+		*/
 
-		IMMDevice *p_audiodev = NULL;
-		IAudioClient *p_audiomgr = NULL;
-		IAudioRenderClient *p_audioout = NULL;
+		BOOL filein_map_enable = TRUE;
+
+		/*
+			bufferout_direct_enable: direct output requested (see enableDirectOutput()).
+			bufferout_direct: the current session writes every processed segment straight into an output span, the output buffer ring is not used.
+		*/
+
+		BOOL bufferout_direct_enable = FALSE;
+		BOOL bufferout_direct = FALSE;
+
+		HANDLE h_filein_map = NULL;
+		const BYTE *p_filein_map = NULL;
+		const BYTE *p_filein_data = NULL;
+
+		ULONG64 filein_n_frames = 0u;
+		ULONG64 filein_nframe_curr = 0u;
+		ULONG64 filein_nframe_seek = 0u;
+
+		ULONG64 DSP_MAX_SPAN_FRAMES = 0u;
+
+		/*
+			Input file read-ahead (input buffer ring only, see setReadAheadSize()):
+
+			h_filein_async: second handle to the input file, opened for overlapped I/O.
+			p_readahead: READAHEAD_N_BLOCKS blocks of READAHEAD_BLOCK_SIZE_BYTES bytes, p_readahead_blocks holds the read of each block.
+			readahead_nblock_curr: block holding the current file position (the next one to be consumed).
+			readahead_pos_next: file position of the next block to be issued.
+
+			READAHEAD_BLOCK_SIZE_BYTES is a whole number of input segments close to READAHEAD_BLOCK_TARGET_BYTES, so a segment never spans 2 blocks.
+			READAHEAD_N_BLOCKS is 0 if the read-ahead is not in use.
+
+			io_n_reads, io_n_waits, io_wait_ticks: input file read statistics (QueryPerformanceCounter() ticks), see getIOStats().
+		*/
+
+		static constexpr SIZE_T READAHEAD_BLOCK_TARGET_BYTES = 262144u;
+		static constexpr SIZE_T READAHEAD_MAX_SIZE_BYTES = 67108864u;
+
+		SIZE_T READAHEAD_SIZE_BYTES = 2097152u;
+		SIZE_T READAHEAD_BLOCK_SIZE_BYTES = 0u;
+		SIZE_T READAHEAD_N_BLOCKS = 0u;
+
+		HANDLE h_filein_async = INVALID_HANDLE_VALUE;
+
+		BYTE *p_readahead = NULL;
+		audiortdsp_readahead_block_t *p_readahead_blocks = NULL;
+
+		SIZE_T readahead_nblock_curr = 0u;
+		ULONG64 readahead_pos_next = 0u;
+
+		volatile LONG64 io_n_reads = 0;
+		volatile LONG64 io_n_waits = 0;
+		volatile LONG64 io_wait_ticks = 0;
+
+		/*
+			p_backend: audio output (see AudioBackend.hpp). Owned by the AudioRTDSP object.
+			Defaults to an AudioBackend_WASAPI (audio device output), or to a real time AudioBackend_Null outside Windows, can be replaced with setAudioBackend().
+		*/
+
+		AudioBackend *p_backend = NULL;
 
 		/*
 			BUFFERS:
 			Buffers will be split into segments:
 
 			Input buffer is the source to the DSP. It should be split into multiple segments.
-			Output buffer is just 2 segments: currently loading and currently playing.
+			Output buffer is a ring of BUFFEROUT_N_SEGMENTS processed segments between the load thread (producer) and the play thread (consumer).
+			The load thread may run ahead of the play thread by up to BUFFEROUT_N_SEGMENTS segments, absorbing file read hiccups.
 
-			1 buffer segment size should be close (maybe a little above) half the audio buffer size. It MUST be a power of 2.
+			1 buffer segment is half the audio buffer size (a whole number of device periods, if any, see audio_hw_init_pcm()). Any frame count.
+			Rings are indexed by segment and by frame offset, never with power of 2 masks.
 		*/
 
 		SIZE_T AUDIOBUFFER_SIZE_FRAMES = 0u;
@@ -107,10 +682,10 @@ class AudioRTDSP {
 		/*
 			AUDIOBUFFER_SEGMENT_SIZE and BUFFER_SEGMENT_SIZE theoretically should be the same,
 			however, due to possible audio hardware limitations (bit depth, number of channels, etc...), 
-			it might be needed to make format conversions from p_bufferoutput to p_audiobuffer.
+			it might be needed to make format conversions from p_bufferoutput to the audio output.
 
 			BUFFER_SEGMENT_SIZE_... refers to p_bufferinput and p_bufferoutput.
-			AUDIOBUFFER_SEGMENT_SIZE_... refers to p_audiobuffer.
+			AUDIOBUFFER_SEGMENT_SIZE_... refers to the audio output (p_backend).
 		*/
 
 		SIZE_T AUDIOBUFFER_SEGMENT_SIZE_FRAMES = 0u;
@@ -121,53 +696,405 @@ class AudioRTDSP {
 		SIZE_T BUFFER_SEGMENT_SIZE_SAMPLES = 0u;
 		SIZE_T BUFFER_SEGMENT_SIZE_BYTES = 0u;
 
-		static constexpr SIZE_T BUFFERIN_SIZE_FRAMES = 65536u;
+		/*
+			Input buffer ring size:
+
+			The input buffer ring (and the comb state, same layout) is sized from the FX parameters: the smallest power of 2 number of segments holding n_delay*(n_feedback + 1) frames of history plus the current segment
+			((n_feedback + 2) with the recursive comb, n_delay only for the comb state of the mapped input). BUFFERIN_MAX_SIZE_FRAMES is a whole number of segments as well.
+
+			BUFFERIN_MAX_SIZE_FRAMES frames of address space are reserved at initialize() (BUFFERIN_RESERVE_FRAMES, halved until the reservation succeeds),
+			and pages are only committed when the FX parameters need a bigger ring (bufferin_grow()). The ring never shrinks within a session.
+
+			BUFFERIN_SIZE_FRAMES: current ring size, owned by the load thread.
+			bufferin_size_next: ring size the load thread switches to once it reaches the last segment of the ring in use (bufferin_resize()), pages already committed.
+			Snapshots built for the new size wait until then (see dspsnap_hold).
+		*/
+
+		static constexpr SIZE_T BUFFERIN_RESERVE_FRAMES = 16777216u;
+		static constexpr SIZE_T BUFFERIN_MIN_RESERVE_FRAMES = 65536u;
+
+		SIZE_T BUFFERIN_MAX_SIZE_FRAMES = 0u;
+
+		SIZE_T BUFFERIN_SIZE_FRAMES = 0u;
 		SIZE_T BUFFERIN_SIZE_SAMPLES = 0u;
 		SIZE_T BUFFERIN_SIZE_BYTES = 0u;
 
+		volatile LONG bufferin_size_next = 0;
+
 		SIZE_T BUFFEROUT_SIZE_FRAMES = 0u;
 		SIZE_T BUFFEROUT_SIZE_SAMPLES = 0u;
 		SIZE_T BUFFEROUT_SIZE_BYTES = 0u;
 
 		SIZE_T BUFFERIN_N_SEGMENTS = 0u;
 
-		static constexpr SIZE_T BUFFEROUT_N_SEGMENTS = 2u;
+		static constexpr SIZE_T BUFFEROUT_MIN_N_SEGMENTS = 2u;
+		static constexpr SIZE_T BUFFEROUT_MAX_N_SEGMENTS = 64u;
+
+		SIZE_T BUFFEROUT_N_SEGMENTS = 2u;
+
+		/*
+			Adaptive output buffer depth (see enableAdaptiveDepth()):
+
+			depth_adapt: adaptive depth enabled.
+			depth_margin_pct: safety margin (percent of the segment period).
+			bufferout_depth: active depth (number of segments, up to BUFFEROUT_N_SEGMENTS), owned by the load thread.
+			depth_period_ticks: segment period (QPC ticks).
+			depth_unit_ticks: decaying peak of the load stage cost per DSP unit (QPC ticks).
+			A DSP unit is one feedback tap (the current segment counts as one), the recursive comb counts as 2 (see depth_update()).
+			depth_load_pct: load stage cost expected for the current FX parameters (percent of the segment period).
+
+			The cost estimate is shared with the deadline watchdog (see enableDeadlineWatchdog()):
+
+			watchdog_enable: deadline watchdog enabled.
+			DEGRADE_MIN_TAPS: number of feedback taps the watchdog always keeps.
+			dsp_tap_limit: number of feedback taps processed for the current segment, 0 for all of them (set by dsp_watchdog(), owned by the load thread).
+		*/
+
+		static constexpr SIZE_T DEPTH_DECAY_SEGMENTS = 64u;
+		static constexpr UINT32 DEPTH_MAX_MARGIN_PCT = 400u;
+
+		BOOL depth_adapt = FALSE;
+		UINT32 depth_margin_pct = 50u;
+
+		SIZE_T bufferout_depth = 2u;
+
+		LONG64 depth_period_ticks = 0;
+		LONG64 depth_unit_ticks = 0;
+		UINT32 depth_load_pct = 0u;
+
+		BOOL watchdog_enable = FALSE;
+		INT32 DEGRADE_MIN_TAPS = 8;
+		INT32 dsp_tap_limit = 0;
+
+#ifdef __RTDSP_TELEMETRY
+		/*
+			Playback telemetry (see getTelemetry()), reset by telemetry_reset() at the beginning of each playback session:
+
+			telemetry_counters: stage timing, indexed by TelemetryStage. Each counter is written by the thread that runs the stage.
+			telemetry_push_ticks: time each output buffer segment was pushed (written by the load thread before the push, read by the play thread after it).
+			telemetry_padding_...: audio buffer padding seen before each write (play thread).
+			telemetry_qpc_freq: QueryPerformanceFrequency().
+		*/
+
+		audiortdsp_telemetry_counter_t telemetry_counters[AUDIORTDSP_TELEMETRY_N_STAGES];
+
+		LONG64 telemetry_push_ticks[BUFFEROUT_MAX_N_SEGMENTS];
+
+		SIZE_T telemetry_padding_min = 0u;
+		SIZE_T telemetry_padding_max = 0u;
+		ULONG64 telemetry_padding_sum = 0u;
+		ULONG64 telemetry_padding_n = 0u;
+
+		LONG64 telemetry_qpc_freq = 0;
+#endif
+
+		/*Output file buffer size (offline render). 1 buffer segment = RENDER_BUFFER_SIZE_FRAMES/2 frames.*/
+
+		static constexpr SIZE_T RENDER_BUFFER_SIZE_FRAMES = 8192u;
+
+		/*
+			Parallel render:
+
+			The timeline is split into up to RENDER_CHUNKS_PER_THREAD chunks per thread (so faster threads pick up the slack),
+			as long as each chunk is at least RENDER_MIN_CHUNK_FRAMES frames long and at least RENDER_MIN_CHUNK_HISTORY_RATIO times its history.
+
+			p_render_chunks: chunk table (owned by runRenderParallel()).
+			render_chunk_next: index of the next chunk to be taken by a render thread (taken with InterlockedIncrement()).
+		*/
+
+		static constexpr SIZE_T RENDER_MAX_N_THREADS = 64u;
+		static constexpr SIZE_T RENDER_CHUNKS_PER_THREAD = 4u;
+		static constexpr ULONG64 RENDER_MIN_CHUNK_FRAMES = 131072u;
+		static constexpr ULONG64 RENDER_MIN_CHUNK_HISTORY_RATIO = 4u;
+
+		audiortdsp_render_chunk_t *p_render_chunks = NULL;
+		SIZE_T render_n_chunks = 0u;
+		volatile LONG render_chunk_next = 0;
+
+		ULONG64 render_history_frames = 0u;
+		ULONG64 render_data_offset = 0u;
+		__string render_fileout_dir = TEXT("");
 
 		/*
 			Segment Indexes:
 
 			bufferin_nseg_curr = index for the input buffer segment currently being loaded.
-			bufferout_nseg_load = index for the output buffer segment currently being loaded.
-			bufferout_nseg_play = index for the output buffer segment currently being played.
+			bufferout_nseg_load = index for the output buffer segment currently being loaded. (owned by the load thread)
+			bufferout_nseg_play = index for the output buffer segment currently being played. (owned by the play thread)
+
+			The load thread indexes (along with dspsnap_front and cmdqueue_pop) and the play thread index are padded to their own cache lines,
+			so that neither thread shares a cache line with the other one or with the fields the control thread writes.
 		*/
 
+		BYTE pad_loadthread_begin[AUDIORTDSP_CACHELINE_SIZE];
+
 		SIZE_T bufferin_nseg_curr = 0u;
 		SIZE_T bufferout_nseg_load = 0u;
+		SIZE_T dspsnap_front = 0u;
+		LONG cmdqueue_pop = 0;
+
+		BYTE pad_loadthread_end[AUDIORTDSP_CACHELINE_SIZE - 3u*sizeof(SIZE_T) - sizeof(LONG)];
+
 		SIZE_T bufferout_nseg_play = 0u;
 
-		VOID *p_audiobuffer = NULL;
+		BYTE pad_playthread_end[AUDIORTDSP_CACHELINE_SIZE - sizeof(SIZE_T)];
+
+		audiortdsp_segring_t bufferout_ring;
+
+		/*
+			p_event_bufferout_ready: signaled by the load thread every time a processed segment is pushed.
+			p_event_bufferout_free: signaled by the play thread every time a played segment is released.
+			bufferout_load_done: set by the load thread when it stops pushing segments (end of file or stop requested).
+		*/
+
+		HANDLE p_event_bufferout_ready = NULL;
+		HANDLE p_event_bufferout_free = NULL;
+
+		volatile LONG bufferout_load_done = 0;
+
+		/*
+			playback_error: set by playback_fail() when the playback session can't go on (audio output error, thread creation error...).
+			Only the first error message is kept in err_msg. runPlayback() returns false.
+		*/
+
+		volatile LONG playback_error = 0;
+
+		audiortdsp_buffer_stats_t bufferout_stats = {
+			.n_segments = 0u,
+			.n_ready = 0u,
+			.n_ready_high = 0u,
+			.n_ready_low = 0u,
+			.n_underruns = 0u,
+			.n_played = 0u,
+			.arena_size = 0u,
+			.n_depth = 0u,
+			.load_pct = 0u,
+			.n_degrade_events = 0u,
+			.n_degraded_segments = 0u,
+			.n_cmd_dropped = 0u
+		};
 
 		VOID *p_bufferinput = NULL;
 		VOID *p_bufferoutput = NULL;
 
 		/*
-			pp_bufferin_segments & pp_bufferout_segments:
+			Buffer arena (see enableLargePageArena()):
+
+			p_arena: arena block, released by the destructor only.
+			arena_size: arena block size (bytes).
+			arena_used: bytes carved by the current session (buffer_alloc()), each buffer starts on an ARENA_ALIGN boundary.
+			arena_reused: the current session reuses the block of a previous session (pages hold stale data, not zeros).
+		*/
+
+		static constexpr SIZE_T ARENA_ALIGN = 64u;
 
-			An array of pointers, each pointer references a different section (segment) of p_bufferinput and p_bufferoutput.
+		BYTE *p_arena = NULL;
+		SIZE_T arena_size = 0u;
+		SIZE_T arena_used = 0u;
+		BOOL arena_reused = FALSE;
+		BOOL arena_large_pages = FALSE;
+
+		/*
+			bufferin_vbuf: virtual memory of the input buffer ring (p_bufferinput is its base address).
+
+			pp_bufferout_segments:
+
+			An array of pointers, each pointer references a different section (segment) of p_bufferoutput.
 			Each pointer points to the first sample of each buffer segment.
+			Input buffer segments are contiguous too, but their number changes as the ring grows: see bufferin_segment().
 		*/
 
-		VOID **pp_bufferin_segments = NULL;
+		audiortdsp_vbuffer_t bufferin_vbuf = {
+			.p_base = NULL,
+			.reserve_size = 0u,
+			.commit_size = 0u
+		};
+
 		VOID **pp_bufferout_segments = NULL;
 
-		HANDLE p_loadthread = NULL;
-		HANDLE p_playthread = NULL;
+		/*
+			p_dspkernel: DSP kernel implementation (scalar or vectorized) selected for the running CPU.
+		*/
+
+		const dspkernel_table_t *p_dspkernel = NULL;
+
+		/*
+			DSP parameter snapshots (triple buffer, single writer: control thread, single reader: load thread):
+
+			dspsnap_back: snapshot owned by the control thread, rebuilt from dsp_params on every FX parameter change (gain table included, so dsp_proc() doesn't need to divide).
+			dspsnap_front: snapshot owned by the load thread, used for a whole segment.
+			dspsnap_mid: the third snapshot, ORed with DSPSNAP_NEW if the control thread has published it since the load thread last took it.
+
+			dsp_snapshot_publish() swaps dspsnap_back with dspsnap_mid, dsp_snapshot_acquire() swaps dspsnap_front with dspsnap_mid if it's new.
+			Neither side ever waits for the other one, and neither side ever touches a snapshot the other side owns.
+
+			Each snapshot has its own gain table of DSPGAINS_SIZE taps (buffer arena).
+
+			dspsnap_hold: load thread snapshot of the FX parameters in use, used instead of a new snapshot built for an input buffer ring the load thread hasn't switched to yet.
+		*/
+
+		static constexpr SIZE_T DSPGAINS_SIZE = 65536u;
+		static constexpr SIZE_T DSPGAINS_SIZE_BYTES = DSPGAINS_SIZE*sizeof(dspkernel_gain_t);
+
+		static constexpr SIZE_T DSPSNAP_COUNT = 3u;
+		static constexpr LONG DSPSNAP_NEW = 0x100;
+		static constexpr LONG DSPSNAP_INDEX_MASK = 0xff;
+
+		audiortdsp_dspsnap_t dspsnaps[DSPSNAP_COUNT];
+		audiortdsp_dspsnap_t dspsnap_hold;
+
+		SIZE_T dspsnap_back = 0u;
+
+		BYTE pad_dspsnap_begin[AUDIORTDSP_CACHELINE_SIZE];
+		volatile LONG dspsnap_mid = 1;
+		BYTE pad_dspsnap_end[AUDIORTDSP_CACHELINE_SIZE - sizeof(LONG)];
+
+		/*
+			Command queue (see postCommand()), bounded and lock-free, multiple producers (control threads), single consumer (load thread):
+
+			cmdqueue: CMDQUEUE_SIZE slots (power of 2), slot seq starts at the slot index.
+			cmdqueue_push: next position to be claimed by a producer (compare exchange), padded to its own cache line.
+			cmdqueue_pop: next position to be taken by the load thread (load thread block above).
+
+			A producer claims position n once slot (n % CMDQUEUE_SIZE) has seq n, stores the command and sets seq to n + 1.
+			The load thread takes it once seq is n + 1 and frees the slot for position n + CMDQUEUE_SIZE. The queue is full if the slot still holds position n - CMDQUEUE_SIZE.
+
+			Load thread side:
+
+			cmd_pending: commands taken from the queue and not applied yet (cmd_n_pending), sorted by frame (see cmd_collect()).
+			cmd_stop: a CMD_STOP command was applied, the session ends after the current segment.
+			dsp_nframe_curr: engine frame of the first frame of the current segment (see getEngineFrame()).
+			dspengine_params, dspengine_versions: FX parameters in use by the load thread (snapshot values plus commands) and the setter versions they came from.
+			bufferin_seek_seg_nframe: frame of the current segment where its input continues from a seek (BUFFER_SEGMENT_SIZE_FRAMES if there's no seek).
+			bufferout_nframes_valid: frames of the current output segment within the audio data (set by buffer_load(), cut short by CMD_STOP).
+
+			dsp_params_versions: control thread side, bumped by every FX parameter setter (copied into the snapshot, see audiortdsp_dspsnap_t).
+		*/
+
+		static constexpr SIZE_T CMDQUEUE_SIZE = 256u;
+
+		audiortdsp_cmdslot_t cmdqueue[CMDQUEUE_SIZE];
+
+		BYTE pad_cmdqueue_begin[AUDIORTDSP_CACHELINE_SIZE];
+		volatile LONG cmdqueue_push = 0;
+		BYTE pad_cmdqueue_end[AUDIORTDSP_CACHELINE_SIZE - sizeof(LONG)];
+
+		audiortdsp_cmd_t cmd_pending[CMDQUEUE_SIZE];
+		SIZE_T cmd_n_pending = 0u;
+		BOOL cmd_stop = FALSE;
+
+		volatile LONG64 dsp_nframe_curr = 0;
+
+		audiortdsp_fx_params_t dspengine_params;
+		UINT32 dspengine_versions[AUDIORTDSP_FX_PARAMS_COUNT];
+
+		SIZE_T bufferin_seek_seg_nframe = 0u;
+		SIZE_T bufferout_nframes_valid = 0u;
+
+		UINT32 dsp_params_versions[AUDIORTDSP_FX_PARAMS_COUNT];
+
+		/*
+			FX parameter transitions (see setTransitionTime()):
+
+			XFADE_MAX_SAMPLES: longest ramp (frames times channels), keeps the ramp step (2^32/ramp samples) at 256 or above.
+			dsp_xfade_frames: transition length, control thread side (copied into the snapshot).
+
+			Load thread side:
+
+			dspsnap_xfade: the FX parameters in use before the transition, feedback taps only (gain table from the buffer arena).
+			p_dspxfade: 1 buffer segment DSP buffer, the old parameters are rendered into it then crossfaded into p_dspbuffer.
+			xfade_len: length of the running transition (frames), 0 if none. xfade_nframe: frames of the transition processed so far.
+			xfade_n_transitions, xfade_n_frames, xfade_extra_ticks, xfade_dsp_ticks: transition statistics (QueryPerformanceCounter() ticks), see getTransitionStats().
+		*/
+
+		static constexpr SIZE_T XFADE_MAX_FRAMES = 1048576u;
+		static constexpr SIZE_T XFADE_MAX_SAMPLES = 16777216u;
+
+		SIZE_T dsp_xfade_frames = 0u;
+
+		audiortdsp_dspsnap_t dspsnap_xfade;
+
+		INT32 *p_dspxfade = NULL;
+
+		SIZE_T xfade_len = 0u;
+		SIZE_T xfade_nframe = 0u;
+
+		volatile LONG64 xfade_n_transitions = 0;
+		volatile LONG64 xfade_n_frames = 0;
+		volatile LONG64 xfade_extra_ticks = 0;
+		volatile LONG64 xfade_dsp_ticks = 0;
+
+		/*
+			DSPBUFFER is a buffer that stores a whole buffer segment of audio.
+			Sample size on DSPBUFFER is bigger than the audio sample size.
+			DSPBUFFER is where most DSP math operations will happen, it's used
+			to prevent integer overflow.
+		*/
+
+		static constexpr SIZE_T DSPBUFFER_SAMPLE_SIZE_BYTES = 4u;
+		SIZE_T DSPBUFFER_SIZE_BYTES = 0u;
+
+		INT32 *p_dspbuffer = NULL;
+
+		/*p_dspzero: 1 buffer segment of zeros, source for the mapped input frames outside the audio data (mapped input only).*/
+
+		VOID *p_dspzero = NULL;
+
+		/*
+			Recursive comb (see enableRecursiveComb()):
+
+			p_dspcomb_state: comb state buffer (1 INT32 per input buffer sample, same layout as the input buffer), base address of dspcomb_vbuf.
+			Only committed once the recursive comb is enabled, then it grows along with the input buffer.
+			DSPCOMB_FRAC_BITS: comb state fractional bits (31 - sample bits, set in audio_hw_init()).
+			The comb kernel parameters are part of the DSP parameter snapshot (see audiortdsp_dspsnap_t).
+		*/
+
+		static constexpr UINT32 DSPCOMB_STATE_BITS = 31u;
+
+		UINT32 DSPCOMB_FRAC_BITS = 0u;
+
+		INT32 *p_dspcomb_state = NULL;
+
+		audiortdsp_vbuffer_t dspcomb_vbuf = {
+			.p_base = NULL,
+			.reserve_size = 0u,
+			.commit_size = 0u
+		};
+
+		/*
+			loadworker: persistent thread that runs loadthread_proc() (buffer load + DSP) once per buffer segment.
+			playworker: persistent thread that runs playthread_proc() (buffer play + audio hardware wait) once per buffer segment.
+			With direct output, playworker runs directthread_proc() (buffer load + DSP + audio hardware wait) instead, and there's no loadworker.
+
+			Both live for the whole playback session (created in playback_loop()).
+		*/
+
+		thread_worker_t loadworker = {
+			.p_thread = NULL,
+			.p_event_run = NULL,
+			.p_event_done = NULL,
+			.p_routine = NULL,
+			.p_args = NULL,
+			.stop = 0
+		};
+
+		thread_worker_t playworker = {
+			.p_thread = NULL,
+			.p_event_run = NULL,
+			.p_event_done = NULL,
+			.p_routine = NULL,
+			.p_args = NULL,
+			.stop = 0
+		};
+
+		/*dsp_params: FX parameters, control thread side (the load thread only reads its snapshot).*/
 
 		audiortdsp_fx_params_t dsp_params = {
 			.n_delay = 240,
 			.n_feedback = 20,
 			.feedback_alt_pol = TRUE,
-			.cyclediv_inc_one = TRUE
+			.cyclediv_inc_one = TRUE,
+			.recursive_comb = FALSE
 		};
 
 		__string FILEIN_DIR = TEXT("");
@@ -179,32 +1106,253 @@ class AudioRTDSP {
 
 		INT status = this->STATUS_UNINITIALIZED;
 
-		BOOL stop_playback = FALSE;
+		/*
+			stop_playback: set by stopPlayback() (control thread) and by the playback threads (end of input, playback_fail()).
+			Polled by the load and play threads, set with an interlocked exchange.
+		*/
+
+		volatile LONG stop_playback = 0;
 
 		BOOL WINAPI filein_open(VOID);
+		BOOL WINAPI filein_map(VOID);
 		VOID WINAPI filein_close(VOID);
 
+		/*
+			filein_read(): read n_bytes from the current file position into p_dest and move the file position forward.
+			Bytes beyond the end of the file read as zeros. Served from the read-ahead if it's in use, with a synchronous read otherwise.
+
+			filein_read_begin(): reset the read statistics and start the read-ahead at the current file position (start of a playback/render session).
+		*/
+
+		VOID WINAPI filein_read(VOID *p_dest, SIZE_T n_bytes);
+		VOID WINAPI filein_read_begin(VOID);
+
+		BOOL WINAPI readahead_init(VOID);
+		VOID WINAPI readahead_deinit(VOID);
+		VOID WINAPI readahead_start(ULONG64 filein_pos);
+		VOID WINAPI readahead_cancel(VOID);
+		VOID WINAPI readahead_issue(audiortdsp_readahead_block_t *p_block, ULONG64 filein_pos);
+		VOID WINAPI readahead_wait(audiortdsp_readahead_block_t *p_block);
+		VOID WINAPI io_stats_reset(VOID);
+
 		virtual BOOL WINAPI audio_hw_init(VOID) = 0;
 
+		/*
+			audio_hw_init_pcm(): open the audio output and set every buffer size for the given sample format. Called from the derived audio_hw_init().
+
+			bits_per_sample: sample container size (bits) of the input/output buffers and the audio output.
+			valid_bits_per_sample: sample resolution (bits).
+			filein_sample_size: input file sample size (bytes).
+		*/
+
+		BOOL WINAPI audio_hw_init_pcm(UINT16 bits_per_sample, UINT16 valid_bits_per_sample, SIZE_T filein_sample_size);
+
+		/*instance_create(): create a new (uninitialized) object of the same derived type (parallel render chunks).*/
+
+		virtual AudioRTDSP* WINAPI instance_create(const audiortdsp_pb_params_t *p_params) = 0;
+
 		VOID WINAPI audio_hw_deinit_device(VOID);
 		VOID WINAPI audio_hw_deinit_all(VOID);
 
 		VOID WINAPI stop_all_threads(VOID);
 
-		virtual BOOL WINAPI buffer_alloc(VOID) = 0;
-		virtual VOID WINAPI buffer_free(VOID) = 0;
+		virtual BOOL WINAPI buffer_alloc(VOID);
+		virtual VOID WINAPI buffer_free(VOID);
+
+		/*
+			buffer_arena_size(): arena bytes needed by buffer_alloc() (derived classes add their own buffers).
+			arena_begin(): get an arena block of at least size bytes, reusing the current one if big enough.
+			arena_carve(): carve the next size bytes of the arena block (returns NULL if the block is full).
+		*/
+
+		virtual SIZE_T WINAPI buffer_arena_size(VOID);
+
+		SIZE_T WINAPI arena_align(SIZE_T size);
+		BOOL WINAPI arena_begin(SIZE_T size);
+		VOID* WINAPI arena_carve(SIZE_T size);
+		VOID WINAPI arena_release(VOID);
+
+		BOOL WINAPI vbuffer_reserve(audiortdsp_vbuffer_t *p_vbuf, SIZE_T size);
+		BOOL WINAPI vbuffer_commit(audiortdsp_vbuffer_t *p_vbuf, SIZE_T size);
+		VOID WINAPI vbuffer_release(audiortdsp_vbuffer_t *p_vbuf);
+
+		BOOL WINAPI bufferin_reserve(VOID);
+		SIZE_T WINAPI bufferin_size_for(const audiortdsp_fx_params_t *p_params);
+		BOOL WINAPI bufferin_grow(const audiortdsp_fx_params_t *p_params);
+		VOID WINAPI bufferin_resize(VOID);
+		VOID WINAPI bufferin_set_size(SIZE_T size_frames);
+		VOID* WINAPI bufferin_segment(SIZE_T nseg);
+
+		BOOL WINAPI playback_proc(VOID);
+
+		BOOL WINAPI render_set_fx(const audiortdsp_fx_params_t *p_fx_params);
+		BOOL WINAPI render_session(const audiortdsp_fx_params_t *p_fx_params, ULONG64 *p_n_frames, DOUBLE *p_elapsed_sec);
+		BOOL WINAPI render_proc(ULONG64 *p_n_frames);
+		BOOL WINAPI render_chunk(const audiortdsp_render_chunk_t *p_chunk);
+		VOID WINAPI render_stats_set(audiortdsp_render_stats_t *p_stats, ULONG64 n_frames, DOUBLE elapsed_sec);
+		BOOL WINAPI playback_init(VOID);
+		BOOL WINAPI playback_loop(VOID);
+		VOID WINAPI playback_fail(const TCHAR *err_msg);
+
+		VOID WINAPI bufferout_reset(VOID);
+		SIZE_T WINAPI bufferout_get_nready(VOID);
+		BOOL WINAPI bufferout_wait_free(VOID);
+		VOID WINAPI bufferout_push(VOID);
+		BOOL WINAPI bufferout_wait_ready(VOID);
+		VOID WINAPI bufferout_pop(VOID);
+
+		/*
+			depth_update(): cost estimate and adaptive depth controller, called by the load thread after each segment (load_ticks: load stage cost of that segment, QPC ticks).
+			Sets bufferout_depth for the FX parameters now in use (adaptive depth only).
+
+			dsp_watchdog(): deadline watchdog, called by the load thread before each segment. Sets dsp_tap_limit for the segment.
+		*/
+
+		VOID WINAPI depth_update(LONG64 load_ticks);
+		VOID WINAPI dsp_watchdog(VOID);
+
+#ifdef __RTDSP_TELEMETRY
+		/*
+			Telemetry hooks (called through the TELEMETRY_... macros, see AudioRTDSP.cpp):
+
+			telemetry_record(): add 1 sample of n_ticks ticks to the stage n_stage.
+			telemetry_end(): record the time elapsed since p_qpc_begin for the stage n_stage.
+			telemetry_push(): timestamp the output buffer segment being pushed (load thread).
+			telemetry_pop(): record the deadline slack of the output buffer segment about to be played (play thread).
+			telemetry_padding(): record the current audio buffer padding (play thread).
+			telemetry_stage_get(): convert the counter of the stage n_stage to microseconds and percentiles.
+		*/
+
+		VOID WINAPI telemetry_reset(VOID);
+		VOID WINAPI telemetry_record(SIZE_T n_stage, LONG64 n_ticks);
+		VOID WINAPI telemetry_end(SIZE_T n_stage, const LARGE_INTEGER *p_qpc_begin);
+		VOID WINAPI telemetry_push(VOID);
+		VOID WINAPI telemetry_pop(VOID);
+		VOID WINAPI telemetry_padding(VOID);
+		VOID WINAPI telemetry_stage_get(SIZE_T n_stage, audiortdsp_telemetry_stage_t *p_stage);
+#endif
+
+		/*
+			buffer_load(): load the next input segment, taking new commands and the seek within the segment, if any. Sets stop_playback at the end of the audio data.
+			buffer_load_span(): load n_frames input frames from the current file position, from frame seg_nframe of the segment on. Only moves the file position if the input is mapped, calls buffer_read() otherwise.
+			Returns how many of them are within the audio data.
+			buffer_read(): read n_frames frames from the file into the current input buffer segment, from frame seg_nframe on.
+		*/
+
+		VOID WINAPI buffer_load(VOID);
+		SIZE_T WINAPI buffer_load_span(SIZE_T seg_nframe, SIZE_T n_frames);
+		virtual VOID WINAPI buffer_read(SIZE_T seg_nframe, SIZE_T n_frames) = 0;
+
+		/*
+			dsp_proc(): process the current segment, one block at a time. A block ends at the next command frame (see cmd_apply()) and at the seek, if any.
+			p_out: receives the output samples of the whole segment (output buffer segment or output span).
+			dsp_proc_block(), dsp_proc_block_mapped(): process n_frames frames of the current segment from frame seg_begin on, input buffer ring or mapped input.
+			p_dsp: DSP buffer of the segment (p_dspbuffer, or p_dspxfade for the old parameters of a transition).
+
+			dsp_xfade_begin(): start a transition from the FX parameters p_prev, if they differ from the ones of p_snap (see setTransitionTime()).
+			dsp_xfade_block(): process a block within a running transition (both parameter sets plus the crossfade). A block never crosses the end of a transition.
+		*/
+
+		VOID WINAPI dsp_proc(VOID *p_out);
+		VOID WINAPI dsp_proc_block(const audiortdsp_dspsnap_t *p_snap, INT32 *p_dsp, SIZE_T seg_begin, SIZE_T n_frames);
+		VOID WINAPI dsp_proc_block_mapped(const audiortdsp_dspsnap_t *p_snap, INT32 *p_dsp, SIZE_T seg_begin, SIZE_T n_frames);
+		VOID WINAPI dsp_xfade_begin(const audiortdsp_dspsnap_t *p_snap, const audiortdsp_fx_params_t *p_prev, SIZE_T seg_nframe);
+		VOID WINAPI dsp_xfade_block(const audiortdsp_dspsnap_t *p_snap, SIZE_T seg_begin, SIZE_T n_frames);
+
+		/*
+			dsp_mapped_src(): Retrieve the mapped input source for a span starting at frame nframe of the audio data (mapped input only).
 
-		VOID WINAPI playback_proc(VOID);
-		VOID WINAPI playback_init(VOID);
-		VOID WINAPI playback_loop(VOID);
+			*p_n_frames is the span length (number of frames, up to 1 buffer segment), and gets shortened so that the span doesn't cross the beginning or the end of the audio data.
+			returns a pointer to frame nframe within the mapped data, or p_dspzero if nframe is outside the audio data.
+		*/
 
-		VOID WINAPI buffer_segment_update(VOID);
+		const VOID* WINAPI dsp_mapped_src(LONG64 nframe, SIZE_T *p_n_frames);
 
-		virtual VOID WINAPI buffer_load(VOID) = 0;
-		virtual VOID WINAPI dsp_proc(VOID) = 0;
+		/*
+			Sample format kernels, implemented by the derived class for its buffer sample type (called by dsp_proc()).
+			p_src, p_corr_src: input samples, from the input buffer ring or from the mapped audio data (file sample format). p_out: output buffer samples.
+
+			dsp_load(): p_acc[n] = p_src[n]
+			dsp_accumulate(): feedback tap (see p_accumulate_i16, p_accumulate_i32).
+			dsp_accumulate2(): two feedback taps in one pass, gains p_gains[0] and p_gains[1] (see p_accumulate2_i16, p_accumulate2_i32).
+			dsp_comb(): recursive comb step (see p_comb_i16, p_comb_i32).
+			dsp_saturate(): clamp p_acc into the output sample format (see p_saturate_i16, p_saturate_i24).
+		*/
 
-		VOID WINAPI buffer_play(VOID);
-		VOID WINAPI audio_hw_wait(VOID);
+		virtual VOID WINAPI dsp_load(INT32 *p_acc, const VOID *p_src, SIZE_T n_samples) = 0;
+		virtual VOID WINAPI dsp_accumulate(INT32 *p_acc, const VOID *p_src, SIZE_T n_samples, const dspkernel_gain_t *p_gain) = 0;
+		virtual VOID WINAPI dsp_accumulate2(INT32 *p_acc, const VOID *p_src1, const VOID *p_src2, SIZE_T n_samples, const dspkernel_gain_t *p_gains) = 0;
+		virtual VOID WINAPI dsp_comb(INT32 *p_state, INT32 *p_acc, const VOID *p_src, const INT32 *p_state_src, const VOID *p_corr_src, SIZE_T n_samples, const dspkernel_comb_t *p_comb) = 0;
+		virtual VOID WINAPI dsp_saturate(VOID *p_out, const INT32 *p_acc, SIZE_T n_samples) = 0;
+
+		/*
+			dsp_snapshot_publish(): rebuild the control thread snapshot from dsp_params and publish it. Called by the control thread after every FX parameter change.
+			dsp_snapshot_acquire(): take the latest published snapshot, if any. Called by the load thread once per segment, unless a transition is running.
+			dsp_snapshot_merge(): keep the command values of the FX parameters that no setter changed since (load thread, after bufferin_resize()).
+			dsp_snapshot_hold(): rebuild dspsnap_hold from the FX parameters in use, for the ring in use (load thread).
+		*/
+
+		VOID WINAPI dsp_snapshot_publish(VOID);
+		audiortdsp_dspsnap_t* WINAPI dsp_snapshot_acquire(VOID);
+		audiortdsp_dspsnap_t* WINAPI dsp_snapshot_hold(const audiortdsp_dspsnap_t *p_snap);
+		VOID WINAPI dsp_snapshot_merge(audiortdsp_dspsnap_t *p_snap);
+
+		/*
+			dsp_gains_update(), dsp_comb_update(): rebuild the gain table and comb parameters of p_snap from its FX parameters.
+			ring_frames: input buffer ring size the snapshot is used with (bufferin_size_next on the control thread, BUFFERIN_SIZE_FRAMES on the load thread).
+
+			dsp_params_fit(): the FX parameters fit the input buffer ring in use and the gain table (load thread).
+		*/
+
+		VOID WINAPI dsp_gains_update(audiortdsp_dspsnap_t *p_snap, SIZE_T ring_frames);
+		VOID WINAPI dsp_comb_update(audiortdsp_dspsnap_t *p_snap, SIZE_T ring_frames);
+		BOOL WINAPI dsp_params_fit(const audiortdsp_fx_params_t *p_params);
+
+		/*
+			Command queue (see postCommand()), load thread side:
+
+			cmd_pop(): take the next command from the queue, returns false if it's empty.
+			cmd_collect(): move every queued command into cmd_pending (as long as there's room), sorted by frame.
+			cmd_insert(): insert a command into cmd_pending, after any other command with the same frame.
+			cmd_seek_take(): take the first seek due within the current segment, returns false if there's none. Any later seek within the segment moves to the next one.
+			cmd_apply(): apply every pending command due at frame seg_nframe of the current segment to p_snap (rebuilding its gain table if needed).
+			returns the length of the block starting at seg_nframe (up to the next command, the seek or the end of the transition), 0 if the session stops there.
+			cmd_session_begin(), cmd_discard(): reset the load thread side (transition and its statistics included) at the start of a session, drop every command left at its end.
+		*/
+
+		BOOL WINAPI cmd_pop(audiortdsp_cmd_t *p_cmd);
+		VOID WINAPI cmd_collect(VOID);
+		VOID WINAPI cmd_insert(const audiortdsp_cmd_t *p_cmd);
+		BOOL WINAPI cmd_seek_take(SIZE_T *p_seg_nframe, ULONG64 *p_nframe_target);
+		SIZE_T WINAPI cmd_apply(audiortdsp_dspsnap_t *p_snap, SIZE_T seg_nframe);
+		VOID WINAPI cmd_session_begin(VOID);
+		VOID WINAPI cmd_discard(VOID);
+
+		/*
+			dsp_comb_span(): Retrieve the next block of the current input buffer segment that the recursive comb can process in one kernel call.
+
+			A block never crosses the ring wrap of any of its sources, and is never longer than n_delay, so the comb state it reads is complete.
+
+			Inputs:
+
+			seg_nframe: first frame of the block within the current input buffer segment.
+			n_delay: comb delay time (number of frames).
+			corr_delay: correction tap delay time (number of frames), 0 if unused.
+
+			Outputs:
+
+			p_src_buf_nframe: receives the index of the delayed frame (input and comb state) within the whole input buffer.
+			p_corr_buf_nframe: receives the index of the correction tap frame within the whole input buffer. Set to NULL if unused.
+			p_n_frames: receives the block length (number of frames).
+
+			returns true if successful, false otherwise.
+		*/
+
+		BOOL WINAPI dsp_comb_span(SIZE_T seg_nframe, SIZE_T n_delay, SIZE_T corr_delay, SIZE_T *p_src_buf_nframe, SIZE_T *p_corr_buf_nframe, SIZE_T *p_n_frames);
+
+		BOOL WINAPI buffer_play(VOID);
+		BOOL WINAPI buffer_play_direct(VOID);
+		BOOL WINAPI audio_hw_wait(VOID);
 
 		/*
 			retrieve_previn_nframe() : Retrieve (calculates) the index for a previous frame based on the current frame index and the delay time.
@@ -240,8 +1388,34 @@ class AudioRTDSP {
 		BOOL WINAPI retrieve_previn_nframe(SIZE_T currin_buf_nframe, SIZE_T n_delay, SIZE_T *p_previn_buf_nframe, SIZE_T *p_previn_nseg, SIZE_T *p_previn_seg_nframe);
 		BOOL WINAPI retrieve_previn_nframe(SIZE_T currin_nseg, SIZE_T currin_seg_nframe, SIZE_T n_delay, SIZE_T *p_previn_buf_nframe, SIZE_T *p_previn_nseg, SIZE_T *p_previn_seg_nframe);
 
+		/*
+			retrieve_previn_span() : Retrieve (calculates) the source span(s) within the input buffer for a block of an input buffer segment delayed by n_delay frames.
+
+			A delayed block occupies n_frames contiguous frames of the input buffer, unless it crosses the end of the buffer (ring wrap).
+			In that case it's split into 2 spans: the first one ends at the last frame of the input buffer, the second one starts at frame 0.
+
+			Inputs:
+
+			currin_nseg: the current input buffer segment index in context.
+			currin_seg_nframe: the first frame of the block within the segment.
+			n_frames: block length (number of frames).
+			n_delay: delay time (number of frames).
+
+			Outputs:
+
+			p_previn_buf_nframe: pointer to variable that receives the index of the first frame of the first span within the whole input buffer.
+			p_span1_nframes: pointer to variable that receives the length (number of frames) of the first span.
+			The second span (if any) is (n_frames - *p_span1_nframes) frames long, starting at frame 0.
+
+			returns true if successful, false otherwise.
+		*/
+
+		BOOL WINAPI retrieve_previn_span(SIZE_T currin_nseg, SIZE_T currin_seg_nframe, SIZE_T n_frames, SIZE_T n_delay, SIZE_T *p_previn_buf_nframe, SIZE_T *p_span1_nframes);
+
 		DWORD WINAPI loadthread_proc(VOID *p_args);
 		DWORD WINAPI playthread_proc(VOID *p_args);
+		DWORD WINAPI directthread_proc(VOID *p_args);
+		DWORD WINAPI renderthread_proc(VOID *p_args);
 };
 
 #endif /*AUDIORTDSP_HPP*/
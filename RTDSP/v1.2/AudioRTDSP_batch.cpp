@@ -0,0 +1,441 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+#include "AudioRTDSP_batch.hpp"
+#include "AudioRTDSP_i16.hpp"
+#include "AudioRTDSP_i24.hpp"
+#include "AudioRTDSP_wavfile.hpp"
+#include "cstrdef.h"
+
+AudioRTDSP_Batch::AudioRTDSP_Batch(VOID)
+{
+}
+
+AudioRTDSP_Batch::~AudioRTDSP_Batch(VOID)
+{
+	this->stop();
+}
+
+BOOL WINAPI AudioRTDSP_Batch::setFXParams(const audiortdsp_fx_params_t *p_params)
+{
+	if(this->running) return FALSE;
+
+	if(p_params == NULL)
+	{
+		this->err_msg = TEXT("AudioRTDSP_Batch::setFXParams: Error: given params object pointer is null.");
+		return FALSE;
+	}
+
+	if((p_params->n_delay < 0) || (p_params->n_feedback < 0))
+	{
+		this->err_msg = TEXT("AudioRTDSP_Batch::setFXParams: Error: invalid FX parameters.");
+		return FALSE;
+	}
+
+	CopyMemory(&(this->fx_params), p_params, sizeof(audiortdsp_fx_params_t));
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP_Batch::setWorkerCount(SIZE_T n_workers)
+{
+	if(this->running) return FALSE;
+
+	if(n_workers > this->MAX_N_WORKERS)
+	{
+		this->err_msg = TEXT("AudioRTDSP_Batch::setWorkerCount: Error: given worker count is too big.");
+		return FALSE;
+	}
+
+	this->N_WORKERS = n_workers;
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP_Batch::addFile(const TCHAR *filein_dir, const TCHAR *fileout_dir)
+{
+	struct batch_file file;
+
+	if(this->running) return FALSE;
+
+	if((filein_dir == NULL) || (fileout_dir == NULL))
+	{
+		this->err_msg = TEXT("AudioRTDSP_Batch::addFile: Error: given file directory is null.");
+		return FALSE;
+	}
+
+	file.filein_dir = filein_dir;
+	file.fileout_dir = fileout_dir;
+	file.done = FALSE;
+	file.success = FALSE;
+	ZeroMemory(&(file.stats), sizeof(audiortdsp_render_stats_t));
+	file.sample_rate = 0u;
+	file.err_msg = TEXT("");
+
+	this->files.push_back(file);
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP_Batch::addDirectory(const TCHAR *dirin, const TCHAR *dirout)
+{
+	HANDLE h_find = INVALID_HANDLE_VALUE;
+	WIN32_FIND_DATA find_data;
+	__string filein_dir = TEXT("");
+
+	if(this->running) return FALSE;
+
+	if((dirin == NULL) || (dirout == NULL))
+	{
+		this->err_msg = TEXT("AudioRTDSP_Batch::addDirectory: Error: given directory is null.");
+		return FALSE;
+	}
+
+	filein_dir = dirin;
+	filein_dir += TEXT("\\*.wav");
+
+	h_find = FindFirstFile(filein_dir.c_str(), &find_data);
+	if(h_find == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioRTDSP_Batch::addDirectory: Error: no .wav files found in the given directory.");
+		return FALSE;
+	}
+
+	do
+	{
+		if(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+
+		filein_dir = dirin;
+		filein_dir += TEXT("\\");
+		filein_dir += find_data.cFileName;
+
+		this->addFile(filein_dir.c_str(), this->get_fileout_dir(find_data.cFileName, dirout).c_str());
+
+	}while(FindNextFile(h_find, &find_data));
+
+	FindClose(h_find);
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP_Batch::addFileList(const TCHAR *listfile_dir, const TCHAR *dirout)
+{
+	HANDLE h_listfile = INVALID_HANDLE_VALUE;
+	CHAR *p_listbuf = NULL;
+	DWORD listfile_size = 0u;
+	DWORD dummy_32;
+
+	SIZE_T n_char = 0u;
+	SIZE_T line_begin = 0u;
+	SIZE_T line_end = 0u;
+
+	TCHAR filein_dir[PATH_SIZE_CHARS];
+
+	if(this->running) return FALSE;
+
+	if((listfile_dir == NULL) || (dirout == NULL))
+	{
+		this->err_msg = TEXT("AudioRTDSP_Batch::addFileList: Error: given file directory is null.");
+		return FALSE;
+	}
+
+	h_listfile = CreateFile(listfile_dir, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0u, NULL);
+	if(h_listfile == INVALID_HANDLE_VALUE)
+	{
+		this->err_msg = TEXT("AudioRTDSP_Batch::addFileList: Error: could not open list file.");
+		return FALSE;
+	}
+
+	listfile_size = GetFileSize(h_listfile, NULL);
+
+	p_listbuf = (CHAR*) HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, ((SIZE_T) listfile_size) + 1u);
+	if(p_listbuf == NULL)
+	{
+		CloseHandle(h_listfile);
+		this->err_msg = TEXT("AudioRTDSP_Batch::addFileList: Error: memory allocate failed.");
+		return FALSE;
+	}
+
+	ReadFile(h_listfile, p_listbuf, listfile_size, &dummy_32, NULL);
+	CloseHandle(h_listfile);
+
+	/*One file directory per line (CRLF or LF), empty lines are skipped*/
+
+	line_begin = 0u;
+
+	for(n_char = 0u; n_char <= (SIZE_T) listfile_size; n_char++)
+	{
+		if((p_listbuf[n_char] != '\n') && (p_listbuf[n_char] != '\0')) continue;
+
+		line_end = n_char;
+		if((line_end > line_begin) && (p_listbuf[line_end - 1u] == '\r')) line_end--;
+
+		if(line_end > line_begin)
+		{
+			p_listbuf[line_end] = '\0';
+
+			if(cstr_char_to_tchar(&p_listbuf[line_begin], filein_dir, PATH_SIZE_CHARS))
+				this->addFile(filein_dir, this->get_fileout_dir(filein_dir, dirout).c_str());
+		}
+
+		line_begin = n_char + 1u;
+	}
+
+	HeapFree(GetProcessHeap(), 0u, p_listbuf);
+	return TRUE;
+}
+
+VOID WINAPI AudioRTDSP_Batch::clear(VOID)
+{
+	if(this->running) return;
+
+	this->files.clear();
+	return;
+}
+
+BOOL WINAPI AudioRTDSP_Batch::run(VOID)
+{
+	SIZE_T n_workers = 0u;
+	SIZE_T n_worker = 0u;
+	SYSTEM_INFO sysinfo;
+
+	LARGE_INTEGER qpc_freq;
+	LARGE_INTEGER qpc_begin;
+	LARGE_INTEGER qpc_end;
+
+	if(this->running) return FALSE;
+
+	if(this->files.empty())
+	{
+		this->err_msg = TEXT("AudioRTDSP_Batch::run: Error: no files queued.");
+		return FALSE;
+	}
+
+	n_workers = this->N_WORKERS;
+
+	if(!n_workers)
+	{
+		GetSystemInfo(&sysinfo);
+		n_workers = (SIZE_T) sysinfo.dwNumberOfProcessors;
+	}
+
+	if(n_workers > this->MAX_N_WORKERS) n_workers = this->MAX_N_WORKERS;
+	if(n_workers > this->files.size()) n_workers = this->files.size();
+	if(!n_workers) n_workers = 1u;
+
+	this->p_workers = (thread_worker_t*) HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, n_workers*sizeof(thread_worker_t));
+	if(this->p_workers == NULL)
+	{
+		this->err_msg = TEXT("AudioRTDSP_Batch::run: Error: memory allocate failed.");
+		return FALSE;
+	}
+
+	for(n_worker = 0u; n_worker < this->files.size(); n_worker++)
+	{
+		this->files[n_worker].done = FALSE;
+		this->files[n_worker].success = FALSE;
+	}
+
+	/*Select the DSP kernels once, before the workers start creating AudioRTDSP objects*/
+	dspkernel_init();
+
+	this->file_next = 0;
+	this->stop_batch = 0;
+	this->running = TRUE;
+
+	QueryPerformanceFrequency(&qpc_freq);
+	QueryPerformanceCounter(&qpc_begin);
+
+	this->n_workers_run = 0u;
+
+	for(n_worker = 0u; n_worker < n_workers; n_worker++)
+	{
+		if(!thread_worker_create(&(this->p_workers[n_worker]), ((DWORD (WINAPI *)(VOID*)) &AudioRTDSP_Batch::workerthread_proc), this)) break;
+
+		thread_worker_run(&(this->p_workers[n_worker]));
+		this->n_workers_run++;
+	}
+
+	for(n_worker = 0u; n_worker < this->n_workers_run; n_worker++)
+	{
+		thread_worker_wait(&(this->p_workers[n_worker]));
+		thread_worker_destroy(&(this->p_workers[n_worker]));
+	}
+
+	QueryPerformanceCounter(&qpc_end);
+
+	HeapFree(GetProcessHeap(), 0u, this->p_workers);
+	this->p_workers = NULL;
+
+	this->elapsed_sec = ((DOUBLE) (qpc_end.QuadPart - qpc_begin.QuadPart))/((DOUBLE) qpc_freq.QuadPart);
+	this->running = FALSE;
+
+	if(!this->n_workers_run)
+	{
+		this->err_msg = TEXT("AudioRTDSP_Batch::run: Error: could not create worker threads.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+VOID WINAPI AudioRTDSP_Batch::stop(VOID)
+{
+	InterlockedExchange(&(this->stop_batch), 1);
+	return;
+}
+
+SIZE_T WINAPI AudioRTDSP_Batch::getFileCount(VOID)
+{
+	return this->files.size();
+}
+
+BOOL WINAPI AudioRTDSP_Batch::getFileResult(SIZE_T index, audiortdsp_batch_result_t *p_result)
+{
+	if(this->running) return FALSE;
+	if(index >= this->files.size()) return FALSE;
+	if(p_result == NULL) return FALSE;
+
+	p_result->filein_dir = this->files[index].filein_dir.c_str();
+	p_result->fileout_dir = this->files[index].fileout_dir.c_str();
+	p_result->done = this->files[index].done;
+	p_result->success = this->files[index].success;
+	p_result->err_msg = this->files[index].err_msg.c_str();
+
+	CopyMemory(&(p_result->stats), &(this->files[index].stats), sizeof(audiortdsp_render_stats_t));
+	return TRUE;
+}
+
+BOOL WINAPI AudioRTDSP_Batch::getSummary(audiortdsp_batch_summary_t *p_summary)
+{
+	SIZE_T n_file = 0u;
+
+	if(this->running) return FALSE;
+	if(p_summary == NULL) return FALSE;
+
+	ZeroMemory(p_summary, sizeof(audiortdsp_batch_summary_t));
+
+	p_summary->n_files = this->files.size();
+	p_summary->n_workers = this->n_workers_run;
+	p_summary->elapsed_sec = this->elapsed_sec;
+
+	for(n_file = 0u; n_file < this->files.size(); n_file++)
+	{
+		if(!this->files[n_file].done) continue;
+
+		if(!this->files[n_file].success)
+		{
+			p_summary->n_failed++;
+			continue;
+		}
+
+		p_summary->n_success++;
+		p_summary->n_frames += this->files[n_file].stats.n_frames;
+		p_summary->audio_sec += ((DOUBLE) this->files[n_file].stats.n_frames)/((DOUBLE) this->files[n_file].sample_rate);
+	}
+
+	if(p_summary->elapsed_sec > 0.0)
+	{
+		p_summary->frames_per_sec = ((DOUBLE) p_summary->n_frames)/(p_summary->elapsed_sec);
+		p_summary->realtime_factor = (p_summary->audio_sec)/(p_summary->elapsed_sec);
+	}
+
+	return TRUE;
+}
+
+__string WINAPI AudioRTDSP_Batch::getLastErrorMessage(VOID)
+{
+	return this->err_msg;
+}
+
+/*
+	get_fileout_dir(): output file directory for an input file: dirout + input file name.
+*/
+
+__string WINAPI AudioRTDSP_Batch::get_fileout_dir(const TCHAR *filein_dir, const TCHAR *dirout)
+{
+	__string filename = filein_dir;
+	__string fileout_dir = dirout;
+	SIZE_T n_char = 0u;
+
+	n_char = filename.find_last_of(TEXT("\\/"));
+	if(n_char != __string::npos) filename = filename.substr(n_char + 1u);
+
+	if(!fileout_dir.empty())
+	{
+		if((fileout_dir.back() != TEXT('\\')) && (fileout_dir.back() != TEXT('/'))) fileout_dir += TEXT("\\");
+	}
+
+	fileout_dir += filename;
+	return fileout_dir;
+}
+
+/*
+	render_file(): render a single file on a new AudioRTDSP object. Called from the worker threads.
+	Only touches its own batch_file entry.
+*/
+
+VOID WINAPI AudioRTDSP_Batch::render_file(struct batch_file *p_file)
+{
+	AudioRTDSP *p_audio = NULL;
+	HANDLE h_filein = INVALID_HANDLE_VALUE;
+	UINT16 bit_depth = 0u;
+
+	audiortdsp_pb_params_t pb_params;
+
+	h_filein = CreateFile(p_file->filein_dir.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0u, NULL);
+	if(h_filein == INVALID_HANDLE_VALUE)
+	{
+		p_file->err_msg = TEXT("Error: could not open file.");
+		return;
+	}
+
+	if(!audiortdsp_wavfile_get_params(h_filein, &pb_params, &bit_depth, &(p_file->err_msg)))
+	{
+		CloseHandle(h_filein);
+		return;
+	}
+
+	CloseHandle(h_filein);
+
+	pb_params.file_dir = p_file->filein_dir.c_str();
+	p_file->sample_rate = pb_params.sample_rate;
+
+	switch(bit_depth)
+	{
+		case 16u:
+			p_audio = new AudioRTDSP_i16(&pb_params);
+			break;
+
+		case 24u:
+			p_audio = new AudioRTDSP_i24(&pb_params);
+			break;
+
+		default:
+			p_file->err_msg = TEXT("Error: audio format not supported.");
+			return;
+	}
+
+	p_file->success = p_audio->runRender(&(this->fx_params), p_file->fileout_dir.c_str(), &(p_file->stats));
+	if(!p_file->success) p_file->err_msg = p_audio->getLastErrorMessage();
+
+	delete p_audio;
+	return;
+}
+
+DWORD WINAPI AudioRTDSP_Batch::workerthread_proc(VOID *p_args)
+{
+	LONG n_file = 0;
+
+	while(!this->stop_batch)
+	{
+		n_file = InterlockedIncrement(&(this->file_next)) - 1;
+		if(((SIZE_T) n_file) >= this->files.size()) break;
+
+		this->render_file(&(this->files[(SIZE_T) n_file]));
+		this->files[(SIZE_T) n_file].done = TRUE;
+	}
+
+	return 0u;
+}
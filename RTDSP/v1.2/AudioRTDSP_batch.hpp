@@ -0,0 +1,173 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+/*
+	Batch Renderer:
+
+	Offline renders (AudioRTDSP::runRender()) many WAV files with the same FX parameters, spread across a pool of worker threads.
+	The pool defaults to one worker per logical processor.
+
+	Each worker renders one file at a time on its own AudioRTDSP object (own private heap, file handles and buffers),
+	workers only share the file queue index. Memory use is bounded: at most n_workers AudioRTDSP objects exist at any time,
+	each one with fixed size buffers, regardless of the number or length of the files.
+
+	Usage:
+
+	setFXParams(), setWorkerCount() (optional).
+	addFile(), addDirectory(), addFileList() to queue files.
+	run() (blocks until every file is done or stop() is called).
+	getFileResult() for each file, getSummary() for the aggregate.
+*/
+
+#ifndef AUDIORTDSP_BATCH_HPP
+#define AUDIORTDSP_BATCH_HPP
+
+#include "globldef.h"
+#include "strdef.hpp"
+#include "thread.h"
+#include "AudioRTDSP.hpp"
+
+#include <vector>
+
+/*
+	Per file result:
+
+	filein_dir, fileout_dir: input and output file directories.
+	done: the file has been processed (successfully or not).
+	success: the file has been rendered successfully.
+	stats: render statistics (valid if success).
+	err_msg: error message (valid if done and not success).
+*/
+
+struct _audiortdsp_batch_result {
+	const TCHAR *filein_dir;
+	const TCHAR *fileout_dir;
+	BOOL done;
+	BOOL success;
+	audiortdsp_render_stats_t stats;
+	const TCHAR *err_msg;
+};
+
+/*
+	Batch summary:
+
+	n_files: number of files queued.
+	n_success: number of files rendered successfully.
+	n_failed: number of files that failed.
+	n_workers: number of worker threads used.
+	n_frames: total number of frames rendered.
+	audio_sec: total duration of the rendered audio (seconds).
+	elapsed_sec: wall clock time of the whole batch (seconds).
+	frames_per_sec: aggregate throughput (n_frames/elapsed_sec).
+	realtime_factor: aggregate real time factor (audio_sec/elapsed_sec).
+*/
+
+struct _audiortdsp_batch_summary {
+	SIZE_T n_files;
+	SIZE_T n_success;
+	SIZE_T n_failed;
+	SIZE_T n_workers;
+	ULONG64 n_frames;
+	DOUBLE audio_sec;
+	DOUBLE elapsed_sec;
+	DOUBLE frames_per_sec;
+	DOUBLE realtime_factor;
+};
+
+typedef struct _audiortdsp_batch_result audiortdsp_batch_result_t;
+typedef struct _audiortdsp_batch_summary audiortdsp_batch_summary_t;
+
+class AudioRTDSP_Batch {
+	public:
+		AudioRTDSP_Batch(VOID);
+		~AudioRTDSP_Batch(VOID);
+
+		BOOL WINAPI setFXParams(const audiortdsp_fx_params_t *p_params);
+
+		/*
+			setWorkerCount(): set the number of worker threads. 0 means one worker per logical processor.
+		*/
+
+		BOOL WINAPI setWorkerCount(SIZE_T n_workers);
+
+		BOOL WINAPI addFile(const TCHAR *filein_dir, const TCHAR *fileout_dir);
+
+		/*
+			addDirectory(): queue every .wav file in dirin. Output files get the same name, in dirout.
+		*/
+
+		BOOL WINAPI addDirectory(const TCHAR *dirin, const TCHAR *dirout);
+
+		/*
+			addFileList(): queue every file listed in a text file (one input file directory per line). Output files get the same name, in dirout.
+		*/
+
+		BOOL WINAPI addFileList(const TCHAR *listfile_dir, const TCHAR *dirout);
+
+		VOID WINAPI clear(VOID);
+
+		BOOL WINAPI run(VOID);
+		VOID WINAPI stop(VOID);
+
+		SIZE_T WINAPI getFileCount(VOID);
+		BOOL WINAPI getFileResult(SIZE_T index, audiortdsp_batch_result_t *p_result);
+		BOOL WINAPI getSummary(audiortdsp_batch_summary_t *p_summary);
+
+		__string WINAPI getLastErrorMessage(VOID);
+
+	protected:
+		static constexpr SIZE_T MAX_N_WORKERS = 64u;
+		static constexpr SIZE_T PATH_SIZE_CHARS = 1024u;
+
+		struct batch_file {
+			__string filein_dir;
+			__string fileout_dir;
+			BOOL done;
+			BOOL success;
+			audiortdsp_render_stats_t stats;
+			UINT32 sample_rate;
+			__string err_msg;
+		};
+
+		std::vector<struct batch_file> files;
+
+		audiortdsp_fx_params_t fx_params = {
+			.n_delay = 240,
+			.n_feedback = 20,
+			.feedback_alt_pol = TRUE,
+			.cyclediv_inc_one = TRUE,
+			.recursive_comb = FALSE
+		};
+
+		thread_worker_t *p_workers = NULL;
+
+		SIZE_T N_WORKERS = 0u;
+		SIZE_T n_workers_run = 0u;
+
+		/*
+			file_next: index of the next file to be taken by a worker (shared by all workers, taken with InterlockedIncrement()).
+			stop_batch: set by stop(), workers won't take any more files.
+		*/
+
+		volatile LONG file_next = 0;
+		volatile LONG stop_batch = 0;
+
+		BOOL running = FALSE;
+
+		DOUBLE elapsed_sec = 0.0;
+
+		__string err_msg = TEXT("");
+
+		__string WINAPI get_fileout_dir(const TCHAR *filein_dir, const TCHAR *dirout);
+
+		VOID WINAPI render_file(struct batch_file *p_file);
+
+		DWORD WINAPI workerthread_proc(VOID *p_args);
+};
+
+#endif /*AUDIORTDSP_BATCH_HPP*/
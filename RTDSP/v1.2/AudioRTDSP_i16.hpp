@@ -20,23 +20,15 @@ class AudioRTDSP_i16 : public AudioRTDSP {
 		static constexpr INT32 SAMPLE_MAX_VALUE = 0x7fff;
 		static constexpr INT32 SAMPLE_MIN_VALUE = -0x8000;
 
-		/*
-			DSPFRAME is a buffer that stores a single frame of audio.
-			Sample size on DSPFRAME is bigger than the audio sample size.
-			DSPFRAME is where most DSP math operations will happen, it's used
-			to prevent integer overflow.
-		*/
-
-		static constexpr SIZE_T DSPFRAME_SAMPLE_SIZE_BYTES = 4u;
-		SIZE_T DSPFRAME_SIZE_BYTES = 0u;
-
-		INT32 *p_dspframe = NULL;
-
 		BOOL WINAPI audio_hw_init(VOID) override;
-		BOOL WINAPI buffer_alloc(VOID) override;
-		VOID WINAPI buffer_free(VOID) override;
-		VOID WINAPI buffer_load(VOID) override;
-		VOID WINAPI dsp_proc(VOID) override;
+		AudioRTDSP* WINAPI instance_create(const audiortdsp_pb_params_t *p_params) override;
+		VOID WINAPI buffer_read(SIZE_T seg_nframe, SIZE_T n_frames) override;
+
+		VOID WINAPI dsp_load(INT32 *p_acc, const VOID *p_src, SIZE_T n_samples) override;
+		VOID WINAPI dsp_accumulate(INT32 *p_acc, const VOID *p_src, SIZE_T n_samples, const dspkernel_gain_t *p_gain) override;
+		VOID WINAPI dsp_accumulate2(INT32 *p_acc, const VOID *p_src1, const VOID *p_src2, SIZE_T n_samples, const dspkernel_gain_t *p_gains) override;
+		VOID WINAPI dsp_comb(INT32 *p_state, INT32 *p_acc, const VOID *p_src, const INT32 *p_state_src, const VOID *p_corr_src, SIZE_T n_samples, const dspkernel_comb_t *p_comb) override;
+		VOID WINAPI dsp_saturate(VOID *p_out, const INT32 *p_acc, SIZE_T n_samples) override;
 };
 
 #endif /*AUDIORTDSP_I16_HPP*/
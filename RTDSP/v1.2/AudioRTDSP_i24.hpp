@@ -24,11 +24,22 @@ class AudioRTDSP_i24 : public AudioRTDSP {
 
 		UINT8 *p_bytebuf = NULL;
 
+		/*p_dspscratch: unpacked mapped input (2 buffer segments: tap source and correction tap). Mapped input only, p_bytebuf is only used by the input buffer ring.*/
+
+		INT32 *p_dspscratch = NULL;
+
 		BOOL WINAPI audio_hw_init(VOID) override;
+		AudioRTDSP* WINAPI instance_create(const audiortdsp_pb_params_t *p_params) override;
 		BOOL WINAPI buffer_alloc(VOID) override;
 		VOID WINAPI buffer_free(VOID) override;
-		VOID WINAPI buffer_load(VOID) override;
-		VOID WINAPI dsp_proc(VOID) override;
+		SIZE_T WINAPI buffer_arena_size(VOID) override;
+		VOID WINAPI buffer_read(SIZE_T seg_nframe, SIZE_T n_frames) override;
+
+		VOID WINAPI dsp_load(INT32 *p_acc, const VOID *p_src, SIZE_T n_samples) override;
+		VOID WINAPI dsp_accumulate(INT32 *p_acc, const VOID *p_src, SIZE_T n_samples, const dspkernel_gain_t *p_gain) override;
+		VOID WINAPI dsp_accumulate2(INT32 *p_acc, const VOID *p_src1, const VOID *p_src2, SIZE_T n_samples, const dspkernel_gain_t *p_gains) override;
+		VOID WINAPI dsp_comb(INT32 *p_state, INT32 *p_acc, const VOID *p_src, const INT32 *p_state_src, const VOID *p_corr_src, SIZE_T n_samples, const dspkernel_comb_t *p_comb) override;
+		VOID WINAPI dsp_saturate(VOID *p_out, const INT32 *p_acc, SIZE_T n_samples) override;
 };
 
 #endif /*AUDIORTDSP_I24_HPP*/
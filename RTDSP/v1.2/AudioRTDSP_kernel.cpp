@@ -0,0 +1,1820 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+#include "AudioRTDSP_kernel.hpp"
+
+#ifdef __DSPKERNEL_X86
+#include <immintrin.h>
+#define __DSPKERNEL_TARGET_SSE2 __attribute__((target("sse2")))
+#define __DSPKERNEL_TARGET_AVX2 __attribute__((target("avx2")))
+
+/*
+	Vector helpers must always be inlined into their kernels.
+	MinGW x64 does not keep 32 byte stack alignment, so an out of line helper taking or returning __m256i
+	by value may spill it with aligned moves to a misaligned slot and fault (GCC bug 54412).
+*/
+#define __DSPKERNEL_FORCEINLINE __attribute__((always_inline))
+#endif
+
+#ifdef __DSPKERNEL_NEON
+#include <arm_neon.h>
+#endif
+
+static constexpr INT32 I16_MAX_VALUE = 0x7fff;
+static constexpr INT32 I16_MIN_VALUE = -0x8000;
+static constexpr INT32 I24_MAX_VALUE = 0x7fffff;
+static constexpr INT32 I24_MIN_VALUE = -0x800000;
+
+/*Tap gains are exact for any sample magnitude up to 2^GAIN_SAMPLE_BITS*/
+
+static constexpr UINT32 GAIN_SAMPLE_BITS = 24u;
+
+/*======================================================================================*/
+/*Tap Gains*/
+
+/*
+	For 0 <= n < 2^N and shift = N + l, with 2^(l - 1) < cycle_div <= 2^l:
+	mul = ceil(2^shift/cycle_div) gives (n*mul) >> shift == n/cycle_div for every n.
+
+	N is chosen so that shift is at least 32 (N >= GAIN_SAMPLE_BITS), which keeps mul within 32 bits
+	and lets the vectorized kernels use a single 32x32->64 bit multiply.
+*/
+
+VOID WINAPI dspkernel_gain_init_div(dspkernel_gain_t *p_gain, INT32 pol, UINT32 cycle_div)
+{
+	UINT32 div_log2 = 0u;
+	UINT32 shift = 0u;
+
+	if(p_gain == NULL) return;
+
+	if(pol < 0) p_gain->pol_mask = -1;
+	else p_gain->pol_mask = 0;
+
+	if(!cycle_div)
+	{
+		p_gain->mul = 0u;
+		p_gain->shift = 0u;
+		return;
+	}
+
+	if(_is_power2((SIZE_T) cycle_div))
+	{
+		div_log2 = 0u;
+		while((1u << div_log2) < cycle_div) div_log2++;
+
+		dspkernel_gain_init_shift(p_gain, pol, div_log2);
+		return;
+	}
+
+	if(cycle_div > (1u << GAIN_SAMPLE_BITS))
+	{
+		p_gain->mul = 0u;
+		p_gain->shift = 0u;
+		return;
+	}
+
+	div_log2 = 0u;
+	while((1u << div_log2) < cycle_div) div_log2++;
+
+	shift = GAIN_SAMPLE_BITS + div_log2;
+	if(shift < 32u) shift = 32u;
+
+	p_gain->mul = (UINT32) ((((UINT64) 1u) << shift)/((UINT64) cycle_div) + 1u); /*cycle_div is not a power of 2, so this is the ceiling*/
+	p_gain->shift = shift;
+
+	return;
+}
+
+VOID WINAPI dspkernel_gain_init_shift(dspkernel_gain_t *p_gain, INT32 pol, UINT32 div_shift)
+{
+	if(p_gain == NULL) return;
+
+	if(pol < 0) p_gain->pol_mask = -1;
+	else p_gain->pol_mask = 0;
+
+	if(div_shift > GAIN_SAMPLE_BITS)
+	{
+		p_gain->mul = 0u;
+		p_gain->shift = 0u;
+		return;
+	}
+
+	p_gain->mul = 1u;
+	p_gain->shift = div_shift;
+
+	return;
+}
+
+/*======================================================================================*/
+/*Scalar Kernels*/
+
+static inline INT32 WINAPI dspkernel_tap_scalar(INT32 sample, const dspkernel_gain_t *p_gain)
+{
+	INT32 sign_mask = 0;
+	UINT32 magnitude = 0u;
+	INT32 quotient = 0;
+
+	sign_mask = (sample >> 31);
+	magnitude = (UINT32) ((sample ^ sign_mask) - sign_mask);
+
+	quotient = (INT32) ((((UINT64) magnitude)*((UINT64) p_gain->mul)) >> p_gain->shift);
+
+	sign_mask ^= p_gain->pol_mask;
+	return ((quotient ^ sign_mask) - sign_mask);
+}
+
+static VOID WINAPI dspkernel_widen_i16_scalar(INT32 *p_acc, const INT16 *p_src, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+
+	for(n_sample = 0u; n_sample < n_samples; n_sample++) p_acc[n_sample] = (INT32) p_src[n_sample];
+
+	return;
+}
+
+static VOID WINAPI dspkernel_accumulate_i16_scalar(INT32 *p_acc, const INT16 *p_src, SIZE_T n_samples, const dspkernel_gain_t *p_gain)
+{
+	SIZE_T n_sample = 0u;
+
+	for(n_sample = 0u; n_sample < n_samples; n_sample++) p_acc[n_sample] += dspkernel_tap_scalar((INT32) p_src[n_sample], p_gain);
+
+	return;
+}
+
+static VOID WINAPI dspkernel_accumulate_i32_scalar(INT32 *p_acc, const INT32 *p_src, SIZE_T n_samples, const dspkernel_gain_t *p_gain)
+{
+	SIZE_T n_sample = 0u;
+
+	for(n_sample = 0u; n_sample < n_samples; n_sample++) p_acc[n_sample] += dspkernel_tap_scalar(p_src[n_sample], p_gain);
+
+	return;
+}
+
+static VOID WINAPI dspkernel_accumulate2_i16_scalar(INT32 *p_acc, const INT16 *p_src1, const INT16 *p_src2, SIZE_T n_samples, const dspkernel_gain_t *p_gains)
+{
+	SIZE_T n_sample = 0u;
+
+	for(n_sample = 0u; n_sample < n_samples; n_sample++) p_acc[n_sample] += dspkernel_tap_scalar((INT32) p_src1[n_sample], &p_gains[0]) + dspkernel_tap_scalar((INT32) p_src2[n_sample], &p_gains[1]);
+
+	return;
+}
+
+static VOID WINAPI dspkernel_accumulate2_i32_scalar(INT32 *p_acc, const INT32 *p_src1, const INT32 *p_src2, SIZE_T n_samples, const dspkernel_gain_t *p_gains)
+{
+	SIZE_T n_sample = 0u;
+
+	for(n_sample = 0u; n_sample < n_samples; n_sample++) p_acc[n_sample] += dspkernel_tap_scalar(p_src1[n_sample], &p_gains[0]) + dspkernel_tap_scalar(p_src2[n_sample], &p_gains[1]);
+
+	return;
+}
+
+static VOID WINAPI dspkernel_saturate_i16_scalar(INT16 *p_out, const INT32 *p_acc, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+	INT32 sample = 0;
+
+	for(n_sample = 0u; n_sample < n_samples; n_sample++)
+	{
+		sample = p_acc[n_sample]/2;
+
+		if(sample > I16_MAX_VALUE) p_out[n_sample] = (INT16) I16_MAX_VALUE;
+		else if(sample < I16_MIN_VALUE) p_out[n_sample] = (INT16) I16_MIN_VALUE;
+		else p_out[n_sample] = (INT16) sample;
+	}
+
+	return;
+}
+
+static VOID WINAPI dspkernel_saturate_i24_scalar(INT32 *p_out, const INT32 *p_acc, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+	INT32 sample = 0;
+
+	for(n_sample = 0u; n_sample < n_samples; n_sample++)
+	{
+		sample = p_acc[n_sample]/2;
+
+		if(sample > I24_MAX_VALUE) sample = I24_MAX_VALUE;
+		else if(sample < I24_MIN_VALUE) sample = I24_MIN_VALUE;
+
+		p_out[n_sample] = (sample << 8);
+	}
+
+	return;
+}
+
+static VOID WINAPI dspkernel_unpack_i24_scalar(INT32 *p_out, const BYTE *p_src, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+	SIZE_T n_byte = 0u;
+
+	for(n_sample = 0u; n_sample < n_samples; n_sample++)
+	{
+		p_out[n_sample] = ((INT32) ((((UINT32) p_src[n_byte + 2u]) << 24) | (((UINT32) p_src[n_byte + 1u]) << 16) | (((UINT32) p_src[n_byte]) << 8))) >> 8;
+		n_byte += 3u;
+	}
+
+	return;
+}
+
+/*Recursive comb step for 1 sample. Returns the new state.*/
+
+static inline INT32 WINAPI dspkernel_comb_scalar(INT32 x, INT32 state, INT32 x_corr, BOOL corr, const dspkernel_comb_t *p_comb)
+{
+	INT32 y = 0;
+
+	y = ((INT32) (((UINT32) x) << p_comb->frac_bits)) + state;
+	y = ((y ^ p_comb->pol_mask) - p_comb->pol_mask) >> 1;
+
+	if(corr)
+	{
+		x_corr = ((INT32) (((UINT32) x_corr) << p_comb->frac_bits)) >> p_comb->corr_shift;
+		y -= ((x_corr ^ p_comb->corr_pol_mask) - p_comb->corr_pol_mask);
+	}
+
+	return y;
+}
+
+static VOID WINAPI dspkernel_comb_i16_scalar(INT32 *p_state, INT32 *p_acc, const INT16 *p_src, const INT32 *p_state_src, const INT16 *p_corr_src, SIZE_T n_samples, const dspkernel_comb_t *p_comb)
+{
+	SIZE_T n_sample = 0u;
+	INT32 round = 0;
+	INT32 x_corr = 0;
+
+	round = (1 << (p_comb->frac_bits - 1u));
+
+	for(n_sample = 0u; n_sample < n_samples; n_sample++)
+	{
+		if(p_corr_src != NULL) x_corr = (INT32) p_corr_src[n_sample];
+
+		p_state[n_sample] = dspkernel_comb_scalar((INT32) p_src[n_sample], p_state_src[n_sample], x_corr, (p_corr_src != NULL), p_comb);
+		p_acc[n_sample] += ((p_state[n_sample] + round) >> p_comb->frac_bits);
+	}
+
+	return;
+}
+
+static VOID WINAPI dspkernel_comb_i32_scalar(INT32 *p_state, INT32 *p_acc, const INT32 *p_src, const INT32 *p_state_src, const INT32 *p_corr_src, SIZE_T n_samples, const dspkernel_comb_t *p_comb)
+{
+	SIZE_T n_sample = 0u;
+	INT32 round = 0;
+	INT32 x_corr = 0;
+
+	round = (1 << (p_comb->frac_bits - 1u));
+
+	for(n_sample = 0u; n_sample < n_samples; n_sample++)
+	{
+		if(p_corr_src != NULL) x_corr = p_corr_src[n_sample];
+
+		p_state[n_sample] = dspkernel_comb_scalar(p_src[n_sample], p_state_src[n_sample], x_corr, (p_corr_src != NULL), p_comb);
+		p_acc[n_sample] += ((p_state[n_sample] + round) >> p_comb->frac_bits);
+	}
+
+	return;
+}
+
+static VOID WINAPI dspkernel_xfade_i32_scalar(INT32 *p_acc, const INT32 *p_old, SIZE_T n_samples, UINT32 ramp_pos, UINT32 ramp_step)
+{
+	SIZE_T n_sample = 0u;
+	INT32 diff = 0;
+	INT32 sign_mask = 0;
+	UINT32 magnitude = 0u;
+
+	for(n_sample = 0u; n_sample < n_samples; n_sample++)
+	{
+		diff = p_acc[n_sample] - p_old[n_sample];
+		sign_mask = (diff >> 31);
+		magnitude = (UINT32) ((diff ^ sign_mask) - sign_mask);
+
+		diff = (INT32) ((((UINT64) magnitude)*((UINT64) (ramp_pos >> 16))) >> 16);
+
+		p_acc[n_sample] = p_old[n_sample] + ((diff ^ sign_mask) - sign_mask);
+		ramp_pos += ramp_step;
+	}
+
+	return;
+}
+
+static const dspkernel_table_t DSPKERNEL_TABLE_SCALAR = {
+	.p_widen_i16 = &dspkernel_widen_i16_scalar,
+	.p_accumulate_i16 = &dspkernel_accumulate_i16_scalar,
+	.p_accumulate_i32 = &dspkernel_accumulate_i32_scalar,
+	.p_accumulate2_i16 = &dspkernel_accumulate2_i16_scalar,
+	.p_accumulate2_i32 = &dspkernel_accumulate2_i32_scalar,
+	.p_saturate_i16 = &dspkernel_saturate_i16_scalar,
+	.p_saturate_i24 = &dspkernel_saturate_i24_scalar,
+	.p_unpack_i24 = &dspkernel_unpack_i24_scalar,
+	.p_comb_i16 = &dspkernel_comb_i16_scalar,
+	.p_comb_i32 = &dspkernel_comb_i32_scalar,
+	.p_xfade_i32 = &dspkernel_xfade_i32_scalar,
+	.isa = DSPKERNEL_ISA_SCALAR
+};
+
+/*======================================================================================*/
+/*SSE2 Kernels (4 samples per register, 8 samples per loop cycle)*/
+
+#ifdef __DSPKERNEL_X86
+
+/*
+	Tap term for 4 INT32 samples.
+	mul: gain multiplier on the low 32 bits of each 64bit lane.
+	shift: gain shift on the low 64 bits.
+	pol_mask: gain polarity mask on all lanes.
+*/
+
+__DSPKERNEL_TARGET_SSE2 __DSPKERNEL_FORCEINLINE static inline __m128i dspkernel_tap_epi32_sse2(__m128i x, __m128i mul, __m128i shift, __m128i pol_mask)
+{
+	__m128i sign_mask;
+	__m128i q_02;
+	__m128i q_13;
+
+	sign_mask = _mm_srai_epi32(x, 31);
+	x = _mm_sub_epi32(_mm_xor_si128(x, sign_mask), sign_mask);
+
+	/*_mm_mul_epu32 multiplies lanes 0 and 2 only*/
+	q_02 = _mm_srl_epi64(_mm_mul_epu32(x, mul), shift);
+	q_13 = _mm_srl_epi64(_mm_mul_epu32(_mm_srli_epi64(x, 32), mul), shift);
+
+	x = _mm_unpacklo_epi32(_mm_shuffle_epi32(q_02, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(q_13, _MM_SHUFFLE(0, 0, 2, 0)));
+
+	sign_mask = _mm_xor_si128(sign_mask, pol_mask);
+	return _mm_sub_epi32(_mm_xor_si128(x, sign_mask), sign_mask);
+}
+
+/*Tap term for 4 INT32 samples, power of 2 divider (mul == 1)*/
+
+__DSPKERNEL_TARGET_SSE2 __DSPKERNEL_FORCEINLINE static inline __m128i dspkernel_tapshift_epi32_sse2(__m128i x, __m128i shift, __m128i pol_mask)
+{
+	__m128i sign_mask;
+
+	sign_mask = _mm_srai_epi32(x, 31);
+	x = _mm_srl_epi32(_mm_sub_epi32(_mm_xor_si128(x, sign_mask), sign_mask), shift);
+
+	sign_mask = _mm_xor_si128(sign_mask, pol_mask);
+	return _mm_sub_epi32(_mm_xor_si128(x, sign_mask), sign_mask);
+}
+
+/*Tap term for 4 INT32 samples, any tap gain (see dspkernel_tap_epi32_sse2(), dspkernel_tapshift_epi32_sse2())*/
+
+__DSPKERNEL_TARGET_SSE2 __DSPKERNEL_FORCEINLINE static inline __m128i dspkernel_tapgain_epi32_sse2(__m128i x, const dspkernel_gain_t *p_gain, __m128i mul, __m128i shift, __m128i pol_mask)
+{
+	if(p_gain->mul == 1u) return dspkernel_tapshift_epi32_sse2(x, shift, pol_mask);
+
+	return dspkernel_tap_epi32_sse2(x, mul, shift, pol_mask);
+}
+
+/*Signed divide by 2 (truncated towards zero)*/
+
+__DSPKERNEL_TARGET_SSE2 __DSPKERNEL_FORCEINLINE static inline __m128i dspkernel_half_epi32_sse2(__m128i x)
+{
+	return _mm_srai_epi32(_mm_add_epi32(x, _mm_srli_epi32(x, 31)), 1);
+}
+
+__DSPKERNEL_TARGET_SSE2 static VOID WINAPI dspkernel_widen_i16_sse2(INT32 *p_acc, const INT16 *p_src, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+	__m128i x;
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x = _mm_loadu_si128((const __m128i*) &p_src[n_sample]);
+
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample], _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample + 4u], _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+	}
+
+	dspkernel_widen_i16_scalar(&p_acc[n_sample], &p_src[n_sample], (n_samples - n_sample));
+	return;
+}
+
+__DSPKERNEL_TARGET_SSE2 static VOID WINAPI dspkernel_accumulate_i16_sse2(INT32 *p_acc, const INT16 *p_src, SIZE_T n_samples, const dspkernel_gain_t *p_gain)
+{
+	SIZE_T n_sample = 0u;
+	__m128i mul;
+	__m128i shift;
+	__m128i pol_mask;
+	__m128i x;
+	__m128i x_lo;
+	__m128i x_hi;
+
+	mul = _mm_set1_epi32((INT32) p_gain->mul);
+	shift = _mm_cvtsi32_si128((INT32) p_gain->shift);
+	pol_mask = _mm_set1_epi32(p_gain->pol_mask);
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x = _mm_loadu_si128((const __m128i*) &p_src[n_sample]);
+
+		x_lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+		x_hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+
+		if(p_gain->mul == 1u)
+		{
+			x_lo = dspkernel_tapshift_epi32_sse2(x_lo, shift, pol_mask);
+			x_hi = dspkernel_tapshift_epi32_sse2(x_hi, shift, pol_mask);
+		}
+		else
+		{
+			x_lo = dspkernel_tap_epi32_sse2(x_lo, mul, shift, pol_mask);
+			x_hi = dspkernel_tap_epi32_sse2(x_hi, mul, shift, pol_mask);
+		}
+
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample], _mm_add_epi32(_mm_loadu_si128((const __m128i*) &p_acc[n_sample]), x_lo));
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample + 4u], _mm_add_epi32(_mm_loadu_si128((const __m128i*) &p_acc[n_sample + 4u]), x_hi));
+	}
+
+	dspkernel_accumulate_i16_scalar(&p_acc[n_sample], &p_src[n_sample], (n_samples - n_sample), p_gain);
+	return;
+}
+
+__DSPKERNEL_TARGET_SSE2 static VOID WINAPI dspkernel_accumulate_i32_sse2(INT32 *p_acc, const INT32 *p_src, SIZE_T n_samples, const dspkernel_gain_t *p_gain)
+{
+	SIZE_T n_sample = 0u;
+	__m128i mul;
+	__m128i shift;
+	__m128i pol_mask;
+	__m128i x_lo;
+	__m128i x_hi;
+
+	mul = _mm_set1_epi32((INT32) p_gain->mul);
+	shift = _mm_cvtsi32_si128((INT32) p_gain->shift);
+	pol_mask = _mm_set1_epi32(p_gain->pol_mask);
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x_lo = _mm_loadu_si128((const __m128i*) &p_src[n_sample]);
+		x_hi = _mm_loadu_si128((const __m128i*) &p_src[n_sample + 4u]);
+
+		if(p_gain->mul == 1u)
+		{
+			x_lo = dspkernel_tapshift_epi32_sse2(x_lo, shift, pol_mask);
+			x_hi = dspkernel_tapshift_epi32_sse2(x_hi, shift, pol_mask);
+		}
+		else
+		{
+			x_lo = dspkernel_tap_epi32_sse2(x_lo, mul, shift, pol_mask);
+			x_hi = dspkernel_tap_epi32_sse2(x_hi, mul, shift, pol_mask);
+		}
+
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample], _mm_add_epi32(_mm_loadu_si128((const __m128i*) &p_acc[n_sample]), x_lo));
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample + 4u], _mm_add_epi32(_mm_loadu_si128((const __m128i*) &p_acc[n_sample + 4u]), x_hi));
+	}
+
+	dspkernel_accumulate_i32_scalar(&p_acc[n_sample], &p_src[n_sample], (n_samples - n_sample), p_gain);
+	return;
+}
+
+/*Two taps per pass: one accumulator load and store for both*/
+
+__DSPKERNEL_TARGET_SSE2 static VOID WINAPI dspkernel_accumulate2_i16_sse2(INT32 *p_acc, const INT16 *p_src1, const INT16 *p_src2, SIZE_T n_samples, const dspkernel_gain_t *p_gains)
+{
+	SIZE_T n_sample = 0u;
+	__m128i mul1;
+	__m128i mul2;
+	__m128i shift1;
+	__m128i shift2;
+	__m128i pol_mask1;
+	__m128i pol_mask2;
+	__m128i x1;
+	__m128i x2;
+	__m128i x_lo;
+	__m128i x_hi;
+
+	mul1 = _mm_set1_epi32((INT32) p_gains[0].mul);
+	mul2 = _mm_set1_epi32((INT32) p_gains[1].mul);
+	shift1 = _mm_cvtsi32_si128((INT32) p_gains[0].shift);
+	shift2 = _mm_cvtsi32_si128((INT32) p_gains[1].shift);
+	pol_mask1 = _mm_set1_epi32(p_gains[0].pol_mask);
+	pol_mask2 = _mm_set1_epi32(p_gains[1].pol_mask);
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x1 = _mm_loadu_si128((const __m128i*) &p_src1[n_sample]);
+		x2 = _mm_loadu_si128((const __m128i*) &p_src2[n_sample]);
+
+		x_lo = _mm_add_epi32(dspkernel_tapgain_epi32_sse2(_mm_srai_epi32(_mm_unpacklo_epi16(x1, x1), 16), &p_gains[0], mul1, shift1, pol_mask1), dspkernel_tapgain_epi32_sse2(_mm_srai_epi32(_mm_unpacklo_epi16(x2, x2), 16), &p_gains[1], mul2, shift2, pol_mask2));
+		x_hi = _mm_add_epi32(dspkernel_tapgain_epi32_sse2(_mm_srai_epi32(_mm_unpackhi_epi16(x1, x1), 16), &p_gains[0], mul1, shift1, pol_mask1), dspkernel_tapgain_epi32_sse2(_mm_srai_epi32(_mm_unpackhi_epi16(x2, x2), 16), &p_gains[1], mul2, shift2, pol_mask2));
+
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample], _mm_add_epi32(_mm_loadu_si128((const __m128i*) &p_acc[n_sample]), x_lo));
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample + 4u], _mm_add_epi32(_mm_loadu_si128((const __m128i*) &p_acc[n_sample + 4u]), x_hi));
+	}
+
+	dspkernel_accumulate2_i16_scalar(&p_acc[n_sample], &p_src1[n_sample], &p_src2[n_sample], (n_samples - n_sample), p_gains);
+	return;
+}
+
+__DSPKERNEL_TARGET_SSE2 static VOID WINAPI dspkernel_accumulate2_i32_sse2(INT32 *p_acc, const INT32 *p_src1, const INT32 *p_src2, SIZE_T n_samples, const dspkernel_gain_t *p_gains)
+{
+	SIZE_T n_sample = 0u;
+	__m128i mul1;
+	__m128i mul2;
+	__m128i shift1;
+	__m128i shift2;
+	__m128i pol_mask1;
+	__m128i pol_mask2;
+	__m128i x_lo;
+	__m128i x_hi;
+
+	mul1 = _mm_set1_epi32((INT32) p_gains[0].mul);
+	mul2 = _mm_set1_epi32((INT32) p_gains[1].mul);
+	shift1 = _mm_cvtsi32_si128((INT32) p_gains[0].shift);
+	shift2 = _mm_cvtsi32_si128((INT32) p_gains[1].shift);
+	pol_mask1 = _mm_set1_epi32(p_gains[0].pol_mask);
+	pol_mask2 = _mm_set1_epi32(p_gains[1].pol_mask);
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x_lo = _mm_add_epi32(dspkernel_tapgain_epi32_sse2(_mm_loadu_si128((const __m128i*) &p_src1[n_sample]), &p_gains[0], mul1, shift1, pol_mask1), dspkernel_tapgain_epi32_sse2(_mm_loadu_si128((const __m128i*) &p_src2[n_sample]), &p_gains[1], mul2, shift2, pol_mask2));
+		x_hi = _mm_add_epi32(dspkernel_tapgain_epi32_sse2(_mm_loadu_si128((const __m128i*) &p_src1[n_sample + 4u]), &p_gains[0], mul1, shift1, pol_mask1), dspkernel_tapgain_epi32_sse2(_mm_loadu_si128((const __m128i*) &p_src2[n_sample + 4u]), &p_gains[1], mul2, shift2, pol_mask2));
+
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample], _mm_add_epi32(_mm_loadu_si128((const __m128i*) &p_acc[n_sample]), x_lo));
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample + 4u], _mm_add_epi32(_mm_loadu_si128((const __m128i*) &p_acc[n_sample + 4u]), x_hi));
+	}
+
+	dspkernel_accumulate2_i32_scalar(&p_acc[n_sample], &p_src1[n_sample], &p_src2[n_sample], (n_samples - n_sample), p_gains);
+	return;
+}
+
+__DSPKERNEL_TARGET_SSE2 static VOID WINAPI dspkernel_saturate_i16_sse2(INT16 *p_out, const INT32 *p_acc, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+	__m128i x_lo;
+	__m128i x_hi;
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x_lo = dspkernel_half_epi32_sse2(_mm_loadu_si128((const __m128i*) &p_acc[n_sample]));
+		x_hi = dspkernel_half_epi32_sse2(_mm_loadu_si128((const __m128i*) &p_acc[n_sample + 4u]));
+
+		/*_mm_packs_epi32 narrows INT32 to INT16 with signed saturation*/
+		_mm_storeu_si128((__m128i*) &p_out[n_sample], _mm_packs_epi32(x_lo, x_hi));
+	}
+
+	dspkernel_saturate_i16_scalar(&p_out[n_sample], &p_acc[n_sample], (n_samples - n_sample));
+	return;
+}
+
+__DSPKERNEL_TARGET_SSE2 static VOID WINAPI dspkernel_saturate_i24_sse2(INT32 *p_out, const INT32 *p_acc, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+	__m128i max_value;
+	__m128i min_value;
+	__m128i mask;
+	__m128i x;
+
+	max_value = _mm_set1_epi32(I24_MAX_VALUE);
+	min_value = _mm_set1_epi32(I24_MIN_VALUE);
+
+	for(n_sample = 0u; (n_sample + 4u) <= n_samples; n_sample += 4u)
+	{
+		x = dspkernel_half_epi32_sse2(_mm_loadu_si128((const __m128i*) &p_acc[n_sample]));
+
+		/*SSE2 has no INT32 min/max*/
+		mask = _mm_cmpgt_epi32(x, max_value);
+		x = _mm_or_si128(_mm_and_si128(mask, max_value), _mm_andnot_si128(mask, x));
+
+		mask = _mm_cmplt_epi32(x, min_value);
+		x = _mm_or_si128(_mm_and_si128(mask, min_value), _mm_andnot_si128(mask, x));
+
+		_mm_storeu_si128((__m128i*) &p_out[n_sample], _mm_slli_epi32(x, 8));
+	}
+
+	dspkernel_saturate_i24_scalar(&p_out[n_sample], &p_acc[n_sample], (n_samples - n_sample));
+	return;
+}
+
+/*
+	Unpack 4 packed 24bit samples from the first 12 bytes of x (SSE2 has no byte shuffle):
+	each 64bit lane gets 2 samples (bytes 0-7 and 6-13), shifted so that one sample sits on the top 24 bits of each 32bit lane, then sign extended.
+*/
+
+__DSPKERNEL_TARGET_SSE2 __DSPKERNEL_FORCEINLINE static inline __m128i dspkernel_unpack_i24_epi32_sse2(__m128i x, __m128i mask_even)
+{
+	x = _mm_unpacklo_epi64(x, _mm_srli_si128(x, 6));
+	x = _mm_or_si128(_mm_and_si128(mask_even, _mm_slli_epi64(x, 8)), _mm_andnot_si128(mask_even, _mm_slli_epi64(x, 16)));
+
+	return _mm_srai_epi32(x, 8);
+}
+
+__DSPKERNEL_TARGET_SSE2 static VOID WINAPI dspkernel_unpack_i24_sse2(INT32 *p_out, const BYTE *p_src, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+	__m128i mask_even;
+
+	mask_even = _mm_set_epi32(0, -1, 0, -1);
+
+	/*Each load reads 16 bytes for 12 bytes of samples, stop while the last load is still within p_src*/
+
+	for(n_sample = 0u; (3u*n_sample + 28u) <= 3u*n_samples; n_sample += 8u)
+	{
+		_mm_storeu_si128((__m128i*) &p_out[n_sample], dspkernel_unpack_i24_epi32_sse2(_mm_loadu_si128((const __m128i*) &p_src[3u*n_sample]), mask_even));
+		_mm_storeu_si128((__m128i*) &p_out[n_sample + 4u], dspkernel_unpack_i24_epi32_sse2(_mm_loadu_si128((const __m128i*) &p_src[3u*n_sample + 12u]), mask_even));
+	}
+
+	dspkernel_unpack_i24_scalar(&p_out[n_sample], &p_src[3u*n_sample], (n_samples - n_sample));
+	return;
+}
+
+/*
+	Recursive comb step for 4 INT32 samples. Returns the new state.
+	frac_bits, corr_shift: shift counts on the low 64 bits.
+*/
+
+__DSPKERNEL_TARGET_SSE2 __DSPKERNEL_FORCEINLINE static inline __m128i dspkernel_comb_epi32_sse2(__m128i x, __m128i state, __m128i x_corr, BOOL corr, __m128i frac_bits, __m128i corr_shift, __m128i pol_mask, __m128i corr_pol_mask)
+{
+	__m128i y;
+
+	y = _mm_add_epi32(_mm_sll_epi32(x, frac_bits), state);
+	y = _mm_srai_epi32(_mm_sub_epi32(_mm_xor_si128(y, pol_mask), pol_mask), 1);
+
+	if(corr)
+	{
+		x_corr = _mm_sra_epi32(_mm_sll_epi32(x_corr, frac_bits), corr_shift);
+		y = _mm_sub_epi32(y, _mm_sub_epi32(_mm_xor_si128(x_corr, corr_pol_mask), corr_pol_mask));
+	}
+
+	return y;
+}
+
+__DSPKERNEL_TARGET_SSE2 static VOID WINAPI dspkernel_comb_i16_sse2(INT32 *p_state, INT32 *p_acc, const INT16 *p_src, const INT32 *p_state_src, const INT16 *p_corr_src, SIZE_T n_samples, const dspkernel_comb_t *p_comb)
+{
+	SIZE_T n_sample = 0u;
+	BOOL corr = FALSE;
+	__m128i frac_bits;
+	__m128i corr_shift;
+	__m128i pol_mask;
+	__m128i corr_pol_mask;
+	__m128i round;
+	__m128i x;
+	__m128i x_corr;
+	__m128i x_corr_lo;
+	__m128i x_corr_hi;
+	__m128i y_lo;
+	__m128i y_hi;
+
+	corr = (p_corr_src != NULL);
+
+	frac_bits = _mm_cvtsi32_si128((INT32) p_comb->frac_bits);
+	corr_shift = _mm_cvtsi32_si128((INT32) p_comb->corr_shift);
+	pol_mask = _mm_set1_epi32(p_comb->pol_mask);
+	corr_pol_mask = _mm_set1_epi32(p_comb->corr_pol_mask);
+	round = _mm_set1_epi32(1 << (p_comb->frac_bits - 1u));
+
+	x_corr_lo = _mm_setzero_si128();
+	x_corr_hi = _mm_setzero_si128();
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x = _mm_loadu_si128((const __m128i*) &p_src[n_sample]);
+
+		if(corr)
+		{
+			x_corr = _mm_loadu_si128((const __m128i*) &p_corr_src[n_sample]);
+			x_corr_lo = _mm_srai_epi32(_mm_unpacklo_epi16(x_corr, x_corr), 16);
+			x_corr_hi = _mm_srai_epi32(_mm_unpackhi_epi16(x_corr, x_corr), 16);
+		}
+
+		y_lo = dspkernel_comb_epi32_sse2(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16), _mm_loadu_si128((const __m128i*) &p_state_src[n_sample]), x_corr_lo, corr, frac_bits, corr_shift, pol_mask, corr_pol_mask);
+		y_hi = dspkernel_comb_epi32_sse2(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16), _mm_loadu_si128((const __m128i*) &p_state_src[n_sample + 4u]), x_corr_hi, corr, frac_bits, corr_shift, pol_mask, corr_pol_mask);
+
+		_mm_storeu_si128((__m128i*) &p_state[n_sample], y_lo);
+		_mm_storeu_si128((__m128i*) &p_state[n_sample + 4u], y_hi);
+
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample], _mm_add_epi32(_mm_loadu_si128((const __m128i*) &p_acc[n_sample]), _mm_sra_epi32(_mm_add_epi32(y_lo, round), frac_bits)));
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample + 4u], _mm_add_epi32(_mm_loadu_si128((const __m128i*) &p_acc[n_sample + 4u]), _mm_sra_epi32(_mm_add_epi32(y_hi, round), frac_bits)));
+	}
+
+	if(corr) dspkernel_comb_i16_scalar(&p_state[n_sample], &p_acc[n_sample], &p_src[n_sample], &p_state_src[n_sample], &p_corr_src[n_sample], (n_samples - n_sample), p_comb);
+	else dspkernel_comb_i16_scalar(&p_state[n_sample], &p_acc[n_sample], &p_src[n_sample], &p_state_src[n_sample], NULL, (n_samples - n_sample), p_comb);
+
+	return;
+}
+
+__DSPKERNEL_TARGET_SSE2 static VOID WINAPI dspkernel_comb_i32_sse2(INT32 *p_state, INT32 *p_acc, const INT32 *p_src, const INT32 *p_state_src, const INT32 *p_corr_src, SIZE_T n_samples, const dspkernel_comb_t *p_comb)
+{
+	SIZE_T n_sample = 0u;
+	BOOL corr = FALSE;
+	__m128i frac_bits;
+	__m128i corr_shift;
+	__m128i pol_mask;
+	__m128i corr_pol_mask;
+	__m128i round;
+	__m128i x_corr_lo;
+	__m128i x_corr_hi;
+	__m128i y_lo;
+	__m128i y_hi;
+
+	corr = (p_corr_src != NULL);
+
+	frac_bits = _mm_cvtsi32_si128((INT32) p_comb->frac_bits);
+	corr_shift = _mm_cvtsi32_si128((INT32) p_comb->corr_shift);
+	pol_mask = _mm_set1_epi32(p_comb->pol_mask);
+	corr_pol_mask = _mm_set1_epi32(p_comb->corr_pol_mask);
+	round = _mm_set1_epi32(1 << (p_comb->frac_bits - 1u));
+
+	x_corr_lo = _mm_setzero_si128();
+	x_corr_hi = _mm_setzero_si128();
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		if(corr)
+		{
+			x_corr_lo = _mm_loadu_si128((const __m128i*) &p_corr_src[n_sample]);
+			x_corr_hi = _mm_loadu_si128((const __m128i*) &p_corr_src[n_sample + 4u]);
+		}
+
+		y_lo = dspkernel_comb_epi32_sse2(_mm_loadu_si128((const __m128i*) &p_src[n_sample]), _mm_loadu_si128((const __m128i*) &p_state_src[n_sample]), x_corr_lo, corr, frac_bits, corr_shift, pol_mask, corr_pol_mask);
+		y_hi = dspkernel_comb_epi32_sse2(_mm_loadu_si128((const __m128i*) &p_src[n_sample + 4u]), _mm_loadu_si128((const __m128i*) &p_state_src[n_sample + 4u]), x_corr_hi, corr, frac_bits, corr_shift, pol_mask, corr_pol_mask);
+
+		_mm_storeu_si128((__m128i*) &p_state[n_sample], y_lo);
+		_mm_storeu_si128((__m128i*) &p_state[n_sample + 4u], y_hi);
+
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample], _mm_add_epi32(_mm_loadu_si128((const __m128i*) &p_acc[n_sample]), _mm_sra_epi32(_mm_add_epi32(y_lo, round), frac_bits)));
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample + 4u], _mm_add_epi32(_mm_loadu_si128((const __m128i*) &p_acc[n_sample + 4u]), _mm_sra_epi32(_mm_add_epi32(y_hi, round), frac_bits)));
+	}
+
+	if(corr) dspkernel_comb_i32_scalar(&p_state[n_sample], &p_acc[n_sample], &p_src[n_sample], &p_state_src[n_sample], &p_corr_src[n_sample], (n_samples - n_sample), p_comb);
+	else dspkernel_comb_i32_scalar(&p_state[n_sample], &p_acc[n_sample], &p_src[n_sample], &p_state_src[n_sample], NULL, (n_samples - n_sample), p_comb);
+
+	return;
+}
+
+/*Crossfade step for 4 INT32 samples. w: crossfade weight (16 bits) on all lanes.*/
+
+__DSPKERNEL_TARGET_SSE2 __DSPKERNEL_FORCEINLINE static inline __m128i dspkernel_xfade_epi32_sse2(__m128i x, __m128i x_old, __m128i w)
+{
+	__m128i sign_mask;
+	__m128i q_02;
+	__m128i q_13;
+
+	x = _mm_sub_epi32(x, x_old);
+	sign_mask = _mm_srai_epi32(x, 31);
+	x = _mm_sub_epi32(_mm_xor_si128(x, sign_mask), sign_mask);
+
+	q_02 = _mm_srli_epi64(_mm_mul_epu32(x, w), 16);
+	q_13 = _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(x, 32), _mm_srli_epi64(w, 32)), 16);
+
+	x = _mm_unpacklo_epi32(_mm_shuffle_epi32(q_02, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(q_13, _MM_SHUFFLE(0, 0, 2, 0)));
+
+	return _mm_add_epi32(x_old, _mm_sub_epi32(_mm_xor_si128(x, sign_mask), sign_mask));
+}
+
+__DSPKERNEL_TARGET_SSE2 static VOID WINAPI dspkernel_xfade_i32_sse2(INT32 *p_acc, const INT32 *p_old, SIZE_T n_samples, UINT32 ramp_pos, UINT32 ramp_step)
+{
+	SIZE_T n_sample = 0u;
+	__m128i pos_lo;
+	__m128i pos_hi;
+	__m128i step;
+
+	pos_lo = _mm_setr_epi32((INT32) ramp_pos, (INT32) (ramp_pos + ramp_step), (INT32) (ramp_pos + 2u*ramp_step), (INT32) (ramp_pos + 3u*ramp_step));
+	pos_hi = _mm_add_epi32(pos_lo, _mm_set1_epi32((INT32) (4u*ramp_step)));
+	step = _mm_set1_epi32((INT32) (8u*ramp_step));
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample], dspkernel_xfade_epi32_sse2(_mm_loadu_si128((const __m128i*) &p_acc[n_sample]), _mm_loadu_si128((const __m128i*) &p_old[n_sample]), _mm_srli_epi32(pos_lo, 16)));
+		_mm_storeu_si128((__m128i*) &p_acc[n_sample + 4u], dspkernel_xfade_epi32_sse2(_mm_loadu_si128((const __m128i*) &p_acc[n_sample + 4u]), _mm_loadu_si128((const __m128i*) &p_old[n_sample + 4u]), _mm_srli_epi32(pos_hi, 16)));
+
+		pos_lo = _mm_add_epi32(pos_lo, step);
+		pos_hi = _mm_add_epi32(pos_hi, step);
+	}
+
+	dspkernel_xfade_i32_scalar(&p_acc[n_sample], &p_old[n_sample], (n_samples - n_sample), (ramp_pos + ((UINT32) n_sample)*ramp_step), ramp_step);
+	return;
+}
+
+static const dspkernel_table_t DSPKERNEL_TABLE_SSE2 = {
+	.p_widen_i16 = &dspkernel_widen_i16_sse2,
+	.p_accumulate_i16 = &dspkernel_accumulate_i16_sse2,
+	.p_accumulate_i32 = &dspkernel_accumulate_i32_sse2,
+	.p_accumulate2_i16 = &dspkernel_accumulate2_i16_sse2,
+	.p_accumulate2_i32 = &dspkernel_accumulate2_i32_sse2,
+	.p_saturate_i16 = &dspkernel_saturate_i16_sse2,
+	.p_saturate_i24 = &dspkernel_saturate_i24_sse2,
+	.p_unpack_i24 = &dspkernel_unpack_i24_sse2,
+	.p_comb_i16 = &dspkernel_comb_i16_sse2,
+	.p_comb_i32 = &dspkernel_comb_i32_sse2,
+	.p_xfade_i32 = &dspkernel_xfade_i32_sse2,
+	.isa = DSPKERNEL_ISA_SSE2
+};
+
+/*======================================================================================*/
+/*AVX2 Kernels (8 samples per register, 16 samples per loop cycle)*/
+
+__DSPKERNEL_TARGET_AVX2 __DSPKERNEL_FORCEINLINE static inline __m256i dspkernel_tap_epi32_avx2(__m256i x, __m256i mul, __m128i shift, __m256i pol_mask)
+{
+	__m256i sign_mask;
+	__m256i q_02;
+	__m256i q_13;
+
+	sign_mask = _mm256_srai_epi32(x, 31);
+	x = _mm256_abs_epi32(x);
+
+	/*_mm256_mul_epu32 multiplies lanes 0, 2, 4 and 6 only*/
+	q_02 = _mm256_srl_epi64(_mm256_mul_epu32(x, mul), shift);
+	q_13 = _mm256_srl_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), mul), shift);
+
+	x = _mm256_unpacklo_epi32(_mm256_shuffle_epi32(q_02, _MM_SHUFFLE(0, 0, 2, 0)), _mm256_shuffle_epi32(q_13, _MM_SHUFFLE(0, 0, 2, 0)));
+
+	sign_mask = _mm256_xor_si256(sign_mask, pol_mask);
+	return _mm256_sub_epi32(_mm256_xor_si256(x, sign_mask), sign_mask);
+}
+
+__DSPKERNEL_TARGET_AVX2 __DSPKERNEL_FORCEINLINE static inline __m256i dspkernel_tapshift_epi32_avx2(__m256i x, __m128i shift, __m256i pol_mask)
+{
+	__m256i sign_mask;
+
+	sign_mask = _mm256_xor_si256(_mm256_srai_epi32(x, 31), pol_mask);
+	x = _mm256_srl_epi32(_mm256_abs_epi32(x), shift);
+
+	return _mm256_sub_epi32(_mm256_xor_si256(x, sign_mask), sign_mask);
+}
+
+__DSPKERNEL_TARGET_AVX2 __DSPKERNEL_FORCEINLINE static inline __m256i dspkernel_tapgain_epi32_avx2(__m256i x, const dspkernel_gain_t *p_gain, __m256i mul, __m128i shift, __m256i pol_mask)
+{
+	if(p_gain->mul == 1u) return dspkernel_tapshift_epi32_avx2(x, shift, pol_mask);
+
+	return dspkernel_tap_epi32_avx2(x, mul, shift, pol_mask);
+}
+
+__DSPKERNEL_TARGET_AVX2 __DSPKERNEL_FORCEINLINE static inline __m256i dspkernel_half_epi32_avx2(__m256i x)
+{
+	return _mm256_srai_epi32(_mm256_add_epi32(x, _mm256_srli_epi32(x, 31)), 1);
+}
+
+__DSPKERNEL_TARGET_AVX2 static VOID WINAPI dspkernel_widen_i16_avx2(INT32 *p_acc, const INT16 *p_src, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+
+	for(n_sample = 0u; (n_sample + 16u) <= n_samples; n_sample += 16u)
+	{
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample], _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) &p_src[n_sample])));
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample + 8u], _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) &p_src[n_sample + 8u])));
+	}
+
+	dspkernel_widen_i16_scalar(&p_acc[n_sample], &p_src[n_sample], (n_samples - n_sample));
+	return;
+}
+
+__DSPKERNEL_TARGET_AVX2 static VOID WINAPI dspkernel_accumulate_i16_avx2(INT32 *p_acc, const INT16 *p_src, SIZE_T n_samples, const dspkernel_gain_t *p_gain)
+{
+	SIZE_T n_sample = 0u;
+	__m256i mul;
+	__m128i shift;
+	__m256i pol_mask;
+	__m256i x_lo;
+	__m256i x_hi;
+
+	mul = _mm256_set1_epi32((INT32) p_gain->mul);
+	shift = _mm_cvtsi32_si128((INT32) p_gain->shift);
+	pol_mask = _mm256_set1_epi32(p_gain->pol_mask);
+
+	for(n_sample = 0u; (n_sample + 16u) <= n_samples; n_sample += 16u)
+	{
+		x_lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) &p_src[n_sample]));
+		x_hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) &p_src[n_sample + 8u]));
+
+		if(p_gain->mul == 1u)
+		{
+			x_lo = dspkernel_tapshift_epi32_avx2(x_lo, shift, pol_mask);
+			x_hi = dspkernel_tapshift_epi32_avx2(x_hi, shift, pol_mask);
+		}
+		else
+		{
+			x_lo = dspkernel_tap_epi32_avx2(x_lo, mul, shift, pol_mask);
+			x_hi = dspkernel_tap_epi32_avx2(x_hi, mul, shift, pol_mask);
+		}
+
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample]), x_lo));
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample + 8u], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample + 8u]), x_hi));
+	}
+
+	dspkernel_accumulate_i16_scalar(&p_acc[n_sample], &p_src[n_sample], (n_samples - n_sample), p_gain);
+	return;
+}
+
+__DSPKERNEL_TARGET_AVX2 static VOID WINAPI dspkernel_accumulate_i32_avx2(INT32 *p_acc, const INT32 *p_src, SIZE_T n_samples, const dspkernel_gain_t *p_gain)
+{
+	SIZE_T n_sample = 0u;
+	__m256i mul;
+	__m128i shift;
+	__m256i pol_mask;
+	__m256i x_lo;
+	__m256i x_hi;
+
+	mul = _mm256_set1_epi32((INT32) p_gain->mul);
+	shift = _mm_cvtsi32_si128((INT32) p_gain->shift);
+	pol_mask = _mm256_set1_epi32(p_gain->pol_mask);
+
+	for(n_sample = 0u; (n_sample + 16u) <= n_samples; n_sample += 16u)
+	{
+		x_lo = _mm256_loadu_si256((const __m256i*) &p_src[n_sample]);
+		x_hi = _mm256_loadu_si256((const __m256i*) &p_src[n_sample + 8u]);
+
+		if(p_gain->mul == 1u)
+		{
+			x_lo = dspkernel_tapshift_epi32_avx2(x_lo, shift, pol_mask);
+			x_hi = dspkernel_tapshift_epi32_avx2(x_hi, shift, pol_mask);
+		}
+		else
+		{
+			x_lo = dspkernel_tap_epi32_avx2(x_lo, mul, shift, pol_mask);
+			x_hi = dspkernel_tap_epi32_avx2(x_hi, mul, shift, pol_mask);
+		}
+
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample]), x_lo));
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample + 8u], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample + 8u]), x_hi));
+	}
+
+	dspkernel_accumulate_i32_scalar(&p_acc[n_sample], &p_src[n_sample], (n_samples - n_sample), p_gain);
+	return;
+}
+
+__DSPKERNEL_TARGET_AVX2 static VOID WINAPI dspkernel_accumulate2_i16_avx2(INT32 *p_acc, const INT16 *p_src1, const INT16 *p_src2, SIZE_T n_samples, const dspkernel_gain_t *p_gains)
+{
+	SIZE_T n_sample = 0u;
+	__m256i mul1;
+	__m256i mul2;
+	__m128i shift1;
+	__m128i shift2;
+	__m256i pol_mask1;
+	__m256i pol_mask2;
+	__m256i x_lo;
+	__m256i x_hi;
+
+	mul1 = _mm256_set1_epi32((INT32) p_gains[0].mul);
+	mul2 = _mm256_set1_epi32((INT32) p_gains[1].mul);
+	shift1 = _mm_cvtsi32_si128((INT32) p_gains[0].shift);
+	shift2 = _mm_cvtsi32_si128((INT32) p_gains[1].shift);
+	pol_mask1 = _mm256_set1_epi32(p_gains[0].pol_mask);
+	pol_mask2 = _mm256_set1_epi32(p_gains[1].pol_mask);
+
+	for(n_sample = 0u; (n_sample + 16u) <= n_samples; n_sample += 16u)
+	{
+		x_lo = _mm256_add_epi32(dspkernel_tapgain_epi32_avx2(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) &p_src1[n_sample])), &p_gains[0], mul1, shift1, pol_mask1), dspkernel_tapgain_epi32_avx2(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) &p_src2[n_sample])), &p_gains[1], mul2, shift2, pol_mask2));
+		x_hi = _mm256_add_epi32(dspkernel_tapgain_epi32_avx2(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) &p_src1[n_sample + 8u])), &p_gains[0], mul1, shift1, pol_mask1), dspkernel_tapgain_epi32_avx2(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) &p_src2[n_sample + 8u])), &p_gains[1], mul2, shift2, pol_mask2));
+
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample]), x_lo));
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample + 8u], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample + 8u]), x_hi));
+	}
+
+	dspkernel_accumulate2_i16_scalar(&p_acc[n_sample], &p_src1[n_sample], &p_src2[n_sample], (n_samples - n_sample), p_gains);
+	return;
+}
+
+__DSPKERNEL_TARGET_AVX2 static VOID WINAPI dspkernel_accumulate2_i32_avx2(INT32 *p_acc, const INT32 *p_src1, const INT32 *p_src2, SIZE_T n_samples, const dspkernel_gain_t *p_gains)
+{
+	SIZE_T n_sample = 0u;
+	__m256i mul1;
+	__m256i mul2;
+	__m128i shift1;
+	__m128i shift2;
+	__m256i pol_mask1;
+	__m256i pol_mask2;
+	__m256i x_lo;
+	__m256i x_hi;
+
+	mul1 = _mm256_set1_epi32((INT32) p_gains[0].mul);
+	mul2 = _mm256_set1_epi32((INT32) p_gains[1].mul);
+	shift1 = _mm_cvtsi32_si128((INT32) p_gains[0].shift);
+	shift2 = _mm_cvtsi32_si128((INT32) p_gains[1].shift);
+	pol_mask1 = _mm256_set1_epi32(p_gains[0].pol_mask);
+	pol_mask2 = _mm256_set1_epi32(p_gains[1].pol_mask);
+
+	for(n_sample = 0u; (n_sample + 16u) <= n_samples; n_sample += 16u)
+	{
+		x_lo = _mm256_add_epi32(dspkernel_tapgain_epi32_avx2(_mm256_loadu_si256((const __m256i*) &p_src1[n_sample]), &p_gains[0], mul1, shift1, pol_mask1), dspkernel_tapgain_epi32_avx2(_mm256_loadu_si256((const __m256i*) &p_src2[n_sample]), &p_gains[1], mul2, shift2, pol_mask2));
+		x_hi = _mm256_add_epi32(dspkernel_tapgain_epi32_avx2(_mm256_loadu_si256((const __m256i*) &p_src1[n_sample + 8u]), &p_gains[0], mul1, shift1, pol_mask1), dspkernel_tapgain_epi32_avx2(_mm256_loadu_si256((const __m256i*) &p_src2[n_sample + 8u]), &p_gains[1], mul2, shift2, pol_mask2));
+
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample]), x_lo));
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample + 8u], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample + 8u]), x_hi));
+	}
+
+	dspkernel_accumulate2_i32_scalar(&p_acc[n_sample], &p_src1[n_sample], &p_src2[n_sample], (n_samples - n_sample), p_gains);
+	return;
+}
+
+__DSPKERNEL_TARGET_AVX2 static VOID WINAPI dspkernel_saturate_i16_avx2(INT16 *p_out, const INT32 *p_acc, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+	__m256i x_lo;
+	__m256i x_hi;
+
+	for(n_sample = 0u; (n_sample + 16u) <= n_samples; n_sample += 16u)
+	{
+		x_lo = dspkernel_half_epi32_avx2(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample]));
+		x_hi = dspkernel_half_epi32_avx2(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample + 8u]));
+
+		/*_mm256_packs_epi32 packs within 128bit lanes, the permute restores sample order*/
+		_mm256_storeu_si256((__m256i*) &p_out[n_sample], _mm256_permute4x64_epi64(_mm256_packs_epi32(x_lo, x_hi), _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+
+	dspkernel_saturate_i16_scalar(&p_out[n_sample], &p_acc[n_sample], (n_samples - n_sample));
+	return;
+}
+
+__DSPKERNEL_TARGET_AVX2 static VOID WINAPI dspkernel_saturate_i24_avx2(INT32 *p_out, const INT32 *p_acc, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+	__m256i max_value;
+	__m256i min_value;
+	__m256i x_lo;
+	__m256i x_hi;
+
+	max_value = _mm256_set1_epi32(I24_MAX_VALUE);
+	min_value = _mm256_set1_epi32(I24_MIN_VALUE);
+
+	for(n_sample = 0u; (n_sample + 16u) <= n_samples; n_sample += 16u)
+	{
+		x_lo = dspkernel_half_epi32_avx2(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample]));
+		x_hi = dspkernel_half_epi32_avx2(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample + 8u]));
+
+		x_lo = _mm256_max_epi32(_mm256_min_epi32(x_lo, max_value), min_value);
+		x_hi = _mm256_max_epi32(_mm256_min_epi32(x_hi, max_value), min_value);
+
+		_mm256_storeu_si256((__m256i*) &p_out[n_sample], _mm256_slli_epi32(x_lo, 8));
+		_mm256_storeu_si256((__m256i*) &p_out[n_sample + 8u], _mm256_slli_epi32(x_hi, 8));
+	}
+
+	dspkernel_saturate_i24_scalar(&p_out[n_sample], &p_acc[n_sample], (n_samples - n_sample));
+	return;
+}
+
+/*Unpack 8 packed 24bit samples: 12 bytes (4 samples) at the beginning of each 128bit lane, shuffled onto the top 24 bits of each 32bit lane, then sign extended.*/
+
+__DSPKERNEL_TARGET_AVX2 __DSPKERNEL_FORCEINLINE static inline __m256i dspkernel_unpack_i24_epi32_avx2(const BYTE *p_src, __m256i shuffle)
+{
+	__m256i x;
+
+	x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*) p_src)), _mm_loadu_si128((const __m128i*) &p_src[12u]), 1);
+
+	return _mm256_srai_epi32(_mm256_shuffle_epi8(x, shuffle), 8);
+}
+
+__DSPKERNEL_TARGET_AVX2 static VOID WINAPI dspkernel_unpack_i24_avx2(INT32 *p_out, const BYTE *p_src, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+	__m256i shuffle;
+
+	/*Byte -1 (0x80) zeroes the bottom byte of each 32bit lane*/
+
+	shuffle = _mm256_setr_epi8(
+		-128, 0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11,
+		-128, 0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11);
+
+	/*Each 128bit load reads 16 bytes for 12 bytes of samples, stop while the last load is still within p_src*/
+
+	for(n_sample = 0u; (3u*n_sample + 52u) <= 3u*n_samples; n_sample += 16u)
+	{
+		_mm256_storeu_si256((__m256i*) &p_out[n_sample], dspkernel_unpack_i24_epi32_avx2(&p_src[3u*n_sample], shuffle));
+		_mm256_storeu_si256((__m256i*) &p_out[n_sample + 8u], dspkernel_unpack_i24_epi32_avx2(&p_src[3u*n_sample + 24u], shuffle));
+	}
+
+	dspkernel_unpack_i24_scalar(&p_out[n_sample], &p_src[3u*n_sample], (n_samples - n_sample));
+	return;
+}
+
+__DSPKERNEL_TARGET_AVX2 __DSPKERNEL_FORCEINLINE static inline __m256i dspkernel_comb_epi32_avx2(__m256i x, __m256i state, __m256i x_corr, BOOL corr, __m128i frac_bits, __m128i corr_shift, __m256i pol_mask, __m256i corr_pol_mask)
+{
+	__m256i y;
+
+	y = _mm256_add_epi32(_mm256_sll_epi32(x, frac_bits), state);
+	y = _mm256_srai_epi32(_mm256_sub_epi32(_mm256_xor_si256(y, pol_mask), pol_mask), 1);
+
+	if(corr)
+	{
+		x_corr = _mm256_sra_epi32(_mm256_sll_epi32(x_corr, frac_bits), corr_shift);
+		y = _mm256_sub_epi32(y, _mm256_sub_epi32(_mm256_xor_si256(x_corr, corr_pol_mask), corr_pol_mask));
+	}
+
+	return y;
+}
+
+__DSPKERNEL_TARGET_AVX2 static VOID WINAPI dspkernel_comb_i16_avx2(INT32 *p_state, INT32 *p_acc, const INT16 *p_src, const INT32 *p_state_src, const INT16 *p_corr_src, SIZE_T n_samples, const dspkernel_comb_t *p_comb)
+{
+	SIZE_T n_sample = 0u;
+	BOOL corr = FALSE;
+	__m128i frac_bits;
+	__m128i corr_shift;
+	__m256i pol_mask;
+	__m256i corr_pol_mask;
+	__m256i round;
+	__m256i x_corr_lo;
+	__m256i x_corr_hi;
+	__m256i y_lo;
+	__m256i y_hi;
+
+	corr = (p_corr_src != NULL);
+
+	frac_bits = _mm_cvtsi32_si128((INT32) p_comb->frac_bits);
+	corr_shift = _mm_cvtsi32_si128((INT32) p_comb->corr_shift);
+	pol_mask = _mm256_set1_epi32(p_comb->pol_mask);
+	corr_pol_mask = _mm256_set1_epi32(p_comb->corr_pol_mask);
+	round = _mm256_set1_epi32(1 << (p_comb->frac_bits - 1u));
+
+	x_corr_lo = _mm256_setzero_si256();
+	x_corr_hi = _mm256_setzero_si256();
+
+	for(n_sample = 0u; (n_sample + 16u) <= n_samples; n_sample += 16u)
+	{
+		if(corr)
+		{
+			x_corr_lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) &p_corr_src[n_sample]));
+			x_corr_hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) &p_corr_src[n_sample + 8u]));
+		}
+
+		y_lo = dspkernel_comb_epi32_avx2(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) &p_src[n_sample])), _mm256_loadu_si256((const __m256i*) &p_state_src[n_sample]), x_corr_lo, corr, frac_bits, corr_shift, pol_mask, corr_pol_mask);
+		y_hi = dspkernel_comb_epi32_avx2(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) &p_src[n_sample + 8u])), _mm256_loadu_si256((const __m256i*) &p_state_src[n_sample + 8u]), x_corr_hi, corr, frac_bits, corr_shift, pol_mask, corr_pol_mask);
+
+		_mm256_storeu_si256((__m256i*) &p_state[n_sample], y_lo);
+		_mm256_storeu_si256((__m256i*) &p_state[n_sample + 8u], y_hi);
+
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample]), _mm256_sra_epi32(_mm256_add_epi32(y_lo, round), frac_bits)));
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample + 8u], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample + 8u]), _mm256_sra_epi32(_mm256_add_epi32(y_hi, round), frac_bits)));
+	}
+
+	if(corr) dspkernel_comb_i16_scalar(&p_state[n_sample], &p_acc[n_sample], &p_src[n_sample], &p_state_src[n_sample], &p_corr_src[n_sample], (n_samples - n_sample), p_comb);
+	else dspkernel_comb_i16_scalar(&p_state[n_sample], &p_acc[n_sample], &p_src[n_sample], &p_state_src[n_sample], NULL, (n_samples - n_sample), p_comb);
+
+	return;
+}
+
+__DSPKERNEL_TARGET_AVX2 static VOID WINAPI dspkernel_comb_i32_avx2(INT32 *p_state, INT32 *p_acc, const INT32 *p_src, const INT32 *p_state_src, const INT32 *p_corr_src, SIZE_T n_samples, const dspkernel_comb_t *p_comb)
+{
+	SIZE_T n_sample = 0u;
+	BOOL corr = FALSE;
+	__m128i frac_bits;
+	__m128i corr_shift;
+	__m256i pol_mask;
+	__m256i corr_pol_mask;
+	__m256i round;
+	__m256i x_corr_lo;
+	__m256i x_corr_hi;
+	__m256i y_lo;
+	__m256i y_hi;
+
+	corr = (p_corr_src != NULL);
+
+	frac_bits = _mm_cvtsi32_si128((INT32) p_comb->frac_bits);
+	corr_shift = _mm_cvtsi32_si128((INT32) p_comb->corr_shift);
+	pol_mask = _mm256_set1_epi32(p_comb->pol_mask);
+	corr_pol_mask = _mm256_set1_epi32(p_comb->corr_pol_mask);
+	round = _mm256_set1_epi32(1 << (p_comb->frac_bits - 1u));
+
+	x_corr_lo = _mm256_setzero_si256();
+	x_corr_hi = _mm256_setzero_si256();
+
+	for(n_sample = 0u; (n_sample + 16u) <= n_samples; n_sample += 16u)
+	{
+		if(corr)
+		{
+			x_corr_lo = _mm256_loadu_si256((const __m256i*) &p_corr_src[n_sample]);
+			x_corr_hi = _mm256_loadu_si256((const __m256i*) &p_corr_src[n_sample + 8u]);
+		}
+
+		y_lo = dspkernel_comb_epi32_avx2(_mm256_loadu_si256((const __m256i*) &p_src[n_sample]), _mm256_loadu_si256((const __m256i*) &p_state_src[n_sample]), x_corr_lo, corr, frac_bits, corr_shift, pol_mask, corr_pol_mask);
+		y_hi = dspkernel_comb_epi32_avx2(_mm256_loadu_si256((const __m256i*) &p_src[n_sample + 8u]), _mm256_loadu_si256((const __m256i*) &p_state_src[n_sample + 8u]), x_corr_hi, corr, frac_bits, corr_shift, pol_mask, corr_pol_mask);
+
+		_mm256_storeu_si256((__m256i*) &p_state[n_sample], y_lo);
+		_mm256_storeu_si256((__m256i*) &p_state[n_sample + 8u], y_hi);
+
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample]), _mm256_sra_epi32(_mm256_add_epi32(y_lo, round), frac_bits)));
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample + 8u], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample + 8u]), _mm256_sra_epi32(_mm256_add_epi32(y_hi, round), frac_bits)));
+	}
+
+	if(corr) dspkernel_comb_i32_scalar(&p_state[n_sample], &p_acc[n_sample], &p_src[n_sample], &p_state_src[n_sample], &p_corr_src[n_sample], (n_samples - n_sample), p_comb);
+	else dspkernel_comb_i32_scalar(&p_state[n_sample], &p_acc[n_sample], &p_src[n_sample], &p_state_src[n_sample], NULL, (n_samples - n_sample), p_comb);
+
+	return;
+}
+
+/*Crossfade step for 8 INT32 samples. w: crossfade weight (16 bits) on all lanes.*/
+
+__DSPKERNEL_TARGET_AVX2 __DSPKERNEL_FORCEINLINE static inline __m256i dspkernel_xfade_epi32_avx2(__m256i x, __m256i x_old, __m256i w)
+{
+	__m256i sign_mask;
+	__m256i q_02;
+	__m256i q_13;
+
+	x = _mm256_sub_epi32(x, x_old);
+	sign_mask = _mm256_srai_epi32(x, 31);
+	x = _mm256_abs_epi32(x);
+
+	q_02 = _mm256_srli_epi64(_mm256_mul_epu32(x, w), 16);
+	q_13 = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(w, 32)), 16);
+
+	x = _mm256_unpacklo_epi32(_mm256_shuffle_epi32(q_02, _MM_SHUFFLE(0, 0, 2, 0)), _mm256_shuffle_epi32(q_13, _MM_SHUFFLE(0, 0, 2, 0)));
+
+	return _mm256_add_epi32(x_old, _mm256_sub_epi32(_mm256_xor_si256(x, sign_mask), sign_mask));
+}
+
+__DSPKERNEL_TARGET_AVX2 static VOID WINAPI dspkernel_xfade_i32_avx2(INT32 *p_acc, const INT32 *p_old, SIZE_T n_samples, UINT32 ramp_pos, UINT32 ramp_step)
+{
+	SIZE_T n_sample = 0u;
+	__m256i pos_lo;
+	__m256i pos_hi;
+	__m256i step;
+
+	pos_lo = _mm256_add_epi32(_mm256_set1_epi32((INT32) ramp_pos), _mm256_mullo_epi32(_mm256_set1_epi32((INT32) ramp_step), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+	pos_hi = _mm256_add_epi32(pos_lo, _mm256_set1_epi32((INT32) (8u*ramp_step)));
+	step = _mm256_set1_epi32((INT32) (16u*ramp_step));
+
+	for(n_sample = 0u; (n_sample + 16u) <= n_samples; n_sample += 16u)
+	{
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample], dspkernel_xfade_epi32_avx2(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample]), _mm256_loadu_si256((const __m256i*) &p_old[n_sample]), _mm256_srli_epi32(pos_lo, 16)));
+		_mm256_storeu_si256((__m256i*) &p_acc[n_sample + 8u], dspkernel_xfade_epi32_avx2(_mm256_loadu_si256((const __m256i*) &p_acc[n_sample + 8u]), _mm256_loadu_si256((const __m256i*) &p_old[n_sample + 8u]), _mm256_srli_epi32(pos_hi, 16)));
+
+		pos_lo = _mm256_add_epi32(pos_lo, step);
+		pos_hi = _mm256_add_epi32(pos_hi, step);
+	}
+
+	dspkernel_xfade_i32_scalar(&p_acc[n_sample], &p_old[n_sample], (n_samples - n_sample), (ramp_pos + ((UINT32) n_sample)*ramp_step), ramp_step);
+	return;
+}
+
+static const dspkernel_table_t DSPKERNEL_TABLE_AVX2 = {
+	.p_widen_i16 = &dspkernel_widen_i16_avx2,
+	.p_accumulate_i16 = &dspkernel_accumulate_i16_avx2,
+	.p_accumulate_i32 = &dspkernel_accumulate_i32_avx2,
+	.p_accumulate2_i16 = &dspkernel_accumulate2_i16_avx2,
+	.p_accumulate2_i32 = &dspkernel_accumulate2_i32_avx2,
+	.p_saturate_i16 = &dspkernel_saturate_i16_avx2,
+	.p_saturate_i24 = &dspkernel_saturate_i24_avx2,
+	.p_unpack_i24 = &dspkernel_unpack_i24_avx2,
+	.p_comb_i16 = &dspkernel_comb_i16_avx2,
+	.p_comb_i32 = &dspkernel_comb_i32_avx2,
+	.p_xfade_i32 = &dspkernel_xfade_i32_avx2,
+	.isa = DSPKERNEL_ISA_AVX2
+};
+
+#endif /*__DSPKERNEL_X86*/
+
+/*======================================================================================*/
+/*NEON Kernels (4 samples per register, 8 samples per loop cycle)*/
+
+#ifdef __DSPKERNEL_NEON
+
+/*
+	Tap term for 4 INT32 samples.
+	shift: negative gain shift on all lanes (vshlq_u64 shifts right with a negative count).
+*/
+
+static inline int32x4_t dspkernel_tap_s32_neon(int32x4_t x, uint32x2_t mul, int64x2_t shift, int32x4_t pol_mask)
+{
+	int32x4_t sign_mask;
+	uint32x4_t magnitude;
+	uint64x2_t q_lo;
+	uint64x2_t q_hi;
+
+	sign_mask = vshrq_n_s32(x, 31);
+	magnitude = vreinterpretq_u32_s32(vabsq_s32(x));
+
+	q_lo = vshlq_u64(vmull_u32(vget_low_u32(magnitude), mul), shift);
+	q_hi = vshlq_u64(vmull_u32(vget_high_u32(magnitude), mul), shift);
+
+	x = vreinterpretq_s32_u32(vcombine_u32(vmovn_u64(q_lo), vmovn_u64(q_hi)));
+
+	sign_mask = veorq_s32(sign_mask, pol_mask);
+	return vsubq_s32(veorq_s32(x, sign_mask), sign_mask);
+}
+
+/*Tap term for 4 INT32 samples, power of 2 divider (mul == 1). shift: negative gain shift on all lanes.*/
+
+static inline int32x4_t dspkernel_tapshift_s32_neon(int32x4_t x, int32x4_t shift, int32x4_t pol_mask)
+{
+	int32x4_t sign_mask;
+
+	sign_mask = veorq_s32(vshrq_n_s32(x, 31), pol_mask);
+	x = vreinterpretq_s32_u32(vshlq_u32(vreinterpretq_u32_s32(vabsq_s32(x)), shift));
+
+	return vsubq_s32(veorq_s32(x, sign_mask), sign_mask);
+}
+
+static inline int32x4_t dspkernel_tapgain_s32_neon(int32x4_t x, const dspkernel_gain_t *p_gain, uint32x2_t mul, int64x2_t shift, int32x4_t shift32, int32x4_t pol_mask)
+{
+	if(p_gain->mul == 1u) return dspkernel_tapshift_s32_neon(x, shift32, pol_mask);
+
+	return dspkernel_tap_s32_neon(x, mul, shift, pol_mask);
+}
+
+static inline int32x4_t dspkernel_half_s32_neon(int32x4_t x)
+{
+	return vshrq_n_s32(vaddq_s32(x, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(x), 31))), 1);
+}
+
+static VOID WINAPI dspkernel_widen_i16_neon(INT32 *p_acc, const INT16 *p_src, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+	int16x8_t x;
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x = vld1q_s16(&p_src[n_sample]);
+
+		vst1q_s32(&p_acc[n_sample], vmovl_s16(vget_low_s16(x)));
+		vst1q_s32(&p_acc[n_sample + 4u], vmovl_s16(vget_high_s16(x)));
+	}
+
+	dspkernel_widen_i16_scalar(&p_acc[n_sample], &p_src[n_sample], (n_samples - n_sample));
+	return;
+}
+
+static VOID WINAPI dspkernel_accumulate_i16_neon(INT32 *p_acc, const INT16 *p_src, SIZE_T n_samples, const dspkernel_gain_t *p_gain)
+{
+	SIZE_T n_sample = 0u;
+	uint32x2_t mul;
+	int64x2_t shift;
+	int32x4_t shift32;
+	int32x4_t pol_mask;
+	int32x4_t x_lo;
+	int32x4_t x_hi;
+	int16x8_t x;
+
+	mul = vdup_n_u32(p_gain->mul);
+	shift = vdupq_n_s64(-((INT64) p_gain->shift));
+	shift32 = vdupq_n_s32(-((INT32) p_gain->shift));
+	pol_mask = vdupq_n_s32(p_gain->pol_mask);
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x = vld1q_s16(&p_src[n_sample]);
+
+		x_lo = vmovl_s16(vget_low_s16(x));
+		x_hi = vmovl_s16(vget_high_s16(x));
+
+		if(p_gain->mul == 1u)
+		{
+			x_lo = dspkernel_tapshift_s32_neon(x_lo, shift32, pol_mask);
+			x_hi = dspkernel_tapshift_s32_neon(x_hi, shift32, pol_mask);
+		}
+		else
+		{
+			x_lo = dspkernel_tap_s32_neon(x_lo, mul, shift, pol_mask);
+			x_hi = dspkernel_tap_s32_neon(x_hi, mul, shift, pol_mask);
+		}
+
+		vst1q_s32(&p_acc[n_sample], vaddq_s32(vld1q_s32(&p_acc[n_sample]), x_lo));
+		vst1q_s32(&p_acc[n_sample + 4u], vaddq_s32(vld1q_s32(&p_acc[n_sample + 4u]), x_hi));
+	}
+
+	dspkernel_accumulate_i16_scalar(&p_acc[n_sample], &p_src[n_sample], (n_samples - n_sample), p_gain);
+	return;
+}
+
+static VOID WINAPI dspkernel_accumulate_i32_neon(INT32 *p_acc, const INT32 *p_src, SIZE_T n_samples, const dspkernel_gain_t *p_gain)
+{
+	SIZE_T n_sample = 0u;
+	uint32x2_t mul;
+	int64x2_t shift;
+	int32x4_t shift32;
+	int32x4_t pol_mask;
+	int32x4_t x_lo;
+	int32x4_t x_hi;
+
+	mul = vdup_n_u32(p_gain->mul);
+	shift = vdupq_n_s64(-((INT64) p_gain->shift));
+	shift32 = vdupq_n_s32(-((INT32) p_gain->shift));
+	pol_mask = vdupq_n_s32(p_gain->pol_mask);
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x_lo = vld1q_s32(&p_src[n_sample]);
+		x_hi = vld1q_s32(&p_src[n_sample + 4u]);
+
+		if(p_gain->mul == 1u)
+		{
+			x_lo = dspkernel_tapshift_s32_neon(x_lo, shift32, pol_mask);
+			x_hi = dspkernel_tapshift_s32_neon(x_hi, shift32, pol_mask);
+		}
+		else
+		{
+			x_lo = dspkernel_tap_s32_neon(x_lo, mul, shift, pol_mask);
+			x_hi = dspkernel_tap_s32_neon(x_hi, mul, shift, pol_mask);
+		}
+
+		vst1q_s32(&p_acc[n_sample], vaddq_s32(vld1q_s32(&p_acc[n_sample]), x_lo));
+		vst1q_s32(&p_acc[n_sample + 4u], vaddq_s32(vld1q_s32(&p_acc[n_sample + 4u]), x_hi));
+	}
+
+	dspkernel_accumulate_i32_scalar(&p_acc[n_sample], &p_src[n_sample], (n_samples - n_sample), p_gain);
+	return;
+}
+
+static VOID WINAPI dspkernel_accumulate2_i16_neon(INT32 *p_acc, const INT16 *p_src1, const INT16 *p_src2, SIZE_T n_samples, const dspkernel_gain_t *p_gains)
+{
+	SIZE_T n_sample = 0u;
+	uint32x2_t mul1;
+	uint32x2_t mul2;
+	int64x2_t shift1;
+	int64x2_t shift2;
+	int32x4_t shift32_1;
+	int32x4_t shift32_2;
+	int32x4_t pol_mask1;
+	int32x4_t pol_mask2;
+	int32x4_t x_lo;
+	int32x4_t x_hi;
+	int16x8_t x1;
+	int16x8_t x2;
+
+	mul1 = vdup_n_u32(p_gains[0].mul);
+	mul2 = vdup_n_u32(p_gains[1].mul);
+	shift1 = vdupq_n_s64(-((INT64) p_gains[0].shift));
+	shift2 = vdupq_n_s64(-((INT64) p_gains[1].shift));
+	shift32_1 = vdupq_n_s32(-((INT32) p_gains[0].shift));
+	shift32_2 = vdupq_n_s32(-((INT32) p_gains[1].shift));
+	pol_mask1 = vdupq_n_s32(p_gains[0].pol_mask);
+	pol_mask2 = vdupq_n_s32(p_gains[1].pol_mask);
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x1 = vld1q_s16(&p_src1[n_sample]);
+		x2 = vld1q_s16(&p_src2[n_sample]);
+
+		x_lo = vaddq_s32(dspkernel_tapgain_s32_neon(vmovl_s16(vget_low_s16(x1)), &p_gains[0], mul1, shift1, shift32_1, pol_mask1), dspkernel_tapgain_s32_neon(vmovl_s16(vget_low_s16(x2)), &p_gains[1], mul2, shift2, shift32_2, pol_mask2));
+		x_hi = vaddq_s32(dspkernel_tapgain_s32_neon(vmovl_s16(vget_high_s16(x1)), &p_gains[0], mul1, shift1, shift32_1, pol_mask1), dspkernel_tapgain_s32_neon(vmovl_s16(vget_high_s16(x2)), &p_gains[1], mul2, shift2, shift32_2, pol_mask2));
+
+		vst1q_s32(&p_acc[n_sample], vaddq_s32(vld1q_s32(&p_acc[n_sample]), x_lo));
+		vst1q_s32(&p_acc[n_sample + 4u], vaddq_s32(vld1q_s32(&p_acc[n_sample + 4u]), x_hi));
+	}
+
+	dspkernel_accumulate2_i16_scalar(&p_acc[n_sample], &p_src1[n_sample], &p_src2[n_sample], (n_samples - n_sample), p_gains);
+	return;
+}
+
+static VOID WINAPI dspkernel_accumulate2_i32_neon(INT32 *p_acc, const INT32 *p_src1, const INT32 *p_src2, SIZE_T n_samples, const dspkernel_gain_t *p_gains)
+{
+	SIZE_T n_sample = 0u;
+	uint32x2_t mul1;
+	uint32x2_t mul2;
+	int64x2_t shift1;
+	int64x2_t shift2;
+	int32x4_t shift32_1;
+	int32x4_t shift32_2;
+	int32x4_t pol_mask1;
+	int32x4_t pol_mask2;
+	int32x4_t x_lo;
+	int32x4_t x_hi;
+
+	mul1 = vdup_n_u32(p_gains[0].mul);
+	mul2 = vdup_n_u32(p_gains[1].mul);
+	shift1 = vdupq_n_s64(-((INT64) p_gains[0].shift));
+	shift2 = vdupq_n_s64(-((INT64) p_gains[1].shift));
+	shift32_1 = vdupq_n_s32(-((INT32) p_gains[0].shift));
+	shift32_2 = vdupq_n_s32(-((INT32) p_gains[1].shift));
+	pol_mask1 = vdupq_n_s32(p_gains[0].pol_mask);
+	pol_mask2 = vdupq_n_s32(p_gains[1].pol_mask);
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x_lo = vaddq_s32(dspkernel_tapgain_s32_neon(vld1q_s32(&p_src1[n_sample]), &p_gains[0], mul1, shift1, shift32_1, pol_mask1), dspkernel_tapgain_s32_neon(vld1q_s32(&p_src2[n_sample]), &p_gains[1], mul2, shift2, shift32_2, pol_mask2));
+		x_hi = vaddq_s32(dspkernel_tapgain_s32_neon(vld1q_s32(&p_src1[n_sample + 4u]), &p_gains[0], mul1, shift1, shift32_1, pol_mask1), dspkernel_tapgain_s32_neon(vld1q_s32(&p_src2[n_sample + 4u]), &p_gains[1], mul2, shift2, shift32_2, pol_mask2));
+
+		vst1q_s32(&p_acc[n_sample], vaddq_s32(vld1q_s32(&p_acc[n_sample]), x_lo));
+		vst1q_s32(&p_acc[n_sample + 4u], vaddq_s32(vld1q_s32(&p_acc[n_sample + 4u]), x_hi));
+	}
+
+	dspkernel_accumulate2_i32_scalar(&p_acc[n_sample], &p_src1[n_sample], &p_src2[n_sample], (n_samples - n_sample), p_gains);
+	return;
+}
+
+static VOID WINAPI dspkernel_saturate_i16_neon(INT16 *p_out, const INT32 *p_acc, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+	int32x4_t x_lo;
+	int32x4_t x_hi;
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x_lo = dspkernel_half_s32_neon(vld1q_s32(&p_acc[n_sample]));
+		x_hi = dspkernel_half_s32_neon(vld1q_s32(&p_acc[n_sample + 4u]));
+
+		/*vqmovn_s32 narrows INT32 to INT16 with signed saturation*/
+		vst1q_s16(&p_out[n_sample], vcombine_s16(vqmovn_s32(x_lo), vqmovn_s32(x_hi)));
+	}
+
+	dspkernel_saturate_i16_scalar(&p_out[n_sample], &p_acc[n_sample], (n_samples - n_sample));
+	return;
+}
+
+static VOID WINAPI dspkernel_saturate_i24_neon(INT32 *p_out, const INT32 *p_acc, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+	int32x4_t max_value;
+	int32x4_t min_value;
+	int32x4_t x_lo;
+	int32x4_t x_hi;
+
+	max_value = vdupq_n_s32(I24_MAX_VALUE);
+	min_value = vdupq_n_s32(I24_MIN_VALUE);
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x_lo = dspkernel_half_s32_neon(vld1q_s32(&p_acc[n_sample]));
+		x_hi = dspkernel_half_s32_neon(vld1q_s32(&p_acc[n_sample + 4u]));
+
+		x_lo = vmaxq_s32(vminq_s32(x_lo, max_value), min_value);
+		x_hi = vmaxq_s32(vminq_s32(x_hi, max_value), min_value);
+
+		vst1q_s32(&p_out[n_sample], vshlq_n_s32(x_lo, 8));
+		vst1q_s32(&p_out[n_sample + 4u], vshlq_n_s32(x_hi, 8));
+	}
+
+	dspkernel_saturate_i24_scalar(&p_out[n_sample], &p_acc[n_sample], (n_samples - n_sample));
+	return;
+}
+
+static VOID WINAPI dspkernel_unpack_i24_neon(INT32 *p_out, const BYTE *p_src, SIZE_T n_samples)
+{
+	SIZE_T n_sample = 0u;
+	uint8x8x3_t x;
+	uint16x8_t x_low;
+	int16x8_t x_high;
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		/*vld3_u8 deinterleaves the 3 bytes of each sample: val[0] = bits 0-7, val[1] = bits 8-15, val[2] = bits 16-23 (sign)*/
+		x = vld3_u8(&p_src[3u*n_sample]);
+
+		x_low = vorrq_u16(vmovl_u8(x.val[0]), vshll_n_u8(x.val[1], 8));
+		x_high = vmovl_s8(vreinterpret_s8_u8(x.val[2]));
+
+		vst1q_s32(&p_out[n_sample], vorrq_s32(vshll_n_s16(vget_low_s16(x_high), 16), vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(x_low)))));
+		vst1q_s32(&p_out[n_sample + 4u], vorrq_s32(vshll_n_s16(vget_high_s16(x_high), 16), vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(x_low)))));
+	}
+
+	dspkernel_unpack_i24_scalar(&p_out[n_sample], &p_src[3u*n_sample], (n_samples - n_sample));
+	return;
+}
+
+/*Recursive comb step for 4 INT32 samples. frac_bits: positive shift on all lanes, corr_shift: negative shift on all lanes.*/
+
+static inline int32x4_t dspkernel_comb_s32_neon(int32x4_t x, int32x4_t state, int32x4_t x_corr, BOOL corr, int32x4_t frac_bits, int32x4_t corr_shift, int32x4_t pol_mask, int32x4_t corr_pol_mask)
+{
+	int32x4_t y;
+
+	y = vaddq_s32(vshlq_s32(x, frac_bits), state);
+	y = vshrq_n_s32(vsubq_s32(veorq_s32(y, pol_mask), pol_mask), 1);
+
+	if(corr)
+	{
+		x_corr = vshlq_s32(vshlq_s32(x_corr, frac_bits), corr_shift);
+		y = vsubq_s32(y, vsubq_s32(veorq_s32(x_corr, corr_pol_mask), corr_pol_mask));
+	}
+
+	return y;
+}
+
+static VOID WINAPI dspkernel_comb_i16_neon(INT32 *p_state, INT32 *p_acc, const INT16 *p_src, const INT32 *p_state_src, const INT16 *p_corr_src, SIZE_T n_samples, const dspkernel_comb_t *p_comb)
+{
+	SIZE_T n_sample = 0u;
+	BOOL corr = FALSE;
+	int32x4_t frac_bits;
+	int32x4_t frac_bits_neg;
+	int32x4_t corr_shift;
+	int32x4_t pol_mask;
+	int32x4_t corr_pol_mask;
+	int32x4_t round;
+	int16x8_t x;
+	int16x8_t x_corr;
+	int32x4_t x_corr_lo;
+	int32x4_t x_corr_hi;
+	int32x4_t y_lo;
+	int32x4_t y_hi;
+
+	corr = (p_corr_src != NULL);
+
+	frac_bits = vdupq_n_s32((INT32) p_comb->frac_bits);
+	frac_bits_neg = vdupq_n_s32(-((INT32) p_comb->frac_bits));
+	corr_shift = vdupq_n_s32(-((INT32) p_comb->corr_shift));
+	pol_mask = vdupq_n_s32(p_comb->pol_mask);
+	corr_pol_mask = vdupq_n_s32(p_comb->corr_pol_mask);
+	round = vdupq_n_s32(1 << (p_comb->frac_bits - 1u));
+
+	x_corr_lo = vdupq_n_s32(0);
+	x_corr_hi = vdupq_n_s32(0);
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		x = vld1q_s16(&p_src[n_sample]);
+
+		if(corr)
+		{
+			x_corr = vld1q_s16(&p_corr_src[n_sample]);
+			x_corr_lo = vmovl_s16(vget_low_s16(x_corr));
+			x_corr_hi = vmovl_s16(vget_high_s16(x_corr));
+		}
+
+		y_lo = dspkernel_comb_s32_neon(vmovl_s16(vget_low_s16(x)), vld1q_s32(&p_state_src[n_sample]), x_corr_lo, corr, frac_bits, corr_shift, pol_mask, corr_pol_mask);
+		y_hi = dspkernel_comb_s32_neon(vmovl_s16(vget_high_s16(x)), vld1q_s32(&p_state_src[n_sample + 4u]), x_corr_hi, corr, frac_bits, corr_shift, pol_mask, corr_pol_mask);
+
+		vst1q_s32(&p_state[n_sample], y_lo);
+		vst1q_s32(&p_state[n_sample + 4u], y_hi);
+
+		vst1q_s32(&p_acc[n_sample], vaddq_s32(vld1q_s32(&p_acc[n_sample]), vshlq_s32(vaddq_s32(y_lo, round), frac_bits_neg)));
+		vst1q_s32(&p_acc[n_sample + 4u], vaddq_s32(vld1q_s32(&p_acc[n_sample + 4u]), vshlq_s32(vaddq_s32(y_hi, round), frac_bits_neg)));
+	}
+
+	if(corr) dspkernel_comb_i16_scalar(&p_state[n_sample], &p_acc[n_sample], &p_src[n_sample], &p_state_src[n_sample], &p_corr_src[n_sample], (n_samples - n_sample), p_comb);
+	else dspkernel_comb_i16_scalar(&p_state[n_sample], &p_acc[n_sample], &p_src[n_sample], &p_state_src[n_sample], NULL, (n_samples - n_sample), p_comb);
+
+	return;
+}
+
+static VOID WINAPI dspkernel_comb_i32_neon(INT32 *p_state, INT32 *p_acc, const INT32 *p_src, const INT32 *p_state_src, const INT32 *p_corr_src, SIZE_T n_samples, const dspkernel_comb_t *p_comb)
+{
+	SIZE_T n_sample = 0u;
+	BOOL corr = FALSE;
+	int32x4_t frac_bits;
+	int32x4_t frac_bits_neg;
+	int32x4_t corr_shift;
+	int32x4_t pol_mask;
+	int32x4_t corr_pol_mask;
+	int32x4_t round;
+	int32x4_t x_corr_lo;
+	int32x4_t x_corr_hi;
+	int32x4_t y_lo;
+	int32x4_t y_hi;
+
+	corr = (p_corr_src != NULL);
+
+	frac_bits = vdupq_n_s32((INT32) p_comb->frac_bits);
+	frac_bits_neg = vdupq_n_s32(-((INT32) p_comb->frac_bits));
+	corr_shift = vdupq_n_s32(-((INT32) p_comb->corr_shift));
+	pol_mask = vdupq_n_s32(p_comb->pol_mask);
+	corr_pol_mask = vdupq_n_s32(p_comb->corr_pol_mask);
+	round = vdupq_n_s32(1 << (p_comb->frac_bits - 1u));
+
+	x_corr_lo = vdupq_n_s32(0);
+	x_corr_hi = vdupq_n_s32(0);
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		if(corr)
+		{
+			x_corr_lo = vld1q_s32(&p_corr_src[n_sample]);
+			x_corr_hi = vld1q_s32(&p_corr_src[n_sample + 4u]);
+		}
+
+		y_lo = dspkernel_comb_s32_neon(vld1q_s32(&p_src[n_sample]), vld1q_s32(&p_state_src[n_sample]), x_corr_lo, corr, frac_bits, corr_shift, pol_mask, corr_pol_mask);
+		y_hi = dspkernel_comb_s32_neon(vld1q_s32(&p_src[n_sample + 4u]), vld1q_s32(&p_state_src[n_sample + 4u]), x_corr_hi, corr, frac_bits, corr_shift, pol_mask, corr_pol_mask);
+
+		vst1q_s32(&p_state[n_sample], y_lo);
+		vst1q_s32(&p_state[n_sample + 4u], y_hi);
+
+		vst1q_s32(&p_acc[n_sample], vaddq_s32(vld1q_s32(&p_acc[n_sample]), vshlq_s32(vaddq_s32(y_lo, round), frac_bits_neg)));
+		vst1q_s32(&p_acc[n_sample + 4u], vaddq_s32(vld1q_s32(&p_acc[n_sample + 4u]), vshlq_s32(vaddq_s32(y_hi, round), frac_bits_neg)));
+	}
+
+	if(corr) dspkernel_comb_i32_scalar(&p_state[n_sample], &p_acc[n_sample], &p_src[n_sample], &p_state_src[n_sample], &p_corr_src[n_sample], (n_samples - n_sample), p_comb);
+	else dspkernel_comb_i32_scalar(&p_state[n_sample], &p_acc[n_sample], &p_src[n_sample], &p_state_src[n_sample], NULL, (n_samples - n_sample), p_comb);
+
+	return;
+}
+
+/*Crossfade step for 4 INT32 samples. w: crossfade weight (16 bits) on all lanes.*/
+
+static inline int32x4_t dspkernel_xfade_s32_neon(int32x4_t x, int32x4_t x_old, uint32x4_t w)
+{
+	int32x4_t sign_mask;
+	uint32x4_t magnitude;
+	uint64x2_t q_lo;
+	uint64x2_t q_hi;
+
+	x = vsubq_s32(x, x_old);
+	sign_mask = vshrq_n_s32(x, 31);
+	magnitude = vreinterpretq_u32_s32(vabsq_s32(x));
+
+	q_lo = vshrq_n_u64(vmull_u32(vget_low_u32(magnitude), vget_low_u32(w)), 16);
+	q_hi = vshrq_n_u64(vmull_u32(vget_high_u32(magnitude), vget_high_u32(w)), 16);
+
+	x = vreinterpretq_s32_u32(vcombine_u32(vmovn_u64(q_lo), vmovn_u64(q_hi)));
+
+	return vaddq_s32(x_old, vsubq_s32(veorq_s32(x, sign_mask), sign_mask));
+}
+
+static VOID WINAPI dspkernel_xfade_i32_neon(INT32 *p_acc, const INT32 *p_old, SIZE_T n_samples, UINT32 ramp_pos, UINT32 ramp_step)
+{
+	SIZE_T n_sample = 0u;
+	const UINT32 offset[4] = {0u, 1u, 2u, 3u};
+	uint32x4_t pos_lo;
+	uint32x4_t pos_hi;
+	uint32x4_t step;
+
+	pos_lo = vmlaq_n_u32(vdupq_n_u32(ramp_pos), vld1q_u32(offset), ramp_step);
+	pos_hi = vaddq_u32(pos_lo, vdupq_n_u32(4u*ramp_step));
+	step = vdupq_n_u32(8u*ramp_step);
+
+	for(n_sample = 0u; (n_sample + 8u) <= n_samples; n_sample += 8u)
+	{
+		vst1q_s32(&p_acc[n_sample], dspkernel_xfade_s32_neon(vld1q_s32(&p_acc[n_sample]), vld1q_s32(&p_old[n_sample]), vshrq_n_u32(pos_lo, 16)));
+		vst1q_s32(&p_acc[n_sample + 4u], dspkernel_xfade_s32_neon(vld1q_s32(&p_acc[n_sample + 4u]), vld1q_s32(&p_old[n_sample + 4u]), vshrq_n_u32(pos_hi, 16)));
+
+		pos_lo = vaddq_u32(pos_lo, step);
+		pos_hi = vaddq_u32(pos_hi, step);
+	}
+
+	dspkernel_xfade_i32_scalar(&p_acc[n_sample], &p_old[n_sample], (n_samples - n_sample), (ramp_pos + ((UINT32) n_sample)*ramp_step), ramp_step);
+	return;
+}
+
+static const dspkernel_table_t DSPKERNEL_TABLE_NEON = {
+	.p_widen_i16 = &dspkernel_widen_i16_neon,
+	.p_accumulate_i16 = &dspkernel_accumulate_i16_neon,
+	.p_accumulate_i32 = &dspkernel_accumulate_i32_neon,
+	.p_accumulate2_i16 = &dspkernel_accumulate2_i16_neon,
+	.p_accumulate2_i32 = &dspkernel_accumulate2_i32_neon,
+	.p_saturate_i16 = &dspkernel_saturate_i16_neon,
+	.p_saturate_i24 = &dspkernel_saturate_i24_neon,
+	.p_unpack_i24 = &dspkernel_unpack_i24_neon,
+	.p_comb_i16 = &dspkernel_comb_i16_neon,
+	.p_comb_i32 = &dspkernel_comb_i32_neon,
+	.p_xfade_i32 = &dspkernel_xfade_i32_neon,
+	.isa = DSPKERNEL_ISA_NEON
+};
+
+#endif /*__DSPKERNEL_NEON*/
+
+/*======================================================================================*/
+/*Runtime Dispatch*/
+
+static const dspkernel_table_t *p_dspkernel_table = NULL;
+
+VOID WINAPI dspkernel_init(VOID)
+{
+	if(p_dspkernel_table != NULL) return;
+
+	if(dspkernel_select_isa(DSPKERNEL_ISA_AVX2)) return;
+	if(dspkernel_select_isa(DSPKERNEL_ISA_NEON)) return;
+	if(dspkernel_select_isa(DSPKERNEL_ISA_SSE2)) return;
+
+	dspkernel_select_isa(DSPKERNEL_ISA_SCALAR);
+	return;
+}
+
+BOOL WINAPI dspkernel_select_isa(INT isa)
+{
+	if(!dspkernel_isa_supported(isa)) return FALSE;
+
+	switch(isa)
+	{
+		case DSPKERNEL_ISA_SCALAR:
+			p_dspkernel_table = &DSPKERNEL_TABLE_SCALAR;
+			return TRUE;
+
+#ifdef __DSPKERNEL_X86
+		case DSPKERNEL_ISA_SSE2:
+			p_dspkernel_table = &DSPKERNEL_TABLE_SSE2;
+			return TRUE;
+
+		case DSPKERNEL_ISA_AVX2:
+			p_dspkernel_table = &DSPKERNEL_TABLE_AVX2;
+			return TRUE;
+#endif
+
+#ifdef __DSPKERNEL_NEON
+		case DSPKERNEL_ISA_NEON:
+			p_dspkernel_table = &DSPKERNEL_TABLE_NEON;
+			return TRUE;
+#endif
+	}
+
+	return FALSE;
+}
+
+BOOL WINAPI dspkernel_isa_supported(INT isa)
+{
+	switch(isa)
+	{
+		case DSPKERNEL_ISA_SCALAR:
+			return TRUE;
+
+#ifdef __DSPKERNEL_X86
+		case DSPKERNEL_ISA_SSE2:
+			__builtin_cpu_init();
+			return (__builtin_cpu_supports("sse2") != 0);
+
+		case DSPKERNEL_ISA_AVX2:
+			__builtin_cpu_init();
+			return (__builtin_cpu_supports("avx2") != 0);
+#endif
+
+#ifdef __DSPKERNEL_NEON
+		case DSPKERNEL_ISA_NEON:
+			return TRUE;
+#endif
+	}
+
+	return FALSE;
+}
+
+const dspkernel_table_t* WINAPI dspkernel_get_table(VOID)
+{
+	if(p_dspkernel_table == NULL) dspkernel_init();
+
+	return p_dspkernel_table;
+}
@@ -0,0 +1,145 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+/*
+	DSP Kernels:
+
+	These are the inner loops of the DSP (widen, accumulate feedback tap, saturate/narrow, crossfade),
+	each one working over a contiguous span of samples.
+
+	Every kernel has a scalar implementation and vectorized implementations (SSE2, AVX2 on x86/x64, NEON on ARM64).
+	The best implementation supported by the running CPU is selected at runtime by dspkernel_init().
+	All implementations produce the exact same output.
+*/
+
+#ifndef AUDIORTDSP_KERNEL_HPP
+#define AUDIORTDSP_KERNEL_HPP
+
+#include "globldef.h"
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define __DSPKERNEL_X86
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define __DSPKERNEL_NEON
+#endif
+
+#define DSPKERNEL_ISA_SCALAR 0
+#define DSPKERNEL_ISA_SSE2 1
+#define DSPKERNEL_ISA_AVX2 2
+#define DSPKERNEL_ISA_NEON 3
+
+/*
+	Feedback tap gain:
+
+	A feedback tap adds pol*sample/cycle_div to the output, where pol is either 1 or -1, with integer division (truncated towards zero).
+	Instead of dividing, the tap gain stores a precomputed fixed-point reciprocal of cycle_div:
+
+	pol*sample/cycle_div == sign(pol*sample)*((|sample|*mul) >> shift)
+
+	mul = ceil(2^shift/cycle_div), with shift large enough to make the result exact for any |sample| <= 2^24 (16bit and 24bit samples).
+	When cycle_div is a power of 2, mul is 1 and the tap is a plain shift.
+	mul is 0 when the tap is zero for every sample value (cycle_div > 2^24), these taps can be skipped.
+
+	pol_mask is 0 for pol == 1, all ones (-1) for pol == -1.
+*/
+
+struct _dspkernel_gain {
+	UINT32 mul;
+	UINT32 shift;
+	INT32 pol_mask;
+};
+
+typedef struct _dspkernel_gain dspkernel_gain_t;
+
+/*Initialize a tap gain from its divider and polarity (1 or -1).
+cycle_div must be greater than 0.*/
+
+extern VOID WINAPI dspkernel_gain_init_div(dspkernel_gain_t *p_gain, INT32 pol, UINT32 cycle_div);
+
+/*Initialize a tap gain from a power of 2 divider (cycle_div = 2^div_shift) and polarity (1 or -1).*/
+
+extern VOID WINAPI dspkernel_gain_init_shift(dspkernel_gain_t *p_gain, INT32 pol, UINT32 div_shift);
+
+/*
+	Recursive comb step:
+
+	With power of 2 dividers, the feedback taps pol^k*x[t - k*delay]/2^k (k = 1..K) are a truncated geometric series, so their sum s[t] follows
+
+	s[t] = (pol/2)*(x[t - delay] + s[t - delay]) - (pol/2)^(K + 1)*x[t - (K + 1)*delay]
+
+	A recursive comb plus one correction tap that removes the part of the series beyond tap K.
+	s[t] is kept in fixed point with frac_bits fractional bits (state = s*2^frac_bits). frac_bits = 31 - sample bits keeps the state within INT32.
+
+	pol_mask: 0 for pol == 1, all ones (-1) for pol == -1.
+	corr_pol_mask: polarity mask of (pol^(K + 1)).
+	corr_shift: K + 1.
+*/
+
+struct _dspkernel_comb {
+	INT32 pol_mask;
+	INT32 corr_pol_mask;
+	UINT32 frac_bits;
+	UINT32 corr_shift;
+};
+
+typedef struct _dspkernel_comb dspkernel_comb_t;
+
+/*
+	p_widen_i16: p_acc[n] = p_src[n]
+	p_accumulate_i16, p_accumulate_i32: p_acc[n] += pol*p_src[n]/cycle_div (see tap gain above). Requires |p_src[n]| <= 2^24.
+	p_accumulate2_i16, p_accumulate2_i32: two taps in one pass, p_acc[n] += (tap p_gains[0] of p_src1[n]) + (tap p_gains[1] of p_src2[n]). Same result as two p_accumulate calls.
+	p_saturate_i16: p_out[n] = clamp(p_acc[n]/2) (16bit)
+	p_saturate_i24: p_out[n] = (clamp(p_acc[n]/2) << 8) (24bit on a 32bit container). p_out may be the same as p_acc.
+	p_unpack_i24: p_out[n] = sample n of p_src (packed 24bit, 3 bytes per sample, little endian), sign extended. Never reads beyond p_src[3*n_samples - 1].
+
+	p_comb_i16, p_comb_i32: recursive comb step (see above), p_src[n] = x[t - delay], p_state_src[n] = state[t - delay], p_corr_src[n] = x[t - (K + 1)*delay]:
+	p_state[n] = (pol*((p_src[n] << frac_bits) + p_state_src[n])) >> 1 - corr_pol*((p_corr_src[n] << frac_bits) >> corr_shift)
+	p_acc[n] += round(p_state[n]/2^frac_bits)
+	p_corr_src may be NULL (no correction tap). p_state must not overlap p_state_src.
+
+	p_xfade_i32: crossfade from p_old to p_acc, p_acc[n] = p_old[n] + (p_acc[n] - p_old[n])*w[n]/2^16 (truncated towards zero),
+	with the weight w[n] = (ramp_pos + n*ramp_step) >> 16 (32bit wraparound). Requires |p_acc[n] - p_old[n]| < 2^31.
+*/
+
+struct _dspkernel_table {
+	VOID (WINAPI *p_widen_i16)(INT32 *p_acc, const INT16 *p_src, SIZE_T n_samples);
+	VOID (WINAPI *p_accumulate_i16)(INT32 *p_acc, const INT16 *p_src, SIZE_T n_samples, const dspkernel_gain_t *p_gain);
+	VOID (WINAPI *p_accumulate_i32)(INT32 *p_acc, const INT32 *p_src, SIZE_T n_samples, const dspkernel_gain_t *p_gain);
+	VOID (WINAPI *p_accumulate2_i16)(INT32 *p_acc, const INT16 *p_src1, const INT16 *p_src2, SIZE_T n_samples, const dspkernel_gain_t *p_gains);
+	VOID (WINAPI *p_accumulate2_i32)(INT32 *p_acc, const INT32 *p_src1, const INT32 *p_src2, SIZE_T n_samples, const dspkernel_gain_t *p_gains);
+	VOID (WINAPI *p_saturate_i16)(INT16 *p_out, const INT32 *p_acc, SIZE_T n_samples);
+	VOID (WINAPI *p_saturate_i24)(INT32 *p_out, const INT32 *p_acc, SIZE_T n_samples);
+	VOID (WINAPI *p_unpack_i24)(INT32 *p_out, const BYTE *p_src, SIZE_T n_samples);
+	VOID (WINAPI *p_comb_i16)(INT32 *p_state, INT32 *p_acc, const INT16 *p_src, const INT32 *p_state_src, const INT16 *p_corr_src, SIZE_T n_samples, const dspkernel_comb_t *p_comb);
+	VOID (WINAPI *p_comb_i32)(INT32 *p_state, INT32 *p_acc, const INT32 *p_src, const INT32 *p_state_src, const INT32 *p_corr_src, SIZE_T n_samples, const dspkernel_comb_t *p_comb);
+	VOID (WINAPI *p_xfade_i32)(INT32 *p_acc, const INT32 *p_old, SIZE_T n_samples, UINT32 ramp_pos, UINT32 ramp_step);
+	INT isa;
+};
+
+typedef struct _dspkernel_table dspkernel_table_t;
+
+/*Select the best kernel implementation for the running CPU. Safe to call more than once.*/
+
+extern VOID WINAPI dspkernel_init(VOID);
+
+/*Force a specific kernel implementation (DSPKERNEL_ISA_...).
+Returns FALSE if the given ISA is not supported by the running CPU/build.*/
+
+extern BOOL WINAPI dspkernel_select_isa(INT isa);
+
+/*Check if a specific kernel implementation is supported by the running CPU/build.*/
+
+extern BOOL WINAPI dspkernel_isa_supported(INT isa);
+
+/*Get the currently selected kernel table. Calls dspkernel_init() if needed.*/
+
+extern const dspkernel_table_t* WINAPI dspkernel_get_table(VOID);
+
+#endif /*AUDIORTDSP_KERNEL_HPP*/
@@ -0,0 +1,129 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+#include "AudioRTDSP_wavfile.hpp"
+
+static BOOL WINAPI wavfile_compare_signature(const CHAR *auth, const CHAR *buf)
+{
+	if(auth == NULL) return FALSE;
+	if(buf == NULL) return FALSE;
+
+	if(auth[0] != buf[0]) return FALSE;
+	if(auth[1] != buf[1]) return FALSE;
+	if(auth[2] != buf[2]) return FALSE;
+	if(auth[3] != buf[3]) return FALSE;
+
+	return TRUE;
+}
+
+BOOL WINAPI audiortdsp_wavfile_get_params(HANDLE h_file, audiortdsp_pb_params_t *p_params, UINT16 *p_bit_depth, __string *p_err_msg)
+{
+	const SIZE_T BUFFER_SIZE = 4096u;
+	SIZE_T buffer_index = 0u;
+
+	UINT8 *p_headerinfo = NULL;
+
+	DWORD dummy_32;
+
+	UINT32 u32 = 0u;
+	UINT16 u16 = 0u;
+
+	__string err_msg = TEXT("");
+
+	if((h_file == INVALID_HANDLE_VALUE) || (p_params == NULL) || (p_bit_depth == NULL))
+	{
+		err_msg = TEXT("Error: invalid arguments.");
+		goto _l_wavfile_get_params_error;
+	}
+
+	p_headerinfo = (UINT8*) HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, BUFFER_SIZE);
+	if(p_headerinfo == NULL)
+	{
+		err_msg = TEXT("Error: memory allocate failed.");
+		goto _l_wavfile_get_params_error;
+	}
+
+	SetFilePointer(h_file, 0, NULL, FILE_BEGIN);
+	ReadFile(h_file, p_headerinfo, (DWORD) BUFFER_SIZE, &dummy_32, NULL);
+
+	if(!wavfile_compare_signature("RIFF", (const CHAR*) p_headerinfo))
+	{
+		err_msg = TEXT("Error: file format not supported.");
+		goto _l_wavfile_get_params_error;
+	}
+
+	if(!wavfile_compare_signature("WAVE", (const CHAR*) (((SIZE_T) p_headerinfo) + 8u)))
+	{
+		err_msg = TEXT("Error: file format not supported.");
+		goto _l_wavfile_get_params_error;
+	}
+
+	buffer_index = 12u;
+
+	while(TRUE)
+	{
+		if(buffer_index > (BUFFER_SIZE - 8u))
+		{
+			err_msg = TEXT("Error: broken header (missing subchunk \"fmt \").\r\nFile probably corrupted.");
+			goto _l_wavfile_get_params_error;
+		}
+
+		if(wavfile_compare_signature("fmt ", (const CHAR*) (((SIZE_T) p_headerinfo) + buffer_index))) break;
+
+		u32 = *((UINT32*) (((SIZE_T) p_headerinfo) + buffer_index + 4u));
+		buffer_index += (SIZE_T) (u32 + 8u);
+	}
+
+	if(buffer_index > (BUFFER_SIZE - 24u))
+	{
+		err_msg = TEXT("Error: broken header (error on subchunk \"fmt \").\r\nFile probably corrupted.");
+		goto _l_wavfile_get_params_error;
+	}
+
+	u16 = *((UINT16*) (((SIZE_T) p_headerinfo) + buffer_index + 8u));
+
+	if(u16 != 1u)
+	{
+		err_msg = TEXT("Error: audio encoding format not supported.");
+		goto _l_wavfile_get_params_error;
+	}
+
+	p_params->n_channels = *((UINT16*) (((SIZE_T) p_headerinfo) + buffer_index + 10u));
+	p_params->sample_rate = *((UINT32*) (((SIZE_T) p_headerinfo) + buffer_index + 12u));
+	*p_bit_depth = *((UINT16*) (((SIZE_T) p_headerinfo) + buffer_index + 22u));
+
+	u32 = *((UINT32*) (((SIZE_T) p_headerinfo) + buffer_index + 4u));
+	buffer_index += (SIZE_T) (u32 + 8u);
+
+	while(TRUE)
+	{
+		if(buffer_index > (BUFFER_SIZE - 8u))
+		{
+			err_msg = TEXT("Error: broken header (missing subchunk \"data\").\r\nFile probably corrupted.");
+			goto _l_wavfile_get_params_error;
+		}
+
+		if(wavfile_compare_signature("data", (const CHAR*) (((SIZE_T) p_headerinfo) + buffer_index))) break;
+
+		u32 = *((UINT32*) (((SIZE_T) p_headerinfo) + buffer_index + 4u));
+		buffer_index += (SIZE_T) (u32 + 8u);
+	}
+
+	u32 = *((UINT32*) (((SIZE_T) p_headerinfo) + buffer_index + 4u));
+
+	p_params->audio_data_begin = (ULONG64) (buffer_index + 8u);
+	p_params->audio_data_end = p_params->audio_data_begin + ((ULONG64) u32);
+
+	HeapFree(GetProcessHeap(), 0u, p_headerinfo);
+	return TRUE;
+
+_l_wavfile_get_params_error:
+	if(p_headerinfo != NULL) HeapFree(GetProcessHeap(), 0u, p_headerinfo);
+	if(p_err_msg != NULL) *p_err_msg = err_msg;
+	return FALSE;
+}
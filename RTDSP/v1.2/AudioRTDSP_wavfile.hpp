@@ -0,0 +1,35 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+/*
+	WAV File Header:
+
+	Reads the playback parameters (audio data position, sample rate, number of channels, bit depth) from the RIFF/WAVE header of an input file.
+	Only uses its arguments and local memory, so it's safe to call from multiple threads on different files.
+*/
+
+#ifndef AUDIORTDSP_WAVFILE_HPP
+#define AUDIORTDSP_WAVFILE_HPP
+
+#include "globldef.h"
+#include "strdef.hpp"
+#include "AudioRTDSP.hpp"
+
+/*
+	audiortdsp_wavfile_get_params(): parse the header of an open WAV file (h_file must have read access).
+
+	p_params: pointer to object that receives audio_data_begin, audio_data_end, sample_rate and n_channels (file_dir is left untouched).
+	p_bit_depth: pointer to variable that receives the bit depth (bits per sample).
+	p_err_msg: pointer to string that receives the error message on failure. Set to NULL if unused.
+
+	returns true if successful, false otherwise.
+*/
+
+extern BOOL WINAPI audiortdsp_wavfile_get_params(HANDLE h_file, audiortdsp_pb_params_t *p_params, UINT16 *p_bit_depth, __string *p_err_msg);
+
+#endif /*AUDIORTDSP_WAVFILE_HPP*/
@@ -1,13 +1,32 @@
-"C:\MinGW64\bin\g++.exe" globldef.c -c -std=c++11 -m32 -o globldef_32.o
-"C:\MinGW64\bin\g++.exe" cstrdef.c -c -std=c++11 -m32 -o cstrdef_32.o
-"C:\MinGW64\bin\g++.exe" thread.c -c -std=c++11 -m32 -o thread_32.o
-"C:\MinGW64\bin\g++.exe" strdef.cpp -c -std=c++11 -m32 -o strdef_32.o
-"C:\MinGW64\bin\g++.exe" main.cpp -c -std=c++11 -m32 -o main_32.o
-"C:\MinGW64\bin\g++.exe" AudioRTDSP.cpp -c -std=c++11 -m32 -o AudioRTDSP_32.o
-"C:\MinGW64\bin\g++.exe" AudioRTDSP_i16.cpp -c -std=c++11 -m32 -o AudioRTDSP_i16_32.o
-"C:\MinGW64\bin\g++.exe" AudioRTDSP_i24.cpp -c -std=c++11 -m32 -o AudioRTDSP_i24_32.o
+"C:\MinGW64\bin\g++.exe" globldef.c -c -std=c++11 -O2 -m32 -o globldef_32.o
+"C:\MinGW64\bin\g++.exe" cstrdef.c -c -std=c++11 -O2 -m32 -o cstrdef_32.o
+"C:\MinGW64\bin\g++.exe" thread.c -c -std=c++11 -O2 -m32 -o thread_32.o
+"C:\MinGW64\bin\g++.exe" strdef.cpp -c -std=c++11 -O2 -m32 -o strdef_32.o
+"C:\MinGW64\bin\g++.exe" main.cpp -c -std=c++11 -O2 -m32 -o main_32.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP.cpp -c -std=c++11 -O2 -m32 -o AudioRTDSP_32.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_i16.cpp -c -std=c++11 -O2 -m32 -o AudioRTDSP_i16_32.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_i24.cpp -c -std=c++11 -O2 -m32 -o AudioRTDSP_i24_32.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_kernel.cpp -c -std=c++11 -O2 -m32 -o AudioRTDSP_kernel_32.o
+"C:\MinGW64\bin\g++.exe" AudioBackend.cpp -c -std=c++11 -O2 -m32 -o AudioBackend_32.o
+"C:\MinGW64\bin\g++.exe" AudioBackend_WASAPI.cpp -c -std=c++11 -O2 -m32 -o AudioBackend_WASAPI_32.o
+"C:\MinGW64\bin\g++.exe" AudioBackend_SimClock.cpp -c -std=c++11 -O2 -m32 -o AudioBackend_SimClock_32.o
+"C:\MinGW64\bin\g++.exe" AudioBackend_Null.cpp -c -std=c++11 -O2 -m32 -o AudioBackend_Null_32.o
+"C:\MinGW64\bin\g++.exe" AudioBackend_WAVFile.cpp -c -std=c++11 -O2 -m32 -o AudioBackend_WAVFile_32.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_wavfile.cpp -c -std=c++11 -O2 -m32 -o AudioRTDSP_wavfile_32.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_batch.cpp -c -std=c++11 -O2 -m32 -o AudioRTDSP_batch_32.o
+"C:\MinGW64\bin\g++.exe" AudioBackend_WAVRegion.cpp -c -std=c++11 -O2 -m32 -o AudioBackend_WAVRegion_32.o
 
-"C:\MinGW64\bin\g++.exe" main_32.o globldef_32.o cstrdef_32.o thread_32.o strdef_32.o AudioRTDSP_32.o AudioRTDSP_i16_32.o AudioRTDSP_i24_32.o -lole32 -lksuser -mwindows -m32 -o rtdsp32.exe
+"C:\MinGW64\bin\g++.exe" main_32.o globldef_32.o cstrdef_32.o thread_32.o strdef_32.o AudioRTDSP_32.o AudioRTDSP_i16_32.o AudioRTDSP_i24_32.o AudioRTDSP_kernel_32.o AudioBackend_32.o AudioBackend_WASAPI_32.o AudioBackend_SimClock_32.o AudioBackend_Null_32.o AudioBackend_WAVFile_32.o AudioRTDSP_wavfile_32.o AudioRTDSP_batch_32.o AudioBackend_WAVRegion_32.o -lole32 -lksuser -lshell32 -mwindows -m32 -o rtdsp32.exe
+"C:\MinGW64\bin\g++.exe" kernelbench.cpp AudioRTDSP_kernel_32.o globldef_32.o -std=c++11 -O2 -m32 -o kernelbench32.exe
+"C:\MinGW64\bin\g++.exe" rtdsptest.cpp globldef_32.o cstrdef_32.o thread_32.o strdef_32.o AudioRTDSP_32.o AudioRTDSP_i16_32.o AudioRTDSP_i24_32.o AudioRTDSP_kernel_32.o AudioBackend_32.o AudioBackend_WASAPI_32.o AudioBackend_SimClock_32.o AudioBackend_Null_32.o AudioBackend_WAVFile_32.o AudioRTDSP_wavfile_32.o AudioRTDSP_batch_32.o AudioBackend_WAVRegion_32.o -lole32 -lksuser -lshell32 -std=c++11 -O2 -m32 -o rtdsptest32.exe
+
+"C:\MinGW64\bin\g++.exe" AudioRTDSP.cpp -c -std=c++11 -O2 -m32 -D__RTDSP_TELEMETRY -o AudioRTDSP_telemetry_32.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_i16.cpp -c -std=c++11 -O2 -m32 -D__RTDSP_TELEMETRY -o AudioRTDSP_i16_telemetry_32.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_i24.cpp -c -std=c++11 -O2 -m32 -D__RTDSP_TELEMETRY -o AudioRTDSP_i24_telemetry_32.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_wavfile.cpp -c -std=c++11 -O2 -m32 -D__RTDSP_TELEMETRY -o AudioRTDSP_wavfile_telemetry_32.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_batch.cpp -c -std=c++11 -O2 -m32 -D__RTDSP_TELEMETRY -o AudioRTDSP_batch_telemetry_32.o
+
+"C:\MinGW64\bin\g++.exe" rtdsptest.cpp globldef_32.o cstrdef_32.o thread_32.o strdef_32.o AudioRTDSP_telemetry_32.o AudioRTDSP_i16_telemetry_32.o AudioRTDSP_i24_telemetry_32.o AudioRTDSP_kernel_32.o AudioBackend_32.o AudioBackend_WASAPI_32.o AudioBackend_SimClock_32.o AudioBackend_Null_32.o AudioBackend_WAVFile_32.o AudioRTDSP_wavfile_telemetry_32.o AudioRTDSP_batch_telemetry_32.o AudioBackend_WAVRegion_32.o -lole32 -lksuser -lshell32 -std=c++11 -O2 -m32 -D__RTDSP_TELEMETRY -o rtdsptest_telemetry32.exe
 
 del globldef_32.o
 del cstrdef_32.o
@@ -17,4 +36,18 @@ del main_32.o
 del AudioRTDSP_32.o
 del AudioRTDSP_i16_32.o
 del AudioRTDSP_i24_32.o
+del AudioRTDSP_kernel_32.o
+del AudioBackend_32.o
+del AudioBackend_WASAPI_32.o
+del AudioBackend_SimClock_32.o
+del AudioBackend_Null_32.o
+del AudioBackend_WAVFile_32.o
+del AudioRTDSP_wavfile_32.o
+del AudioRTDSP_batch_32.o
+del AudioBackend_WAVRegion_32.o
+del AudioRTDSP_telemetry_32.o
+del AudioRTDSP_i16_telemetry_32.o
+del AudioRTDSP_i24_telemetry_32.o
+del AudioRTDSP_wavfile_telemetry_32.o
+del AudioRTDSP_batch_telemetry_32.o
 
@@ -1,13 +1,32 @@
-"C:\MinGW64\bin\g++.exe" globldef.c -c -std=c++11 -m64 -o globldef_64.o
-"C:\MinGW64\bin\g++.exe" cstrdef.c -c -std=c++11 -m64 -o cstrdef_64.o
-"C:\MinGW64\bin\g++.exe" thread.c -c -std=c++11 -m64 -o thread_64.o
-"C:\MinGW64\bin\g++.exe" strdef.cpp -c -std=c++11 -m64 -o strdef_64.o
-"C:\MinGW64\bin\g++.exe" main.cpp -c -std=c++11 -m64 -o main_64.o
-"C:\MinGW64\bin\g++.exe" AudioRTDSP.cpp -c -std=c++11 -m64 -o AudioRTDSP_64.o
-"C:\MinGW64\bin\g++.exe" AudioRTDSP_i16.cpp -c -std=c++11 -m64 -o AudioRTDSP_i16_64.o
-"C:\MinGW64\bin\g++.exe" AudioRTDSP_i24.cpp -c -std=c++11 -m64 -o AudioRTDSP_i24_64.o
+"C:\MinGW64\bin\g++.exe" globldef.c -c -std=c++11 -O2 -m64 -o globldef_64.o
+"C:\MinGW64\bin\g++.exe" cstrdef.c -c -std=c++11 -O2 -m64 -o cstrdef_64.o
+"C:\MinGW64\bin\g++.exe" thread.c -c -std=c++11 -O2 -m64 -o thread_64.o
+"C:\MinGW64\bin\g++.exe" strdef.cpp -c -std=c++11 -O2 -m64 -o strdef_64.o
+"C:\MinGW64\bin\g++.exe" main.cpp -c -std=c++11 -O2 -m64 -o main_64.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP.cpp -c -std=c++11 -O2 -m64 -o AudioRTDSP_64.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_i16.cpp -c -std=c++11 -O2 -m64 -o AudioRTDSP_i16_64.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_i24.cpp -c -std=c++11 -O2 -m64 -o AudioRTDSP_i24_64.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_kernel.cpp -c -std=c++11 -O2 -m64 -o AudioRTDSP_kernel_64.o
+"C:\MinGW64\bin\g++.exe" AudioBackend.cpp -c -std=c++11 -O2 -m64 -o AudioBackend_64.o
+"C:\MinGW64\bin\g++.exe" AudioBackend_WASAPI.cpp -c -std=c++11 -O2 -m64 -o AudioBackend_WASAPI_64.o
+"C:\MinGW64\bin\g++.exe" AudioBackend_SimClock.cpp -c -std=c++11 -O2 -m64 -o AudioBackend_SimClock_64.o
+"C:\MinGW64\bin\g++.exe" AudioBackend_Null.cpp -c -std=c++11 -O2 -m64 -o AudioBackend_Null_64.o
+"C:\MinGW64\bin\g++.exe" AudioBackend_WAVFile.cpp -c -std=c++11 -O2 -m64 -o AudioBackend_WAVFile_64.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_wavfile.cpp -c -std=c++11 -O2 -m64 -o AudioRTDSP_wavfile_64.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_batch.cpp -c -std=c++11 -O2 -m64 -o AudioRTDSP_batch_64.o
+"C:\MinGW64\bin\g++.exe" AudioBackend_WAVRegion.cpp -c -std=c++11 -O2 -m64 -o AudioBackend_WAVRegion_64.o
 
-"C:\MinGW64\bin\g++.exe" main_64.o globldef_64.o cstrdef_64.o thread_64.o strdef_64.o AudioRTDSP_64.o AudioRTDSP_i16_64.o AudioRTDSP_i24_64.o -lole32 -lksuser -mwindows -m64 -o rtdsp64.exe
+"C:\MinGW64\bin\g++.exe" main_64.o globldef_64.o cstrdef_64.o thread_64.o strdef_64.o AudioRTDSP_64.o AudioRTDSP_i16_64.o AudioRTDSP_i24_64.o AudioRTDSP_kernel_64.o AudioBackend_64.o AudioBackend_WASAPI_64.o AudioBackend_SimClock_64.o AudioBackend_Null_64.o AudioBackend_WAVFile_64.o AudioRTDSP_wavfile_64.o AudioRTDSP_batch_64.o AudioBackend_WAVRegion_64.o -lole32 -lksuser -lshell32 -mwindows -m64 -o rtdsp64.exe
+"C:\MinGW64\bin\g++.exe" kernelbench.cpp AudioRTDSP_kernel_64.o globldef_64.o -std=c++11 -O2 -m64 -o kernelbench64.exe
+"C:\MinGW64\bin\g++.exe" rtdsptest.cpp globldef_64.o cstrdef_64.o thread_64.o strdef_64.o AudioRTDSP_64.o AudioRTDSP_i16_64.o AudioRTDSP_i24_64.o AudioRTDSP_kernel_64.o AudioBackend_64.o AudioBackend_WASAPI_64.o AudioBackend_SimClock_64.o AudioBackend_Null_64.o AudioBackend_WAVFile_64.o AudioRTDSP_wavfile_64.o AudioRTDSP_batch_64.o AudioBackend_WAVRegion_64.o -lole32 -lksuser -lshell32 -std=c++11 -O2 -m64 -o rtdsptest64.exe
+
+"C:\MinGW64\bin\g++.exe" AudioRTDSP.cpp -c -std=c++11 -O2 -m64 -D__RTDSP_TELEMETRY -o AudioRTDSP_telemetry_64.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_i16.cpp -c -std=c++11 -O2 -m64 -D__RTDSP_TELEMETRY -o AudioRTDSP_i16_telemetry_64.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_i24.cpp -c -std=c++11 -O2 -m64 -D__RTDSP_TELEMETRY -o AudioRTDSP_i24_telemetry_64.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_wavfile.cpp -c -std=c++11 -O2 -m64 -D__RTDSP_TELEMETRY -o AudioRTDSP_wavfile_telemetry_64.o
+"C:\MinGW64\bin\g++.exe" AudioRTDSP_batch.cpp -c -std=c++11 -O2 -m64 -D__RTDSP_TELEMETRY -o AudioRTDSP_batch_telemetry_64.o
+
+"C:\MinGW64\bin\g++.exe" rtdsptest.cpp globldef_64.o cstrdef_64.o thread_64.o strdef_64.o AudioRTDSP_telemetry_64.o AudioRTDSP_i16_telemetry_64.o AudioRTDSP_i24_telemetry_64.o AudioRTDSP_kernel_64.o AudioBackend_64.o AudioBackend_WASAPI_64.o AudioBackend_SimClock_64.o AudioBackend_Null_64.o AudioBackend_WAVFile_64.o AudioRTDSP_wavfile_telemetry_64.o AudioRTDSP_batch_telemetry_64.o AudioBackend_WAVRegion_64.o -lole32 -lksuser -lshell32 -std=c++11 -O2 -m64 -D__RTDSP_TELEMETRY -o rtdsptest_telemetry64.exe
 
 del globldef_64.o
 del cstrdef_64.o
@@ -17,4 +36,18 @@ del main_64.o
 del AudioRTDSP_64.o
 del AudioRTDSP_i16_64.o
 del AudioRTDSP_i24_64.o
+del AudioRTDSP_kernel_64.o
+del AudioBackend_64.o
+del AudioBackend_WASAPI_64.o
+del AudioBackend_SimClock_64.o
+del AudioBackend_Null_64.o
+del AudioBackend_WAVFile_64.o
+del AudioRTDSP_wavfile_64.o
+del AudioRTDSP_batch_64.o
+del AudioBackend_WAVRegion_64.o
+del AudioRTDSP_telemetry_64.o
+del AudioRTDSP_i16_telemetry_64.o
+del AudioRTDSP_i24_telemetry_64.o
+del AudioRTDSP_wavfile_telemetry_64.o
+del AudioRTDSP_batch_telemetry_64.o
 
@@ -0,0 +1,59 @@
+#!/bin/sh
+
+# Linux build of the engine test program (rtdsptest) and the kernel benchmark (kernelbench).
+# The Win32 API subset the engine uses comes from posixdef.c, threads and events from thread.c (pthread).
+# The user interface (main.cpp) and the WASAPI backend are Windows only.
+# rtdsptest_telemetry: the same test program with the playback telemetry built in (__RTDSP_TELEMETRY, see config.h),
+# only the sources that include AudioRTDSP.hpp are built again.
+
+set -e
+
+g++ globldef.c -c -std=c++11 -O2 -o globldef_linux.o
+g++ cstrdef.c -c -std=c++11 -O2 -o cstrdef_linux.o
+g++ thread.c -c -std=c++11 -O2 -o thread_linux.o
+g++ posixdef.c -c -std=c++11 -O2 -o posixdef_linux.o
+g++ strdef.cpp -c -std=c++11 -O2 -o strdef_linux.o
+g++ AudioRTDSP.cpp -c -std=c++11 -O2 -o AudioRTDSP_linux.o
+g++ AudioRTDSP_i16.cpp -c -std=c++11 -O2 -o AudioRTDSP_i16_linux.o
+g++ AudioRTDSP_i24.cpp -c -std=c++11 -O2 -o AudioRTDSP_i24_linux.o
+g++ AudioRTDSP_kernel.cpp -c -std=c++11 -O2 -o AudioRTDSP_kernel_linux.o
+g++ AudioBackend.cpp -c -std=c++11 -O2 -o AudioBackend_linux.o
+g++ AudioBackend_SimClock.cpp -c -std=c++11 -O2 -o AudioBackend_SimClock_linux.o
+g++ AudioBackend_Null.cpp -c -std=c++11 -O2 -o AudioBackend_Null_linux.o
+g++ AudioBackend_WAVFile.cpp -c -std=c++11 -O2 -o AudioBackend_WAVFile_linux.o
+g++ AudioRTDSP_wavfile.cpp -c -std=c++11 -O2 -o AudioRTDSP_wavfile_linux.o
+g++ AudioRTDSP_batch.cpp -c -std=c++11 -O2 -o AudioRTDSP_batch_linux.o
+g++ AudioBackend_WAVRegion.cpp -c -std=c++11 -O2 -o AudioBackend_WAVRegion_linux.o
+
+g++ kernelbench.cpp AudioRTDSP_kernel_linux.o globldef_linux.o posixdef_linux.o -std=c++11 -O2 -lpthread -o kernelbench
+g++ rtdsptest.cpp globldef_linux.o cstrdef_linux.o thread_linux.o posixdef_linux.o strdef_linux.o AudioRTDSP_linux.o AudioRTDSP_i16_linux.o AudioRTDSP_i24_linux.o AudioRTDSP_kernel_linux.o AudioBackend_linux.o AudioBackend_SimClock_linux.o AudioBackend_Null_linux.o AudioBackend_WAVFile_linux.o AudioRTDSP_wavfile_linux.o AudioRTDSP_batch_linux.o AudioBackend_WAVRegion_linux.o -std=c++11 -O2 -lpthread -o rtdsptest
+
+g++ AudioRTDSP.cpp -c -std=c++11 -O2 -D__RTDSP_TELEMETRY -o AudioRTDSP_telemetry_linux.o
+g++ AudioRTDSP_i16.cpp -c -std=c++11 -O2 -D__RTDSP_TELEMETRY -o AudioRTDSP_i16_telemetry_linux.o
+g++ AudioRTDSP_i24.cpp -c -std=c++11 -O2 -D__RTDSP_TELEMETRY -o AudioRTDSP_i24_telemetry_linux.o
+g++ AudioRTDSP_wavfile.cpp -c -std=c++11 -O2 -D__RTDSP_TELEMETRY -o AudioRTDSP_wavfile_telemetry_linux.o
+g++ AudioRTDSP_batch.cpp -c -std=c++11 -O2 -D__RTDSP_TELEMETRY -o AudioRTDSP_batch_telemetry_linux.o
+
+g++ rtdsptest.cpp globldef_linux.o cstrdef_linux.o thread_linux.o posixdef_linux.o strdef_linux.o AudioRTDSP_telemetry_linux.o AudioRTDSP_i16_telemetry_linux.o AudioRTDSP_i24_telemetry_linux.o AudioRTDSP_kernel_linux.o AudioBackend_linux.o AudioBackend_SimClock_linux.o AudioBackend_Null_linux.o AudioBackend_WAVFile_linux.o AudioRTDSP_wavfile_telemetry_linux.o AudioRTDSP_batch_telemetry_linux.o AudioBackend_WAVRegion_linux.o -std=c++11 -O2 -D__RTDSP_TELEMETRY -lpthread -o rtdsptest_telemetry
+
+rm globldef_linux.o
+rm cstrdef_linux.o
+rm thread_linux.o
+rm posixdef_linux.o
+rm strdef_linux.o
+rm AudioRTDSP_linux.o
+rm AudioRTDSP_i16_linux.o
+rm AudioRTDSP_i24_linux.o
+rm AudioRTDSP_kernel_linux.o
+rm AudioBackend_linux.o
+rm AudioBackend_SimClock_linux.o
+rm AudioBackend_Null_linux.o
+rm AudioBackend_WAVFile_linux.o
+rm AudioRTDSP_wavfile_linux.o
+rm AudioRTDSP_batch_linux.o
+rm AudioBackend_WAVRegion_linux.o
+rm AudioRTDSP_telemetry_linux.o
+rm AudioRTDSP_i16_telemetry_linux.o
+rm AudioRTDSP_i24_telemetry_linux.o
+rm AudioRTDSP_wavfile_telemetry_linux.o
+rm AudioRTDSP_batch_telemetry_linux.o
@@ -40,4 +40,11 @@ Define the size (in number of characters) of the global TCHAR[] textbuf buffer.*
 
 #define TEXTBUF_SIZE_CHARS 1024U
 
+/*======================================================================================*/
+/*Playback Telemetry
+Define __RTDSP_TELEMETRY to build the per segment playback telemetry (stage timing histograms, deadline slack, audio buffer padding, see AudioRTDSP::getTelemetry())
+If not defined, the telemetry hooks compile to nothing*/
+
+/*#define __RTDSP_TELEMETRY*/
+
 #endif /*CONFIG_H*/
@@ -50,7 +50,13 @@
 #endif
 #endif
 
+/*Non Windows builds: POSIX implementation of the Win32 API subset the engine uses (see posixdef.h)*/
+
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include "posixdef.h"
+#endif
 
 #define TEXTBUF_SIZE_BYTES (TEXTBUF_SIZE_CHARS*sizeof(TCHAR))
 
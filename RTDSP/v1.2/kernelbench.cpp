@@ -0,0 +1,335 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+/*
+	DSP Kernel Benchmark:
+
+	Standalone console program. Runs every DSP kernel of every ISA supported by the running CPU/build over the same input,
+	checks that each output is identical to the scalar output, and prints the time per sample and the speedup over scalar.
+
+	Exit code is 0 if all outputs match, 1 otherwise.
+*/
+
+#include "AudioRTDSP_kernel.hpp"
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_N_SAMPLES 8192u
+#define BENCH_N_BLOCKS 32u
+#define BENCH_BLOCK_ITERATIONS 64u /*Accumulating kernels are reset between blocks, this keeps them within INT32*/
+
+#define BENCH_N_ISA 4
+
+enum BenchKernels {
+	BENCH_KERNEL_WIDEN_I16 = 0,
+	BENCH_KERNEL_ACCUMULATE_I16,
+	BENCH_KERNEL_ACCUMULATE_I32,
+	BENCH_KERNEL_ACCUMULATE2_I16,
+	BENCH_KERNEL_ACCUMULATE2_I32,
+	BENCH_KERNEL_SATURATE_I16,
+	BENCH_KERNEL_SATURATE_I24,
+	BENCH_KERNEL_UNPACK_I24,
+	BENCH_KERNEL_COMB_I16,
+	BENCH_KERNEL_COMB_I32,
+	BENCH_KERNEL_XFADE_I32,
+	BENCH_N_KERNELS
+};
+
+static const CHAR *BENCH_KERNEL_NAMES[BENCH_N_KERNELS] = {
+	"widen_i16",
+	"accumulate_i16",
+	"accumulate_i32",
+	"accumulate2_i16",
+	"accumulate2_i32",
+	"saturate_i16",
+	"saturate_i24",
+	"unpack_i24",
+	"comb_i16",
+	"comb_i32",
+	"xfade_i32"
+};
+
+static const CHAR *BENCH_ISA_NAMES[BENCH_N_ISA] = {"scalar", "sse2", "avx2", "neon"};
+
+struct _bench_buffers {
+	INT16 *p_src16;
+	INT16 *p_corr16;
+	INT32 *p_src32;
+	INT32 *p_corr32;
+	BYTE *p_src24;
+	INT32 *p_state_src16;
+	INT32 *p_state_src32;
+	INT32 *p_old;
+	INT32 *p_acc_init;
+
+	INT32 *p_acc;
+	INT32 *p_state;
+	INT16 *p_out16;
+	INT32 *p_out32;
+
+	dspkernel_gain_t gain_pos;
+	dspkernel_gain_t gain_neg;
+	dspkernel_gain_t gains2_pos[2];
+	dspkernel_gain_t gains2_neg[2];
+	dspkernel_comb_t comb16;
+	dspkernel_comb_t comb32;
+};
+
+typedef struct _bench_buffers bench_buffers_t;
+
+static UINT32 bench_rand_state = 0x12345678u;
+
+static INT32 WINAPI bench_rand(UINT32 n_bits)
+{
+	bench_rand_state = bench_rand_state*1664525u + 1013904223u;
+	return ((INT32) bench_rand_state) >> (32u - n_bits);
+}
+
+static BOOL WINAPI bench_alloc(bench_buffers_t *p_buf)
+{
+	SIZE_T n_sample;
+
+	p_buf->p_src16 = (INT16*) HeapAlloc(p_processheap, 0u, BENCH_N_SAMPLES*sizeof(INT16));
+	p_buf->p_corr16 = (INT16*) HeapAlloc(p_processheap, 0u, BENCH_N_SAMPLES*sizeof(INT16));
+	p_buf->p_src32 = (INT32*) HeapAlloc(p_processheap, 0u, BENCH_N_SAMPLES*sizeof(INT32));
+	p_buf->p_corr32 = (INT32*) HeapAlloc(p_processheap, 0u, BENCH_N_SAMPLES*sizeof(INT32));
+	p_buf->p_src24 = (BYTE*) HeapAlloc(p_processheap, 0u, 3u*BENCH_N_SAMPLES);
+	p_buf->p_state_src16 = (INT32*) HeapAlloc(p_processheap, 0u, BENCH_N_SAMPLES*sizeof(INT32));
+	p_buf->p_state_src32 = (INT32*) HeapAlloc(p_processheap, 0u, BENCH_N_SAMPLES*sizeof(INT32));
+	p_buf->p_old = (INT32*) HeapAlloc(p_processheap, 0u, BENCH_N_SAMPLES*sizeof(INT32));
+	p_buf->p_acc_init = (INT32*) HeapAlloc(p_processheap, 0u, BENCH_N_SAMPLES*sizeof(INT32));
+	p_buf->p_acc = (INT32*) HeapAlloc(p_processheap, 0u, BENCH_N_SAMPLES*sizeof(INT32));
+	p_buf->p_state = (INT32*) HeapAlloc(p_processheap, 0u, BENCH_N_SAMPLES*sizeof(INT32));
+	p_buf->p_out16 = (INT16*) HeapAlloc(p_processheap, 0u, BENCH_N_SAMPLES*sizeof(INT16));
+	p_buf->p_out32 = (INT32*) HeapAlloc(p_processheap, 0u, BENCH_N_SAMPLES*sizeof(INT32));
+
+	if(p_buf->p_src16 == NULL) return FALSE;
+	if(p_buf->p_corr16 == NULL) return FALSE;
+	if(p_buf->p_src32 == NULL) return FALSE;
+	if(p_buf->p_corr32 == NULL) return FALSE;
+	if(p_buf->p_src24 == NULL) return FALSE;
+	if(p_buf->p_state_src16 == NULL) return FALSE;
+	if(p_buf->p_state_src32 == NULL) return FALSE;
+	if(p_buf->p_old == NULL) return FALSE;
+	if(p_buf->p_acc_init == NULL) return FALSE;
+	if(p_buf->p_acc == NULL) return FALSE;
+	if(p_buf->p_state == NULL) return FALSE;
+	if(p_buf->p_out16 == NULL) return FALSE;
+	if(p_buf->p_out32 == NULL) return FALSE;
+
+	/*
+		State inputs are kept within 2^29 and samples within 24 bits, so the comb step stays within INT32.
+		p_acc_init is within 2^25, so saturation clamps part of the samples on both output formats.
+	*/
+
+	for(n_sample = 0u; n_sample < BENCH_N_SAMPLES; n_sample++)
+	{
+		p_buf->p_src16[n_sample] = (INT16) bench_rand(16u);
+		p_buf->p_corr16[n_sample] = (INT16) bench_rand(16u);
+		p_buf->p_src32[n_sample] = bench_rand(24u);
+		p_buf->p_corr32[n_sample] = bench_rand(24u);
+		p_buf->p_state_src16[n_sample] = bench_rand(30u);
+		p_buf->p_state_src32[n_sample] = bench_rand(30u);
+		p_buf->p_old[n_sample] = bench_rand(26u);
+		p_buf->p_acc_init[n_sample] = bench_rand(26u);
+
+		p_buf->p_src24[3u*n_sample] = (BYTE) bench_rand(8u);
+		p_buf->p_src24[3u*n_sample + 1u] = (BYTE) bench_rand(8u);
+		p_buf->p_src24[3u*n_sample + 2u] = (BYTE) bench_rand(8u);
+	}
+
+	dspkernel_gain_init_div(&p_buf->gain_pos, 1, 3u);
+	dspkernel_gain_init_div(&p_buf->gain_neg, -1, 3u);
+	dspkernel_gain_init_div(&p_buf->gains2_pos[0], 1, 3u);
+	dspkernel_gain_init_div(&p_buf->gains2_pos[1], -1, 5u);
+	dspkernel_gain_init_div(&p_buf->gains2_neg[0], -1, 3u);
+	dspkernel_gain_init_div(&p_buf->gains2_neg[1], 1, 5u);
+
+	p_buf->comb16.pol_mask = -1;
+	p_buf->comb16.corr_pol_mask = 0;
+	p_buf->comb16.frac_bits = 15u;
+	p_buf->comb16.corr_shift = 5u;
+
+	p_buf->comb32.pol_mask = -1;
+	p_buf->comb32.corr_pol_mask = 0;
+	p_buf->comb32.frac_bits = 7u;
+	p_buf->comb32.corr_shift = 5u;
+
+	return TRUE;
+}
+
+static VOID WINAPI bench_reset(bench_buffers_t *p_buf)
+{
+	CopyMemory(p_buf->p_acc, p_buf->p_acc_init, BENCH_N_SAMPLES*sizeof(INT32));
+	ZeroMemory(p_buf->p_state, BENCH_N_SAMPLES*sizeof(INT32));
+	ZeroMemory(p_buf->p_out16, BENCH_N_SAMPLES*sizeof(INT16));
+	ZeroMemory(p_buf->p_out32, BENCH_N_SAMPLES*sizeof(INT32));
+	return;
+}
+
+/*
+	Runs a kernel n_iterations times over the same buffers.
+	Accumulate alternates tap polarity (the taps cancel out exactly, pol*x/div is truncated towards zero).
+	Accumulate2 runs two taps per sample (second source: p_corr16, p_corr32): compare its time against twice the accumulate time.
+*/
+
+static VOID WINAPI bench_run(const dspkernel_table_t *p_table, bench_buffers_t *p_buf, INT kernel, UINT n_iterations)
+{
+	UINT n_iteration;
+
+	for(n_iteration = 0u; n_iteration < n_iterations; n_iteration++)
+	{
+		switch(kernel)
+		{
+			case BENCH_KERNEL_WIDEN_I16:
+				p_table->p_widen_i16(p_buf->p_acc, p_buf->p_src16, BENCH_N_SAMPLES);
+				break;
+
+			case BENCH_KERNEL_ACCUMULATE_I16:
+				p_table->p_accumulate_i16(p_buf->p_acc, p_buf->p_src16, BENCH_N_SAMPLES, (n_iteration & 1u) ? &p_buf->gain_neg : &p_buf->gain_pos);
+				break;
+
+			case BENCH_KERNEL_ACCUMULATE_I32:
+				p_table->p_accumulate_i32(p_buf->p_acc, p_buf->p_src32, BENCH_N_SAMPLES, (n_iteration & 1u) ? &p_buf->gain_neg : &p_buf->gain_pos);
+				break;
+
+			case BENCH_KERNEL_ACCUMULATE2_I16:
+				p_table->p_accumulate2_i16(p_buf->p_acc, p_buf->p_src16, p_buf->p_corr16, BENCH_N_SAMPLES, (n_iteration & 1u) ? p_buf->gains2_neg : p_buf->gains2_pos);
+				break;
+
+			case BENCH_KERNEL_ACCUMULATE2_I32:
+				p_table->p_accumulate2_i32(p_buf->p_acc, p_buf->p_src32, p_buf->p_corr32, BENCH_N_SAMPLES, (n_iteration & 1u) ? p_buf->gains2_neg : p_buf->gains2_pos);
+				break;
+
+			case BENCH_KERNEL_SATURATE_I16:
+				p_table->p_saturate_i16(p_buf->p_out16, p_buf->p_acc, BENCH_N_SAMPLES);
+				break;
+
+			case BENCH_KERNEL_SATURATE_I24:
+				p_table->p_saturate_i24(p_buf->p_out32, p_buf->p_acc, BENCH_N_SAMPLES);
+				break;
+
+			case BENCH_KERNEL_UNPACK_I24:
+				p_table->p_unpack_i24(p_buf->p_out32, p_buf->p_src24, BENCH_N_SAMPLES);
+				break;
+
+			case BENCH_KERNEL_COMB_I16:
+				p_table->p_comb_i16(p_buf->p_state, p_buf->p_acc, p_buf->p_src16, p_buf->p_state_src16, p_buf->p_corr16, BENCH_N_SAMPLES, &p_buf->comb16);
+				break;
+
+			case BENCH_KERNEL_COMB_I32:
+				p_table->p_comb_i32(p_buf->p_state, p_buf->p_acc, p_buf->p_src32, p_buf->p_state_src32, p_buf->p_corr32, BENCH_N_SAMPLES, &p_buf->comb32);
+				break;
+
+			case BENCH_KERNEL_XFADE_I32:
+				p_table->p_xfade_i32(p_buf->p_acc, p_buf->p_old, BENCH_N_SAMPLES, 0u, (UINT32) (0x100000000ull/BENCH_N_SAMPLES));
+				break;
+		}
+	}
+
+	return;
+}
+
+/*Compares every output buffer of a single kernel pass against the scalar output.*/
+
+static BOOL WINAPI bench_verify(const dspkernel_table_t *p_table, const dspkernel_table_t *p_table_ref, bench_buffers_t *p_buf, bench_buffers_t *p_buf_ref, INT kernel)
+{
+	bench_reset(p_buf);
+	bench_reset(p_buf_ref);
+
+	bench_run(p_table, p_buf, kernel, 1u);
+	bench_run(p_table_ref, p_buf_ref, kernel, 1u);
+
+	if(memcmp(p_buf->p_acc, p_buf_ref->p_acc, BENCH_N_SAMPLES*sizeof(INT32))) return FALSE;
+	if(memcmp(p_buf->p_state, p_buf_ref->p_state, BENCH_N_SAMPLES*sizeof(INT32))) return FALSE;
+	if(memcmp(p_buf->p_out16, p_buf_ref->p_out16, BENCH_N_SAMPLES*sizeof(INT16))) return FALSE;
+	if(memcmp(p_buf->p_out32, p_buf_ref->p_out32, BENCH_N_SAMPLES*sizeof(INT32))) return FALSE;
+
+	return TRUE;
+}
+
+/*Returns the time per sample in nanoseconds. Only the kernel calls are timed.*/
+
+static DOUBLE WINAPI bench_time(const dspkernel_table_t *p_table, bench_buffers_t *p_buf, INT kernel)
+{
+	LARGE_INTEGER qpc_freq;
+	LARGE_INTEGER qpc_start;
+	LARGE_INTEGER qpc_end;
+	INT64 qpc_total = 0;
+	UINT n_block;
+
+	QueryPerformanceFrequency(&qpc_freq);
+
+	for(n_block = 0u; n_block < BENCH_N_BLOCKS; n_block++)
+	{
+		bench_reset(p_buf);
+
+		QueryPerformanceCounter(&qpc_start);
+		bench_run(p_table, p_buf, kernel, BENCH_BLOCK_ITERATIONS);
+		QueryPerformanceCounter(&qpc_end);
+
+		qpc_total += (qpc_end.QuadPart - qpc_start.QuadPart);
+	}
+
+	return (((DOUBLE) qpc_total)*1.0e9)/(((DOUBLE) qpc_freq.QuadPart)*((DOUBLE) (BENCH_N_BLOCKS*BENCH_BLOCK_ITERATIONS*BENCH_N_SAMPLES)));
+}
+
+int main(void)
+{
+	bench_buffers_t buf;
+	bench_buffers_t buf_ref;
+	const dspkernel_table_t *p_table_ref = NULL;
+	const dspkernel_table_t *p_table = NULL;
+	DOUBLE ns_ref[BENCH_N_KERNELS];
+	DOUBLE ns = 0.0;
+	BOOL match = FALSE;
+	BOOL all_match = TRUE;
+	INT isa;
+	INT kernel;
+
+	p_processheap = GetProcessHeap();
+
+	bench_rand_state = 0x12345678u;
+	if(!bench_alloc(&buf))
+	{
+		printf("Error: memory allocate failed.\n");
+		return 1;
+	}
+
+	bench_rand_state = 0x12345678u;
+	if(!bench_alloc(&buf_ref))
+	{
+		printf("Error: memory allocate failed.\n");
+		return 1;
+	}
+
+	dspkernel_select_isa(DSPKERNEL_ISA_SCALAR);
+	p_table_ref = dspkernel_get_table();
+
+	printf("%u samples per call, %u calls per kernel\n\n", BENCH_N_SAMPLES, BENCH_N_BLOCKS*BENCH_BLOCK_ITERATIONS);
+	printf("%-8s %-16s %12s %10s %8s\n", "ISA", "Kernel", "ns/sample", "Speedup", "Output");
+
+	for(isa = 0; isa < BENCH_N_ISA; isa++)
+	{
+		if(!dspkernel_select_isa(isa)) continue;
+		p_table = dspkernel_get_table();
+
+		for(kernel = 0; kernel < BENCH_N_KERNELS; kernel++)
+		{
+			match = bench_verify(p_table, p_table_ref, &buf, &buf_ref, kernel);
+			if(!match) all_match = FALSE;
+
+			ns = bench_time(p_table, &buf, kernel);
+			if(isa == DSPKERNEL_ISA_SCALAR) ns_ref[kernel] = ns;
+
+			printf("%-8s %-16s %12.3f %9.2fx %8s\n", BENCH_ISA_NAMES[isa], BENCH_KERNEL_NAMES[kernel], ns, ns_ref[kernel]/ns, match ? "OK" : "MISMATCH");
+		}
+	}
+
+	return all_match ? 0 : 1;
+}
@@ -14,10 +14,13 @@
 #include "shared.hpp"
 
 #include <combaseapi.h>
+#include <shellapi.h>
 
 #include "AudioRTDSP.hpp"
 #include "AudioRTDSP_i16.hpp"
 #include "AudioRTDSP_i24.hpp"
+#include "AudioRTDSP_wavfile.hpp"
+#include "AudioRTDSP_batch.hpp"
 
 #define CUSTOM_GENERIC_WNDCLASS_NAME TEXT("__CUSTOMGENERICWNDCLASS__")
 
@@ -143,6 +146,28 @@
 #define PB_I16 1
 #define PB_I24 2
 
+/*
+	Offline render (command line):
+
+	rtdsp64.exe -render <input.wav> <output.wav> [delay] [feedback] [feedback alt pol (0/1)] [cycle div inc one (0/1)] [threads] [recursive comb (0/1)]
+
+	-render splits the file across [threads] threads (0: one thread per logical processor, omitted: 1, sequential render).
+	[recursive comb] processes the feedback taps as a recursive comb when cycle div inc one is 0 (see AudioRTDSP::enableRecursiveComb()), always rendered sequentially.
+
+	rtdsp64.exe -batch <input directory | list file> <output directory> [delay] [feedback] [feedback alt pol (0/1)] [cycle div inc one (0/1)] [workers] [recursive comb (0/1)]
+
+	-batch renders every .wav file in the input directory (or every file listed in the list file, one per line) into the output directory,
+	in parallel (workers = 0 or omitted: one worker per logical processor).
+
+	No window is created. Results are printed to the parent console (or shown in a message box if there's none).
+*/
+
+#define RENDERCLI_SWITCH L"-render"
+#define RENDERCLI_MIN_ARGC 4
+
+#define BATCHCLI_SWITCH L"-batch"
+#define BATCHCLI_MIN_ARGC 4
+
 HANDLE p_audiothread = NULL;
 HANDLE h_filein = INVALID_HANDLE_VALUE;
 
@@ -231,14 +256,41 @@ extern BOOL WINAPI filein_open(const TCHAR *filein_dir);
 extern VOID WINAPI filein_close(VOID);
 
 extern INT WINAPI filein_get_params(VOID);
-extern BOOL WINAPI compare_signature(const CHAR *auth, const CHAR *buf);
 
 extern DWORD WINAPI audiothread_proc(VOID *p_args);
 
+extern INT WINAPI rendercli_proc(INT argc, WCHAR **argv);
+extern INT WINAPI batchcli_proc(INT argc, WCHAR **argv);
+extern VOID WINAPI rendercli_print(const TCHAR *text, BOOL error);
+
 INT WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, INT nCmdShow)
 {
+	WCHAR **argv = NULL;
+	INT argc = 0;
+	INT n_ret = 0;
+
 	p_instance = hInstance;
 
+	argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+	if(argv != NULL)
+	{
+		if((argc > 1) && !wcscmp(argv[1], RENDERCLI_SWITCH))
+		{
+			n_ret = rendercli_proc(argc, argv);
+			LocalFree(argv);
+			return n_ret;
+		}
+
+		if((argc > 1) && !wcscmp(argv[1], BATCHCLI_SWITCH))
+		{
+			n_ret = batchcli_proc(argc, argv);
+			LocalFree(argv);
+			return n_ret;
+		}
+
+		LocalFree(argv);
+	}
+
 	if(!app_init()) return 1;
 
 	runtime_loop();
@@ -1667,135 +1719,346 @@ VOID WINAPI filein_close(VOID)
 
 INT WINAPI filein_get_params(VOID)
 {
-	const SIZE_T BUFFER_SIZE = 4096u;
-	SIZE_T buffer_index = 0u;
+	UINT16 bit_depth = 0u;
 
-	UINT8 *p_headerinfo = NULL;
+	if(!audiortdsp_wavfile_get_params(h_filein, &pb_params, &bit_depth, &tstr))
+	{
+		filein_close();
+		return -1;
+	}
 
-	DWORD dummy_32;
+	filein_close();
 
-	UINT32 u32 = 0u;
-	UINT16 u16 = 0u;
+	switch(bit_depth)
+	{
+		case 16u:
+			return PB_I16;
 
-	UINT16 bit_depth = 0u;
+		case 24u:
+			return PB_I24;
+	}
+
+	tstr = TEXT("Error: audio format not supported.");
+	return -1;
+}
+
+DWORD WINAPI audiothread_proc(VOID *p_args)
+{
+	if(!p_audio->runPlayback()) app_exit(1u, p_audio->getLastErrorMessage().c_str());
 
-	p_headerinfo = (UINT8*) HeapAlloc(p_processheap, HEAP_ZERO_MEMORY, BUFFER_SIZE);
-	if(p_headerinfo == NULL)
+	PostMessage(p_mainwnd, CUSTOM_WM_PLAYBACK_FINISHED, 0, 0);
+	return 0u;
+}
+
+INT WINAPI rendercli_proc(INT argc, WCHAR **argv)
+{
+	__string fileout_dir = TEXT("");
+	INT n32 = 0;
+	INT n_threads = 1;
+	INT readahead_kib = -1;
+	BOOL ret = FALSE;
+
+	audiortdsp_fx_params_t fx_params;
+
+	audiortdsp_render_stats_t render_stats;
+
+	fx_params.n_delay = 240;
+	fx_params.n_feedback = 20;
+	fx_params.feedback_alt_pol = TRUE;
+	fx_params.cyclediv_inc_one = TRUE;
+	fx_params.recursive_comb = FALSE;
+
+	AttachConsole(ATTACH_PARENT_PROCESS);
+
+	if(argc < RENDERCLI_MIN_ARGC)
 	{
-		tstr = TEXT("Error: memory allocate failed.");
-		goto _l_filein_get_params_error;
+		rendercli_print(TEXT("Usage: -render <input.wav> <output.wav> [delay] [feedback] [feedback alt pol (0/1)] [cycle div inc one (0/1)] [threads] [recursive comb (0/1)] [read-ahead (KiB)]\r\n"), TRUE);
+		return 1;
 	}
 
-	SetFilePointer(h_filein, 0, NULL, FILE_BEGIN);
-	ReadFile(h_filein, p_headerinfo, (DWORD) BUFFER_SIZE, &dummy_32, NULL);
-	filein_close();
+	p_processheap = GetProcessHeap();
+	if(p_processheap == NULL)
+	{
+		rendercli_print(TEXT("Error: Invalid Process Heap.\r\n"), TRUE);
+		return 1;
+	}
+
+	cstr_wchar_to_tchar(argv[2], textbuf, TEXTBUF_SIZE_CHARS);
+	tstr = textbuf;
 
-	if(!compare_signature("RIFF", (const CHAR*) p_headerinfo))
+	cstr_wchar_to_tchar(argv[3], textbuf, TEXTBUF_SIZE_CHARS);
+	fileout_dir = textbuf;
+
+	try
 	{
-		tstr = TEXT("Error: file format not supported.");
-		goto _l_filein_get_params_error;
+		if(argc > 4) fx_params.n_delay = (INT32) std::stoi(argv[4]);
+		if(argc > 5) fx_params.n_feedback = (INT32) std::stoi(argv[5]);
+		if(argc > 6) fx_params.feedback_alt_pol = (std::stoi(argv[6]) != 0);
+		if(argc > 7) fx_params.cyclediv_inc_one = (std::stoi(argv[7]) != 0);
+		if(argc > 8) n_threads = std::stoi(argv[8]);
+		if(argc > 9) fx_params.recursive_comb = (std::stoi(argv[9]) != 0);
+		if(argc > 10) readahead_kib = std::stoi(argv[10]);
+	}
+	catch(...)
+	{
+		rendercli_print(TEXT("Error: invalid value entered.\r\n"), TRUE);
+		return 1;
 	}
 
-	if(!compare_signature("WAVE", (const CHAR*) (((SIZE_T) p_headerinfo) + 8u)))
+	if(n_threads < 0)
 	{
-		tstr = TEXT("Error: file format not supported.");
-		goto _l_filein_get_params_error;
+		rendercli_print(TEXT("Error: invalid value entered.\r\n"), TRUE);
+		return 1;
 	}
 
-	buffer_index = 12u;
+	if(!filein_open(tstr.c_str()))
+	{
+		rendercli_print(TEXT("Error: could not open input file.\r\n"), TRUE);
+		return 1;
+	}
 
-	while(TRUE)
+	n32 = filein_get_params();
+	if(n32 < 0)
 	{
-		if(buffer_index > (BUFFER_SIZE - 8u))
-		{
-			tstr = TEXT("Error: broken header (missing subchunk \"fmt \").\r\nFile probably corrupted.");
-			goto _l_filein_get_params_error;
-		}
+		tstr += TEXT("\r\n");
+		rendercli_print(tstr.c_str(), TRUE);
+		return 1;
+	}
 
-		if(compare_signature("fmt ", (const CHAR*) (((SIZE_T) p_headerinfo) + buffer_index))) break;
+	cstr_wchar_to_tchar(argv[2], textbuf, TEXTBUF_SIZE_CHARS);
+	tstr = textbuf;
+	pb_params.file_dir = tstr.c_str();
+
+	switch(n32)
+	{
+		case PB_I16:
+			p_audio = new AudioRTDSP_i16(&pb_params);
+			break;
+
+		case PB_I24:
+			p_audio = new AudioRTDSP_i24(&pb_params);
+			break;
+	}
 
-		u32 = *((UINT32*) (((SIZE_T) p_headerinfo) + buffer_index + 4u));
-		buffer_index += (SIZE_T) (u32 + 8u);
+	if(p_audio == NULL)
+	{
+		rendercli_print(TEXT("Error: Failed to create audio object instance.\r\n"), TRUE);
+		return 1;
 	}
 
-	if(buffer_index > (BUFFER_SIZE - 24u))
+	if(readahead_kib >= 0)
 	{
-		tstr = TEXT("Error: broken header (error on subchunk \"fmt \").\r\nFile probably corrupted.");
-		goto _l_filein_get_params_error;
+		if(!p_audio->setReadAheadSize(((SIZE_T) readahead_kib)*1024u))
+		{
+			tstr = TEXT("Error: ");
+			tstr += p_audio->getLastErrorMessage();
+			tstr += TEXT("\r\n");
+
+			delete p_audio;
+			p_audio = NULL;
+
+			rendercli_print(tstr.c_str(), TRUE);
+			return 1;
+		}
 	}
 
-	u16 = *((UINT16*) (((SIZE_T) p_headerinfo) + buffer_index + 8u));
+	if(n_threads == 1) ret = p_audio->runRender(&fx_params, fileout_dir.c_str(), &render_stats);
+	else ret = p_audio->runRenderParallel(&fx_params, fileout_dir.c_str(), (SIZE_T) n_threads, &render_stats);
 
-	if(u16 != 1u)
+	if(!ret)
 	{
-		tstr = TEXT("Error: audio encoding format not supported.");
-		goto _l_filein_get_params_error;
+		tstr = TEXT("Error: render failed\r\nExtended error message: ");
+		tstr += p_audio->getLastErrorMessage();
+		tstr += TEXT("\r\n");
+
+		delete p_audio;
+		p_audio = NULL;
+
+		rendercli_print(tstr.c_str(), TRUE);
+		return 1;
 	}
 
-	pb_params.n_channels = *((UINT16*) (((SIZE_T) p_headerinfo) + buffer_index + 10u));
-	pb_params.sample_rate = *((UINT32*) (((SIZE_T) p_headerinfo) + buffer_index + 12u));
-	bit_depth = *((UINT16*) (((SIZE_T) p_headerinfo) + buffer_index + 22u));
+	delete p_audio;
+	p_audio = NULL;
+
+	__SPRINTF(textbuf, TEXTBUF_SIZE_CHARS, TEXT("Rendered %llu frames in %.3f s: %.0f frames/s (%.1fx real time), %.3f s waiting on input reads, %llu KiB buffer arena\r\n"), (unsigned long long) render_stats.n_frames, render_stats.elapsed_sec, render_stats.frames_per_sec, render_stats.realtime_factor, render_stats.io_wait_sec, (unsigned long long) (render_stats.arena_size/1024u));
+	rendercli_print(textbuf, FALSE);
+
+	return 0;
+}
+
+INT WINAPI batchcli_proc(INT argc, WCHAR **argv)
+{
+	AudioRTDSP_Batch *p_batch = NULL;
+	__string dirin = TEXT("");
+	__string dirout = TEXT("");
+	SIZE_T n_workers = 0u;
+	SIZE_T n_file = 0u;
+	DWORD attrib = 0u;
+	BOOL ret = FALSE;
+
+	audiortdsp_fx_params_t fx_params;
 
-	u32 = *((UINT32*) (((SIZE_T) p_headerinfo) + buffer_index + 4u));
-	buffer_index += (SIZE_T) (u32 + 8u);
+	audiortdsp_batch_result_t result;
+	audiortdsp_batch_summary_t summary;
 
-	while(TRUE)
+	fx_params.n_delay = 240;
+	fx_params.n_feedback = 20;
+	fx_params.feedback_alt_pol = TRUE;
+	fx_params.cyclediv_inc_one = TRUE;
+	fx_params.recursive_comb = FALSE;
+
+	AttachConsole(ATTACH_PARENT_PROCESS);
+
+	if(argc < BATCHCLI_MIN_ARGC)
 	{
-		if(buffer_index > (BUFFER_SIZE - 8u))
-		{
-			tstr = TEXT("Error: broken header (missing subchunk \"data\").\r\nFile probably corrupted.");
-			goto _l_filein_get_params_error;
-		}
+		rendercli_print(TEXT("Usage: -batch <input directory | list file> <output directory> [delay] [feedback] [feedback alt pol (0/1)] [cycle div inc one (0/1)] [workers] [recursive comb (0/1)]\r\n"), TRUE);
+		return 1;
+	}
+
+	p_processheap = GetProcessHeap();
+	if(p_processheap == NULL)
+	{
+		rendercli_print(TEXT("Error: Invalid Process Heap.\r\n"), TRUE);
+		return 1;
+	}
 
-		if(compare_signature("data", (const CHAR*) (((SIZE_T) p_headerinfo) + buffer_index))) break;
+	cstr_wchar_to_tchar(argv[2], textbuf, TEXTBUF_SIZE_CHARS);
+	dirin = textbuf;
 
-		u32 = *((UINT32*) (((SIZE_T) p_headerinfo) + buffer_index + 4u));
-		buffer_index += (SIZE_T) (u32 + 8u);
+	cstr_wchar_to_tchar(argv[3], textbuf, TEXTBUF_SIZE_CHARS);
+	dirout = textbuf;
+
+	try
+	{
+		if(argc > 4) fx_params.n_delay = (INT32) std::stoi(argv[4]);
+		if(argc > 5) fx_params.n_feedback = (INT32) std::stoi(argv[5]);
+		if(argc > 6) fx_params.feedback_alt_pol = (std::stoi(argv[6]) != 0);
+		if(argc > 7) fx_params.cyclediv_inc_one = (std::stoi(argv[7]) != 0);
+		if(argc > 8) n_workers = (SIZE_T) std::stoi(argv[8]);
+		if(argc > 9) fx_params.recursive_comb = (std::stoi(argv[9]) != 0);
+	}
+	catch(...)
+	{
+		rendercli_print(TEXT("Error: invalid value entered.\r\n"), TRUE);
+		return 1;
 	}
 
-	u32 = *((UINT32*) (((SIZE_T) p_headerinfo) + buffer_index + 4u));
+	p_batch = new AudioRTDSP_Batch();
 
-	pb_params.audio_data_begin = (ULONG64) (buffer_index + 8u);
-	pb_params.audio_data_end = pb_params.audio_data_begin + ((ULONG64) u32);
+	if(!p_batch->setFXParams(&fx_params)) goto _l_batchcli_proc_error;
+	if(!p_batch->setWorkerCount(n_workers)) goto _l_batchcli_proc_error;
 
-	HeapFree(p_processheap, 0u, p_headerinfo);
+	attrib = GetFileAttributes(dirin.c_str());
+	if(attrib == INVALID_FILE_ATTRIBUTES)
+	{
+		delete p_batch;
+		rendercli_print(TEXT("Error: could not open input directory or list file.\r\n"), TRUE);
+		return 1;
+	}
 
-	p_headerinfo = NULL;
+	if(attrib & FILE_ATTRIBUTE_DIRECTORY) ret = p_batch->addDirectory(dirin.c_str(), dirout.c_str());
+	else ret = p_batch->addFileList(dirin.c_str(), dirout.c_str());
 
-	switch(bit_depth)
+	if(!ret) goto _l_batchcli_proc_error;
+	if(!p_batch->run()) goto _l_batchcli_proc_error;
+
+	for(n_file = 0u; n_file < p_batch->getFileCount(); n_file++)
 	{
-		case 16u:
-			return PB_I16;
+		if(!p_batch->getFileResult(n_file, &result)) continue;
 
-		case 24u:
-			return PB_I24;
+		if(result.success)
+		{
+			__SPRINTF(textbuf, TEXTBUF_SIZE_CHARS, TEXT("OK: %s: %llu frames in %.3f s (%.1fx real time)\r\n"), result.filein_dir, (unsigned long long) result.stats.n_frames, result.stats.elapsed_sec, result.stats.realtime_factor);
+			rendercli_print(textbuf, FALSE);
+		}
+		else if(result.done)
+		{
+			tstr = TEXT("FAILED: ");
+			tstr += result.filein_dir;
+			tstr += TEXT(": ");
+			tstr += result.err_msg;
+			tstr += TEXT("\r\n");
+			rendercli_print(tstr.c_str(), TRUE);
+		}
 	}
 
-	tstr = TEXT("Error: audio format not supported.");
+	p_batch->getSummary(&summary);
+	delete p_batch;
 
-_l_filein_get_params_error:
-	filein_close();
-	if(p_headerinfo != NULL) HeapFree(p_processheap, 0u, p_headerinfo);
-	return -1;
-}
+	__SPRINTF(textbuf, TEXTBUF_SIZE_CHARS, TEXT("Batch: %llu files (%llu ok, %llu failed) on %llu workers, %llu frames (%.1f s of audio) in %.3f s: %.0f frames/s (%.1fx real time)\r\n"), (unsigned long long) summary.n_files, (unsigned long long) summary.n_success, (unsigned long long) summary.n_failed, (unsigned long long) summary.n_workers, (unsigned long long) summary.n_frames, summary.audio_sec, summary.elapsed_sec, summary.frames_per_sec, summary.realtime_factor);
+	rendercli_print(textbuf, FALSE);
 
-BOOL WINAPI compare_signature(const CHAR *auth, const CHAR *buf)
-{
-	if(auth == NULL) return FALSE;
-	if(buf == NULL) return FALSE;
+	if(summary.n_failed) return 1;
+	return 0;
 
-	if(auth[0] != buf[0]) return FALSE;
-	if(auth[1] != buf[1]) return FALSE;
-	if(auth[2] != buf[2]) return FALSE;
-	if(auth[3] != buf[3]) return FALSE;
+_l_batchcli_proc_error:
+	tstr = TEXT("Error: batch render failed\r\nExtended error message: ");
+	tstr += p_batch->getLastErrorMessage();
+	tstr += TEXT("\r\n");
 
-	return TRUE;
+	delete p_batch;
+
+	rendercli_print(tstr.c_str(), TRUE);
+	return 1;
 }
 
-DWORD WINAPI audiothread_proc(VOID *p_args)
+VOID WINAPI rendercli_print(const TCHAR *text, BOOL error)
 {
-	p_audio->runPlayback();
+	HANDLE h_stdout = NULL;
+	DWORD dummy_32;
+	SIZE_T text_len = 0u;
 
-	PostMessage(p_mainwnd, CUSTOM_WM_PLAYBACK_FINISHED, 0, 0);
-	return 0u;
+#ifdef __USE_UTF16
+	CHAR textbuf8[1024];
+	SIZE_T n_char = 0u;
+	SIZE_T chunk_len = 0u;
+	INT n_bytes = 0;
+#endif
+
+	if(error) h_stdout = GetStdHandle(STD_ERROR_HANDLE);
+	else h_stdout = GetStdHandle(STD_OUTPUT_HANDLE);
+
+	if((h_stdout == NULL) || (h_stdout == INVALID_HANDLE_VALUE))
+	{
+		if(error) MessageBox(NULL, text, TEXT("ERROR"), (MB_ICONEXCLAMATION | MB_OK));
+		else MessageBox(NULL, text, TEXT("RENDER"), (MB_ICONINFORMATION | MB_OK));
+		return;
+	}
+
+	text_len = (SIZE_T) cstr_getlength(text);
+
+	if(GetConsoleMode(h_stdout, &dummy_32))
+	{
+		WriteConsole(h_stdout, text, (DWORD) text_len, &dummy_32, NULL);
+		return;
+	}
+
+	/*
+		Redirected to a file or a pipe: WriteConsole() fails on those, write the text as bytes instead.
+		UTF-16 text is written as UTF-8, in chunks that fit textbuf8 (up to 3 bytes per UTF-16 char), never splitting a surrogate pair.
+	*/
+
+#ifdef __USE_UTF16
+	while(n_char < text_len)
+	{
+		chunk_len = text_len - n_char;
+		if(chunk_len > 256u)
+		{
+			chunk_len = 256u;
+			if((text[n_char + chunk_len - 1u] >= 0xd800) && (text[n_char + chunk_len - 1u] <= 0xdbff)) chunk_len--;
+		}
+
+		n_bytes = WideCharToMultiByte(CP_UTF8, 0, &text[n_char], (INT) chunk_len, textbuf8, (INT) sizeof(textbuf8), NULL, NULL);
+		if(n_bytes <= 0) return;
+
+		if(!WriteFile(h_stdout, textbuf8, (DWORD) n_bytes, &dummy_32, NULL)) return;
+
+		n_char += chunk_len;
+	}
+#else
+	WriteFile(h_stdout, text, (DWORD) text_len, &dummy_32, NULL);
+#endif
+
+	return;
 }
@@ -0,0 +1,875 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+#include "globldef.h"
+
+#ifndef _WIN32
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define POSIXDEF_PATH_SIZE 4096u
+
+#define POSIXDEF_HANDLE_FILE 1
+#define POSIXDEF_HANDLE_MAP 2
+#define POSIXDEF_HANDLE_FIND 3
+
+/*
+	Handle objects (files, file mappings, file searches).
+	fd: file descriptor (the mapping owns a duplicate of the file descriptor, so it may outlive the file handle).
+	map_size: size of the file mapping.
+	p_dir, pattern: open directory and file name pattern of a file search.
+*/
+
+struct _posixdef_handle {
+	INT type;
+	INT fd;
+	SIZE_T map_size;
+	DIR *p_dir;
+	CHAR pattern[POSIXDEF_PATH_SIZE];
+};
+
+typedef struct _posixdef_handle posixdef_handle_t;
+
+/*
+	Mapped regions (VirtualAlloc() reservations and file views), MEM_RELEASE and UnmapViewOfFile() only get the base address.
+*/
+
+struct _posixdef_region {
+	VOID *p_base;
+	SIZE_T size;
+	struct _posixdef_region *p_next;
+};
+
+typedef struct _posixdef_region posixdef_region_t;
+
+static posixdef_region_t *p_posixdef_regions = NULL;
+static pthread_mutex_t posixdef_regions_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static BYTE posixdef_processheap = 0u;
+
+static __thread DWORD posixdef_last_error = 0u;
+
+/*======================================================================================*/
+/*Internal*/
+
+static BOOL WINAPI posixdef_set_error(DWORD error)
+{
+	posixdef_last_error = error;
+	return FALSE;
+}
+
+static SIZE_T WINAPI posixdef_get_pagesize(VOID)
+{
+	return (SIZE_T) sysconf(_SC_PAGESIZE);
+}
+
+/*Convert a TCHAR path to an UTF-8 path, backslashes to slashes. Returns FALSE if it doesn't fit.*/
+
+static BOOL WINAPI posixdef_path(const TCHAR *file_dir, CHAR *path, SIZE_T size)
+{
+	SIZE_T n_char = 0u;
+	SIZE_T n_byte = 0u;
+	UINT32 code = 0u;
+
+	if(file_dir == NULL) return FALSE;
+
+	while(file_dir[n_char] != '\0')
+	{
+		code = (UINT32) file_dir[n_char];
+		n_char++;
+
+		if(code == '\\') code = '/';
+
+		if(code < 0x80u)
+		{
+			if((n_byte + 1u) >= size) return FALSE;
+			path[n_byte++] = (CHAR) code;
+		}
+		else if(code < 0x800u)
+		{
+			if((n_byte + 2u) >= size) return FALSE;
+			path[n_byte++] = (CHAR) (0xc0u | (code >> 6));
+			path[n_byte++] = (CHAR) (0x80u | (code & 0x3fu));
+		}
+		else if(code < 0x10000u)
+		{
+			if((n_byte + 3u) >= size) return FALSE;
+			path[n_byte++] = (CHAR) (0xe0u | (code >> 12));
+			path[n_byte++] = (CHAR) (0x80u | ((code >> 6) & 0x3fu));
+			path[n_byte++] = (CHAR) (0x80u | (code & 0x3fu));
+		}
+		else
+		{
+			if((n_byte + 4u) >= size) return FALSE;
+			path[n_byte++] = (CHAR) (0xf0u | (code >> 18));
+			path[n_byte++] = (CHAR) (0x80u | ((code >> 12) & 0x3fu));
+			path[n_byte++] = (CHAR) (0x80u | ((code >> 6) & 0x3fu));
+			path[n_byte++] = (CHAR) (0x80u | (code & 0x3fu));
+		}
+	}
+
+	path[n_byte] = '\0';
+	return TRUE;
+}
+
+/*Convert an UTF-8 file name to a TCHAR file name (truncated to size - 1 characters). Invalid sequences are copied byte by byte.*/
+
+static VOID WINAPI posixdef_name(const CHAR *name, TCHAR *file_name, SIZE_T size)
+{
+	const BYTE *p_name = (const BYTE*) name;
+	SIZE_T n_char = 0u;
+	SIZE_T n_len = 0u;
+	SIZE_T n_cont = 0u;
+	UINT32 code = 0u;
+
+	while((*p_name != '\0') && ((n_char + 1u) < size))
+	{
+		code = (UINT32) *p_name;
+		n_len = 1u;
+
+		if((sizeof(TCHAR) > 1u) && (code >= 0xc0u))
+		{
+			if(code >= 0xf0u) n_len = 4u;
+			else if(code >= 0xe0u) n_len = 3u;
+			else n_len = 2u;
+
+			code &= (0x3fu >> (n_len - 1u));
+
+			for(n_cont = 1u; n_cont < n_len; n_cont++)
+			{
+				if((p_name[n_cont] & 0xc0u) != 0x80u) break;
+				code = (code << 6) | (p_name[n_cont] & 0x3fu);
+			}
+
+			if(n_cont < n_len)
+			{
+				code = (UINT32) *p_name;
+				n_len = 1u;
+			}
+		}
+
+		file_name[n_char++] = (TCHAR) code;
+		p_name += n_len;
+	}
+
+	file_name[n_char] = '\0';
+	return;
+}
+
+static HANDLE WINAPI posixdef_handle_create(INT type)
+{
+	posixdef_handle_t *p_handle = NULL;
+
+	p_handle = (posixdef_handle_t*) calloc(1u, sizeof(posixdef_handle_t));
+	if(p_handle == NULL) return NULL;
+
+	p_handle->type = type;
+	p_handle->fd = -1;
+
+	return (HANDLE) p_handle;
+}
+
+static posixdef_handle_t* WINAPI posixdef_handle_get(HANDLE h_object, INT type)
+{
+	posixdef_handle_t *p_handle = (posixdef_handle_t*) h_object;
+
+	if((h_object == NULL) || (h_object == INVALID_HANDLE_VALUE)) return NULL;
+	if(p_handle->type != type) return NULL;
+
+	return p_handle;
+}
+
+static BOOL WINAPI posixdef_region_add(VOID *p_base, SIZE_T size)
+{
+	posixdef_region_t *p_region = NULL;
+
+	p_region = (posixdef_region_t*) malloc(sizeof(posixdef_region_t));
+	if(p_region == NULL) return FALSE;
+
+	p_region->p_base = p_base;
+	p_region->size = size;
+
+	pthread_mutex_lock(&posixdef_regions_mutex);
+
+	p_region->p_next = p_posixdef_regions;
+	p_posixdef_regions = p_region;
+
+	pthread_mutex_unlock(&posixdef_regions_mutex);
+	return TRUE;
+}
+
+/*Remove the region starting at p_base, unmap it. Returns FALSE if there's no such region.*/
+
+static BOOL WINAPI posixdef_region_release(const VOID *p_base)
+{
+	posixdef_region_t **pp_region = NULL;
+	posixdef_region_t *p_region = NULL;
+
+	pthread_mutex_lock(&posixdef_regions_mutex);
+
+	pp_region = &p_posixdef_regions;
+
+	while(*pp_region != NULL)
+	{
+		if((*pp_region)->p_base == p_base)
+		{
+			p_region = *pp_region;
+			*pp_region = p_region->p_next;
+			break;
+		}
+
+		pp_region = &((*pp_region)->p_next);
+	}
+
+	pthread_mutex_unlock(&posixdef_regions_mutex);
+
+	if(p_region == NULL) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	munmap(p_region->p_base, p_region->size);
+	free(p_region);
+	return TRUE;
+}
+
+static BOOL WINAPI posixdef_seek(INT fd, LONG64 distance, DWORD move_method, LONG64 *p_new_pos)
+{
+	off_t pos = 0;
+	INT whence = SEEK_SET;
+
+	if(move_method == FILE_CURRENT) whence = SEEK_CUR;
+	else if(move_method == FILE_END) whence = SEEK_END;
+
+	pos = lseek(fd, (off_t) distance, whence);
+	if(pos < 0) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	if(p_new_pos != NULL) *p_new_pos = (LONG64) pos;
+	return TRUE;
+}
+
+/*======================================================================================*/
+/*Memory*/
+
+HANDLE WINAPI GetProcessHeap(VOID)
+{
+	return (HANDLE) &posixdef_processheap;
+}
+
+HANDLE WINAPI HeapCreate(DWORD options, SIZE_T initial_size, SIZE_T max_size)
+{
+	posixdef_set_error(ERROR_GEN_FAILURE);
+	return NULL;
+}
+
+BOOL WINAPI HeapDestroy(HANDLE p_heap)
+{
+	return posixdef_set_error(ERROR_GEN_FAILURE);
+}
+
+VOID* WINAPI HeapAlloc(HANDLE p_heap, DWORD flags, SIZE_T size)
+{
+	if(!size) size = 1u;
+
+	if(flags & HEAP_ZERO_MEMORY) return calloc(1u, size);
+
+	return malloc(size);
+}
+
+BOOL WINAPI HeapFree(HANDLE p_heap, DWORD flags, VOID *p_mem)
+{
+	free(p_mem);
+	return TRUE;
+}
+
+VOID* WINAPI VirtualAlloc(VOID *p_addr, SIZE_T size, DWORD alloc_type, DWORD protect)
+{
+	SIZE_T pagesize = 0u;
+	ULONG_PTR addr_begin = 0u;
+	ULONG_PTR addr_end = 0u;
+	VOID *p_base = NULL;
+
+	if(!size) return NULL;
+	if(alloc_type & MEM_LARGE_PAGES) return NULL;
+
+	pagesize = posixdef_get_pagesize();
+
+	if(p_addr == NULL)
+	{
+		if(!(alloc_type & MEM_RESERVE)) return NULL;
+
+		size = ((size + pagesize - 1u)/pagesize)*pagesize;
+
+		if(alloc_type & MEM_COMMIT) p_base = mmap(NULL, size, (PROT_READ | PROT_WRITE), (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+		else p_base = mmap(NULL, size, PROT_NONE, (MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE), -1, 0);
+
+		if(p_base == MAP_FAILED) return NULL;
+
+		if(!posixdef_region_add(p_base, size))
+		{
+			munmap(p_base, size);
+			return NULL;
+		}
+
+		return p_base;
+	}
+
+	/*Commit pages of a reservation*/
+
+	if(!(alloc_type & MEM_COMMIT)) return NULL;
+
+	addr_begin = (((ULONG_PTR) p_addr)/pagesize)*pagesize;
+	addr_end = ((((ULONG_PTR) p_addr) + size + pagesize - 1u)/pagesize)*pagesize;
+
+	if(mprotect((VOID*) addr_begin, (SIZE_T) (addr_end - addr_begin), (PROT_READ | PROT_WRITE))) return NULL;
+
+	return (VOID*) addr_begin;
+}
+
+BOOL WINAPI VirtualFree(VOID *p_addr, SIZE_T size, DWORD free_type)
+{
+	SIZE_T pagesize = 0u;
+	ULONG_PTR addr_begin = 0u;
+	ULONG_PTR addr_end = 0u;
+
+	if(p_addr == NULL) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	if(free_type & MEM_RELEASE)
+	{
+		if(size) return posixdef_set_error(ERROR_GEN_FAILURE);
+		return posixdef_region_release(p_addr);
+	}
+
+	if(!(free_type & MEM_DECOMMIT)) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	pagesize = posixdef_get_pagesize();
+
+	addr_begin = (((ULONG_PTR) p_addr)/pagesize)*pagesize;
+	addr_end = ((((ULONG_PTR) p_addr) + size + pagesize - 1u)/pagesize)*pagesize;
+
+	madvise((VOID*) addr_begin, (SIZE_T) (addr_end - addr_begin), MADV_DONTNEED);
+	if(mprotect((VOID*) addr_begin, (SIZE_T) (addr_end - addr_begin), PROT_NONE)) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	return TRUE;
+}
+
+SIZE_T WINAPI GetLargePageMinimum(VOID)
+{
+	return 0u;
+}
+
+/*======================================================================================*/
+/*Files*/
+
+DWORD WINAPI GetLastError(VOID)
+{
+	return posixdef_last_error;
+}
+
+HANDLE WINAPI CreateFile(const TCHAR *file_dir, DWORD access, DWORD share_mode, VOID *p_security, DWORD creation, DWORD flags, HANDLE h_template)
+{
+	posixdef_handle_t *p_handle = NULL;
+	CHAR path[POSIXDEF_PATH_SIZE];
+	INT open_flags = 0;
+	INT fd = -1;
+
+	if(!posixdef_path(file_dir, path, POSIXDEF_PATH_SIZE))
+	{
+		posixdef_set_error(ERROR_GEN_FAILURE);
+		return INVALID_HANDLE_VALUE;
+	}
+
+	if((access & GENERIC_READ) && (access & GENERIC_WRITE)) open_flags = O_RDWR;
+	else if(access & GENERIC_WRITE) open_flags = O_WRONLY;
+	else open_flags = O_RDONLY;
+
+	if(creation == CREATE_ALWAYS) open_flags |= (O_CREAT | O_TRUNC);
+	else if(creation != OPEN_EXISTING)
+	{
+		posixdef_set_error(ERROR_GEN_FAILURE);
+		return INVALID_HANDLE_VALUE;
+	}
+
+	p_handle = (posixdef_handle_t*) posixdef_handle_create(POSIXDEF_HANDLE_FILE);
+	if(p_handle == NULL)
+	{
+		posixdef_set_error(ERROR_GEN_FAILURE);
+		return INVALID_HANDLE_VALUE;
+	}
+
+	fd = open(path, (open_flags | O_CLOEXEC), 0666);
+	if(fd < 0)
+	{
+		free(p_handle);
+		posixdef_set_error(ERROR_GEN_FAILURE);
+		return INVALID_HANDLE_VALUE;
+	}
+
+	p_handle->fd = fd;
+	return (HANDLE) p_handle;
+}
+
+BOOL WINAPI CloseHandle(HANDLE h_object)
+{
+	posixdef_handle_t *p_handle = (posixdef_handle_t*) h_object;
+
+	if((h_object == NULL) || (h_object == INVALID_HANDLE_VALUE)) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	if(p_handle->fd >= 0) close(p_handle->fd);
+	if(p_handle->p_dir != NULL) closedir(p_handle->p_dir);
+
+	free(p_handle);
+	return TRUE;
+}
+
+BOOL WINAPI DeleteFile(const TCHAR *file_dir)
+{
+	CHAR path[POSIXDEF_PATH_SIZE];
+
+	if(!posixdef_path(file_dir, path, POSIXDEF_PATH_SIZE)) return posixdef_set_error(ERROR_GEN_FAILURE);
+	if(unlink(path)) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	return TRUE;
+}
+
+BOOL WINAPI ReadFile(HANDLE h_file, VOID *p_buffer, DWORD n_bytes, DWORD *p_n_read, OVERLAPPED *p_overlapped)
+{
+	posixdef_handle_t *p_handle = NULL;
+	BYTE *p_bytes = (BYTE*) p_buffer;
+	SIZE_T n_done = 0u;
+	ssize_t n_ret = 0;
+	off_t filepos = 0;
+
+	if(p_n_read != NULL) *p_n_read = 0u;
+
+	p_handle = posixdef_handle_get(h_file, POSIXDEF_HANDLE_FILE);
+	if(p_handle == NULL) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	if(p_overlapped != NULL) filepos = (off_t) ((((ULONG64) p_overlapped->OffsetHigh) << 32) | ((ULONG64) p_overlapped->Offset));
+
+	while(n_done < (SIZE_T) n_bytes)
+	{
+		if(p_overlapped != NULL) n_ret = pread(p_handle->fd, &p_bytes[n_done], ((SIZE_T) n_bytes) - n_done, filepos + (off_t) n_done);
+		else n_ret = read(p_handle->fd, &p_bytes[n_done], ((SIZE_T) n_bytes) - n_done);
+
+		if(n_ret < 0)
+		{
+			if(errno == EINTR) continue;
+			return posixdef_set_error(ERROR_GEN_FAILURE);
+		}
+
+		if(!n_ret) break;
+
+		n_done += (SIZE_T) n_ret;
+	}
+
+	if(p_n_read != NULL) *p_n_read = (DWORD) n_done;
+
+	if(p_overlapped != NULL)
+	{
+		p_overlapped->InternalHigh = (ULONG_PTR) n_done;
+		p_overlapped->Internal = STATUS_SUCCESS;
+
+		/*Overlapped reads report the end of file as an error*/
+
+		if((!n_done) && n_bytes)
+		{
+			p_overlapped->Internal = STATUS_END_OF_FILE;
+			return posixdef_set_error(ERROR_HANDLE_EOF);
+		}
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI WriteFile(HANDLE h_file, const VOID *p_buffer, DWORD n_bytes, DWORD *p_n_written, OVERLAPPED *p_overlapped)
+{
+	posixdef_handle_t *p_handle = NULL;
+	const BYTE *p_bytes = (const BYTE*) p_buffer;
+	SIZE_T n_done = 0u;
+	ssize_t n_ret = 0;
+
+	if(p_n_written != NULL) *p_n_written = 0u;
+
+	p_handle = posixdef_handle_get(h_file, POSIXDEF_HANDLE_FILE);
+	if(p_handle == NULL) return posixdef_set_error(ERROR_GEN_FAILURE);
+	if(p_overlapped != NULL) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	while(n_done < (SIZE_T) n_bytes)
+	{
+		n_ret = write(p_handle->fd, &p_bytes[n_done], ((SIZE_T) n_bytes) - n_done);
+
+		if(n_ret < 0)
+		{
+			if(errno == EINTR) continue;
+			break;
+		}
+
+		n_done += (SIZE_T) n_ret;
+	}
+
+	if(p_n_written != NULL) *p_n_written = (DWORD) n_done;
+
+	if(n_done < (SIZE_T) n_bytes) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	return TRUE;
+}
+
+BOOL WINAPI GetOverlappedResult(HANDLE h_file, OVERLAPPED *p_overlapped, DWORD *p_n_bytes, BOOL wait)
+{
+	if(p_overlapped == NULL) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	if(p_n_bytes != NULL) *p_n_bytes = (DWORD) p_overlapped->InternalHigh;
+
+	if(p_overlapped->Internal == STATUS_END_OF_FILE) return posixdef_set_error(ERROR_HANDLE_EOF);
+
+	return TRUE;
+}
+
+BOOL WINAPI CancelIoEx(HANDLE h_file, OVERLAPPED *p_overlapped)
+{
+	/*Reads complete synchronously, there's never any to cancel*/
+	return posixdef_set_error(ERROR_GEN_FAILURE);
+}
+
+DWORD WINAPI SetFilePointer(HANDLE h_file, LONG distance_low, LONG *p_distance_high, DWORD move_method)
+{
+	posixdef_handle_t *p_handle = NULL;
+	LONG64 distance = 0;
+	LONG64 new_pos = 0;
+
+	p_handle = posixdef_handle_get(h_file, POSIXDEF_HANDLE_FILE);
+	if(p_handle == NULL)
+	{
+		posixdef_set_error(ERROR_GEN_FAILURE);
+		return INVALID_SET_FILE_POINTER;
+	}
+
+	if(p_distance_high != NULL) distance = (LONG64) ((((ULONG64) (ULONG32) *p_distance_high) << 32) | ((ULONG64) (ULONG32) distance_low));
+	else distance = (LONG64) distance_low;
+
+	if(!posixdef_seek(p_handle->fd, distance, move_method, &new_pos)) return INVALID_SET_FILE_POINTER;
+
+	if(p_distance_high != NULL) *p_distance_high = (LONG) (new_pos >> 32);
+
+	return (DWORD) (new_pos & 0xffffffff);
+}
+
+BOOL WINAPI SetFilePointerEx(HANDLE h_file, LARGE_INTEGER distance, LARGE_INTEGER *p_new_pos, DWORD move_method)
+{
+	posixdef_handle_t *p_handle = NULL;
+	LONG64 new_pos = 0;
+
+	p_handle = posixdef_handle_get(h_file, POSIXDEF_HANDLE_FILE);
+	if(p_handle == NULL) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	if(!posixdef_seek(p_handle->fd, distance.QuadPart, move_method, &new_pos)) return FALSE;
+
+	if(p_new_pos != NULL) p_new_pos->QuadPart = new_pos;
+	return TRUE;
+}
+
+DWORD WINAPI GetFileSize(HANDLE h_file, DWORD *p_size_high)
+{
+	LARGE_INTEGER size;
+
+	if(!GetFileSizeEx(h_file, &size)) return INVALID_FILE_SIZE;
+
+	if(p_size_high != NULL) *p_size_high = (DWORD) (((ULONG64) size.QuadPart) >> 32);
+
+	return (DWORD) (((ULONG64) size.QuadPart) & 0xffffffffu);
+}
+
+BOOL WINAPI GetFileSizeEx(HANDLE h_file, LARGE_INTEGER *p_size)
+{
+	posixdef_handle_t *p_handle = NULL;
+	struct stat file_stat;
+
+	p_handle = posixdef_handle_get(h_file, POSIXDEF_HANDLE_FILE);
+	if(p_handle == NULL) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	if(fstat(p_handle->fd, &file_stat)) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	p_size->QuadPart = (LONG64) file_stat.st_size;
+	return TRUE;
+}
+
+BOOL WINAPI SetEndOfFile(HANDLE h_file)
+{
+	posixdef_handle_t *p_handle = NULL;
+	off_t pos = 0;
+
+	p_handle = posixdef_handle_get(h_file, POSIXDEF_HANDLE_FILE);
+	if(p_handle == NULL) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	pos = lseek(p_handle->fd, 0, SEEK_CUR);
+	if(pos < 0) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	if(ftruncate(p_handle->fd, pos)) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	return TRUE;
+}
+
+BOOL WINAPI FlushFileBuffers(HANDLE h_file)
+{
+	posixdef_handle_t *p_handle = NULL;
+
+	p_handle = posixdef_handle_get(h_file, POSIXDEF_HANDLE_FILE);
+	if(p_handle == NULL) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	if(fsync(p_handle->fd)) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	return TRUE;
+}
+
+HANDLE WINAPI CreateFileMapping(HANDLE h_file, VOID *p_security, DWORD protect, DWORD max_size_high, DWORD max_size_low, const TCHAR *name)
+{
+	posixdef_handle_t *p_file = NULL;
+	posixdef_handle_t *p_map = NULL;
+	LARGE_INTEGER size;
+
+	p_file = posixdef_handle_get(h_file, POSIXDEF_HANDLE_FILE);
+	if(p_file == NULL) goto _l_createfilemapping_error;
+
+	if(protect != PAGE_READONLY) goto _l_createfilemapping_error;
+
+	size.QuadPart = (LONG64) ((((ULONG64) max_size_high) << 32) | ((ULONG64) max_size_low));
+	if(!size.QuadPart)
+	{
+		if(!GetFileSizeEx(h_file, &size)) goto _l_createfilemapping_error;
+	}
+
+	/*Same as Win32: an empty file can't be mapped*/
+
+	if(size.QuadPart <= 0) goto _l_createfilemapping_error;
+
+	p_map = (posixdef_handle_t*) posixdef_handle_create(POSIXDEF_HANDLE_MAP);
+	if(p_map == NULL) goto _l_createfilemapping_error;
+
+	p_map->fd = dup(p_file->fd);
+	if(p_map->fd < 0)
+	{
+		free(p_map);
+		goto _l_createfilemapping_error;
+	}
+
+	p_map->map_size = (SIZE_T) size.QuadPart;
+	return (HANDLE) p_map;
+
+_l_createfilemapping_error:
+	posixdef_set_error(ERROR_GEN_FAILURE);
+	return NULL;
+}
+
+VOID* WINAPI MapViewOfFile(HANDLE h_map, DWORD access, DWORD offset_high, DWORD offset_low, SIZE_T size)
+{
+	posixdef_handle_t *p_map = NULL;
+	ULONG64 offset = 0u;
+	VOID *p_view = NULL;
+
+	p_map = posixdef_handle_get(h_map, POSIXDEF_HANDLE_MAP);
+	if(p_map == NULL) goto _l_mapviewoffile_error;
+
+	if(access != FILE_MAP_READ) goto _l_mapviewoffile_error;
+
+	offset = (((ULONG64) offset_high) << 32) | ((ULONG64) offset_low);
+	if(offset >= (ULONG64) p_map->map_size) goto _l_mapviewoffile_error;
+
+	if(!size) size = (SIZE_T) (((ULONG64) p_map->map_size) - offset);
+	if((offset + (ULONG64) size) > (ULONG64) p_map->map_size) goto _l_mapviewoffile_error;
+
+	p_view = mmap(NULL, size, PROT_READ, MAP_SHARED, p_map->fd, (off_t) offset);
+	if(p_view == MAP_FAILED) goto _l_mapviewoffile_error;
+
+	if(!posixdef_region_add(p_view, size))
+	{
+		munmap(p_view, size);
+		goto _l_mapviewoffile_error;
+	}
+
+	return p_view;
+
+_l_mapviewoffile_error:
+	posixdef_set_error(ERROR_GEN_FAILURE);
+	return NULL;
+}
+
+BOOL WINAPI UnmapViewOfFile(const VOID *p_view)
+{
+	return posixdef_region_release(p_view);
+}
+
+static BOOL WINAPI posixdef_find_next(posixdef_handle_t *p_find, WIN32_FIND_DATA *p_find_data)
+{
+	struct dirent *p_entry = NULL;
+	struct stat file_stat;
+
+	while(TRUE)
+	{
+		p_entry = readdir(p_find->p_dir);
+		if(p_entry == NULL) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+		if(fnmatch(p_find->pattern, p_entry->d_name, 0)) continue;
+
+		ZeroMemory(p_find_data, sizeof(WIN32_FIND_DATA));
+
+		if(!fstatat(dirfd(p_find->p_dir), p_entry->d_name, &file_stat, 0))
+		{
+			if(S_ISDIR(file_stat.st_mode)) p_find_data->dwFileAttributes = FILE_ATTRIBUTE_DIRECTORY;
+			else p_find_data->dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+
+			p_find_data->nFileSizeHigh = (DWORD) (((ULONG64) file_stat.st_size) >> 32);
+			p_find_data->nFileSizeLow = (DWORD) (((ULONG64) file_stat.st_size) & 0xffffffffu);
+		}
+		else p_find_data->dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+
+		posixdef_name(p_entry->d_name, p_find_data->cFileName, MAX_PATH);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+HANDLE WINAPI FindFirstFile(const TCHAR *file_dir, WIN32_FIND_DATA *p_find_data)
+{
+	posixdef_handle_t *p_find = NULL;
+	CHAR path[POSIXDEF_PATH_SIZE];
+	CHAR *p_slash = NULL;
+
+	if(!posixdef_path(file_dir, path, POSIXDEF_PATH_SIZE)) goto _l_findfirstfile_error;
+
+	p_find = (posixdef_handle_t*) posixdef_handle_create(POSIXDEF_HANDLE_FIND);
+	if(p_find == NULL) goto _l_findfirstfile_error;
+
+	/*Split the directory from the file name pattern*/
+
+	p_slash = strrchr(path, '/');
+
+	if(p_slash == NULL)
+	{
+		strcpy(p_find->pattern, path);
+		p_find->p_dir = opendir(".");
+	}
+	else
+	{
+		strcpy(p_find->pattern, &p_slash[1]);
+
+		if(p_slash == path) p_find->p_dir = opendir("/");
+		else
+		{
+			*p_slash = '\0';
+			p_find->p_dir = opendir(path);
+		}
+	}
+
+	if(p_find->p_dir == NULL) goto _l_findfirstfile_error;
+
+	if(!posixdef_find_next(p_find, p_find_data)) goto _l_findfirstfile_error;
+
+	return (HANDLE) p_find;
+
+_l_findfirstfile_error:
+	if(p_find != NULL) CloseHandle((HANDLE) p_find);
+
+	posixdef_set_error(ERROR_GEN_FAILURE);
+	return INVALID_HANDLE_VALUE;
+}
+
+BOOL WINAPI FindNextFile(HANDLE h_find, WIN32_FIND_DATA *p_find_data)
+{
+	posixdef_handle_t *p_find = NULL;
+
+	p_find = posixdef_handle_get(h_find, POSIXDEF_HANDLE_FIND);
+	if(p_find == NULL) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	return posixdef_find_next(p_find, p_find_data);
+}
+
+BOOL WINAPI FindClose(HANDLE h_find)
+{
+	if(posixdef_handle_get(h_find, POSIXDEF_HANDLE_FIND) == NULL) return posixdef_set_error(ERROR_GEN_FAILURE);
+
+	return CloseHandle(h_find);
+}
+
+/*======================================================================================*/
+/*System*/
+
+VOID WINAPI GetSystemInfo(SYSTEM_INFO *p_sysinfo)
+{
+	LONG n_cpus = 0;
+
+	n_cpus = (LONG) sysconf(_SC_NPROCESSORS_ONLN);
+	if(n_cpus < 1) n_cpus = 1;
+
+	p_sysinfo->dwPageSize = (DWORD) posixdef_get_pagesize();
+	p_sysinfo->dwNumberOfProcessors = (DWORD) n_cpus;
+	p_sysinfo->dwAllocationGranularity = (DWORD) posixdef_get_pagesize();
+	return;
+}
+
+BOOL WINAPI QueryPerformanceCounter(LARGE_INTEGER *p_count)
+{
+	struct timespec time_now;
+
+	clock_gettime(CLOCK_MONOTONIC, &time_now);
+
+	p_count->QuadPart = ((LONG64) time_now.tv_sec)*1000000000LL + ((LONG64) time_now.tv_nsec);
+	return TRUE;
+}
+
+BOOL WINAPI QueryPerformanceFrequency(LARGE_INTEGER *p_freq)
+{
+	p_freq->QuadPart = 1000000000LL;
+	return TRUE;
+}
+
+VOID WINAPI Sleep(DWORD time_ms)
+{
+	struct timespec time_req;
+
+	if(!time_ms)
+	{
+		sched_yield();
+		return;
+	}
+
+	time_req.tv_sec = (time_t) (time_ms/1000u);
+	time_req.tv_nsec = ((long) (time_ms%1000u))*1000000L;
+
+	while(nanosleep(&time_req, &time_req) && (errno == EINTR));
+
+	return;
+}
+
+VOID WINAPI ExitProcess(UINT exit_code)
+{
+	exit((INT) exit_code);
+}
+
+INT WINAPI MessageBox(HWND p_wnd, const TCHAR *text, const TCHAR *caption, UINT type)
+{
+
+#ifdef UNICODE
+	fprintf(stderr, "%ls: %ls\n", caption, text);
+#else
+	fprintf(stderr, "%s: %s\n", caption, text);
+#endif
+
+	return 1;
+}
+
+#endif /*_WIN32*/
@@ -0,0 +1,315 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+/*
+	POSIX Definitions:
+
+	POSIX implementation of the Win32 API subset used by the DSP engine, the file, null and simulated clock backends, the batch renderer
+	and the test programs (rtdsptest, kernelbench), so these build and run on Linux (see build_linux.sh).
+	globldef.h includes this file instead of <windows.h> when _WIN32 isn't defined.
+
+	This is not a general Win32 emulation, only what the modules above use. The user interface (main.cpp) and the WASAPI backend stay Windows only.
+	Threads and events aren't here either: thread.c implements them on pthread directly.
+
+	Differences from Win32:
+
+	Paths: TCHAR paths are converted to UTF-8, backslashes to slashes.
+	CreateFile(): sharing modes and flags are ignored.
+	Overlapped reads (ReadFile() with an OVERLAPPED) always complete synchronously: ReadFile() returns TRUE (or FALSE with ERROR_HANDLE_EOF),
+	the event in OVERLAPPED is left alone, the result is retrieved with GetOverlappedResult().
+	CancelIoEx() has nothing to cancel.
+	HeapCreate() always fails (callers fall back to GetProcessHeap()), every heap is the C runtime heap.
+	GetLargePageMinimum() returns 0 (no large pages).
+	FindFirstFile(): '*' and '?' wildcards in the last path component only, case sensitive.
+	GetLastError(): only the errors callers check for (ERROR_IO_PENDING, ERROR_HANDLE_EOF) are told apart, any other error reads ERROR_GEN_FAILURE.
+	MessageBox() prints the message on stderr.
+*/
+
+#ifndef POSIXDEF_H
+#define POSIXDEF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <wchar.h>
+#include <sys/types.h>
+
+/*======================================================================================*/
+/*Types*/
+
+#define WINAPI
+#define CALLBACK
+#define __declspec(attr) __attribute__((attr))
+
+#define VOID void
+
+typedef int BOOL;
+typedef uint8_t BYTE;
+typedef char CHAR;
+typedef wchar_t WCHAR;
+typedef int INT;
+typedef unsigned int UINT;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef float FLOAT;
+typedef double DOUBLE;
+
+typedef int8_t INT8;
+typedef int16_t INT16;
+typedef int32_t INT32;
+typedef int64_t INT64;
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint32_t UINT32;
+typedef uint64_t UINT64;
+typedef int32_t LONG32;
+typedef uint32_t ULONG32;
+typedef int64_t LONG64;
+typedef uint64_t ULONG64;
+typedef int64_t LONGLONG;
+typedef uint64_t ULONGLONG;
+
+typedef size_t SIZE_T;
+typedef ssize_t SSIZE_T;
+typedef intptr_t INT_PTR;
+typedef uintptr_t UINT_PTR;
+typedef intptr_t LONG_PTR;
+typedef uintptr_t ULONG_PTR;
+
+typedef VOID *HANDLE;
+typedef HANDLE HINSTANCE;
+typedef HANDLE HWND;
+
+#ifdef UNICODE
+typedef WCHAR TCHAR;
+#define TEXT(str) L##str
+#else
+typedef CHAR TCHAR;
+#define TEXT(str) str
+#endif
+
+typedef union {
+	struct {
+		DWORD LowPart;
+		LONG HighPart;
+	};
+	LONG64 QuadPart;
+} LARGE_INTEGER;
+
+typedef union {
+	struct {
+		DWORD LowPart;
+		DWORD HighPart;
+	};
+	ULONG64 QuadPart;
+} ULARGE_INTEGER;
+
+/*Internal: completion status (STATUS_SUCCESS or STATUS_END_OF_FILE). InternalHigh: number of bytes read.*/
+
+typedef struct {
+	ULONG_PTR Internal;
+	ULONG_PTR InternalHigh;
+	union {
+		struct {
+			DWORD Offset;
+			DWORD OffsetHigh;
+		};
+		VOID *Pointer;
+	};
+	HANDLE hEvent;
+} OVERLAPPED;
+
+typedef struct {
+	DWORD dwPageSize;
+	DWORD dwNumberOfProcessors;
+	DWORD dwAllocationGranularity;
+} SYSTEM_INFO;
+
+#define MAX_PATH 260
+
+typedef struct {
+	DWORD dwFileAttributes;
+	DWORD nFileSizeHigh;
+	DWORD nFileSizeLow;
+	TCHAR cFileName[MAX_PATH];
+} WIN32_FIND_DATA;
+
+/*======================================================================================*/
+/*Constants*/
+
+#define TRUE 1
+#define FALSE 0
+
+#define INFINITE 0xffffffffu
+
+#define INVALID_HANDLE_VALUE ((HANDLE) (LONG_PTR) -1)
+#define INVALID_FILE_SIZE 0xffffffffu
+#define INVALID_SET_FILE_POINTER 0xffffffffu
+
+#define GENERIC_READ 0x80000000u
+#define GENERIC_WRITE 0x40000000u
+
+#define FILE_SHARE_READ 0x1u
+#define FILE_SHARE_WRITE 0x2u
+
+#define CREATE_ALWAYS 2u
+#define OPEN_EXISTING 3u
+
+#define FILE_ATTRIBUTE_DIRECTORY 0x10u
+#define FILE_ATTRIBUTE_NORMAL 0x80u
+#define FILE_FLAG_SEQUENTIAL_SCAN 0x08000000u
+#define FILE_FLAG_OVERLAPPED 0x40000000u
+
+#define FILE_BEGIN 0u
+#define FILE_CURRENT 1u
+#define FILE_END 2u
+
+#define PAGE_READONLY 0x02u
+#define PAGE_READWRITE 0x04u
+#define FILE_MAP_READ 0x04u
+
+#define MEM_COMMIT 0x1000u
+#define MEM_RESERVE 0x2000u
+#define MEM_DECOMMIT 0x4000u
+#define MEM_RELEASE 0x8000u
+#define MEM_LARGE_PAGES 0x20000000u
+
+#define HEAP_ZERO_MEMORY 0x08u
+
+#define ERROR_HANDLE_EOF 38u
+#define ERROR_GEN_FAILURE 31u
+#define ERROR_IO_PENDING 997u
+
+#define STATUS_SUCCESS 0x00000000u
+#define STATUS_END_OF_FILE 0xc0000011u
+
+#define MB_OK 0x00u
+#define MB_ICONSTOP 0x10u
+#define MB_ICONEXCLAMATION 0x30u
+#define MB_ICONINFORMATION 0x40u
+
+/*======================================================================================*/
+/*Memory*/
+
+#define ZeroMemory(dst, len) memset((dst), 0, (len))
+#define FillMemory(dst, len, val) memset((dst), (val), (len))
+#define CopyMemory(dst, src, len) memcpy((dst), (src), (len))
+#define MoveMemory(dst, src, len) memmove((dst), (src), (len))
+#define RtlEqualMemory(dst, src, len) (!memcmp((dst), (src), (len)))
+
+extern HANDLE WINAPI GetProcessHeap(VOID);
+extern HANDLE WINAPI HeapCreate(DWORD options, SIZE_T initial_size, SIZE_T max_size);
+extern BOOL WINAPI HeapDestroy(HANDLE p_heap);
+extern VOID* WINAPI HeapAlloc(HANDLE p_heap, DWORD flags, SIZE_T size);
+extern BOOL WINAPI HeapFree(HANDLE p_heap, DWORD flags, VOID *p_mem);
+
+/*MEM_RESERVE maps inaccessible pages, MEM_COMMIT makes them read/write (zeroed on first touch), MEM_DECOMMIT drops them, MEM_RELEASE unmaps the whole reservation.*/
+
+extern VOID* WINAPI VirtualAlloc(VOID *p_addr, SIZE_T size, DWORD alloc_type, DWORD protect);
+extern BOOL WINAPI VirtualFree(VOID *p_addr, SIZE_T size, DWORD free_type);
+extern SIZE_T WINAPI GetLargePageMinimum(VOID);
+
+/*======================================================================================*/
+/*Files*/
+
+extern DWORD WINAPI GetLastError(VOID);
+
+extern HANDLE WINAPI CreateFile(const TCHAR *file_dir, DWORD access, DWORD share_mode, VOID *p_security, DWORD creation, DWORD flags, HANDLE h_template);
+extern BOOL WINAPI CloseHandle(HANDLE h_object);
+extern BOOL WINAPI DeleteFile(const TCHAR *file_dir);
+
+extern BOOL WINAPI ReadFile(HANDLE h_file, VOID *p_buffer, DWORD n_bytes, DWORD *p_n_read, OVERLAPPED *p_overlapped);
+extern BOOL WINAPI WriteFile(HANDLE h_file, const VOID *p_buffer, DWORD n_bytes, DWORD *p_n_written, OVERLAPPED *p_overlapped);
+extern BOOL WINAPI GetOverlappedResult(HANDLE h_file, OVERLAPPED *p_overlapped, DWORD *p_n_bytes, BOOL wait);
+extern BOOL WINAPI CancelIoEx(HANDLE h_file, OVERLAPPED *p_overlapped);
+
+#define HasOverlappedIoCompleted(p_overlapped) TRUE
+
+extern DWORD WINAPI SetFilePointer(HANDLE h_file, LONG distance_low, LONG *p_distance_high, DWORD move_method);
+extern BOOL WINAPI SetFilePointerEx(HANDLE h_file, LARGE_INTEGER distance, LARGE_INTEGER *p_new_pos, DWORD move_method);
+extern DWORD WINAPI GetFileSize(HANDLE h_file, DWORD *p_size_high);
+extern BOOL WINAPI GetFileSizeEx(HANDLE h_file, LARGE_INTEGER *p_size);
+extern BOOL WINAPI SetEndOfFile(HANDLE h_file);
+extern BOOL WINAPI FlushFileBuffers(HANDLE h_file);
+
+/*Read only mappings of the whole file (or of size bytes from the given offset).*/
+
+extern HANDLE WINAPI CreateFileMapping(HANDLE h_file, VOID *p_security, DWORD protect, DWORD max_size_high, DWORD max_size_low, const TCHAR *name);
+extern VOID* WINAPI MapViewOfFile(HANDLE h_map, DWORD access, DWORD offset_high, DWORD offset_low, SIZE_T size);
+extern BOOL WINAPI UnmapViewOfFile(const VOID *p_view);
+
+extern HANDLE WINAPI FindFirstFile(const TCHAR *file_dir, WIN32_FIND_DATA *p_find_data);
+extern BOOL WINAPI FindNextFile(HANDLE h_find, WIN32_FIND_DATA *p_find_data);
+extern BOOL WINAPI FindClose(HANDLE h_find);
+
+/*======================================================================================*/
+/*System*/
+
+extern VOID WINAPI GetSystemInfo(SYSTEM_INFO *p_sysinfo);
+
+/*The counter is CLOCK_MONOTONIC in nanoseconds*/
+
+extern BOOL WINAPI QueryPerformanceCounter(LARGE_INTEGER *p_count);
+extern BOOL WINAPI QueryPerformanceFrequency(LARGE_INTEGER *p_freq);
+
+extern VOID WINAPI Sleep(DWORD time_ms);
+
+extern __declspec(noreturn) VOID WINAPI ExitProcess(UINT exit_code);
+
+extern INT WINAPI MessageBox(HWND p_wnd, const TCHAR *text, const TCHAR *caption, UINT type);
+
+/*======================================================================================*/
+/*Interlocked operations (sequentially consistent, as the Win32 ones)*/
+
+static inline LONG InterlockedExchange(volatile LONG *p_target, LONG value)
+{
+	return __atomic_exchange_n(p_target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG InterlockedCompareExchange(volatile LONG *p_target, LONG exchange, LONG comparand)
+{
+	__atomic_compare_exchange_n(p_target, &comparand, exchange, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return comparand;
+}
+
+static inline LONG InterlockedIncrement(volatile LONG *p_target)
+{
+	return __atomic_add_fetch(p_target, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG InterlockedDecrement(volatile LONG *p_target)
+{
+	return __atomic_sub_fetch(p_target, 1, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG InterlockedExchangeAdd(volatile LONG *p_target, LONG value)
+{
+	return __atomic_fetch_add(p_target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG64 InterlockedExchange64(volatile LONG64 *p_target, LONG64 value)
+{
+	return __atomic_exchange_n(p_target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline LONG64 InterlockedCompareExchange64(volatile LONG64 *p_target, LONG64 exchange, LONG64 comparand)
+{
+	__atomic_compare_exchange_n(p_target, &comparand, exchange, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return comparand;
+}
+
+static inline LONG64 InterlockedExchangeAdd64(volatile LONG64 *p_target, LONG64 value)
+{
+	return __atomic_fetch_add(p_target, value, __ATOMIC_SEQ_CST);
+}
+
+#define MemoryBarrier() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#endif /*POSIXDEF_H*/
@@ -0,0 +1,1522 @@
+/*
+	Audio Real-Time Delay for Windows
+	Version 1.2
+
+	Author: Rafael Sabe
+	Email: rafaelmsabe@gmail.com
+*/
+
+/*
+	Engine Test Program:
+
+	Standalone console program. Runs the whole load/DSP/play pipeline without any audio device, through the
+	WAV file (AudioBackend_WAVFile), null (AudioBackend_Null) and simulated clock (AudioBackend_SimClock) backends, and checks the output.
+
+	Render: every output file must match a reference model byte for byte (the recursive comb: within its error bound, see AudioRTDSP::enableRecursiveComb()). The model is the effect computed the plain way
+	(every feedback tap of every sample, with an integer division), so the checks cover the span kernels, the tap gains,
+	every kernel ISA supported by the running CPU, the mapped and read-ahead inputs, and the parallel render.
+
+	Playback: the WAV file output must hold the audio buffer prime (silence), then the model output. The last segment is padded with silence,
+	over which the feedback taps keep playing the end of the input (the model reads silence past the end of the input as well).
+	The null and simulated clock outputs must receive every frame.
+
+	Commands: commands posted with timestamps (postCommand()) must apply at exactly their frame. Render and WAV file playback outputs must match the model
+	with the FX parameters switched at those frames, a seek must continue from its target frame, a stop must end the output there,
+	commands that don't fit the input buffer ring must be dropped and counted, and two runs must give the same output.
+	A delay change with a transition time must show in the transition statistics.
+
+	Pacing: the simulated clock in real time mode (the device plays on whatever the engine does, see AudioBackend_SimClock.hpp)
+	must not run dry at 48 kHz (plays in real time, 2.5 seconds per sample format), and must run dry at a sample rate no CPU can keep up with.
+
+	Latency: playback on the simulated clock (deterministic mode) at device periods that aren't powers of 2.
+	Prints the segment size and the output queued behind each new segment (average), and checks that the device never runs dry.
+
+	Telemetry: playback stage counts, histograms and report file when built with __RTDSP_TELEMETRY (see test_telemetry_checks()).
+
+	Threads: the thread.h workers and events (run/wait cycles, timeouts, manual and auto reset, force quit).
+
+	Test files are written to the current directory and deleted afterwards.
+	Exit code is 0 if every check passes, 1 otherwise.
+
+	rtdsptest bench [heavy feedback count]: runs the playback benchmarks instead of the checks (real time, a few seconds each), see test_bench().
+*/
+
+#include "AudioRTDSP.hpp"
+#include "AudioRTDSP_i16.hpp"
+#include "AudioRTDSP_i24.hpp"
+#include "AudioBackend_Null.hpp"
+#include "AudioBackend_SimClock.hpp"
+#include "AudioBackend_WAVFile.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef UNICODE
+#define TEST_FORMAT_TSTR "%ls"
+#else
+#define TEST_FORMAT_TSTR "%s"
+#endif
+
+#define TEST_FILEIN_16_DIR TEXT("rtdsptest_in16.wav")
+#define TEST_FILEIN_24_DIR TEXT("rtdsptest_in24.wav")
+#define TEST_FILEOUT_REF_DIR TEXT("rtdsptest_ref.wav")
+#define TEST_FILEOUT_DIR TEXT("rtdsptest_out.wav")
+#define TEST_FILEOUT_TELEMETRY_DIR TEXT("rtdsptest_telemetry.txt")
+
+#define TEST_HEADER_SIZE_BYTES 44u
+#define TEST_SAMPLE_RATE 48000u
+#define TEST_N_CHANNELS 2u
+#define TEST_N_FRAMES 120000u
+
+#define TEST_N_ISA 4
+
+static const CHAR *TEST_ISA_NAMES[TEST_N_ISA] = {"scalar", "sse2", "avx2", "neon"};
+
+/*
+	FX parameter sets: the playback defaults, power of 2 dividers, many short taps (ring larger than the default),
+	and the recursive comb (not bit-identical to the model, checked against it within its error bound, see AudioRTDSP::enableRecursiveComb()).
+*/
+
+#define TEST_N_FX 4
+
+static const audiortdsp_fx_params_t TEST_FX_PARAMS[TEST_N_FX] = {
+	{240, 20, TRUE, TRUE, FALSE},
+	{1000, 6, FALSE, FALSE, FALSE},
+	{37, 300, TRUE, TRUE, FALSE},
+	{240, 20, FALSE, FALSE, TRUE}
+};
+
+struct _test_input {
+	const TCHAR *file_dir;
+	UINT16 bit_depth;
+	SIZE_T n_frames;
+	INT32 *p_samples;
+};
+
+typedef struct _test_input test_input_t;
+
+static UINT n_checks = 0u;
+static UINT n_failed = 0u;
+
+static UINT32 test_rand_state = 0x2545f491u;
+
+/*main.cpp counterparts. This program has no window.*/
+
+__declspec(noreturn) VOID WINAPI app_exit(UINT exit_code, const TCHAR *exit_msg)
+{
+	if(exit_msg != NULL) printf("app_exit: " TEST_FORMAT_TSTR "\n", exit_msg);
+
+	ExitProcess(exit_code);
+	while(TRUE) Sleep(1000u);
+}
+
+BOOL WINAPI listbox_clear(HWND p_listbox)
+{
+	return TRUE;
+}
+
+SSIZE_T WINAPI listbox_add_item(HWND p_listbox, const TCHAR *text)
+{
+	return -1;
+}
+
+SSIZE_T WINAPI listbox_remove_item(HWND p_listbox, SIZE_T index)
+{
+	return -1;
+}
+
+SSIZE_T WINAPI listbox_get_item_count(HWND p_listbox)
+{
+	return 0;
+}
+
+SSIZE_T WINAPI listbox_get_sel_index(HWND p_listbox)
+{
+	return -1;
+}
+
+/*======================================================================================*/
+/*Helpers*/
+
+static VOID WINAPI test_check(BOOL passed, const CHAR *name)
+{
+	n_checks++;
+	if(!passed) n_failed++;
+
+	printf("%s %s\n", passed ? "PASS" : "FAIL", name);
+	return;
+}
+
+static VOID WINAPI test_print_error(AudioRTDSP *p_audio)
+{
+	printf("    " TEST_FORMAT_TSTR "\n", p_audio->getLastErrorMessage().c_str());
+	return;
+}
+
+/*dspkernel_init() only selects once, this is its selection order.*/
+
+static VOID WINAPI test_select_isa_best(VOID)
+{
+	if(dspkernel_select_isa(DSPKERNEL_ISA_AVX2)) return;
+	if(dspkernel_select_isa(DSPKERNEL_ISA_NEON)) return;
+	if(dspkernel_select_isa(DSPKERNEL_ISA_SSE2)) return;
+
+	dspkernel_select_isa(DSPKERNEL_ISA_SCALAR);
+	return;
+}
+
+static INT32 WINAPI test_rand(UINT32 n_bits)
+{
+	test_rand_state = test_rand_state*1664525u + 1013904223u;
+	return ((INT32) test_rand_state) >> (32u - n_bits);
+}
+
+/*
+	Writes a headerless input file (TEST_HEADER_SIZE_BYTES zero bytes, then the audio data): the engine only uses the data position.
+	One sample in 4 is full scale, so the output saturates now and then.
+*/
+
+static BOOL WINAPI test_write_input(test_input_t *p_input)
+{
+	HANDLE h_file = INVALID_HANDLE_VALUE;
+	BYTE *p_data = NULL;
+	SIZE_T sample_size = (SIZE_T) (p_input->bit_depth/8u);
+	SIZE_T n_samples = TEST_N_FRAMES*TEST_N_CHANNELS;
+	SIZE_T n_sample;
+	DWORD n_written = 0u;
+	INT32 sample = 0;
+	BOOL ret = FALSE;
+
+	p_input->p_samples = (INT32*) HeapAlloc(p_processheap, 0u, n_samples*sizeof(INT32));
+	p_data = (BYTE*) HeapAlloc(p_processheap, HEAP_ZERO_MEMORY, TEST_HEADER_SIZE_BYTES + n_samples*sample_size);
+
+	if((p_input->p_samples == NULL) || (p_data == NULL)) goto _l_test_write_input_end;
+
+	for(n_sample = 0u; n_sample < n_samples; n_sample++)
+	{
+		sample = test_rand((UINT32) p_input->bit_depth);
+
+		if(!(test_rand(8u) & 0x3)) sample = (sample < 0) ? -(1 << (p_input->bit_depth - 1u)) : ((1 << (p_input->bit_depth - 1u)) - 1);
+
+		p_input->p_samples[n_sample] = sample;
+		CopyMemory(&p_data[TEST_HEADER_SIZE_BYTES + n_sample*sample_size], &sample, sample_size);
+	}
+
+	h_file = CreateFile(p_input->file_dir, GENERIC_WRITE, 0u, NULL, CREATE_ALWAYS, 0u, NULL);
+	if(h_file == INVALID_HANDLE_VALUE) goto _l_test_write_input_end;
+
+	ret = WriteFile(h_file, p_data, (DWORD) (TEST_HEADER_SIZE_BYTES + n_samples*sample_size), &n_written, NULL);
+	CloseHandle(h_file);
+
+_l_test_write_input_end:
+	if(p_data != NULL) HeapFree(p_processheap, 0u, p_data);
+	return ret;
+}
+
+/*Reads a whole file. The caller frees *pp_data.*/
+
+static BOOL WINAPI test_read_file(const TCHAR *file_dir, BYTE **pp_data, SIZE_T *p_size)
+{
+	HANDLE h_file = INVALID_HANDLE_VALUE;
+	LARGE_INTEGER file_size;
+	DWORD n_read = 0u;
+	BOOL ret = FALSE;
+
+	*pp_data = NULL;
+	*p_size = 0u;
+
+	h_file = CreateFile(file_dir, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0u, NULL);
+	if(h_file == INVALID_HANDLE_VALUE) return FALSE;
+
+	if(!GetFileSizeEx(h_file, &file_size)) goto _l_test_read_file_end;
+
+	*pp_data = (BYTE*) HeapAlloc(p_processheap, 0u, (SIZE_T) file_size.QuadPart + 1u);
+	if(*pp_data == NULL) goto _l_test_read_file_end;
+
+	if(!ReadFile(h_file, *pp_data, (DWORD) file_size.QuadPart, &n_read, NULL)) goto _l_test_read_file_end;
+	if(n_read != (DWORD) file_size.QuadPart) goto _l_test_read_file_end;
+
+	*p_size = (SIZE_T) file_size.QuadPart;
+	ret = TRUE;
+
+_l_test_read_file_end:
+	CloseHandle(h_file);
+
+	if(!ret && (*pp_data != NULL))
+	{
+		HeapFree(p_processheap, 0u, *pp_data);
+		*pp_data = NULL;
+	}
+
+	return ret;
+}
+
+static BOOL WINAPI test_compare_files(const TCHAR *file_dir_a, const TCHAR *file_dir_b)
+{
+	BYTE *p_data_a = NULL;
+	BYTE *p_data_b = NULL;
+	SIZE_T size_a = 0u;
+	SIZE_T size_b = 0u;
+	BOOL ret = FALSE;
+
+	if(!test_read_file(file_dir_a, &p_data_a, &size_a)) goto _l_test_compare_files_end;
+	if(!test_read_file(file_dir_b, &p_data_b, &size_b)) goto _l_test_compare_files_end;
+
+	if(size_a != size_b) goto _l_test_compare_files_end;
+
+	ret = !memcmp(p_data_a, p_data_b, size_a);
+
+_l_test_compare_files_end:
+	if(p_data_a != NULL) HeapFree(p_processheap, 0u, p_data_a);
+	if(p_data_b != NULL) HeapFree(p_processheap, 0u, p_data_b);
+	return ret;
+}
+
+/*
+	Finds the "data" chunk of an output file (plain PCM or WAVE_FORMAT_EXTENSIBLE header).
+	Output samples are INT16 (16bit) or INT32 (24bit on a 32bit container).
+*/
+
+static BOOL WINAPI test_find_data(const BYTE *p_file, SIZE_T file_size, SIZE_T *p_data_begin, SIZE_T *p_data_size)
+{
+	SIZE_T index = 12u;
+	UINT32 chunk_size = 0u;
+
+	while((index + 8u) <= file_size)
+	{
+		CopyMemory(&chunk_size, &p_file[index + 4u], 4u);
+
+		if(!memcmp(&p_file[index], "data", 4u))
+		{
+			*p_data_begin = index + 8u;
+			*p_data_size = (SIZE_T) chunk_size;
+			return ((index + 8u + ((SIZE_T) chunk_size)) <= file_size);
+		}
+
+		index += 8u + ((SIZE_T) chunk_size);
+	}
+
+	return FALSE;
+}
+
+/*
+	Reference model: output sample = clamp((x[t] + sum of the feedback taps)/2), every division truncated towards zero.
+	Tap k (1 to n_feedback + 1) is pol^k*x[t - k*n_delay]/div_k, pol = -1 with feedback_alt_pol, div_k = k + 1 with cyclediv_inc_one, 2^k otherwise.
+	x is silence before the first frame and past the last frame of the input.
+	Writes n_frames output frames in the output file format.
+*/
+
+static VOID WINAPI test_model(const test_input_t *p_input, const audiortdsp_fx_params_t *p_fx, SIZE_T n_frames, BYTE *p_out)
+{
+	SIZE_T n_samples_in = p_input->n_frames*TEST_N_CHANNELS;
+	SIZE_T n_samples = n_frames*TEST_N_CHANNELS;
+	SIZE_T n_sample;
+	SIZE_T tap_offset = 0u;
+	INT32 n_tap;
+	INT64 tap_div = 0;
+	INT64 tap_pol = 0;
+	INT64 acc = 0;
+	INT64 term = 0;
+	INT64 sample_max = (((INT64) 1) << (p_input->bit_depth - 1u)) - 1;
+	INT16 out16 = 0;
+	INT32 out32 = 0;
+
+	for(n_sample = 0u; n_sample < n_samples; n_sample++)
+	{
+		if(n_sample < n_samples_in) acc = (INT64) p_input->p_samples[n_sample];
+		else acc = 0;
+		tap_pol = 1;
+
+		for(n_tap = 1; n_tap <= (p_fx->n_feedback + 1); n_tap++)
+		{
+			if(p_fx->feedback_alt_pol) tap_pol = -tap_pol;
+
+			if(p_fx->cyclediv_inc_one) tap_div = (INT64) (n_tap + 1);
+			else if(n_tap < 32) tap_div = ((INT64) 1) << n_tap;
+			else break;
+
+			tap_offset = ((SIZE_T) n_tap)*((SIZE_T) p_fx->n_delay)*TEST_N_CHANNELS;
+			if(tap_offset > n_sample) break;
+			if((n_sample - tap_offset) >= n_samples_in) continue;
+
+			term = tap_pol*((INT64) p_input->p_samples[n_sample - tap_offset]);
+			acc += term/tap_div;
+		}
+
+		acc /= 2;
+
+		if(acc > sample_max) acc = sample_max;
+		else if(acc < (-sample_max - 1)) acc = -sample_max - 1;
+
+		if(p_input->bit_depth == 16u)
+		{
+			out16 = (INT16) acc;
+			CopyMemory(&p_out[n_sample*sizeof(INT16)], &out16, sizeof(INT16));
+		}
+		else
+		{
+			out32 = ((INT32) acc) << 8;
+			CopyMemory(&p_out[n_sample*sizeof(INT32)], &out32, sizeof(INT32));
+		}
+	}
+
+	return;
+}
+
+/*
+	Largest difference between the engine output and the model: 0 (byte exact) with the feedback taps,
+	(n_taps + 2)/2 LSB with the recursive comb, n_taps = min(n_feedback + 1, sample bits - 1) (see AudioRTDSP::enableRecursiveComb()).
+	The engine falls back to the feedback taps when the comb can't be used, the bound holds either way.
+*/
+
+static INT32 WINAPI test_model_max_diff(const test_input_t *p_input, const audiortdsp_fx_params_t *p_fx)
+{
+	INT32 n_taps = 0;
+
+	if(!p_fx->recursive_comb) return 0;
+
+	n_taps = p_fx->n_feedback + 1;
+	if(n_taps > (INT32) (p_input->bit_depth - 1u)) n_taps = (INT32) (p_input->bit_depth - 1u);
+
+	return (n_taps + 2)/2;
+}
+
+/*
+	Checks an output file against the model: n_frames_lead frames of silence, then the model output.
+	Render (n_frames_lead = 0): exactly the input length. Playback: the input length plus the padding of the last segment (less than n_frames_lead).
+	max_diff: largest difference allowed between an output sample and the model (LSB of the input bit depth), 0 for a byte exact match.
+*/
+
+static BOOL WINAPI test_check_output(const TCHAR *file_dir, const test_input_t *p_input, const audiortdsp_fx_params_t *p_fx, SIZE_T n_frames_lead, INT32 max_diff)
+{
+	BYTE *p_file = NULL;
+	BYTE *p_model = NULL;
+	SIZE_T file_size = 0u;
+	SIZE_T data_begin = 0u;
+	SIZE_T data_size = 0u;
+	SIZE_T frame_size = 0u;
+	SIZE_T model_size = 0u;
+	SIZE_T n_frames = 0u;
+	SIZE_T index;
+	INT16 out16 = 0;
+	INT16 model16 = 0;
+	INT32 out32 = 0;
+	INT32 model32 = 0;
+	INT32 diff = 0;
+	BOOL ret = FALSE;
+
+	frame_size = TEST_N_CHANNELS*((p_input->bit_depth == 16u) ? sizeof(INT16) : sizeof(INT32));
+
+	if(!test_read_file(file_dir, &p_file, &file_size)) goto _l_test_check_output_end;
+	if(!test_find_data(p_file, file_size, &data_begin, &data_size)) goto _l_test_check_output_end;
+
+	if(data_size%frame_size) goto _l_test_check_output_end;
+	if(data_size < (n_frames_lead + TEST_N_FRAMES)*frame_size) goto _l_test_check_output_end;
+
+	n_frames = data_size/frame_size - n_frames_lead;
+
+	if(n_frames_lead)
+	{
+		if(n_frames >= (TEST_N_FRAMES + n_frames_lead)) goto _l_test_check_output_end;
+	}
+	else if(n_frames != TEST_N_FRAMES) goto _l_test_check_output_end;
+
+	model_size = n_frames*frame_size;
+
+	p_model = (BYTE*) HeapAlloc(p_processheap, 0u, model_size);
+	if(p_model == NULL) goto _l_test_check_output_end;
+
+	test_model(p_input, p_fx, n_frames, p_model);
+
+	for(index = 0u; index < n_frames_lead*frame_size; index++) if(p_file[data_begin + index]) goto _l_test_check_output_end;
+
+	if(!max_diff)
+	{
+		ret = !memcmp(&p_file[data_begin + n_frames_lead*frame_size], p_model, model_size);
+		goto _l_test_check_output_end;
+	}
+
+	data_begin += n_frames_lead*frame_size;
+
+	for(index = 0u; index < n_frames*TEST_N_CHANNELS; index++)
+	{
+		if(p_input->bit_depth == 16u)
+		{
+			CopyMemory(&out16, &p_file[data_begin + index*sizeof(INT16)], sizeof(INT16));
+			CopyMemory(&model16, &p_model[index*sizeof(INT16)], sizeof(INT16));
+			diff = ((INT32) out16) - ((INT32) model16);
+		}
+		else
+		{
+			CopyMemory(&out32, &p_file[data_begin + index*sizeof(INT32)], sizeof(INT32));
+			CopyMemory(&model32, &p_model[index*sizeof(INT32)], sizeof(INT32));
+			diff = (out32 >> 8) - (model32 >> 8);
+		}
+
+		if((diff > max_diff) || (diff < -max_diff)) goto _l_test_check_output_end;
+	}
+
+	ret = TRUE;
+
+_l_test_check_output_end:
+	if(p_file != NULL) HeapFree(p_processheap, 0u, p_file);
+	if(p_model != NULL) HeapFree(p_processheap, 0u, p_model);
+	return ret;
+}
+
+static AudioRTDSP* WINAPI test_engine_create(const test_input_t *p_input, UINT32 sample_rate)
+{
+	audiortdsp_pb_params_t pb_params;
+
+	pb_params.file_dir = p_input->file_dir;
+	pb_params.audio_data_begin = TEST_HEADER_SIZE_BYTES;
+	pb_params.audio_data_end = TEST_HEADER_SIZE_BYTES + ((ULONG64) TEST_N_FRAMES)*((ULONG64) (TEST_N_CHANNELS*(p_input->bit_depth/8u)));
+	pb_params.sample_rate = sample_rate;
+	pb_params.n_channels = TEST_N_CHANNELS;
+
+	if(p_input->bit_depth == 16u) return new AudioRTDSP_i16(&pb_params);
+
+	return new AudioRTDSP_i24(&pb_params);
+}
+
+/*======================================================================================*/
+/*Render Checks*/
+
+static BOOL WINAPI test_render(const test_input_t *p_input, const audiortdsp_fx_params_t *p_fx, const TCHAR *fileout_dir, INT input_mode, BOOL parallel)
+{
+	AudioRTDSP *p_audio = NULL;
+	BOOL ret = FALSE;
+
+	p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+
+	/*input_mode: 0 = engine defaults, 1 = no file mapping (read-ahead), 2 = no file mapping, synchronous reads*/
+
+	if(input_mode == 1) p_audio->enableMappedInput(FALSE);
+	else if(input_mode == 2)
+	{
+		p_audio->enableMappedInput(FALSE);
+		p_audio->setReadAheadSize(0u);
+	}
+
+	if(parallel) ret = p_audio->runRenderParallel(p_fx, fileout_dir, 3u, NULL);
+	else ret = p_audio->runRender(p_fx, fileout_dir, NULL);
+
+	if(!ret) test_print_error(p_audio);
+
+	delete p_audio;
+	return ret;
+}
+
+static VOID WINAPI test_render_checks(const test_input_t *p_input)
+{
+	CHAR name[256];
+	INT n_fx;
+	INT isa;
+	INT input_mode;
+	BOOL passed = FALSE;
+
+	for(n_fx = 0; n_fx < TEST_N_FX; n_fx++)
+	{
+		/*Reference render: scalar kernels, checked against the model (recursive comb: within its error bound)*/
+
+		dspkernel_select_isa(DSPKERNEL_ISA_SCALAR);
+
+		passed = test_render(p_input, &TEST_FX_PARAMS[n_fx], TEST_FILEOUT_REF_DIR, 0, FALSE);
+		if(passed) passed = test_check_output(TEST_FILEOUT_REF_DIR, p_input, &TEST_FX_PARAMS[n_fx], 0u, test_model_max_diff(p_input, &TEST_FX_PARAMS[n_fx]));
+
+		if(TEST_FX_PARAMS[n_fx].recursive_comb) snprintf(name, sizeof(name), "render %ubit fx %d scalar == model within %d LSB", (UINT) p_input->bit_depth, n_fx, (INT) test_model_max_diff(p_input, &TEST_FX_PARAMS[n_fx]));
+		else snprintf(name, sizeof(name), "render %ubit fx %d scalar == model", (UINT) p_input->bit_depth, n_fx);
+		test_check(passed, name);
+
+		for(isa = DSPKERNEL_ISA_SSE2; isa < TEST_N_ISA; isa++)
+		{
+			if(!dspkernel_select_isa(isa)) continue;
+
+			passed = test_render(p_input, &TEST_FX_PARAMS[n_fx], TEST_FILEOUT_DIR, 0, FALSE);
+			if(passed) passed = test_compare_files(TEST_FILEOUT_DIR, TEST_FILEOUT_REF_DIR);
+
+			snprintf(name, sizeof(name), "render %ubit fx %d %s == scalar", (UINT) p_input->bit_depth, n_fx, TEST_ISA_NAMES[isa]);
+			test_check(passed, name);
+		}
+
+		test_select_isa_best();
+
+		for(input_mode = 1; input_mode <= 2; input_mode++)
+		{
+			passed = test_render(p_input, &TEST_FX_PARAMS[n_fx], TEST_FILEOUT_DIR, input_mode, FALSE);
+			if(passed) passed = test_compare_files(TEST_FILEOUT_DIR, TEST_FILEOUT_REF_DIR);
+
+			snprintf(name, sizeof(name), "render %ubit fx %d %s == scalar", (UINT) p_input->bit_depth, n_fx, (input_mode == 1) ? "read-ahead" : "sync read");
+			test_check(passed, name);
+		}
+
+		passed = test_render(p_input, &TEST_FX_PARAMS[n_fx], TEST_FILEOUT_DIR, 0, TRUE);
+		if(passed) passed = test_compare_files(TEST_FILEOUT_DIR, TEST_FILEOUT_REF_DIR);
+
+		snprintf(name, sizeof(name), "render %ubit fx %d parallel == scalar", (UINT) p_input->bit_depth, n_fx);
+		test_check(passed, name);
+	}
+
+	return;
+}
+
+/*======================================================================================*/
+/*Playback Checks*/
+
+/*Playback runs with the default FX parameters (TEST_FX_PARAMS[0]).*/
+
+static BOOL WINAPI test_playback(AudioRTDSP *p_audio, AudioBackend *p_backend)
+{
+	if(!p_audio->setAudioBackend(p_backend))
+	{
+		delete p_backend;
+		test_print_error(p_audio);
+		return FALSE;
+	}
+
+	if(!p_audio->initialize())
+	{
+		test_print_error(p_audio);
+		return FALSE;
+	}
+
+	if(!p_audio->runPlayback())
+	{
+		test_print_error(p_audio);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static VOID WINAPI test_playback_checks(const test_input_t *p_input)
+{
+	CHAR name[256];
+	AudioRTDSP *p_audio = NULL;
+	AudioBackend_Null *p_null = NULL;
+	AudioBackend_SimClock *p_simclock = NULL;
+	BOOL passed = FALSE;
+
+	/*WAV file output, through the output buffer ring. 4410 frames: segments of 2205 frames, not a power of 2.*/
+
+	p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+
+	passed = test_playback(p_audio, new AudioBackend_WAVFile(TEST_FILEOUT_DIR, 4410u));
+	if(passed) passed = test_check_output(TEST_FILEOUT_DIR, p_input, &TEST_FX_PARAMS[0], 4410u, 0);
+
+	delete p_audio;
+
+	snprintf(name, sizeof(name), "playback %ubit wavfile == model", (UINT) p_input->bit_depth);
+	test_check(passed, name);
+
+	/*WAV file output, DSP straight into the write page*/
+
+	p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+	p_audio->enableDirectOutput(TRUE);
+
+	passed = test_playback(p_audio, new AudioBackend_WAVFile(TEST_FILEOUT_DIR, 4096u));
+	if(passed) passed = test_check_output(TEST_FILEOUT_DIR, p_input, &TEST_FX_PARAMS[0], 4096u, 0);
+
+	delete p_audio;
+
+	snprintf(name, sizeof(name), "playback %ubit wavfile direct == model", (UINT) p_input->bit_depth);
+	test_check(passed, name);
+
+	/*Null output: every frame is written (the audio buffer prime, the audio data, the silence padding the last segment)*/
+
+	p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+	p_null = new AudioBackend_Null(4096u, FALSE);
+
+	passed = test_playback(p_audio, p_null);
+	if(passed) passed = (p_null->getFramesWritten() >= (4096u + TEST_N_FRAMES)) && (p_null->getFramesWritten() <= (2u*4096u + TEST_N_FRAMES));
+
+	delete p_audio;
+
+	snprintf(name, sizeof(name), "playback %ubit null", (UINT) p_input->bit_depth);
+	test_check(passed, name);
+
+	/*Simulated clock output: the clock only moves in whole periods, and drains at least the whole audio data*/
+
+	p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+	p_simclock = new AudioBackend_SimClock(1764u, 441u, FALSE);
+
+	passed = test_playback(p_audio, p_simclock);
+	if(passed) passed = (p_simclock->getClockFrames() >= TEST_N_FRAMES) && (p_simclock->getClockFrames() == 441u*p_simclock->getWakeupCount());
+
+	delete p_audio;
+
+	snprintf(name, sizeof(name), "playback %ubit simclock", (UINT) p_input->bit_depth);
+	test_check(passed, name);
+
+	return;
+}
+
+/*======================================================================================*/
+/*Command Checks*/
+
+/*
+	Commands, engine frames chosen off the segment grid. The delay and feedback commands switch TEST_FX_PARAMS[0] to {100, 20} at TEST_CMD_NFRAME_DELAY,
+	then to {100, 6} at TEST_CMD_NFRAME_FEEDBACK. The last one doesn't fit the read-ahead input buffer ring (dropped), it fits the mapped input.
+*/
+
+#define TEST_N_CMD_FX 3
+
+#define TEST_CMD_NFRAME_DELAY 50001u
+#define TEST_CMD_NFRAME_FEEDBACK 70003u
+#define TEST_CMD_NFRAME_DROP 90001u
+#define TEST_CMD_NFRAME_SEEK 30011u
+#define TEST_CMD_SEEK_TARGET 80000u
+#define TEST_CMD_NFRAME_STOP 65537u
+#define TEST_CMD_XFADE_FRAMES 1000u
+
+static const audiortdsp_cmd_t TEST_CMDS_FX[TEST_N_CMD_FX] = {
+	{AudioRTDSP::CMD_SET_DELAY, TEST_CMD_NFRAME_DELAY, 100},
+	{AudioRTDSP::CMD_SET_FEEDBACK, TEST_CMD_NFRAME_FEEDBACK, 6},
+	{AudioRTDSP::CMD_SET_FEEDBACK, TEST_CMD_NFRAME_DROP, 60000}
+};
+
+static const audiortdsp_cmd_t TEST_CMD_SEEK = {AudioRTDSP::CMD_SEEK, TEST_CMD_NFRAME_SEEK, TEST_CMD_SEEK_TARGET};
+static const audiortdsp_cmd_t TEST_CMD_STOP = {AudioRTDSP::CMD_STOP, TEST_CMD_NFRAME_STOP, 0};
+
+static const audiortdsp_fx_params_t TEST_CMD_FX_PARAMS[TEST_N_CMD_FX] = {
+	{240, 20, TRUE, TRUE, FALSE},
+	{100, 20, TRUE, TRUE, FALSE},
+	{100, 6, TRUE, TRUE, FALSE}
+};
+
+static const SIZE_T TEST_CMD_FX_NFRAMES[TEST_N_CMD_FX] = {0u, TEST_CMD_NFRAME_DELAY, TEST_CMD_NFRAME_FEEDBACK};
+
+/*
+	Checks an output file against the model, FX parameters p_fx[k] from frame p_nframes[k] onwards (p_nframes[0] = 0).
+	Each output frame is the model output for the FX parameters in use at that frame: the feedback taps read the input, not previous outputs (no transitions).
+	p_input holds the input as played (seeks included). Output length as in test_check_output(), n_frames long for the render.
+*/
+
+static BOOL WINAPI test_check_output_cmd(const TCHAR *file_dir, const test_input_t *p_input, const audiortdsp_fx_params_t *p_fx, const SIZE_T *p_nframes, SIZE_T n_fx, SIZE_T n_frames, SIZE_T n_frames_lead)
+{
+	BYTE *p_file = NULL;
+	BYTE *p_model = NULL;
+	SIZE_T file_size = 0u;
+	SIZE_T data_begin = 0u;
+	SIZE_T data_size = 0u;
+	SIZE_T frame_size = 0u;
+	SIZE_T nframe_end = 0u;
+	SIZE_T n_fx_curr;
+	SIZE_T index;
+	BOOL ret = FALSE;
+
+	frame_size = TEST_N_CHANNELS*((p_input->bit_depth == 16u) ? sizeof(INT16) : sizeof(INT32));
+
+	if(!test_read_file(file_dir, &p_file, &file_size)) goto _l_test_check_output_cmd_end;
+	if(!test_find_data(p_file, file_size, &data_begin, &data_size)) goto _l_test_check_output_cmd_end;
+
+	if(data_size%frame_size) goto _l_test_check_output_cmd_end;
+	if(data_size < (n_frames_lead + n_frames)*frame_size) goto _l_test_check_output_cmd_end;
+
+	if(n_frames_lead)
+	{
+		n_frames = data_size/frame_size - n_frames_lead;
+		if(n_frames >= (p_input->n_frames + n_frames_lead)) goto _l_test_check_output_cmd_end;
+	}
+	else if(data_size != n_frames*frame_size) goto _l_test_check_output_cmd_end;
+
+	p_model = (BYTE*) HeapAlloc(p_processheap, 0u, n_frames*frame_size);
+	if(p_model == NULL) goto _l_test_check_output_cmd_end;
+
+	for(index = 0u; index < n_frames_lead*frame_size; index++) if(p_file[data_begin + index]) goto _l_test_check_output_cmd_end;
+
+	data_begin += n_frames_lead*frame_size;
+
+	for(n_fx_curr = 0u; n_fx_curr < n_fx; n_fx_curr++)
+	{
+		nframe_end = ((n_fx_curr + 1u) < n_fx) ? p_nframes[n_fx_curr + 1u] : n_frames;
+		if(nframe_end > n_frames) nframe_end = n_frames;
+		if(p_nframes[n_fx_curr] >= nframe_end) continue;
+
+		test_model(p_input, &p_fx[n_fx_curr], nframe_end, p_model);
+
+		index = p_nframes[n_fx_curr]*frame_size;
+		if(memcmp(&p_file[data_begin + index], &p_model[index], nframe_end*frame_size - index)) goto _l_test_check_output_cmd_end;
+	}
+
+	ret = TRUE;
+
+_l_test_check_output_cmd_end:
+	if(p_file != NULL) HeapFree(p_processheap, 0u, p_file);
+	if(p_model != NULL) HeapFree(p_processheap, 0u, p_model);
+	return ret;
+}
+
+/*
+	Offline render of TEST_FX_PARAMS[0] with the given commands, posted beforehand (they apply to the next session).
+	Receives the number of commands dropped (p_n_dropped).
+*/
+
+static BOOL WINAPI test_render_cmd(const test_input_t *p_input, const audiortdsp_cmd_t *p_cmds, SIZE_T n_cmds, const TCHAR *fileout_dir, BOOL mapped, ULONG64 *p_n_dropped)
+{
+	AudioRTDSP *p_audio = NULL;
+	audiortdsp_buffer_stats_t buffer_stats;
+	SIZE_T n_cmd;
+	BOOL ret = TRUE;
+
+	p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+	p_audio->enableMappedInput(mapped);
+
+	for(n_cmd = 0u; n_cmd < n_cmds; n_cmd++) ret = p_audio->postCommand(&p_cmds[n_cmd]) && ret;
+
+	if(ret)
+	{
+		ret = p_audio->runRender(&TEST_FX_PARAMS[0], fileout_dir, NULL);
+		if(!ret) test_print_error(p_audio);
+	}
+
+	if(ret)
+	{
+		p_audio->getBufferStats(&buffer_stats);
+		*p_n_dropped = buffer_stats.n_cmd_dropped;
+	}
+
+	delete p_audio;
+	return ret;
+}
+
+/*WAV file playback with the given commands, posted before initialize(). 4410 frames: segments of 2205 frames.*/
+
+static BOOL WINAPI test_playback_cmd(const test_input_t *p_input, const audiortdsp_cmd_t *p_cmds, SIZE_T n_cmds, const TCHAR *fileout_dir)
+{
+	AudioRTDSP *p_audio = NULL;
+	SIZE_T n_cmd;
+	BOOL ret = TRUE;
+
+	p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+	p_audio->enableMappedInput(FALSE);
+
+	for(n_cmd = 0u; n_cmd < n_cmds; n_cmd++) ret = p_audio->postCommand(&p_cmds[n_cmd]) && ret;
+
+	if(ret) ret = test_playback(p_audio, new AudioBackend_WAVFile(fileout_dir, 4410u));
+
+	delete p_audio;
+	return ret;
+}
+
+static VOID WINAPI test_command_checks(const test_input_t *p_input)
+{
+	CHAR name[256];
+	AudioRTDSP *p_audio = NULL;
+	AudioBackend_SimClock *p_simclock = NULL;
+	audiortdsp_cmd_t cmds[TEST_N_CMD_FX + 2];
+	audiortdsp_xfade_stats_t xfade_stats;
+	test_input_t input_seek;
+	ULONG64 n_dropped = 0u;
+	BOOL passed = FALSE;
+	INT mapped;
+
+	/*FX parameter commands: the FX parameters switch at exactly the command frame. The last one only fits the mapped input.*/
+
+	for(mapped = 0; mapped < 2; mapped++)
+	{
+		passed = test_render_cmd(p_input, TEST_CMDS_FX, TEST_N_CMD_FX, TEST_FILEOUT_DIR, (BOOL) mapped, &n_dropped);
+
+		if(mapped) passed = passed && (n_dropped == 0u);
+		else passed = passed && (n_dropped == 1u) && test_check_output_cmd(TEST_FILEOUT_DIR, p_input, TEST_CMD_FX_PARAMS, TEST_CMD_FX_NFRAMES, TEST_N_CMD_FX, TEST_N_FRAMES, 0u);
+
+		if(mapped) snprintf(name, sizeof(name), "commands %ubit render mapped: none dropped", (UINT) p_input->bit_depth);
+		else snprintf(name, sizeof(name), "commands %ubit render read-ahead: fx switches at the command frames, 1 dropped", (UINT) p_input->bit_depth);
+		test_check(passed, name);
+	}
+
+	/*Seek: engine frames from the seek onwards read the input from the seek target, the feedback taps the input as played*/
+
+	input_seek.file_dir = NULL;
+	input_seek.bit_depth = p_input->bit_depth;
+	input_seek.n_frames = TEST_CMD_NFRAME_SEEK + (TEST_N_FRAMES - TEST_CMD_SEEK_TARGET);
+	input_seek.p_samples = (INT32*) HeapAlloc(p_processheap, 0u, input_seek.n_frames*TEST_N_CHANNELS*sizeof(INT32));
+
+	passed = (input_seek.p_samples != NULL);
+	if(passed)
+	{
+		CopyMemory(input_seek.p_samples, p_input->p_samples, TEST_CMD_NFRAME_SEEK*TEST_N_CHANNELS*sizeof(INT32));
+		CopyMemory(&input_seek.p_samples[TEST_CMD_NFRAME_SEEK*TEST_N_CHANNELS], &p_input->p_samples[TEST_CMD_SEEK_TARGET*TEST_N_CHANNELS], (TEST_N_FRAMES - TEST_CMD_SEEK_TARGET)*TEST_N_CHANNELS*sizeof(INT32));
+
+		passed = test_render_cmd(p_input, &TEST_CMD_SEEK, 1u, TEST_FILEOUT_DIR, FALSE, &n_dropped);
+		passed = passed && test_check_output_cmd(TEST_FILEOUT_DIR, &input_seek, TEST_CMD_FX_PARAMS, TEST_CMD_FX_NFRAMES, 1u, input_seek.n_frames, 0u);
+
+		HeapFree(p_processheap, 0u, input_seek.p_samples);
+	}
+
+	snprintf(name, sizeof(name), "commands %ubit render: seek continues from the target frame", (UINT) p_input->bit_depth);
+	test_check(passed, name);
+
+	/*Stop: the render output ends at the command frame*/
+
+	passed = test_render_cmd(p_input, &TEST_CMD_STOP, 1u, TEST_FILEOUT_DIR, FALSE, &n_dropped);
+	passed = passed && test_check_output_cmd(TEST_FILEOUT_DIR, p_input, TEST_CMD_FX_PARAMS, TEST_CMD_FX_NFRAMES, 1u, TEST_CMD_NFRAME_STOP, 0u);
+
+	snprintf(name, sizeof(name), "commands %ubit render: stop ends the output at the command frame", (UINT) p_input->bit_depth);
+	test_check(passed, name);
+
+	/*Every command at once, twice: same output*/
+
+	CopyMemory(cmds, TEST_CMDS_FX, sizeof(TEST_CMDS_FX));
+	cmds[TEST_N_CMD_FX] = TEST_CMD_SEEK;
+	cmds[TEST_N_CMD_FX + 1] = TEST_CMD_STOP;
+
+	passed = test_render_cmd(p_input, cmds, TEST_N_CMD_FX + 2, TEST_FILEOUT_REF_DIR, FALSE, &n_dropped);
+	passed = passed && test_render_cmd(p_input, cmds, TEST_N_CMD_FX + 2, TEST_FILEOUT_DIR, FALSE, &n_dropped);
+	passed = passed && test_compare_files(TEST_FILEOUT_DIR, TEST_FILEOUT_REF_DIR);
+
+	snprintf(name, sizeof(name), "commands %ubit render: two runs, same output", (UINT) p_input->bit_depth);
+	test_check(passed, name);
+
+	/*Playback through the output buffer ring: same switch frames (behind the audio buffer prime), two runs give the same output*/
+
+	passed = test_playback_cmd(p_input, TEST_CMDS_FX, TEST_N_CMD_FX, TEST_FILEOUT_REF_DIR);
+	passed = passed && test_check_output_cmd(TEST_FILEOUT_REF_DIR, p_input, TEST_CMD_FX_PARAMS, TEST_CMD_FX_NFRAMES, TEST_N_CMD_FX, TEST_N_FRAMES, 4410u);
+	passed = passed && test_playback_cmd(p_input, TEST_CMDS_FX, TEST_N_CMD_FX, TEST_FILEOUT_DIR);
+	passed = passed && test_compare_files(TEST_FILEOUT_DIR, TEST_FILEOUT_REF_DIR);
+
+	snprintf(name, sizeof(name), "commands %ubit playback wavfile: fx switches at the command frames, two runs, same output", (UINT) p_input->bit_depth);
+	test_check(passed, name);
+
+	/*Simulated clock: the stop ends the playback session early (the device drains the output buffered until then)*/
+
+	p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+	p_simclock = new AudioBackend_SimClock(1764u, 441u, FALSE);
+
+	passed = p_audio->postCommand(&TEST_CMD_STOP);
+	passed = passed && test_playback(p_audio, p_simclock);
+	passed = passed && (p_simclock->getClockFrames() >= TEST_CMD_NFRAME_STOP) && (p_simclock->getClockFrames() < (TEST_CMD_NFRAME_STOP + TEST_N_FRAMES)/2u);
+
+	delete p_audio;
+
+	snprintf(name, sizeof(name), "commands %ubit playback simclock: stop ends the session", (UINT) p_input->bit_depth);
+	test_check(passed, name);
+
+	/*Transition: a delay change crossfades over the transition time, counted in the transition statistics*/
+
+	p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+	p_simclock = new AudioBackend_SimClock(1764u, 441u, FALSE);
+
+	passed = p_audio->setTransitionTime(TEST_CMD_XFADE_FRAMES);
+	passed = passed && p_audio->postCommand(&TEST_CMDS_FX[0]);
+	passed = passed && test_playback(p_audio, p_simclock);
+	passed = passed && p_audio->getTransitionStats(&xfade_stats);
+	passed = passed && (xfade_stats.n_transitions == 1u) && (xfade_stats.n_frames == TEST_CMD_XFADE_FRAMES) && (xfade_stats.extra_sec > 0.0);
+
+	delete p_audio;
+
+	snprintf(name, sizeof(name), "commands %ubit playback simclock: delay change with a transition, counted", (UINT) p_input->bit_depth);
+	test_check(passed, name);
+
+	return;
+}
+
+/*======================================================================================*/
+/*Pacing Checks*/
+
+/*
+	Simulated clock that also measures the output latency:
+	the frames queued in the device buffer right after each segment is written (the last frame of the segment plays that many frames later).
+*/
+
+class TestSimClockProbe : public AudioBackend_SimClock {
+	public:
+		TestSimClockProbe(SIZE_T audiobuffer_size_frames, SIZE_T period_size_frames) : AudioBackend_SimClock(audiobuffer_size_frames, period_size_frames, FALSE)
+		{
+		}
+
+		BOOL WINAPI commitFrames(SIZE_T n_frames) override
+		{
+			if(!AudioBackend_SimClock::commitFrames(n_frames)) return FALSE;
+
+			/*The audio buffer prime is written before start()*/
+
+			if(this->started)
+			{
+				this->segment_size_frames = n_frames;
+				this->queued_sum += (ULONG64) this->n_frames_pending;
+				this->n_segments++;
+			}
+
+			return TRUE;
+		}
+
+		SIZE_T segment_size_frames = 0u;
+		ULONG64 queued_sum = 0u;
+		ULONG64 n_segments = 0u;
+};
+
+static VOID WINAPI test_pacing_checks(const test_input_t *p_input)
+{
+	CHAR name[256];
+	AudioRTDSP *p_audio = NULL;
+	AudioBackend_SimClock *p_simclock = NULL;
+	BOOL passed = FALSE;
+
+	/*48 kHz, 100 ms device buffer: the engine is far faster than real time*/
+
+	p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+	p_simclock = new AudioBackend_SimClock(4800u, 480u, TRUE);
+
+	passed = test_playback(p_audio, p_simclock);
+	if(passed)
+	{
+		printf("    %llu underrun frames\n", (unsigned long long) p_simclock->getUnderrunFrames());
+		passed = (p_simclock->getUnderrunFrames() == 0u);
+	}
+
+	delete p_audio;
+
+	snprintf(name, sizeof(name), "pacing %ubit simclock realtime %u Hz: no underrun", (UINT) p_input->bit_depth, TEST_SAMPLE_RATE);
+	test_check(passed, name);
+
+	/*2 GHz: the device runs dry as soon as it starts*/
+
+	p_audio = test_engine_create(p_input, 2000000000u);
+	p_simclock = new AudioBackend_SimClock(960u, 480u, TRUE);
+
+	passed = test_playback(p_audio, p_simclock);
+	if(passed)
+	{
+		printf("    %llu underrun frames\n", (unsigned long long) p_simclock->getUnderrunFrames());
+		passed = (p_simclock->getUnderrunFrames() > 0u);
+	}
+
+	delete p_audio;
+
+	snprintf(name, sizeof(name), "pacing %ubit simclock realtime 2 GHz: underruns", (UINT) p_input->bit_depth);
+	test_check(passed, name);
+
+	return;
+}
+
+#define TEST_N_LATENCY 5
+
+static const SIZE_T TEST_LATENCY_PERIODS[TEST_N_LATENCY][2] = {
+	{480u, 960u},
+	{441u, 882u},
+	{480u, 1440u},
+	{528u, 1056u},
+	{256u, 1024u}
+};
+
+static VOID WINAPI test_latency_checks(const test_input_t *p_input)
+{
+	CHAR name[256];
+	AudioRTDSP *p_audio = NULL;
+	TestSimClockProbe *p_probe = NULL;
+	DOUBLE queued_avg = 0.0;
+	BOOL passed = FALSE;
+	INT n_config;
+
+	for(n_config = 0; n_config < TEST_N_LATENCY; n_config++)
+	{
+		p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+		p_probe = new TestSimClockProbe(TEST_LATENCY_PERIODS[n_config][1], TEST_LATENCY_PERIODS[n_config][0]);
+
+		passed = test_playback(p_audio, p_probe);
+		if(passed && p_probe->n_segments)
+		{
+			queued_avg = ((DOUBLE) p_probe->queued_sum)/((DOUBLE) p_probe->n_segments);
+
+			printf("    period %4u buffer %4u: segment %4u, queued avg %7.1f frames (%.2f ms), %llu underrun frames\n",
+				(UINT) TEST_LATENCY_PERIODS[n_config][0], (UINT) TEST_LATENCY_PERIODS[n_config][1], (UINT) p_probe->segment_size_frames,
+				queued_avg, 1000.0*queued_avg/((DOUBLE) TEST_SAMPLE_RATE), (unsigned long long) p_probe->getUnderrunFrames());
+
+			passed = (p_probe->getUnderrunFrames() == 0u);
+		}
+		else passed = FALSE;
+
+		delete p_audio;
+
+		snprintf(name, sizeof(name), "latency %ubit simclock period %u buffer %u: no underrun", (UINT) p_input->bit_depth, (UINT) TEST_LATENCY_PERIODS[n_config][0], (UINT) TEST_LATENCY_PERIODS[n_config][1]);
+		test_check(passed, name);
+	}
+
+	return;
+}
+
+/*======================================================================================*/
+/*Telemetry Checks*/
+
+/*
+	Built with __RTDSP_TELEMETRY (see build_linux.sh, build32.bat, build64.bat): playback on the simulated clock (deterministic mode), then
+	every stage timed once per segment played (no wait after the last one at most), every histogram summing to its sample count,
+	the padding within the audio buffer, and the report file holding the whole report with the same counts.
+	Built without it: getTelemetry() and dumpTelemetry() fail.
+*/
+
+static VOID WINAPI test_telemetry_checks(const test_input_t *p_input)
+{
+	CHAR name[256];
+	AudioRTDSP *p_audio = NULL;
+	BOOL passed = FALSE;
+#ifdef __RTDSP_TELEMETRY
+	audiortdsp_telemetry_t telemetry;
+	audiortdsp_buffer_stats_t buffer_stats;
+	const audiortdsp_telemetry_stage_t *p_stage = NULL;
+	CHAR line[128];
+	BYTE *p_report = NULL;
+	SIZE_T report_size = 0u;
+	ULONG64 hist_sum = 0u;
+	ULONG64 n_played = 0u;
+	SIZE_T n_stage;
+	SIZE_T n_bucket;
+
+	p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+
+	passed = test_playback(p_audio, new AudioBackend_SimClock(1764u, 441u, FALSE));
+	passed = passed && p_audio->getTelemetry(&telemetry) && p_audio->getBufferStats(&buffer_stats);
+
+	if(passed)
+	{
+		n_played = telemetry.n_played;
+		passed = (n_played > 0u) && (n_played == buffer_stats.n_played) && (telemetry.n_underruns == buffer_stats.n_underruns);
+
+		for(n_stage = 0u; n_stage < AUDIORTDSP_TELEMETRY_N_STAGES; n_stage++)
+		{
+			p_stage = &(telemetry.stages[n_stage]);
+
+			if(n_stage == AudioRTDSP::TELEMETRY_WAIT) passed = passed && ((p_stage->n_samples == n_played) || ((p_stage->n_samples + 1u) == n_played));
+			else passed = passed && (p_stage->n_samples == n_played);
+
+			hist_sum = 0u;
+			for(n_bucket = 0u; n_bucket < AUDIORTDSP_TELEMETRY_N_BUCKETS; n_bucket++) hist_sum += p_stage->hist[n_bucket];
+
+			passed = passed && (hist_sum == p_stage->n_samples);
+			passed = passed && (p_stage->p50_us <= p_stage->p99_us) && (p_stage->p99_us <= p_stage->p999_us) && (p_stage->p999_us <= p_stage->max_us);
+		}
+
+		passed = passed && (telemetry.padding_min <= telemetry.padding_max) && (telemetry.padding_max <= 1764u);
+	}
+
+	snprintf(name, sizeof(name), "telemetry %ubit simclock: stage sample counts, histogram sums", (UINT) p_input->bit_depth);
+	test_check(passed, name);
+
+	/*Report file: the header, the same counts, every histogram bucket (not truncated)*/
+
+	passed = passed && p_audio->dumpTelemetry(TEST_FILEOUT_TELEMETRY_DIR);
+	passed = passed && test_read_file(TEST_FILEOUT_TELEMETRY_DIR, &p_report, &report_size);
+
+	if(passed)
+	{
+		p_report[report_size] = 0u;
+
+		snprintf(line, sizeof(line), "segments played: %llu, underruns: %llu\r\n", (unsigned long long) telemetry.n_played, (unsigned long long) telemetry.n_underruns);
+		passed = !strncmp((const CHAR*) p_report, "AudioRTDSP playback telemetry\r\n", 31u) && (strstr((const CHAR*) p_report, line) != NULL);
+
+		snprintf(line, sizeof(line), "\r\n%-8llu %12s", (unsigned long long) (AUDIORTDSP_TELEMETRY_N_BUCKETS - 1u), "-");
+		passed = passed && (strstr((const CHAR*) p_report, line) != NULL);
+		passed = passed && (report_size >= 2u) && !memcmp(&p_report[report_size - 2u], "\r\n", 2u);
+	}
+
+	if(p_report != NULL) HeapFree(p_processheap, 0u, p_report);
+	DeleteFile(TEST_FILEOUT_TELEMETRY_DIR);
+
+	delete p_audio;
+
+	snprintf(name, sizeof(name), "telemetry %ubit simclock: report file", (UINT) p_input->bit_depth);
+	test_check(passed, name);
+#else
+	audiortdsp_telemetry_t telemetry;
+
+	p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+
+	passed = test_playback(p_audio, new AudioBackend_SimClock(1764u, 441u, FALSE));
+	passed = passed && !p_audio->getTelemetry(&telemetry) && !p_audio->dumpTelemetry(TEST_FILEOUT_TELEMETRY_DIR);
+
+	delete p_audio;
+
+	snprintf(name, sizeof(name), "telemetry %ubit: not built in, getTelemetry() and dumpTelemetry() fail", (UINT) p_input->bit_depth);
+	test_check(passed, name);
+#endif
+	return;
+}
+
+/*======================================================================================*/
+/*Thread Checks*/
+
+/*
+	The thread.h primitives the engine schedules its workers with (Win32 on Windows, pthread elsewhere):
+	many run/wait cycles on a few workers, an event wait timing out, manual reset and auto reset events,
+	and a worker force quit while it waits for a run.
+*/
+
+#define TEST_THREAD_N_WORKERS 4u
+#define TEST_THREAD_N_RUNS 20000u
+#define TEST_THREAD_TIMEOUT_MS 20u
+
+struct _test_thread_args {
+	volatile LONG n_runs;
+	volatile LONG n_released;
+	HANDLE p_event;
+};
+
+typedef struct _test_thread_args test_thread_args_t;
+
+static DWORD WINAPI test_thread_count_proc(VOID *p_args)
+{
+	InterlockedIncrement(&(((test_thread_args_t*) p_args)->n_runs));
+	return 0u;
+}
+
+static DWORD WINAPI test_thread_release_proc(VOID *p_args)
+{
+	test_thread_args_t *p_thread_args = (test_thread_args_t*) p_args;
+
+	if(event_wait(p_thread_args->p_event, INFINITE)) InterlockedIncrement(&(p_thread_args->n_released));
+	return 0u;
+}
+
+static VOID WINAPI test_thread_checks(VOID)
+{
+	test_thread_args_t args;
+	thread_worker_t workers[TEST_THREAD_N_WORKERS];
+	HANDLE threads[TEST_THREAD_N_WORKERS];
+	LARGE_INTEGER freq;
+	LARGE_INTEGER t_begin;
+	LARGE_INTEGER t_end;
+	BOOL passed;
+	UINT n_worker;
+	UINT n_run;
+
+	args.n_runs = 0;
+	args.n_released = 0;
+	args.p_event = NULL;
+
+	/*Workers: every run requested must run exactly once*/
+
+	passed = TRUE;
+	for(n_worker = 0u; n_worker < TEST_THREAD_N_WORKERS; n_worker++) passed = thread_worker_create(&workers[n_worker], &test_thread_count_proc, &args) && passed;
+
+	if(passed)
+	{
+		for(n_run = 0u; n_run < TEST_THREAD_N_RUNS; n_run++)
+		{
+			for(n_worker = 0u; n_worker < TEST_THREAD_N_WORKERS; n_worker++) passed = thread_worker_run(&workers[n_worker]) && passed;
+			for(n_worker = 0u; n_worker < TEST_THREAD_N_WORKERS; n_worker++) passed = thread_worker_wait(&workers[n_worker]) && passed;
+		}
+
+		passed = passed && (args.n_runs == (LONG) (TEST_THREAD_N_WORKERS*TEST_THREAD_N_RUNS));
+		for(n_worker = 0u; n_worker < TEST_THREAD_N_WORKERS; n_worker++) passed = thread_worker_destroy(&workers[n_worker]) && passed;
+	}
+
+	test_check(passed, "thread workers: every run runs once");
+
+	/*Force quit a worker waiting for a run*/
+
+	passed = thread_worker_create(&workers[0], &test_thread_count_proc, &args);
+	if(passed)
+	{
+		Sleep(TEST_THREAD_TIMEOUT_MS);
+		passed = thread_worker_stop(&workers[0], 0u);
+	}
+
+	test_check(passed, "thread worker: force quit while idle");
+
+	/*Auto reset event: times out unsignaled, released once per signal*/
+
+	args.p_event = event_create(FALSE);
+	passed = (args.p_event != NULL);
+	if(passed)
+	{
+		QueryPerformanceFrequency(&freq);
+		QueryPerformanceCounter(&t_begin);
+		passed = !event_wait(args.p_event, TEST_THREAD_TIMEOUT_MS);
+		QueryPerformanceCounter(&t_end);
+
+		/*Timers may round the timeout down by up to a millisecond*/
+		passed = passed && (((ULONG64) (t_end.QuadPart - t_begin.QuadPart))*1000u >= ((ULONG64) (TEST_THREAD_TIMEOUT_MS - 1u))*((ULONG64) freq.QuadPart));
+
+		passed = passed && event_signal(args.p_event);
+		passed = passed && event_wait(args.p_event, 0u);
+		passed = passed && !event_wait(args.p_event, 0u);
+
+		passed = event_destroy(&(args.p_event)) && passed;
+	}
+
+	test_check(passed, "thread events: auto reset event times out, released once per signal");
+
+	/*Manual reset event: one signal releases every waiting thread, stays signaled until reset*/
+
+	args.p_event = event_create(TRUE);
+	passed = (args.p_event != NULL);
+	if(passed)
+	{
+		for(n_worker = 0u; n_worker < TEST_THREAD_N_WORKERS; n_worker++)
+		{
+			threads[n_worker] = thread_create_default(&test_thread_release_proc, &args, NULL);
+			passed = passed && (threads[n_worker] != NULL);
+		}
+
+		if(passed)
+		{
+			Sleep(TEST_THREAD_TIMEOUT_MS);
+			passed = event_signal(args.p_event);
+
+			for(n_worker = 0u; n_worker < TEST_THREAD_N_WORKERS; n_worker++) passed = thread_wait(&threads[n_worker]) && passed;
+
+			passed = passed && (args.n_released == (LONG) TEST_THREAD_N_WORKERS);
+			passed = passed && event_wait(args.p_event, 0u);
+			passed = passed && event_wait(args.p_event, 0u);
+			passed = passed && event_reset(args.p_event);
+			passed = passed && !event_wait(args.p_event, 0u);
+		}
+
+		passed = event_destroy(&(args.p_event)) && passed;
+	}
+
+	test_check(passed, "thread events: manual reset event releases every waiting thread, stays signaled until reset");
+
+	return;
+}
+
+/*======================================================================================*/
+/*Benchmarks*/
+
+/*
+	Real time simulated clock (48 kHz, 480-frame periods, 960-frame buffer) that also drives the FX parameters from the play position,
+	the way an operator would from the user interface (setters called from another thread than the load thread):
+	delay 1 frame, n_feedback_light over the first third of the input, n_feedback_heavy over the middle third, n_feedback_light again over the last third.
+	Records the active output buffer depth and the device underruns of each third.
+*/
+
+#define TEST_BENCH_N_PHASES 3
+
+class TestSimClockLoad : public AudioBackend_SimClock {
+	public:
+		TestSimClockLoad(AudioRTDSP *p_audio, INT32 n_feedback_light, INT32 n_feedback_heavy) : AudioBackend_SimClock(960u, 480u, TRUE)
+		{
+			this->p_audio = p_audio;
+			this->n_feedback[0] = n_feedback_light;
+			this->n_feedback[1] = n_feedback_heavy;
+			this->n_feedback[2] = n_feedback_light;
+		}
+
+		BOOL WINAPI commitFrames(SIZE_T n_frames) override
+		{
+			audiortdsp_buffer_stats_t buffer_stats;
+			SIZE_T n_phase_curr = 0u;
+
+			if(!AudioBackend_SimClock::commitFrames(n_frames)) return FALSE;
+
+			/*The audio buffer prime is written before start()*/
+
+			if(!this->started) return TRUE;
+
+			n_phase_curr = (SIZE_T) ((this->n_frames_committed*TEST_BENCH_N_PHASES)/TEST_N_FRAMES);
+			if(n_phase_curr >= TEST_BENCH_N_PHASES) n_phase_curr = TEST_BENCH_N_PHASES - 1u;
+
+			if(!this->n_frames_committed)
+			{
+				this->p_audio->setFXDelay(1u);
+				this->p_audio->enableFeedbackAltPol(FALSE);
+				this->p_audio->enableCycleDivIncOne(TRUE);
+				this->p_audio->setFXFeedback((SIZE_T) this->n_feedback[0]);
+			}
+			else if(n_phase_curr != this->n_phase)
+			{
+				this->p_audio->setFXFeedback((SIZE_T) this->n_feedback[n_phase_curr]);
+				this->underrun_frames_begin[n_phase_curr] = this->n_underrun_frames;
+				this->n_phase = n_phase_curr;
+			}
+
+			this->n_frames_committed += (ULONG64) n_frames;
+
+			this->p_audio->getBufferStats(&buffer_stats);
+			this->depth_sum[this->n_phase] += (ULONG64) buffer_stats.n_depth;
+			this->n_depth_samples[this->n_phase]++;
+
+			return TRUE;
+		}
+
+		/*Call after playback, the last phase ends with the session*/
+
+		VOID WINAPI printPhases(VOID)
+		{
+			ULONG64 underrun_frames_end = 0u;
+			DOUBLE depth_avg = 0.0;
+			SIZE_T n_phase;
+
+			for(n_phase = 0u; n_phase < TEST_BENCH_N_PHASES; n_phase++)
+			{
+				if(n_phase < (TEST_BENCH_N_PHASES - 1u)) underrun_frames_end = this->underrun_frames_begin[n_phase + 1u];
+				else underrun_frames_end = this->n_underrun_frames;
+
+				depth_avg = 0.0;
+				if(this->n_depth_samples[n_phase]) depth_avg = ((DOUBLE) this->depth_sum[n_phase])/((DOUBLE) this->n_depth_samples[n_phase]);
+
+				printf("    feedback %6d: depth avg %5.2f segments (%6.1f ms queued), %llu underrun frames\n",
+					this->n_feedback[n_phase], depth_avg, 1000.0*depth_avg*480.0/((DOUBLE) TEST_SAMPLE_RATE),
+					(unsigned long long) (underrun_frames_end - this->underrun_frames_begin[n_phase]));
+			}
+
+			return;
+		}
+
+	protected:
+		AudioRTDSP *p_audio = NULL;
+		INT32 n_feedback[TEST_BENCH_N_PHASES] = {0, 0, 0};
+		SIZE_T n_phase = 0u;
+		ULONG64 n_frames_committed = 0u;
+		ULONG64 underrun_frames_begin[TEST_BENCH_N_PHASES] = {0u, 0u, 0u};
+		ULONG64 depth_sum[TEST_BENCH_N_PHASES] = {0u, 0u, 0u};
+		ULONG64 n_depth_samples[TEST_BENCH_N_PHASES] = {0u, 0u, 0u};
+};
+
+/*
+	Adaptive depth (AudioRTDSP::enableAdaptiveDepth()): the active depth and the underruns with the feedback count raised for a third of the run,
+	adaptive with a ceiling of 16 segments against the fixed depths of 16 and 2 segments.
+*/
+
+static VOID WINAPI test_bench_depth(const test_input_t *p_input, INT32 n_feedback_heavy)
+{
+	AudioRTDSP *p_audio = NULL;
+	TestSimClockLoad *p_load = NULL;
+	INT n_config;
+
+	for(n_config = 0; n_config < 3; n_config++)
+	{
+		p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+		p_load = new TestSimClockLoad(p_audio, 4, n_feedback_heavy);
+
+		p_audio->setBufferDepth((n_config == 2) ? 2u : 16u);
+		p_audio->enableAdaptiveDepth(n_config == 0);
+
+		if(n_config == 0) printf("adaptive depth, ceiling 16 segments:\n");
+		else printf("fixed depth, %u segments:\n", (n_config == 2) ? 2u : 16u);
+
+		if(test_playback(p_audio, p_load)) p_load->printPhases();
+
+		delete p_audio;
+	}
+
+	return;
+}
+
+/*
+	Deadline watchdog (AudioRTDSP::enableDeadlineWatchdog()): the underruns at a depth of 2 segments with the feedback count raised for a third of the run,
+	without and with the watchdog, and how often the watchdog dropped tail taps.
+*/
+
+static VOID WINAPI test_bench_watchdog(const test_input_t *p_input, INT32 n_feedback_heavy)
+{
+	AudioRTDSP *p_audio = NULL;
+	TestSimClockLoad *p_load = NULL;
+	audiortdsp_buffer_stats_t buffer_stats;
+	INT n_config;
+
+	for(n_config = 0; n_config < 2; n_config++)
+	{
+		p_audio = test_engine_create(p_input, TEST_SAMPLE_RATE);
+		p_load = new TestSimClockLoad(p_audio, 4, n_feedback_heavy);
+
+		p_audio->setBufferDepth(2u);
+		p_audio->enableDeadlineWatchdog(n_config == 1);
+
+		printf("depth 2 segments, deadline watchdog %s:\n", (n_config == 1) ? "on" : "off");
+
+		if(test_playback(p_audio, p_load))
+		{
+			p_load->printPhases();
+			p_audio->getBufferStats(&buffer_stats);
+			printf("    %llu degrade events, %llu degraded segments\n",
+				(unsigned long long) buffer_stats.n_degrade_events, (unsigned long long) buffer_stats.n_degraded_segments);
+		}
+
+		delete p_audio;
+	}
+
+	return;
+}
+
+/*
+	rtdsptest bench: 16bit stereo input, 2.5 seconds at 48 kHz per run, real time.
+	The heavy feedback count (default 20000) should take the DSP close to (or past) the segment period on the running CPU.
+*/
+
+static VOID WINAPI test_bench(const test_input_t *p_input, INT32 n_feedback_heavy)
+{
+	test_bench_depth(p_input, n_feedback_heavy);
+	test_bench_watchdog(p_input, n_feedback_heavy);
+	return;
+}
+
+int main(int argc, char **argv)
+{
+	test_input_t inputs[2];
+	INT32 n_feedback_heavy = 20000;
+	BOOL bench = FALSE;
+	INT n_input;
+
+	p_processheap = GetProcessHeap();
+
+	if(argc > 1)
+	{
+		if(strcmp(argv[1], "bench"))
+		{
+			printf("Usage: rtdsptest [bench [heavy feedback count]]\n");
+			return 1;
+		}
+
+		bench = TRUE;
+		if(argc > 2) n_feedback_heavy = (INT32) atoi(argv[2]);
+
+		/*Same bound as AudioRTDSP::setFXFeedback() (gains table size)*/
+		if((n_feedback_heavy < 1) || (n_feedback_heavy > 65535))
+		{
+			printf("Error: heavy feedback count must be within 1 and 65535\n");
+			return 1;
+		}
+	}
+
+	inputs[0].file_dir = TEST_FILEIN_16_DIR;
+	inputs[0].bit_depth = 16u;
+	inputs[0].n_frames = TEST_N_FRAMES;
+	inputs[0].p_samples = NULL;
+
+	inputs[1].file_dir = TEST_FILEIN_24_DIR;
+	inputs[1].bit_depth = 24u;
+	inputs[1].n_frames = TEST_N_FRAMES;
+	inputs[1].p_samples = NULL;
+
+	for(n_input = 0; n_input < 2; n_input++)
+	{
+		if(!test_write_input(&inputs[n_input]))
+		{
+			printf("Error: could not create test input file.\n");
+			return 1;
+		}
+	}
+
+	if(bench) test_bench(&inputs[0], n_feedback_heavy);
+	else
+	{
+		test_thread_checks();
+
+		for(n_input = 0; n_input < 2; n_input++)
+		{
+			test_render_checks(&inputs[n_input]);
+			test_playback_checks(&inputs[n_input]);
+			test_command_checks(&inputs[n_input]);
+			test_pacing_checks(&inputs[n_input]);
+			test_latency_checks(&inputs[n_input]);
+			test_telemetry_checks(&inputs[n_input]);
+		}
+	}
+
+	for(n_input = 0; n_input < 2; n_input++)
+	{
+		DeleteFile(inputs[n_input].file_dir);
+		HeapFree(p_processheap, 0u, inputs[n_input].p_samples);
+	}
+
+	DeleteFile(TEST_FILEOUT_REF_DIR);
+	DeleteFile(TEST_FILEOUT_DIR);
+
+	if(bench) return 0;
+
+	printf("\n%u checks, %u failed\n", n_checks, n_failed);
+
+	return (n_failed > 0u) ? 1 : 0;
+}
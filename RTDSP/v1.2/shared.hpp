@@ -10,7 +10,10 @@
 #define SHARED_HPP
 
 #include "globldef.h"
+
+#ifdef _WIN32
 #include <initguid.h>
+#endif
 
 /*
 PKEY_Device_FriendlyName should've been defined somewhere in a header called functiondiscoverykeys_devpkey.h
@@ -16,6 +16,15 @@
 
 #include "thread.h"
 
+#ifndef _WIN32
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#endif
+
+#ifdef _WIN32
+
 HANDLE WINAPI thread_create_default(DWORD (WINAPI *p_thread_start_routine)(VOID*), VOID *p_args, DWORD *p_threadid)
 {
 	if(p_thread_start_routine == NULL) return NULL;
@@ -47,3 +56,383 @@ BOOL WINAPI thread_stop(HANDLE *pp_thread, DWORD exit_code)
 	*pp_thread = NULL;
 	return TRUE;
 }
+
+HANDLE WINAPI event_create(BOOL manual_reset)
+{
+	return CreateEvent(NULL, manual_reset, FALSE, NULL);
+}
+
+BOOL WINAPI event_signal(HANDLE p_event)
+{
+	if(p_event == NULL) return FALSE;
+
+	return SetEvent(p_event);
+}
+
+BOOL WINAPI event_reset(HANDLE p_event)
+{
+	if(p_event == NULL) return FALSE;
+
+	return ResetEvent(p_event);
+}
+
+BOOL WINAPI event_wait(HANDLE p_event, DWORD timeout_ms)
+{
+	if(p_event == NULL) return FALSE;
+
+	return (WaitForSingleObject(p_event, timeout_ms) == WAIT_OBJECT_0);
+}
+
+BOOL WINAPI event_destroy(HANDLE *pp_event)
+{
+	if(pp_event == NULL) return FALSE;
+	if(*pp_event == NULL) return FALSE;
+	if(!CloseHandle(*pp_event)) return FALSE;
+
+	*pp_event = NULL;
+	return TRUE;
+}
+
+#else
+
+/*
+	pthread implementation.
+	A thread handle points to a thread object (the pthread and its start routine).
+	An event handle points to an event object: a state flag guarded by a mutex, waited on with a condition variable (CLOCK_MONOTONIC timeouts).
+*/
+
+struct _thread_posix {
+	pthread_t thread;
+	DWORD (WINAPI *p_routine)(VOID*);
+	VOID *p_args;
+};
+
+typedef struct _thread_posix thread_posix_t;
+
+struct _event_posix {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	BOOL manual_reset;
+	BOOL signaled;
+};
+
+typedef struct _event_posix event_posix_t;
+
+static VOID* thread_posix_proc(VOID *p_args)
+{
+	thread_posix_t *p_thread = (thread_posix_t*) p_args;
+
+	p_thread->p_routine(p_thread->p_args);
+	return NULL;
+}
+
+/*Release the event mutex if the waiting thread is cancelled (thread_stop()) inside pthread_cond_wait()*/
+
+static VOID thread_posix_unlock(VOID *p_args)
+{
+	pthread_mutex_unlock((pthread_mutex_t*) p_args);
+	return;
+}
+
+HANDLE WINAPI thread_create_default(DWORD (WINAPI *p_thread_start_routine)(VOID*), VOID *p_args, DWORD *p_threadid)
+{
+	thread_posix_t *p_thread = NULL;
+
+	if(p_thread_start_routine == NULL) return NULL;
+
+	p_thread = (thread_posix_t*) malloc(sizeof(thread_posix_t));
+	if(p_thread == NULL) return NULL;
+
+	p_thread->p_routine = p_thread_start_routine;
+	p_thread->p_args = p_args;
+
+	if(pthread_create(&(p_thread->thread), NULL, &thread_posix_proc, p_thread))
+	{
+		free(p_thread);
+		return NULL;
+	}
+
+	/*pthread has no numeric thread id*/
+
+	if(p_threadid != NULL) *p_threadid = 0u;
+
+	return (HANDLE) p_thread;
+}
+
+BOOL WINAPI thread_wait(HANDLE *pp_thread)
+{
+	thread_posix_t *p_thread = NULL;
+
+	if(pp_thread == NULL) return FALSE;
+	if(*pp_thread == NULL) return FALSE;
+
+	p_thread = (thread_posix_t*) *pp_thread;
+
+	if(pthread_join(p_thread->thread, NULL)) return FALSE;
+
+	free(p_thread);
+
+	*pp_thread = NULL;
+	return TRUE;
+}
+
+/*The thread quits at its next cancellation point (any wait, event_wait() included), exit_code is ignored.*/
+
+BOOL WINAPI thread_stop(HANDLE *pp_thread, DWORD exit_code)
+{
+	thread_posix_t *p_thread = NULL;
+
+	if(pp_thread == NULL) return FALSE;
+	if(*pp_thread == NULL) return FALSE;
+
+	p_thread = (thread_posix_t*) *pp_thread;
+
+	if(pthread_cancel(p_thread->thread)) return FALSE;
+
+	pthread_join(p_thread->thread, NULL);
+	free(p_thread);
+
+	*pp_thread = NULL;
+	return TRUE;
+}
+
+HANDLE WINAPI event_create(BOOL manual_reset)
+{
+	event_posix_t *p_event = NULL;
+	pthread_condattr_t condattr;
+
+	p_event = (event_posix_t*) malloc(sizeof(event_posix_t));
+	if(p_event == NULL) return NULL;
+
+	p_event->manual_reset = manual_reset;
+	p_event->signaled = FALSE;
+
+	if(pthread_mutex_init(&(p_event->mutex), NULL))
+	{
+		free(p_event);
+		return NULL;
+	}
+
+	pthread_condattr_init(&condattr);
+	pthread_condattr_setclock(&condattr, CLOCK_MONOTONIC);
+
+	if(pthread_cond_init(&(p_event->cond), &condattr))
+	{
+		pthread_condattr_destroy(&condattr);
+		pthread_mutex_destroy(&(p_event->mutex));
+		free(p_event);
+		return NULL;
+	}
+
+	pthread_condattr_destroy(&condattr);
+	return (HANDLE) p_event;
+}
+
+BOOL WINAPI event_signal(HANDLE p_event)
+{
+	event_posix_t *p_obj = (event_posix_t*) p_event;
+
+	if(p_event == NULL) return FALSE;
+
+	pthread_mutex_lock(&(p_obj->mutex));
+
+	p_obj->signaled = TRUE;
+
+	/*Auto reset: release a single waiting thread*/
+
+	if(p_obj->manual_reset) pthread_cond_broadcast(&(p_obj->cond));
+	else pthread_cond_signal(&(p_obj->cond));
+
+	pthread_mutex_unlock(&(p_obj->mutex));
+	return TRUE;
+}
+
+BOOL WINAPI event_reset(HANDLE p_event)
+{
+	event_posix_t *p_obj = (event_posix_t*) p_event;
+
+	if(p_event == NULL) return FALSE;
+
+	pthread_mutex_lock(&(p_obj->mutex));
+	p_obj->signaled = FALSE;
+	pthread_mutex_unlock(&(p_obj->mutex));
+
+	return TRUE;
+}
+
+BOOL WINAPI event_wait(HANDLE p_event, DWORD timeout_ms)
+{
+	event_posix_t *p_obj = (event_posix_t*) p_event;
+	struct timespec time_limit;
+	BOOL signaled = FALSE;
+	INT n_ret = 0;
+
+	if(p_event == NULL) return FALSE;
+
+	if(timeout_ms != INFINITE)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &time_limit);
+
+		time_limit.tv_sec += (time_t) (timeout_ms/1000u);
+		time_limit.tv_nsec += ((long) (timeout_ms%1000u))*1000000L;
+
+		if(time_limit.tv_nsec >= 1000000000L)
+		{
+			time_limit.tv_sec++;
+			time_limit.tv_nsec -= 1000000000L;
+		}
+	}
+
+	pthread_mutex_lock(&(p_obj->mutex));
+	pthread_cleanup_push(&thread_posix_unlock, &(p_obj->mutex));
+
+	while(!p_obj->signaled)
+	{
+		if(timeout_ms == INFINITE) n_ret = pthread_cond_wait(&(p_obj->cond), &(p_obj->mutex));
+		else n_ret = pthread_cond_timedwait(&(p_obj->cond), &(p_obj->mutex), &time_limit);
+
+		if(n_ret == ETIMEDOUT) break;
+	}
+
+	signaled = p_obj->signaled;
+
+	if(signaled && !p_obj->manual_reset) p_obj->signaled = FALSE;
+
+	pthread_cleanup_pop(1);
+
+	return signaled;
+}
+
+BOOL WINAPI event_destroy(HANDLE *pp_event)
+{
+	event_posix_t *p_obj = NULL;
+
+	if(pp_event == NULL) return FALSE;
+	if(*pp_event == NULL) return FALSE;
+
+	p_obj = (event_posix_t*) *pp_event;
+
+	pthread_cond_destroy(&(p_obj->cond));
+	pthread_mutex_destroy(&(p_obj->mutex));
+	free(p_obj);
+
+	*pp_event = NULL;
+	return TRUE;
+}
+
+#endif /*_WIN32*/
+
+static VOID WINAPI thread_worker_release(thread_worker_t *p_worker)
+{
+	/*pthread: thread_wait() and thread_stop() already released the thread object*/
+
+#ifdef _WIN32
+	if(p_worker->p_thread != NULL)
+	{
+		CloseHandle(p_worker->p_thread);
+		p_worker->p_thread = NULL;
+	}
+#endif
+
+	if(p_worker->p_event_run != NULL) event_destroy(&(p_worker->p_event_run));
+	if(p_worker->p_event_done != NULL) event_destroy(&(p_worker->p_event_done));
+
+	p_worker->p_routine = NULL;
+	p_worker->p_args = NULL;
+	return;
+}
+
+static DWORD WINAPI thread_worker_proc(VOID *p_args)
+{
+	thread_worker_t *p_worker = (thread_worker_t*) p_args;
+
+	while(TRUE)
+	{
+		if(!event_wait(p_worker->p_event_run, INFINITE)) break;
+		if(p_worker->stop) break;
+
+		p_worker->p_routine(p_worker->p_args);
+
+		event_signal(p_worker->p_event_done);
+	}
+
+	return 0u;
+}
+
+BOOL WINAPI thread_worker_create(thread_worker_t *p_worker, DWORD (WINAPI *p_routine)(VOID*), VOID *p_args)
+{
+	if(p_worker == NULL) return FALSE;
+	if(p_routine == NULL) return FALSE;
+
+	ZeroMemory(p_worker, sizeof(thread_worker_t));
+
+	p_worker->p_routine = p_routine;
+	p_worker->p_args = p_args;
+
+	p_worker->p_event_run = event_create(FALSE);
+	p_worker->p_event_done = event_create(FALSE);
+
+	if((p_worker->p_event_run == NULL) || (p_worker->p_event_done == NULL))
+	{
+		thread_worker_release(p_worker);
+		return FALSE;
+	}
+
+	p_worker->p_thread = thread_create_default(&thread_worker_proc, p_worker, NULL);
+
+	if(p_worker->p_thread == NULL)
+	{
+		thread_worker_release(p_worker);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+BOOL WINAPI thread_worker_run(thread_worker_t *p_worker)
+{
+	if(p_worker == NULL) return FALSE;
+	if(p_worker->p_thread == NULL) return FALSE;
+
+	return event_signal(p_worker->p_event_run);
+}
+
+BOOL WINAPI thread_worker_wait(thread_worker_t *p_worker)
+{
+	if(p_worker == NULL) return FALSE;
+	if(p_worker->p_thread == NULL) return FALSE;
+
+	return event_wait(p_worker->p_event_done, INFINITE);
+}
+
+BOOL WINAPI thread_worker_destroy(thread_worker_t *p_worker)
+{
+	if(p_worker == NULL) return FALSE;
+	if(p_worker->p_thread == NULL) return FALSE;
+
+	InterlockedExchange(&(p_worker->stop), 1);
+	event_signal(p_worker->p_event_run);
+
+#ifdef _WIN32
+	WaitForSingleObject(p_worker->p_thread, INFINITE);
+#else
+	thread_wait(&(p_worker->p_thread));
+#endif
+
+	thread_worker_release(p_worker);
+	return TRUE;
+}
+
+BOOL WINAPI thread_worker_stop(thread_worker_t *p_worker, DWORD exit_code)
+{
+	if(p_worker == NULL) return FALSE;
+	if(p_worker->p_thread == NULL) return FALSE;
+#ifdef _WIN32
+	if(!TerminateThread(p_worker->p_thread, exit_code)) return FALSE;
+#else
+	if(!thread_stop(&(p_worker->p_thread), exit_code)) return FALSE;
+#endif
+
+	thread_worker_release(p_worker);
+	return TRUE;
+}
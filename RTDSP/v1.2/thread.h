@@ -22,6 +22,15 @@
 	https://learn.microsoft.com/en-us/windows/win32/api/processthreadsapi/nf-processthreadsapi-createthread
 	https://learn.microsoft.com/en-us/windows/win32/api/processthreadsapi/nf-processthreadsapi-terminatethread
 	https://learn.microsoft.com/en-us/windows/win32/api/synchapi/nf-synchapi-waitforsingleobject
+
+	Event functions use the CreateEvent(), SetEvent() Windows functions.
+
+	https://learn.microsoft.com/en-us/windows/win32/api/synchapi/nf-synchapi-createeventw
+	https://learn.microsoft.com/en-us/windows/win32/api/synchapi/nf-synchapi-setevent
+
+	Non Windows builds (_WIN32 not defined, see posixdef.h) implement the same functions on pthread:
+	threads with pthread_create()/pthread_join()/pthread_cancel(), events with a mutex and a condition variable.
+	thread_stop() and thread_worker_stop() cancel the thread, it quits at its next cancellation point (any wait, event_wait() included).
 */
 
 #ifndef THREAD_H
@@ -52,4 +61,86 @@ Returns TRUE if successful, FALSE otherwise*/
 
 extern BOOL WINAPI thread_stop(HANDLE *pp_thread, DWORD exit_code);
 
+/*This would be equivalent to pthread_cond_init() in pthread.h
+Create an event object (initially not signaled).
+If manual_reset is FALSE, the event resets itself after releasing a single waiting thread.
+If manual_reset is TRUE, the event stays signaled until event_reset() is called.
+Function returns NULL if it fails, event handle otherwise.*/
+
+extern HANDLE WINAPI event_create(BOOL manual_reset);
+
+/*This would be equivalent to pthread_cond_signal() in pthread.h
+Set the given event to signaled state.
+Returns TRUE if successful, FALSE otherwise*/
+
+extern BOOL WINAPI event_signal(HANDLE p_event);
+
+/*Set the given event to non signaled state.
+Returns TRUE if successful, FALSE otherwise*/
+
+extern BOOL WINAPI event_reset(HANDLE p_event);
+
+/*This would be equivalent to pthread_cond_timedwait() in pthread.h
+Pause the calling thread's execution until the given event is signaled, or until timeout_ms milliseconds have elapsed.
+Use INFINITE to wait without timeout.
+Returns TRUE if the event was signaled, FALSE otherwise (timeout or error)*/
+
+extern BOOL WINAPI event_wait(HANDLE p_event, DWORD timeout_ms);
+
+/*This would be equivalent to pthread_cond_destroy() in pthread.h
+Close the given event handle.
+Returns TRUE if successful, FALSE otherwise*/
+
+extern BOOL WINAPI event_destroy(HANDLE *pp_event);
+
+/*
+	Persistent worker thread:
+
+	A thread that is created once and runs the same routine repeatedly, each time it's requested to.
+	This avoids the cost of creating and destroying a new thread for every single job.
+
+	thread_worker_run() requests one run of the routine, thread_worker_wait() waits for that run to finish.
+	Only one run may be pending at a time: every thread_worker_run() must be matched by a thread_worker_wait() before the next one.
+*/
+
+struct _thread_worker {
+	HANDLE p_thread;
+	HANDLE p_event_run;
+	HANDLE p_event_done;
+	DWORD (WINAPI *p_routine)(VOID*);
+	VOID *p_args;
+	volatile LONG stop;
+};
+
+typedef struct _thread_worker thread_worker_t;
+
+/*Create a new persistent worker thread.
+p_worker is a pointer to the worker object.
+p_routine is a pointer to the routine function executed on every run.
+p_args is a pointer to the routine argument. (This parameter can be NULL).
+Returns TRUE if successful, FALSE otherwise*/
+
+extern BOOL WINAPI thread_worker_create(thread_worker_t *p_worker, DWORD (WINAPI *p_routine)(VOID*), VOID *p_args);
+
+/*Request one run of the worker routine. Does not wait for it.
+Returns TRUE if successful, FALSE otherwise*/
+
+extern BOOL WINAPI thread_worker_run(thread_worker_t *p_worker);
+
+/*Pause the calling thread's execution, wait for the last requested run of the worker routine to finish.
+Returns TRUE if successful, FALSE otherwise*/
+
+extern BOOL WINAPI thread_worker_wait(thread_worker_t *p_worker);
+
+/*Tell the worker thread to quit, wait for it to finish and release the worker resources.
+Must not be called while a run is pending (call thread_worker_wait() first).
+Returns TRUE if successful, FALSE otherwise*/
+
+extern BOOL WINAPI thread_worker_destroy(thread_worker_t *p_worker);
+
+/*Force Quit the worker thread and release the worker resources.
+Returns TRUE if successful, FALSE otherwise*/
+
+extern BOOL WINAPI thread_worker_stop(thread_worker_t *p_worker, DWORD exit_code);
+
 #endif /*THREAD_H*/